@@ -45,6 +45,9 @@ Available boolean options:
   * CONFIG_GRADIENT, enabled by default
   * CONFIG_SYSTEM_TRAY, enabled by default
   * CONFIG_STACKTRACE, disabled by default
+  * CONFIG_BENCHMARKS, disabled by default (bench/ programs, eg.
+    qsynth_levels_bench, timing the output level metering kernels,
+    and qsynth_paint_bench, timing offscreen meter and dial painting)
 Valid values for boolean options are: 1, 0, yes, no, on, off.
 
 * There are also several alternative CMake front-ends, if you don't want to use
@@ -0,0 +1,171 @@
+// qsynthLevelsBench.cpp
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qsynthLevels.h"
+
+#include <QElapsedTimer>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+
+//-------------------------------------------------------------------------
+// Output level metering kernel benchmark.
+//
+// Usage: qsynth_levels_bench [frames [buffers [ports [iterations]]]]
+//
+// Times each kernel available on the running CPU over the same random
+// buffers, as the audio thread would call it on every period, and checks
+// its results against the scalar (reference) kernel; all are also compared
+// with the former metering loop (baseline).
+
+static const char *g_apszKernels[] = { "scalar", "sse2", "avx2", NULL };
+
+// Keeps the timed calls from being optimized away.
+static volatile float g_fSink = 0.0f;
+
+
+// The former metering loop, as it was in qsynth_process(): signed
+// maximum only (no absolute value, no RMS), folded into two ports.
+static void qsynth_levels_baseline ( int nout, float **out, int len,
+	float *pfMeterValue )
+{
+	for (int i = 0; i < nout; ++i) {
+		float *out_i = out[i];
+		for (int j = 0; j < len; ++j) {
+			float fValue = out_i[j];
+			if (pfMeterValue[i & 1] < fValue)
+				pfMeterValue[i & 1] = fValue;
+		}
+	}
+}
+
+
+int main ( int argc, char **argv )
+{
+	const int nframes = (argc > 1 ? ::atoi(argv[1]) : 256);
+	const int nbuffers = (argc > 2 ? ::atoi(argv[2]) : 2);
+	const int nports = (argc > 3 ? ::atoi(argv[3]) : nbuffers);
+	const int iIterations = (argc > 4 ? ::atoi(argv[4]) : 100000);
+
+	if (nframes < 1 || nbuffers < 1 || nports < 1 || iIterations < 1) {
+		fprintf(stderr, "Usage: %s [frames [buffers [ports [iterations]]]]\n",
+			argv[0]);
+		return 1;
+	}
+
+	// Random test signal, some odd frames left over on purpose...
+	float **ppBuffers = new float * [nbuffers];
+	::srand(1);
+	for (int i = 0; i < nbuffers; ++i) {
+		ppBuffers[i] = new float [nframes];
+		for (int j = 0; j < nframes; ++j)
+			ppBuffers[i][j] = 2.0f * float(::rand()) / float(RAND_MAX) - 1.0f;
+	}
+
+	float *pfPeak  = new float [nports];
+	float *pfSumSq = new float [nports];
+
+	// Reference results...
+	float *pfPeakRef  = new float [nports];
+	float *pfSumSqRef = new float [nports];
+	for (int k = 0; k < nports; ++k)
+		pfPeakRef[k] = pfSumSqRef[k] = 0.0f;
+	qsynth_levels_select("scalar");
+	qsynth_levels(nbuffers, ppBuffers, nframes, nports, pfPeakRef, pfSumSqRef);
+
+	fprintf(stdout, "qsynth_levels: %d buffer(s) x %d frame(s) into %d port(s),"
+		" %d iteration(s).\n", nbuffers, nframes, nports, iIterations);
+
+	// Baseline, warm up and time it...
+	float afMeterValue[2] = { 0.0f, 0.0f };
+	for (int i = 0; i < 1000; ++i)
+		qsynth_levels_baseline(nbuffers, ppBuffers, nframes, afMeterValue);
+	QElapsedTimer btimer;
+	btimer.start();
+	for (int i = 0; i < iIterations; ++i) {
+		afMeterValue[0] = afMeterValue[1] = 0.0f;
+		qsynth_levels_baseline(nbuffers, ppBuffers, nframes, afMeterValue);
+		g_fSink = afMeterValue[0];
+	}
+	const double fBaseNsecs = double(btimer.nsecsElapsed()) / double(iIterations);
+	const double fSamples = double(nbuffers) * double(nframes);
+	fprintf(stdout, "  %-8s %10.1f ns/call %8.3f ns/sample"
+		"  (former loop: peak only)\n", "baseline", fBaseNsecs,
+		fBaseNsecs / fSamples);
+
+	double fScalarNsecs = 0.0;
+
+	for (int n = 0; g_apszKernels[n]; ++n) {
+		const char *pszKernel = g_apszKernels[n];
+		if (!qsynth_levels_select(pszKernel)) {
+			fprintf(stdout, "  %-8s n/a\n", pszKernel);
+			continue;
+		}
+		// Check...
+		for (int k = 0; k < nports; ++k)
+			pfPeak[k] = pfSumSq[k] = 0.0f;
+		qsynth_levels(nbuffers, ppBuffers, nframes, nports, pfPeak, pfSumSq);
+		float fError = 0.0f;
+		for (int k = 0; k < nports; ++k) {
+			if (pfPeak[k] != pfPeakRef[k])
+				fError = 1.0f;
+			const float fDelta = ::fabsf(pfSumSq[k] - pfSumSqRef[k])
+				/ (pfSumSqRef[k] > 0.0f ? pfSumSqRef[k] : 1.0f);
+			if (fError < fDelta)
+				fError = fDelta;
+		}
+		// Warm up and time it...
+		for (int i = 0; i < 1000; ++i)
+			qsynth_levels(nbuffers, ppBuffers, nframes, nports, pfPeak, pfSumSq);
+		QElapsedTimer timer;
+		timer.start();
+		for (int i = 0; i < iIterations; ++i) {
+			for (int k = 0; k < nports; ++k)
+				pfPeak[k] = pfSumSq[k] = 0.0f;
+			qsynth_levels(nbuffers, ppBuffers, nframes, nports, pfPeak, pfSumSq);
+			g_fSink = pfSumSq[0];
+		}
+		const double fNsecs = double(timer.nsecsElapsed()) / double(iIterations);
+		if (n == 0)
+			fScalarNsecs = fNsecs;
+		fprintf(stdout, "  %-8s %10.1f ns/call %8.3f ns/sample"
+			"  x%.2f vs. scalar  x%.2f vs. baseline  (rel. error %g)\n",
+			pszKernel, fNsecs, fNsecs / fSamples,
+			(fNsecs > 0.0 ? fScalarNsecs / fNsecs : 0.0),
+			(fNsecs > 0.0 ? fBaseNsecs / fNsecs : 0.0),
+			double(fError));
+	}
+
+	delete [] pfSumSqRef;
+	delete [] pfPeakRef;
+	delete [] pfSumSq;
+	delete [] pfPeak;
+	for (int i = 0; i < nbuffers; ++i)
+		delete [] ppBuffers[i];
+	delete [] ppBuffers;
+
+	return 0;
+}
+
+
+// end of qsynthLevelsBench.cpp
@@ -0,0 +1,195 @@
+// qsynthPaintBench.cpp
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qsynthMeter.h"
+
+#include "qsynthDialClassicStyle.h"
+#include "qsynthDialVokiStyle.h"
+#include "qsynthDialPeppinoStyle.h"
+#include "qsynthDialSkulptureStyle.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QHBoxLayout>
+#include <QDial>
+#include <QImage>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+//-------------------------------------------------------------------------
+// Offscreen widget painting benchmark.
+//
+// Usage: qsynth_paint_bench [frames]
+//
+// Renders the widgets into an offscreen image, frame after frame, as
+// the GUI refresh timer would have them painted, with their pre-rendered
+// image caches either hit (steady state) or missed (meters resized, dial
+// palette changed, every frame).
+
+// Meter strips (ie. output ports) and dials to time.
+static const int g_aiCounts[] = { 2, 16, 64, 0 };
+
+// Meter strip height (pixels).
+#define QSYNTH_BENCH_METER_HEIGHT 120
+
+// Dial size (pixels).
+#define QSYNTH_BENCH_DIAL_SIZE 32
+
+
+// Time a meter bridge with so many strips (nsecs/frame).
+static double qsynth_bench_meter ( int nports, int iFrames, bool bMiss )
+{
+	qsynthMeter meter;
+	meter.setPortCount(nports);
+	meter.resize(nports * 12 + 24, QSYNTH_BENCH_METER_HEIGHT);
+	meter.setAttribute(Qt::WA_DontShowOnScreen);
+	meter.show();
+	QApplication::processEvents();
+
+	QImage image(meter.size(), QImage::Format_ARGB32_Premultiplied);
+
+	qint64 iNsecs = 0;
+	for (int i = 0; i < iFrames; ++i) {
+		// A different size makes all band images stale...
+		if (bMiss) {
+			meter.resize(meter.width(), QSYNTH_BENCH_METER_HEIGHT + (i & 1));
+			QApplication::processEvents();
+		}
+		QElapsedTimer timer;
+		timer.start();
+		for (int k = 0; k < nports; ++k)
+			meter.setValue(k, float((i + k) % 100) / 100.0f);
+		meter.refresh();
+		meter.render(&image);
+		iNsecs += timer.nsecsElapsed();
+	}
+
+	return double(iNsecs) / double(iFrames);
+}
+
+
+// Time a row of so many dials, with some dial style (nsecs/frame).
+static double qsynth_bench_dials ( QStyle *pStyle,
+	int ndials, int iFrames, bool bMiss )
+{
+	QWidget panel;
+	QHBoxLayout *pLayout = new QHBoxLayout(&panel);
+	pLayout->setMargin(0);
+	pLayout->setSpacing(0);
+	QList<QDial *> dials;
+	for (int k = 0; k < ndials; ++k) {
+		QDial *pDial = new QDial(&panel);
+		pDial->setStyle(pStyle);
+		pDial->setRange(0, 127);
+		pDial->setFixedSize(QSYNTH_BENCH_DIAL_SIZE, QSYNTH_BENCH_DIAL_SIZE);
+		pLayout->addWidget(pDial);
+		dials.append(pDial);
+	}
+	panel.setAttribute(Qt::WA_DontShowOnScreen);
+	panel.show();
+	QApplication::processEvents();
+
+	QImage image(panel.size(), QImage::Format_ARGB32_Premultiplied);
+
+	// Have all the angle steps rendered once, for the hits...
+	if (!bMiss) {
+		for (int v = 0; v < 128; ++v) {
+			dials.first()->setValue(v);
+			panel.render(&image);
+		}
+	}
+
+	qint64 iNsecs = 0;
+	for (int i = 0; i < iFrames; ++i) {
+		// A different palette makes for different sprites...
+		if (bMiss) {
+			QPalette pal(panel.palette());
+			pal.setColor(QPalette::Button, QColor::fromRgb(
+				(i * 7) & 0xff, (i >> 3) & 0xff, (i >> 11) & 0xff));
+			panel.setPalette(pal);
+		}
+		QElapsedTimer timer;
+		timer.start();
+		for (int k = 0; k < ndials; ++k)
+			dials.at(k)->setValue((i + k) & 127);
+		panel.render(&image);
+		iNsecs += timer.nsecsElapsed();
+	}
+
+	return double(iNsecs) / double(iFrames);
+}
+
+
+int main ( int argc, char **argv )
+{
+	// No display needed...
+	if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+
+	QApplication app(argc, argv);
+
+	const int iFrames = (argc > 1 ? ::atoi(argv[1]) : 1000);
+	if (iFrames < 1) {
+		fprintf(stderr, "Usage: %s [frames]\n", argv[0]);
+		return 1;
+	}
+
+	fprintf(stdout, "qsynthMeter: %d frame(s), %d pixel(s) high.\n",
+		iFrames, QSYNTH_BENCH_METER_HEIGHT);
+	for (int n = 0; g_aiCounts[n] > 0; ++n) {
+		const int nports = g_aiCounts[n];
+		const double fHitNsecs  = qsynth_bench_meter(nports, iFrames, false);
+		const double fMissNsecs = qsynth_bench_meter(nports, iFrames, true);
+		fprintf(stdout, "  %3d strip(s)  hit %10.1f ns/frame"
+			"  miss %10.1f ns/frame\n", nports, fHitNsecs, fMissNsecs);
+	}
+
+	const char *apszStyles[] = { "Classic", "Voki", "Peppino", "Skulpture" };
+	QStyle *apStyles[] = {
+		new qsynthDialClassicStyle(),
+		new qsynthDialVokiStyle(),
+		new qsynthDialPeppinoStyle(),
+		new qsynthDialSkulptureStyle()
+	};
+
+	for (int s = 0; s < 4; ++s) {
+		fprintf(stdout, "qsynthDial%sStyle: %d frame(s), %dx%d pixel(s).\n",
+			apszStyles[s], iFrames,
+			QSYNTH_BENCH_DIAL_SIZE, QSYNTH_BENCH_DIAL_SIZE);
+		for (int n = 0; g_aiCounts[n] > 0; ++n) {
+			const int ndials = g_aiCounts[n];
+			const double fHitNsecs
+				= qsynth_bench_dials(apStyles[s], ndials, iFrames, false);
+			const double fMissNsecs
+				= qsynth_bench_dials(apStyles[s], ndials, iFrames, true);
+			fprintf(stdout, "  %3d dial(s)   hit %10.1f ns/frame"
+				"  miss %10.1f ns/frame\n", ndials, fHitNsecs, fMissNsecs);
+		}
+		delete apStyles[s];
+	}
+
+	return 0;
+}
+
+
+// end of qsynthPaintBench.cpp
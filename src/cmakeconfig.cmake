@@ -31,6 +31,12 @@
 /* Define if fluid_version_str is available. */
 #cmakedefine CONFIG_FLUID_VERSION_STR @CONFIG_FLUID_VERSION_STR@
 
+/* Define if the fluidsynth soundfont loader structs are public. */
+#cmakedefine CONFIG_FLUID_SFLOADER @CONFIG_FLUID_SFLOADER@
+
+/* Define if new_fluid_file_renderer is available. */
+#cmakedefine CONFIG_FLUID_FILE_RENDERER @CONFIG_FLUID_FILE_RENDERER@
+
 /* Define if system tray is enabled. */
 #cmakedefine CONFIG_SYSTEM_TRAY @CONFIG_SYSTEM_TRAY@
 
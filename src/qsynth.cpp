@@ -22,14 +22,25 @@
 #include "qsynthAbout.h"
 #include "qsynthOptions.h"
 #include "qsynthMainForm.h"
+#include "qsynthEngine.h"
+#include "qsynthEngineManager.h"
+#include "qsynthLevels.h"
+#include "qsynthSoundFontCache.h"
+#include "qsynthSoundFontMeta.h"
+#include "qsynthRender.h"
 
 #include <QApplication>
+#include <QCoreApplication>
+#include <QSocketNotifier>
 #include <QLibraryInfo>
 #include <QTranslator>
 #include <QLocale>
+#include <QTextStream>
 
 #include <QSessionManager>
 
+#include <string.h>
+
 #if QT_VERSION < 0x040500
 namespace Qt {
 const WindowFlags WindowCloseButtonHint = WindowFlags(0x08000000);
@@ -406,6 +417,175 @@ void stacktrace ( int signo )
 #endif
 
 
+//-------------------------------------------------------------------------
+// headless - No GUI, engines driven by a plain core event loop.
+//
+
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(WIN32)
+
+#include <signal.h>
+#include <unistd.h>
+
+static int g_fdSignal[2] = { -1, -1 };
+
+static void qsynth_signal_handler ( int )
+{
+	const char c = 1;
+	if (::write(g_fdSignal[1], &c, sizeof(c)) < 0)
+		return;
+}
+
+#endif
+
+
+static int qsynth_headless ( int argc, char **argv )
+{
+	QCoreApplication app(argc, argv);
+
+	app.setApplicationName(QSYNTH_TITLE);
+
+	// Pick the output level metering kernel, once and for all.
+	qsynth_levels_init();
+
+	// Construct the persistent soundfont metadata cache, early enough.
+	qsynthSoundFontMeta sfmeta;
+
+	// Construct default settings; override with command line arguments.
+	qsynthOptions settings;
+	if (!settings.parse_args(app.arguments()))
+		return 1;
+
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(WIN32)
+	// Quit gracefully on SIGINT/SIGTERM (self-pipe trick)...
+	QSocketNotifier *pSignalNotifier = NULL;
+	if (::pipe(g_fdSignal) == 0) {
+		pSignalNotifier = new QSocketNotifier(
+			g_fdSignal[0], QSocketNotifier::Read, &app);
+		QObject::connect(pSignalNotifier,
+			SIGNAL(activated(int)),
+			&app, SLOT(quit()));
+		::signal(SIGINT,  qsynth_signal_handler);
+		::signal(SIGTERM, qsynth_signal_handler);
+	}
+#endif
+
+	// Construct the shared soundfont cache, which must outlive all engines.
+	qsynthSoundFontCache sfcache;
+
+	// The engine manager, echoing everything to stdout/stderr.
+	qsynthEngineManager *pEngineManager = new qsynthEngineManager(&settings);
+	pEngineManager->setEcho(true);
+
+	// The default engine and all additional custom ones...
+	QList<qsynthEngine *> engines;
+	engines.append(new qsynthEngine(&settings));
+	QStringListIterator iter(settings.engines);
+	while (iter.hasNext())
+		engines.append(new qsynthEngine(&settings, iter.next()));
+
+	QListIterator<qsynthEngine *> eiter(engines);
+	while (eiter.hasNext())
+		pEngineManager->addEngine(eiter.next());
+
+	// Start the press!
+	pEngineManager->startAllEngines();
+
+	const int iResult = app.exec();
+
+	// Stop the press!
+	pEngineManager->stopAllEngines();
+	delete pEngineManager;
+
+	qDeleteAll(engines);
+
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(WIN32)
+	if (pSignalNotifier) {
+		::signal(SIGINT,  SIG_DFL);
+		::signal(SIGTERM, SIG_DFL);
+		delete pSignalNotifier;
+		::close(g_fdSignal[0]);
+		::close(g_fdSignal[1]);
+	}
+#endif
+
+	return iResult;
+}
+
+
+//-------------------------------------------------------------------------
+// render - No GUI, midifiles rendered offline (faster than realtime).
+//
+
+static int qsynth_render ( int argc, char **argv )
+{
+	QCoreApplication app(argc, argv);
+
+	app.setApplicationName(QSYNTH_TITLE);
+
+	// Construct the persistent soundfont metadata cache, early enough.
+	qsynthSoundFontMeta sfmeta;
+
+	// Construct default settings; override with command line arguments.
+	qsynthOptions settings;
+	if (!settings.parse_args(app.arguments()))
+		return 1;
+
+	QTextStream out(stderr);
+
+	if (!qsynthRender::isAvailable()) {
+		out << QObject::tr("Offline rendering is not supported"
+			" by this fluidsynth library.") << endl;
+		return 1;
+	}
+
+	qsynthSetup *pSetup = settings.defaultSetup();
+	if (pSetup->midifiles.isEmpty()) {
+		out << QObject::tr("No midifiles to render.") << endl;
+		return 1;
+	}
+
+	QString sFormat = settings.sRenderFormatArg;
+	if (sFormat.isEmpty())
+		sFormat = settings.sRenderFormat;
+
+	// Construct the shared soundfont cache, which must outlive all renders.
+	qsynthSoundFontCache sfcache;
+
+	// The engine manager, just echoing everything to stdout/stderr.
+	qsynthEngineManager *pEngineManager = new qsynthEngineManager(&settings);
+	pEngineManager->setEcho(true);
+
+	// The default engine and all additional custom ones, if asked for...
+	QList<qsynthEngine *> engines;
+	engines.append(new qsynthEngine(&settings));
+	if (settings.bRenderEngines) {
+		QStringListIterator iter(settings.engines);
+		while (iter.hasNext())
+			engines.append(new qsynthEngine(&settings, iter.next()));
+	}
+
+	qsynthRender *pRender = new qsynthRender(settings.iRenderJobs);
+	pRender->addJobs(engines, pSetup->midifiles, settings.sRenderDir, sFormat);
+
+	if (pRender->jobCount() > 0) {
+		QObject::connect(pEngineManager,
+			SIGNAL(renderFinished(qsynthRender *)),
+			&app, SLOT(quit()));
+		pEngineManager->startRender(pRender);
+		app.exec();
+	}
+
+	const int iResult = (pRender->failedCount() > 0 ? 1 : 0);
+
+	delete pRender;
+	delete pEngineManager;
+
+	qDeleteAll(engines);
+
+	return iResult;
+}
+
+
 //-------------------------------------------------------------------------
 // main - The main program trunk.
 //
@@ -422,8 +602,27 @@ int main ( int argc, char **argv )
 	signal(SIGBUS,  stacktrace);
 #endif
 #endif
+	// Headless mode: no GUI at all...
+	for (int i = 1; i < argc; ++i) {
+		if (::strcmp(argv[i], "--headless") == 0)
+			return qsynth_headless(argc, argv);
+	}
+
+	// Offline render mode: no GUI either...
+	for (int i = 1; i < argc; ++i) {
+		if (::strcmp(argv[i], "--render") == 0
+			|| ::strncmp(argv[i], "--render=", 9) == 0)
+			return qsynth_render(argc, argv);
+	}
+
 	qsynthApplication app(argc, argv);
 
+	// Pick the output level metering kernel, once and for all.
+	qsynth_levels_init();
+
+	// Construct the persistent soundfont metadata cache, early enough.
+	qsynthSoundFontMeta sfmeta;
+
 	// Construct default settings; override with command line arguments.
 	qsynthOptions settings;
 	if (!settings.parse_args(app.arguments())) {
@@ -479,6 +678,8 @@ int main ( int argc, char **argv )
 		| Qt::WindowCloseButtonHint;
 	if (settings.bKeepOnTop)
 		wflags |= Qt::Tool;
+	// Construct the shared soundfont cache, which must outlive all engines.
+	qsynthSoundFontCache sfcache;
 	// Construct the main form, and show it to the world.
 	qsynthMainForm w(0, wflags);
 	w.setup(&settings);
@@ -28,6 +28,8 @@
 #include <fluidsynth.h>
 #endif
 
+#include "qsynthLevels.h"
+
 //----------------------------------------------------------------------------
 // qsynthAboutForm -- UI wrapper form.
 
@@ -72,6 +74,9 @@ qsynthAboutForm::qsynthAboutForm (
 	sText += tr("Using: FluidSynth %1").arg(::fluid_version_str());
 	sText += "<br />\n";
 #endif
+	sText += "<small>";
+	sText += tr("Output metering: %1").arg(::qsynth_levels_name());
+	sText += "</small><br />\n";
 	sText += "<br />\n";
 	sText += tr("Website") + ": <a href=\"" QSYNTH_WEBSITE "\">" QSYNTH_WEBSITE "</a><br />\n";
 	sText += "<br />\n";
@@ -0,0 +1,99 @@
+// qsynthAtomic.h
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qsynthAtomic_h
+#define __qsynthAtomic_h
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+
+
+//-------------------------------------------------------------------------
+// qsynthAtomicInt, qsynthAtomicPointer - Qt5 atomics, also on Qt4.
+//
+// Qt4 atomics have no load()/store() nor their acquire/release
+// variants; those are made of the fetch-and-op primitives it has.
+
+#if QT_VERSION >= 0x050000
+
+typedef QAtomicInt qsynthAtomicInt;
+
+template <typename T>
+class qsynthAtomicPointer : public QAtomicPointer<T>
+{
+public:
+
+	qsynthAtomicPointer(T *p = 0) : QAtomicPointer<T>(p) {}
+
+	qsynthAtomicPointer& operator= (T *p)
+		{ QAtomicPointer<T>::store(p); return *this; }
+};
+
+#else
+
+class qsynthAtomicInt : public QAtomicInt
+{
+public:
+
+	qsynthAtomicInt(int v = 0) : QAtomicInt(v) {}
+
+	qsynthAtomicInt& operator= (int v)
+		{ QAtomicInt::operator= (v); return *this; }
+
+	int load() const
+		{ return int(*this); }
+	int loadAcquire() const
+		{ return const_cast<qsynthAtomicInt *> (this)->fetchAndAddAcquire(0); }
+
+	void store(int v)
+		{ QAtomicInt::operator= (v); }
+	void storeRelease(int v)
+		{ fetchAndStoreRelease(v); }
+};
+
+template <typename T>
+class qsynthAtomicPointer : public QAtomicPointer<T>
+{
+public:
+
+	qsynthAtomicPointer(T *p = 0) : QAtomicPointer<T>(p) {}
+
+	qsynthAtomicPointer& operator= (T *p)
+		{ QAtomicPointer<T>::operator= (p); return *this; }
+
+	T *load() const
+		{ return static_cast<T *> (*this); }
+	T *loadAcquire() const
+		{ return const_cast<qsynthAtomicPointer *> (this)->fetchAndAddAcquire(0); }
+
+	void store(T *p)
+		{ QAtomicPointer<T>::operator= (p); }
+	void storeRelease(T *p)
+		{ QAtomicPointer<T>::fetchAndStoreRelease(p); }
+};
+
+#endif
+
+
+#endif  // __qsynthAtomic_h
+
+
+// end of qsynthAtomic.h
@@ -1,7 +1,7 @@
 // qsynthChannels.cpp
 //
 /****************************************************************************
-   Copyright (C) 2003-2006, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -22,39 +22,261 @@
 #include "qsynthAbout.h"
 #include "qsynthChannels.h"
 
+#include "qsynthPresetIndex.h"
+
+#include <string.h>
+
 
 //-------------------------------------------------------------------------
-// qsynthChannelsItem - Channel view item class.
+// qsynthChannelsModel - Channels view snapshot model.
 //
 
 // Constructor.
-qsynthChannelsItem::qsynthChannelsItem ( QTreeWidget *pParent )
-	: QTreeWidgetItem(pParent)
+qsynthChannelsModel::qsynthChannelsModel ( QObject *pParent )
+	: QAbstractTableModel(pParent)
+{
+	m_pSynth = NULL;
+
+	m_iDirtyFirst = -1;
+	m_iDirtyLast  = -1;
+
+	// Our activity leds (same of main form :).
+	m_ledOn  = QPixmap(":/images/ledon1.png");
+	m_ledOff = QPixmap(":/images/ledoff1.png");
+}
+
+
+// Column header labels.
+void qsynthChannelsModel::setHeaderLabels ( const QStringList& labels )
+{
+	m_headers = labels;
+
+	emit headerDataChanged(Qt::Horizontal, 0, QSYNTH_CHANNELS_COLUMNS - 1);
+}
+
+
+// Synth reference and number of channels (resets the whole model).
+void qsynthChannelsModel::setSynth ( fluid_synth_t *pSynth, int iChannels )
+{
+	beginResetModel();
+
+	m_pSynth = pSynth;
+
+	Channel chan;
+	chan.bOn     = false;
+	chan.bPreset = false;
+	chan.iBank   = 0;
+	chan.iProg   = 0;
+	chan.iSFID   = 0;
+
+	m_channels.clear();
+	if (m_pSynth && iChannels > 0)
+		m_channels.fill(chan, iChannels);
+
+	m_iDirtyFirst = -1;
+	m_iDirtyLast  = -1;
+
+	endResetModel();
+}
+
+
+// Activity LED state (notified on next flush).
+void qsynthChannelsModel::setChannelOn ( int iChan, bool bOn )
+{
+	if (iChan < 0 || iChan >= m_channels.count())
+		return;
+
+	Channel& chan = m_channels[iChan];
+	if (chan.bOn != bOn) {
+		chan.bOn = bOn;
+		dirtyChannel(iChan);
+	}
+}
+
+
+// Read a new snapshot of all channel states (soundfont names
+// from the preset catalogue); returns the number of channels
+// that changed preset.
+int qsynthChannelsModel::updateChannels ( const qsynthPresetIndex& presets )
+{
+	if (m_pSynth == NULL)
+		return 0;
+
+	int iChanges = 0;
+
+	const int iChannels = m_channels.count();
+	for (int iChan = 0; iChan < iChannels; ++iChan) {
+		Channel& chan = m_channels[iChan];
+		bool    bPreset = false;
+		int     iBank   = 0;
+		int     iProg   = 0;
+		int     iSFID   = 0;
+		QString sName;
+	#ifdef CONFIG_FLUID_CHANNEL_INFO
+		fluid_synth_channel_info_t info;
+		::memset(&info, 0, sizeof(info));
+		::fluid_synth_get_channel_info(m_pSynth, iChan, &info);
+		if (info.assigned) {
+		#ifdef CONFIG_FLUID_BANK_OFFSET
+			info.bank += ::fluid_synth_get_bank_offset(m_pSynth, info.sfont_id);
+		#endif
+			bPreset = true;
+			iBank   = info.bank;
+			iProg   = info.program;
+			iSFID   = info.sfont_id;
+			sName   = info.name;
+		}
+	#else
+		fluid_preset_t *pPreset = ::fluid_synth_get_channel_preset(m_pSynth, iChan);
+		if (pPreset) {
+			bPreset = true;
+			iBank   = pPreset->get_banknum(pPreset);
+			iProg   = pPreset->get_num(pPreset);
+			iSFID   = (pPreset->sfont)->id;
+			sName   = pPreset->get_name(pPreset);
+		#ifdef CONFIG_FLUID_BANK_OFFSET
+			iBank += ::fluid_synth_get_bank_offset(m_pSynth, iSFID);
+		#endif
+		}
+	#endif
+		// Same as last seen?
+		if (chan.bPreset == bPreset && chan.iBank == iBank
+			&& chan.iProg == iProg && chan.iSFID == iSFID
+			&& chan.sName == sName)
+			continue;
+		chan.bPreset = bPreset;
+		chan.iBank   = iBank;
+		chan.iProg   = iProg;
+		chan.iSFID   = iSFID;
+		chan.sName   = sName;
+		chan.sSFName = (bPreset ? presets.soundFontName(iSFID) : QString());
+		dirtyChannel(iChan);
+		++iChanges;
+	}
+
+	return iChanges;
+}
+
+
+// Notify all rows changed since last flush, in one range;
+// returns whether there was any.
+bool qsynthChannelsModel::flushChannels (void)
+{
+	if (m_iDirtyFirst < 0)
+		return false;
+
+	const QModelIndex& topLeft
+		= index(m_iDirtyFirst, 0);
+	const QModelIndex& bottomRight
+		= index(m_iDirtyLast, QSYNTH_CHANNELS_COLUMNS - 1);
+
+	m_iDirtyFirst = -1;
+	m_iDirtyLast  = -1;
+
+	emit dataChanged(topLeft, bottomRight);
+
+	return true;
+}
+
+
+// Extend the dirty row range.
+void qsynthChannelsModel::dirtyChannel ( int iChan )
+{
+	if (m_iDirtyFirst < 0 || m_iDirtyFirst > iChan)
+		m_iDirtyFirst = iChan;
+	if (m_iDirtyLast < iChan)
+		m_iDirtyLast = iChan;
+}
+
+
+// Channel record accessor.
+const qsynthChannelsModel::Channel& qsynthChannelsModel::channel ( int iChan ) const
 {
+	return m_channels.at(iChan);
 }
 
 
-// Default Destructor.
-qsynthChannelsItem::~qsynthChannelsItem (void)
+// Model interface.
+int qsynthChannelsModel::rowCount ( const QModelIndex& parent ) const
 {
+	return (parent.isValid() ? 0 : m_channels.count());
 }
 
 
-// Special column sorting virtual comparator.
-// Sort/compare overriden method.
-bool qsynthChannelsItem::operator< (const QTreeWidgetItem& other) const
+int qsynthChannelsModel::columnCount ( const QModelIndex& parent ) const
 {
-	int iColumn = QTreeWidgetItem::treeWidget()->sortColumn();
-	const QString& s1 = text(iColumn);
-	const QString& s2 = other.text(iColumn);
-	if (iColumn == QSYNTH_CHANNELS_CHAN ||
-		iColumn == QSYNTH_CHANNELS_BANK ||
-		iColumn == QSYNTH_CHANNELS_PROG ||
-		iColumn == QSYNTH_CHANNELS_SFID) {
-		return (s1.toInt() < s2.toInt());
-	} else {
-		return (s1 < s2);
+	return (parent.isValid() ? 0 : QSYNTH_CHANNELS_COLUMNS);
+}
+
+
+QVariant qsynthChannelsModel::data ( const QModelIndex& index, int role ) const
+{
+	if (!index.isValid() || index.row() >= m_channels.count())
+		return QVariant();
+
+	const int iChan = index.row();
+	const Channel& chan = m_channels.at(iChan);
+
+	if (role == Qt::DecorationRole) {
+		if (index.column() == QSYNTH_CHANNELS_IN)
+			return (chan.bOn ? m_ledOn : m_ledOff);
+		return QVariant();
+	}
+
+	if (role != Qt::DisplayRole && role != SortRole)
+		return QVariant();
+
+	// Numeric columns sort as such.
+	const bool bSort = (role == SortRole);
+
+	switch (index.column()) {
+	case QSYNTH_CHANNELS_IN:
+		if (bSort)
+			return int(chan.bOn);
+		break;
+	case QSYNTH_CHANNELS_CHAN:
+		if (bSort)
+			return iChan + 1;
+		return QString::number(iChan + 1);
+	case QSYNTH_CHANNELS_BANK:
+		if (!chan.bPreset)
+			return (bSort ? QVariant(-1) : QVariant("-"));
+		if (bSort)
+			return chan.iBank;
+		return QString::number(chan.iBank);
+	case QSYNTH_CHANNELS_PROG:
+		if (!chan.bPreset)
+			return (bSort ? QVariant(-1) : QVariant("-"));
+		if (bSort)
+			return chan.iProg;
+		return QString::number(chan.iProg);
+	case QSYNTH_CHANNELS_NAME:
+		return (chan.bPreset ? chan.sName : QString("-"));
+	case QSYNTH_CHANNELS_SFID:
+		if (!chan.bPreset)
+			return (bSort ? QVariant(-1) : QVariant("-"));
+		if (bSort)
+			return chan.iSFID;
+		return QString::number(chan.iSFID);
+	case QSYNTH_CHANNELS_SFNAME:
+		return (chan.bPreset && !chan.sSFName.isEmpty()
+			? chan.sSFName : QString("-"));
+	default:
+		break;
 	}
+
+	return QVariant();
+}
+
+
+QVariant qsynthChannelsModel::headerData (
+	int section, Qt::Orientation orient, int role ) const
+{
+	if (orient == Qt::Horizontal && role == Qt::DisplayRole
+		&& section >= 0 && section < m_headers.count())
+		return m_headers.at(section);
+
+	return QAbstractTableModel::headerData(section, orient, role);
 }
 
 
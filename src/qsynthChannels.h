@@ -1,7 +1,7 @@
 // qsynthChannels.h
 //
 /****************************************************************************
-   Copyright (C) 2003-2006, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -22,7 +22,15 @@
 #ifndef __qsynthChannels_h
 #define __qsynthChannels_h
 
-#include <QTreeWidget>
+#include <QAbstractTableModel>
+#include <QStringList>
+#include <QVector>
+#include <QPixmap>
+
+#include <fluidsynth.h>
+
+// Forward declarations.
+class qsynthPresetIndex;
 
 // Column index helpers.
 #define QSYNTH_CHANNELS_IN      0
@@ -33,23 +41,84 @@
 #define QSYNTH_CHANNELS_SFID    5
 #define QSYNTH_CHANNELS_SFNAME  6
 
+#define QSYNTH_CHANNELS_COLUMNS 7
+
+
+//-------------------------------------------------------------------------
+// qsynthChannelsModel - Channels view snapshot model.
+//
+// All channel states are read from the synth in one go, into a plain
+// snapshot; rows that changed since the previous one are then notified
+// in a single ranged dataChanged(), when the whole batch is done.
 
-// The channels list view item.
-class qsynthChannelsItem : public QTreeWidgetItem
+class qsynthChannelsModel : public QAbstractTableModel
 {
 public:
 
+	// Custom item data roles.
+	enum { SortRole = Qt::UserRole + 1 };
+
+	// Channel state snapshot record.
+	struct Channel
+	{
+		bool    bOn;        // Activity LED state.
+		bool    bPreset;    // Whether a preset is assigned.
+		int     iBank;
+		int     iProg;
+		QString sName;
+		int     iSFID;
+		QString sSFName;
+	};
+
 	// Constructor.
-	qsynthChannelsItem(QTreeWidget *pParent);
-	// Default destructor.
-	~qsynthChannelsItem();
+	qsynthChannelsModel(QObject *pParent = NULL);
 
-	// Special column sorting virtual comparator.
-	// Sort/compare overriden method.
-	bool operator< (const QTreeWidgetItem& other) const;
-};
+	// Column header labels.
+	void setHeaderLabels(const QStringList& labels);
+
+	// Synth reference and number of channels (resets the whole model).
+	void setSynth(fluid_synth_t *pSynth, int iChannels);
+
+	// Activity LED state (notified on next flush).
+	void setChannelOn(int iChan, bool bOn);
 
-typedef qsynthChannelsItem * qsynthChannelsItemPtr;
+	// Read a new snapshot of all channel states (soundfont names
+	// from the preset catalogue); returns the number of channels
+	// that changed preset.
+	int updateChannels(const qsynthPresetIndex& presets);
+
+	// Notify all rows changed since last flush, in one range;
+	// returns whether there was any.
+	bool flushChannels();
+
+	// Channel record accessor.
+	const Channel& channel(int iChan) const;
+
+	// Model interface.
+	int rowCount(const QModelIndex& parent = QModelIndex()) const;
+	int columnCount(const QModelIndex& parent = QModelIndex()) const;
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+	QVariant headerData(int section, Qt::Orientation orient,
+		int role = Qt::DisplayRole) const;
+
+protected:
+
+	// Extend the dirty row range.
+	void dirtyChannel(int iChan);
+
+private:
+
+	// Instance variables.
+	fluid_synth_t   *m_pSynth;
+	QVector<Channel> m_channels;
+	QStringList      m_headers;
+
+	int m_iDirtyFirst;
+	int m_iDirtyLast;
+
+	QPixmap m_ledOn;
+	QPixmap m_ledOff;
+};
 
 
 #endif  // __qsynthChannels_h
@@ -28,15 +28,25 @@
 #include "qsynthMainForm.h"
 #include "qsynthPresetForm.h"
 
+#include <QSortFilterProxyModel>
 #include <QValidator>
 #include <QHeaderView>
 #include <QMessageBox>
-#include <QFileInfo>
 
 #include <QShowEvent>
 #include <QHideEvent>
-#include <QPixmap>
 #include <QMenu>
+#include <QTimer>
+
+#include <algorithm>
+
+
+// Warm preset switch poll period and timeout (msecs).
+#define QSYNTH_CHANNELS_WARM_POLL     20
+#define QSYNTH_CHANNELS_WARM_TIMEOUT  10000
+
+// Number of preset switch latency samples kept.
+#define QSYNTH_CHANNELS_SWITCH_TIMES  128
 
 
 //----------------------------------------------------------------------------
@@ -50,8 +60,20 @@ qsynthChannelsForm::qsynthChannelsForm (
 	// Setup UI struct...
 	m_ui.setupUi(this);
 
-	m_iChannels  = 0;
-	m_ppChannels = NULL;
+	m_iChannels = 0;
+
+	// Channels snapshot model, sorted only when asked for.
+	m_pChannelsModel = new qsynthChannelsModel(this);
+	m_pChannelsModel->setHeaderLabels(QStringList()
+		<< tr("In") << tr("Chan") << tr("Bank") << tr("Prog")
+		<< tr("Name") << tr("SFID") << tr("Soundfont"));
+
+	m_pChannelsFilter = new QSortFilterProxyModel(this);
+	m_pChannelsFilter->setDynamicSortFilter(false);
+	m_pChannelsFilter->setSortRole(qsynthChannelsModel::SortRole);
+	m_pChannelsFilter->setSourceModel(m_pChannelsModel);
+
+	m_ui.ChannelsListView->setModel(m_pChannelsFilter);
 
 	// No setup synth references initially (the caller will set them).
 	m_pOptions = NULL;
@@ -62,9 +84,14 @@ qsynthChannelsForm::qsynthChannelsForm (
 	m_iDirtySetup = 0;
 	m_iDirtyCount = 0;
 
-	// Our activity leds (same of main form :).
-	m_pXpmLedOn  = new QPixmap(":/images/ledon1.png");
-	m_pXpmLedOff = new QPixmap(":/images/ledoff1.png");
+	m_iDirtyChannels = 0;
+
+	// Deferred (warm) preset switch timer.
+	m_pPendingTimer = new QTimer(this);
+	m_pPendingTimer->setSingleShot(true);
+	m_pPendingTimer->setInterval(QSYNTH_CHANNELS_WARM_POLL);
+
+	m_iSwitchTime = 0;
 
 	// Set validators...
 	m_ui.PresetComboBox->setValidator(
@@ -92,7 +119,7 @@ qsynthChannelsForm::qsynthChannelsForm (
 	m_ui.ChannelsListView->resizeColumnToContents(6);	// Soundfont.
 
 	// Initial sort order...
-	m_ui.ChannelsListView->sortItems(1, Qt::AscendingOrder);
+	m_ui.ChannelsListView->sortByColumn(1, Qt::AscendingOrder);
 
 	// UI connections...
 	QObject::connect(m_ui.PresetComboBox,
@@ -104,15 +131,21 @@ qsynthChannelsForm::qsynthChannelsForm (
 	QObject::connect(m_ui.PresetDeletePushButton,
 		SIGNAL(clicked()),
 		SLOT(deletePreset()));
+	QObject::connect(m_ui.WarmPresetsSpinBox,
+		SIGNAL(valueChanged(int)),
+		SLOT(warmPresetsChanged(int)));
+	QObject::connect(m_pPendingTimer,
+		SIGNAL(timeout()),
+		SLOT(pendingPreset()));
 	QObject::connect(m_ui.ChannelsListView,
 		SIGNAL(customContextMenuRequested(const QPoint&)),
 		SLOT(contextMenuRequested(const QPoint&)));
 //	QObject::connect(m_ui.ChannelsListView,
-//		SIGNAL(itemActivated(QTreeWidgetItem*,int)),
-//		SLOT(itemActivated(QTreeWidgetItem*,int)));
+//		SIGNAL(activated(const QModelIndex&)),
+//		SLOT(itemActivated(const QModelIndex&)));
 	QObject::connect(m_ui.ChannelsListView,
-		SIGNAL(itemDoubleClicked(QTreeWidgetItem*,int)),
-		SLOT(itemActivated(QTreeWidgetItem*,int)));
+		SIGNAL(doubleClicked(const QModelIndex&)),
+		SLOT(itemActivated(const QModelIndex&)));
 }
 
 
@@ -121,10 +154,6 @@ qsynthChannelsForm::~qsynthChannelsForm (void)
 {
 	// Nullify references.
 	setup(NULL, NULL, false);
-
-	// Delete pixmaps.
-	delete m_pXpmLedOn;
-	delete m_pXpmLedOff;
 }
 
 
@@ -174,32 +203,30 @@ void qsynthChannelsForm::setup ( qsynthOptions *pOptions,
 		sTitle += " [" + pEngine->name() + "]";
 	setWindowTitle(sTitle);
 
-	// Free up current channel list view.
-	if (m_ppChannels) {
-		delete [] m_ppChannels;
-		m_ppChannels = NULL;
-		m_iChannels  = 0;
+	// Warm presets setting...
+	if (m_pOptions) {
+		m_iDirtySetup++;
+		m_ui.WarmPresetsSpinBox->setValue(m_pOptions->iWarmPresets);
+		m_iDirtySetup--;
 	}
 
-	// Allocate a new channel list view...
-	m_ui.ChannelsListView->clear();
-	if (m_pSynth && m_ppChannels == NULL) {
+	// Reset any pending preset switch and latency statistics...
+	m_sPendingPreset.clear();
+	m_pPendingTimer->stop();
+	m_switchTimes.clear();
+	m_iSwitchTime = 0;
+	updateSwitchTime();
+
+	// Reset the channels snapshot model...
+	m_iChannels = 0;
+	m_iDirtyChannels = 0;
+	if (m_pSynth)
 		m_iChannels = ::fluid_synth_count_midi_channels(m_pSynth);
-		if (m_iChannels > 0)
-			m_ppChannels = new qsynthChannelsItemPtr [m_iChannels];
-		if (m_ppChannels) {
-			for (int iChan = 0; iChan < m_iChannels; iChan++) {
-				qsynthChannelsItem *pItem = new qsynthChannelsItem(
-					m_ui.ChannelsListView);
-				if (pItem) {
-					pItem->setIcon(QSYNTH_CHANNELS_IN,
-						*m_pXpmLedOff);
-					pItem->setText(QSYNTH_CHANNELS_CHAN,
-						QString::number(iChan + 1));
-				}
-				m_ppChannels[iChan] = pItem;
-			}
-		}
+	m_pChannelsModel->setSynth(m_pSynth, m_iChannels);
+	if (m_pSynth) {
+		for (int iChan = 0; iChan < m_iChannels; iChan++)
+			m_pChannelsModel->setChannelOn(iChan,
+				m_pEngine->isMidiChannelOn(iChan));
 		// Load preset list...
 		m_iDirtySetup++;
 		resetPresets();
@@ -211,83 +238,72 @@ void qsynthChannelsForm::setup ( qsynthOptions *pOptions,
 }
 
 
-// Channel item update.
+// Channel item update (deferred until next flush).
 void qsynthChannelsForm::updateChannel ( int iChan )
 {
-	if (m_pSynth == NULL || m_ppChannels == NULL)
+	if (m_pSynth == NULL)
 		return;
 	if (iChan < 0 || iChan >= m_iChannels)
 		return;
 
-	qsynthChannelsItem *pItem = m_ppChannels[iChan];
-
-	const QString n = "-";
-#ifdef CONFIG_FLUID_CHANNEL_INFO
-	fluid_synth_channel_info_t info;
-	::memset(&info, 0, sizeof(info));
-	::fluid_synth_get_channel_info(m_pSynth, iChan, &info);
-	if (info.assigned) {
-	#ifdef CONFIG_FLUID_BANK_OFFSET
-		info.bank += ::fluid_synth_get_bank_offset(m_pSynth, info.sfont_id);
-	#endif
-		pItem->setText(QSYNTH_CHANNELS_BANK,
-			QString::number(info.bank));
-		pItem->setText(QSYNTH_CHANNELS_PROG,
-			QString::number(info.program));
-		pItem->setText(QSYNTH_CHANNELS_NAME,
-			info.name);
-		pItem->setText(QSYNTH_CHANNELS_SFID,
-			QString::number(info.sfont_id));
-		fluid_sfont_t *sfont
-			= ::fluid_synth_get_sfont_by_id(m_pSynth, info.sfont_id);
-		pItem->setText(QSYNTH_CHANNELS_SFNAME,
-			sfont ? QFileInfo(sfont->get_name(sfont)).baseName() : n);
-		// Make this a dirty-operation.
-		m_iDirtyCount++;
-	} 
-#else
-	fluid_preset_t *pPreset = ::fluid_synth_get_channel_preset(m_pSynth, iChan);
-	if (pPreset) {
-		int iBank = pPreset->get_banknum(pPreset);
-	#ifdef CONFIG_FLUID_BANK_OFFSET
-		iBank += ::fluid_synth_get_bank_offset(m_pSynth, (pPreset->sfont)->id);
-	#endif
-		pItem->setText(QSYNTH_CHANNELS_BANK,
-			QString::number(iBank));
-		pItem->setText(QSYNTH_CHANNELS_PROG,
-			QString::number(pPreset->get_num(pPreset)));
-		pItem->setText(QSYNTH_CHANNELS_NAME,
-			pPreset->get_name(pPreset));
-		pItem->setText(QSYNTH_CHANNELS_SFID,
-			QString::number((pPreset->sfont)->id));
-		pItem->setText(QSYNTH_CHANNELS_SFNAME,
-			QFileInfo((pPreset->sfont)->get_name(pPreset->sfont)).baseName());
-		// Make this a dirty-operation.
-		m_iDirtyCount++;
-	}
-#endif
-	else {
-		pItem->setText(QSYNTH_CHANNELS_BANK, n);
-		pItem->setText(QSYNTH_CHANNELS_PROG, n);
-		pItem->setText(QSYNTH_CHANNELS_NAME, n);
-		pItem->setText(QSYNTH_CHANNELS_SFID, n);
-		pItem->setText(QSYNTH_CHANNELS_SFNAME, n);
+	m_iDirtyChannels++;
+}
+
+
+// Apply all pending channel changes, in one batch.
+void qsynthChannelsForm::flushChannels (void)
+{
+	if (m_iDirtyChannels > 0) {
+		updateAllChannels();
+		return;
 	}
+
+	if (m_pChannelsModel->flushChannels()
+		&& m_ui.ChannelsListView->header()->sortIndicatorSection()
+			== QSYNTH_CHANNELS_IN)
+		sortChannels();
 }
 
 
 // All channels update.
 void qsynthChannelsForm::updateAllChannels (void)
 {
-	for (int iChan = 0; iChan < m_iChannels; iChan++)
-		updateChannel(iChan);
+	m_iDirtyChannels = 0;
 
-	m_ui.ChannelsListView->update();
+	// One snapshot of all channels, one ranged change notification...
+	if (m_pEngine)
+		m_iDirtyCount += m_pChannelsModel->updateChannels(m_pEngine->presetIndex());
+	if (m_pChannelsModel->flushChannels())
+		sortChannels();
 
 	stabilizeForm();
 }
 
 
+// Deferred sort, once a batch is done.
+void qsynthChannelsForm::sortChannels (void)
+{
+	QHeaderView *pHeader = m_ui.ChannelsListView->header();
+	m_pChannelsFilter->sort(
+		pHeader->sortIndicatorSection(),
+		pHeader->sortIndicatorOrder());
+}
+
+
+// Channel of some view index (-1 if none).
+int qsynthChannelsForm::channelOf ( const QModelIndex& index ) const
+{
+	if (!index.isValid())
+		return -1;
+
+	const int iChan = m_pChannelsFilter->mapToSource(index).row();
+	if (iChan < 0 || iChan >= m_iChannels)
+		return -1;
+
+	return iChan;
+}
+
+
 // All channels reset update.
 void qsynthChannelsForm::resetAllChannels ( bool bPreset )
 {
@@ -308,26 +324,23 @@ void qsynthChannelsForm::resetAllChannels ( bool bPreset )
 // Update channel activity status LED.
 void qsynthChannelsForm::setChannelOn ( int iChan, bool bOn )
 {
-	if (m_ppChannels == NULL)
-		return;
 	if (iChan < 0 || iChan >= m_iChannels)
 		return;
 
-	m_ppChannels[iChan]->setIcon(QSYNTH_CHANNELS_IN,
-		(bOn ? *m_pXpmLedOn : *m_pXpmLedOff));
+	m_pChannelsModel->setChannelOn(iChan, bOn);
 }
 
 
 // Channel view context menu handler.
 void qsynthChannelsForm::contextMenuRequested ( const QPoint& pos )
 {
-	QTreeWidgetItem *pItem = m_ui.ChannelsListView->itemAt(pos);
+	const int iChan = channelOf(m_ui.ChannelsListView->indexAt(pos));
 
 	// Build the channel context menu...
 	QMenu menu(this);
 	QAction *pAction;
 
-	bool bEnabled = (m_pSynth && pItem);
+	bool bEnabled = (m_pSynth && iChan >= 0);
 	pAction = menu.addAction(
 		QIcon(":/images/edit1.png"),
 		tr("Edit") + "...", this, SLOT(editSelectedChannel()));
@@ -349,23 +362,18 @@ void qsynthChannelsForm::contextMenuRequested ( const QPoint& pos )
 // Edit detail dialog.
 void qsynthChannelsForm::editSelectedChannel (void)
 {
-	itemActivated(m_ui.ChannelsListView->currentItem(), 0);
+	itemActivated(m_ui.ChannelsListView->currentIndex());
 }
 
 
 // Unset program slot.
 void qsynthChannelsForm::unsetSelectedChannel (void)
 {
-	QTreeWidgetItem *pItem = m_ui.ChannelsListView->currentItem();
-	if (pItem == NULL)
-		return;
-	if (m_ppChannels == NULL)
-		return;
 	if (m_pOptions == NULL || m_pEngine == NULL || m_pSynth == NULL)
 		return;
 
-	int iChan = (pItem->text(QSYNTH_CHANNELS_CHAN).toInt() - 1);
-	if (iChan < 0 || iChan >= m_iChannels)
+	const int iChan = channelOf(m_ui.ChannelsListView->currentIndex());
+	if (iChan < 0)
 		return;
 
 #ifdef CONFIG_FLUID_UNSET_PROGRAM
@@ -374,33 +382,27 @@ void qsynthChannelsForm::unsetSelectedChannel (void)
 	m_iDirtyCount++;
 #endif
 
-	updateChannel(iChan);
-
-	stabilizeForm();
+	updateAllChannels();
 }
 
 
 // Show detail dialog.
-void qsynthChannelsForm::itemActivated ( QTreeWidgetItem *pItem, int )
+void qsynthChannelsForm::itemActivated ( const QModelIndex& index )
 {
-	if (pItem == NULL)
-		return;
-	if (m_ppChannels == NULL)
-		return;
 	if (m_pOptions == NULL || m_pEngine == NULL || m_pSynth == NULL)
 		return;
 
-	int iChan = (pItem->text(QSYNTH_CHANNELS_CHAN).toInt() - 1);
-	if (iChan < 0 || iChan >= m_iChannels)
+	const int iChan = channelOf(index);
+	if (iChan < 0)
 		return;
 
 	qsynthPresetForm *pPresetForm = new qsynthPresetForm(this);
 	if (pPresetForm) {
 		// The the proper context.
-		pPresetForm->setup(m_pOptions, m_pSynth, iChan);
+		pPresetForm->setup(m_pOptions, m_pEngine, iChan);
 		// Show the channel preset dialog...
 		if (pPresetForm->exec())
-			updateChannel(iChan);
+			updateAllChannels();
 		// Done.
 		delete pPresetForm;
 	}
@@ -416,21 +418,143 @@ void qsynthChannelsForm::changePreset ( const QString& sPreset )
 	if (m_iDirtySetup > 0)
 		return;
 
+	// Switch latency is timed since first asked for.
+	if (sPreset != m_sPendingPreset)
+		m_switchTime.start();
+
+	// Don't switch until all of its soundfonts are loaded in the
+	// background, so that neither the switch nor the first notes
+	// to follow will ever wait for them (warm presets mode just
+	// gets the next ones loaded ahead)...
+	bool bFailed = false;
+	if (!m_pOptions->warmPreset(m_pEngine, sPreset, &bFailed)) {
+		if (!bFailed && m_switchTime.elapsed() < QSYNTH_CHANNELS_WARM_TIMEOUT) {
+			m_sPendingPreset = sPreset;
+			if (!m_pPendingTimer->isActive())
+				m_pPendingTimer->start();
+			return;
+		}
+		// Give up, keeping the current preset...
+		m_sPendingPreset.clear();
+		m_pPendingTimer->stop();
+		qsynthSetup *pSetup = m_pEngine->setup();
+		if (pSetup) {
+			m_iDirtySetup++;
+			m_ui.PresetComboBox->setEditText(pSetup->sDefPreset);
+			m_iDirtySetup--;
+		}
+		qsynthMainForm *pMainForm = qsynthMainForm::getInstance();
+		if (pMainForm) {
+			pMainForm->appendMessagesError(m_pEngine->name() + ": " + (bFailed
+				? tr("Failed to switch to preset \"%1\".\n\n"
+					"Some of its soundfonts could not be loaded.")
+				: tr("Failed to switch to preset \"%1\".\n\n"
+					"Its soundfonts are taking too long to load."))
+				.arg(sPreset));
+		}
+		stabilizeForm();
+		return;
+	}
+
+	m_sPendingPreset.clear();
+
 	// Force this is pseudo-dirty procedure...
 	m_iDirtyCount++;
 	// Load presets and update/refresh the whole thing.
 	if (m_pOptions->loadPreset(m_pEngine, sPreset)) {
+		addSwitchTime(int(m_switchTime.nsecsElapsed() / 1000));
 		updateAllChannels();
 		// Very special, make this the new default preset.
 		(m_pEngine->setup())->sDefPreset = sPreset;
 		// This is clean now, for sure.
 		m_iDirtyCount = 0;
+		// Get the next ones ready...
+		warmNextPresets(sPreset);
 	}
 
 	stabilizeForm();
 }
 
 
+// Retry a deferred (warm) preset switch.
+void qsynthChannelsForm::pendingPreset (void)
+{
+	if (!m_sPendingPreset.isEmpty())
+		changePreset(m_sPendingPreset);
+}
+
+
+// Get the presets next to the current one ready, in the background.
+void qsynthChannelsForm::warmNextPresets ( const QString& sPreset )
+{
+	if (m_pOptions == NULL || m_pEngine == NULL || m_pSynth == NULL)
+		return;
+
+	const int iCount = m_ui.PresetComboBox->count();
+	int iWarmPresets = m_pOptions->iWarmPresets;
+	if (iWarmPresets > iCount)
+		iWarmPresets = iCount;
+
+	const int iCurrent = m_ui.PresetComboBox->findText(sPreset);
+	for (int i = 1; i <= iWarmPresets; ++i) {
+		const int iItem = (iCurrent + i) % iCount;
+		if (iItem != iCurrent)
+			m_pOptions->warmPreset(m_pEngine,
+				m_ui.PresetComboBox->itemText(iItem));
+	}
+}
+
+
+// Warm presets setting change.
+void qsynthChannelsForm::warmPresetsChanged ( int iWarmPresets )
+{
+	if (m_pOptions == NULL)
+		return;
+	if (m_iDirtySetup > 0)
+		return;
+
+	m_pOptions->iWarmPresets = iWarmPresets;
+
+	warmNextPresets(m_ui.PresetComboBox->currentText());
+}
+
+
+// Preset switch latency statistics.
+void qsynthChannelsForm::addSwitchTime ( int iSwitchTime )
+{
+	if (m_switchTimes.count() < QSYNTH_CHANNELS_SWITCH_TIMES) {
+		m_switchTimes.append(iSwitchTime);
+	} else {
+		m_switchTimes[m_iSwitchTime] = iSwitchTime;
+		m_iSwitchTime = (m_iSwitchTime + 1) % QSYNTH_CHANNELS_SWITCH_TIMES;
+	}
+
+	updateSwitchTime();
+}
+
+
+void qsynthChannelsForm::updateSwitchTime (void)
+{
+	const int iCount = m_switchTimes.count();
+	if (iCount < 1) {
+		m_ui.SwitchTimeTextLabel->setText("-");
+		return;
+	}
+
+	// Nearest rank percentiles...
+	QVector<int> times(m_switchTimes);
+	std::sort(times.begin(), times.end());
+	const int iP50 = times.at((iCount * 50 + 99) / 100 - 1);
+	const int iP99 = times.at((iCount * 99 + 99) / 100 - 1);
+
+	m_ui.SwitchTimeTextLabel->setText(
+		tr("Switch: p50 %1 ms, p99 %2 ms (%3)")
+		.arg(0.001 * iP50, 0, 'f', 1)
+		.arg(0.001 * iP99, 0, 'f', 1)
+		.arg(iCount));
+}
+
+
 void qsynthChannelsForm::savePreset (void)
 {
 	if (m_pOptions == NULL || m_pEngine == NULL || m_pSynth == NULL)
@@ -523,6 +647,8 @@ void qsynthChannelsForm::stabilizeForm (void)
 		m_ui.PresetSavePushButton->setEnabled(false);
 		m_ui.PresetDeletePushButton->setEnabled(false);
 	}
+
+	m_ui.WarmPresetsSpinBox->setEnabled(m_pSynth != NULL);
 }
 
 
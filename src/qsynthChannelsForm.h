@@ -26,14 +26,18 @@
 
 #include <fluidsynth.h>
 
+#include <QElapsedTimer>
+#include <QVector>
+
 
 // Forward declarations.
 class qsynthOptions;
 class qsynthEngine;
 
-class qsynthChannelsItem;
+class qsynthChannelsModel;
 
-class QPixmap;
+class QSortFilterProxyModel;
+class QTimer;
 
 
 //----------------------------------------------------------------------------
@@ -57,15 +61,20 @@ public:
 	void resetAllChannels(bool bPreset);
 	void updateChannel(int iChan);
 
+	// Apply all pending channel changes, in one batch.
+	void flushChannels();
+
 public slots:
 
-	void itemActivated(QTreeWidgetItem*,int);
+	void itemActivated(const QModelIndex&);
 
 	void changePreset(const QString& sPreset);
 
 	void savePreset();
 	void deletePreset();
 
+	void warmPresetsChanged(int iWarmPresets);
+
 	void editSelectedChannel();
 	void unsetSelectedChannel();
 
@@ -73,6 +82,11 @@ public slots:
 
 	void contextMenuRequested(const QPoint&);
 
+protected slots:
+
+	// Retry a deferred (warm) preset switch.
+	void pendingPreset();
+
 protected:
 
 	void showEvent(QShowEvent *);
@@ -82,6 +96,19 @@ protected:
 	void stabilizeForm();
 	void resetPresets();
 
+	// Channel of some view index (-1 if none).
+	int channelOf(const QModelIndex& index) const;
+
+	// Deferred sort, once a batch is done.
+	void sortChannels();
+
+	// Get the presets next to the current one ready, in the background.
+	void warmNextPresets(const QString& sPreset);
+
+	// Preset switch latency statistics.
+	void addSwitchTime(int iSwitchTime);
+	void updateSwitchTime();
+
 private:
 
 	// The Qt-designer UI struct...
@@ -90,7 +117,8 @@ private:
 	// Instance variables.
 	int m_iChannels;
 
-	qsynthChannelsItem **m_ppChannels;
+	qsynthChannelsModel   *m_pChannelsModel;
+	QSortFilterProxyModel *m_pChannelsFilter;
 
 	qsynthOptions *m_pOptions;
 	qsynthEngine  *m_pEngine;
@@ -100,8 +128,17 @@ private:
 	int m_iDirtySetup;
 	int m_iDirtyCount;
 
-	QPixmap *m_pXpmLedOn;
-	QPixmap *m_pXpmLedOff;
+	// Pending channel preset changes.
+	int m_iDirtyChannels;
+
+	// Pending (warm) preset switch.
+	QString m_sPendingPreset;
+	QTimer *m_pPendingTimer;
+
+	// Preset switch latency samples (usecs).
+	QElapsedTimer m_switchTime;
+	QVector<int>  m_switchTimes;
+	int           m_iSwitchTime;
 };
 
 
@@ -59,17 +59,8 @@ static void drawTick(QPainter *p, float angle, int size, bool internal)
 }
 
 void 
-qsynthDialClassicStyle::drawComplexControl(ComplexControl cc, const QStyleOptionComplex *opt, QPainter *p, const QWidget *widget) const
+qsynthDialClassicStyle::drawDial(const QStyleOptionSlider *dial, QPainter *p, const QWidget */*widget*/) const
 {
-	if (cc != QStyle::CC_Dial) {
-		QCommonStyle::drawComplexControl(cc, opt, p, widget);
-		return;
-	}
-	
-	const QStyleOptionSlider *dial = qstyleoption_cast<const QStyleOptionSlider *>(opt); 
-	if (dial == NULL)
-		return;
-	
     float angle = DIAL_MIN + (DIAL_RANGE * (float(dial->sliderValue - dial->minimum) /
                    (float(dial->maximum - dial->minimum))));
 	int degrees = int(angle * 180.0 / M_PI);
@@ -80,7 +71,7 @@ qsynthDialClassicStyle::drawComplexControl(ComplexControl cc, const QStyleOption
     int width = size * scale;
     int indent = (int)(width * 0.15 + 1);
 
-	QPalette pal = opt->palette;    
+	QPalette pal = dial->palette;    
     QColor knobColor = pal.mid().color(); //pal.background().color();
     QColor meterColor = (dial->state & State_Enabled) ? pal.highlight().color() : pal.mid().color(); 
     QPen pen;
@@ -31,17 +31,19 @@
 #ifndef CLASSICTYLE_H_
 #define CLASSICTYLE_H_
 
-#include <QCommonStyle>
+#include "qsynthDialStyle.h"
 
-class qsynthDialClassicStyle : public QCommonStyle
+class qsynthDialClassicStyle : public qsynthDialStyle
 {
 public:
 	qsynthDialClassicStyle() {};
 	virtual ~qsynthDialClassicStyle() {};
 
-	virtual void drawComplexControl(ComplexControl cc, const QStyleOptionComplex *opt, QPainter *p,
-                            		const QWidget *widget = 0) const;
 
+protected:
+
+	virtual void drawDial(const QStyleOptionSlider *dial, QPainter *p,
+		const QWidget *widget) const;
 };
 
 #endif /*CLASSICTYLE_H_*/
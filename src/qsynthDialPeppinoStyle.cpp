@@ -138,17 +138,8 @@ inline void paintDot(QPainter *p, const QStyleOptionSlider *dial)
 }
 
 void
-qsynthDialPeppinoStyle::drawComplexControl(ComplexControl cc, const QStyleOptionComplex *opt, QPainter *p, const QWidget *widget) const
+qsynthDialPeppinoStyle::drawDial(const QStyleOptionSlider *dial, QPainter *p, const QWidget */*widget*/) const
 {
-	if (cc != QStyle::CC_Dial) {
-		QCommonStyle::drawComplexControl(cc, opt, p, widget);
-		return;
-	}
-
-	const QStyleOptionSlider *dial = qstyleoption_cast<const QStyleOptionSlider *>(opt);
-	if (dial == NULL)
-		return;
-
 	p->save();
 	int size = dial->rect.width() < dial->rect.height() ? dial->rect.width() : dial->rect.height();
 	p->setViewport((dial->rect.width()-size)/2, (dial->rect.height()-size)/2, size, size);
@@ -26,16 +26,19 @@
 #ifndef PEPPINOSTYLE_H_
 #define PEPPINOSTYLE_H_
 
-#include <QCommonStyle>
+#include "qsynthDialStyle.h"
 
-class qsynthDialPeppinoStyle : public QCommonStyle
+class qsynthDialPeppinoStyle : public qsynthDialStyle
 {
 public:
 	qsynthDialPeppinoStyle() {};
 	virtual ~qsynthDialPeppinoStyle() {};
 	
-	virtual void drawComplexControl(ComplexControl cc, const QStyleOptionComplex *opt, QPainter *p,
-                            		const QWidget *widget = 0) const;
+
+protected:
+
+	virtual void drawDial(const QStyleOptionSlider *dial, QPainter *p,
+		const QWidget *widget) const;
 };
 
 #endif /*PEPPINOSTYLE_H_*/
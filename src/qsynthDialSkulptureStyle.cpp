@@ -365,21 +365,10 @@ paintCachedGrip(QPainter *painter, const QStyleOption *option, QPalette::ColorRo
 }
 
 void
-qsynthDialSkulptureStyle::drawComplexControl( ComplexControl cc,
-                                              const QStyleOptionComplex *optc,
-                                              QPainter *painter,
-                                              const QWidget *widget) const
+qsynthDialSkulptureStyle::drawDial( const QStyleOptionSlider *option,
+                                    QPainter *painter,
+                                    const QWidget *widget) const
 {
-
-    if (cc != QStyle::CC_Dial) {
-        QCommonStyle::drawComplexControl(cc, optc, painter, widget);
-        return;
-    }
-
-    const QStyleOptionSlider *option = qstyleoption_cast<const QStyleOptionSlider *>(optc);
-    if (option == NULL)
-        return;
-
     int d = qMin(option->rect.width() & ~1, option->rect.height() & ~1);
     QStyleOptionSlider opt = *option;
     const QAbstractSlider *slider = NULL;
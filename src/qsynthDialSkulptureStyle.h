@@ -23,17 +23,19 @@
 #ifndef QSYNTHDIALSKULPTURESTYLE_H_
 #define QSYNTHDIALSKULPTURESTYLE_H_
 
-#include <QCommonStyle>
+#include "qsynthDialStyle.h"
 
-class qsynthDialSkulptureStyle : public QCommonStyle
+class qsynthDialSkulptureStyle : public qsynthDialStyle
 {
 public:
     qsynthDialSkulptureStyle() {};
     virtual ~qsynthDialSkulptureStyle() {};
 
-    virtual void drawComplexControl(ComplexControl cc, const QStyleOptionComplex *opt, QPainter *p,
-                                    const QWidget *widget = 0) const;
 
+protected:
+
+    virtual void drawDial(const QStyleOptionSlider *option, QPainter *painter,
+                          const QWidget *widget) const;
 };
 
 #endif /* QSYNTHDIALSKULPTURESTYLE_H_ */
@@ -0,0 +1,134 @@
+// qsynthDialStyle.cpp
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qsynthAbout.h"
+#include "qsynthDialStyle.h"
+
+#include <QStyleOptionSlider>
+#include <QAbstractSlider>
+#include <QPainter>
+
+
+// Number of angle steps rendered over the whole dial range.
+#define QSYNTH_DIAL_STEPS  128
+
+// Sprite cache size limit (in kilobytes).
+#define QSYNTH_DIAL_CACHE  8192
+
+
+//-------------------------------------------------------------------------
+// qsynthDialStyle - Knob dial style base, with a sprite cache.
+//
+
+// Constructor.
+qsynthDialStyle::qsynthDialStyle (void)
+{
+	m_sprites.setMaxCost(QSYNTH_DIAL_CACHE);
+}
+
+
+// Destructor.
+qsynthDialStyle::~qsynthDialStyle (void)
+{
+}
+
+
+// Complex control drawing, dials from the sprite cache.
+void qsynthDialStyle::drawComplexControl ( ComplexControl cc,
+	const QStyleOptionComplex *opt, QPainter *p, const QWidget *widget ) const
+{
+	if (cc != QStyle::CC_Dial) {
+		QCommonStyle::drawComplexControl(cc, opt, p, widget);
+		return;
+	}
+
+	const QStyleOptionSlider *dial
+		= qstyleoption_cast<const QStyleOptionSlider *> (opt);
+	if (dial == NULL)
+		return;
+
+#if QT_VERSION >= 0x050600
+	const qreal dpr = p->device()->devicePixelRatioF();
+#elif QT_VERSION >= 0x050000
+	const qreal dpr = p->device()->devicePixelRatio();
+#else
+	const qreal dpr = 1.0;
+#endif
+
+	// Too small, too large or no range at all? Draw it directly...
+	const int w = dial->rect.width();
+	const int h = dial->rect.height();
+	const int iRange = dial->maximum - dial->minimum;
+	const int iCost = (qRound(w * dpr) * qRound(h * dpr) * 4) >> 10;
+	if (w < 1 || h < 1 || iRange < 1 || iCost >= QSYNTH_DIAL_CACHE) {
+		drawDial(dial, p, widget);
+		return;
+	}
+
+	// Quantize the value into the nearest angle step...
+	const int iSteps = (iRange < QSYNTH_DIAL_STEPS ? iRange : QSYNTH_DIAL_STEPS);
+	const int iStep = ((dial->sliderValue - dial->minimum) * iSteps
+		+ (iRange >> 1)) / iRange;
+	const int iValue = dial->minimum + (iStep * iRange + (iSteps >> 1)) / iSteps;
+
+	// Whether being dragged (some styles highlight it so).
+	const QAbstractSlider *pSlider
+		= qobject_cast<const QAbstractSlider *> (widget);
+	const bool bSliderDown = (pSlider && pSlider->isSliderDown());
+
+	const uint iState = uint(dial->state) & (QStyle::State_Enabled
+		| QStyle::State_Active | QStyle::State_HasFocus
+		| QStyle::State_MouseOver | QStyle::State_Sunken
+		| QStyle::State_KeyboardFocusChange);
+
+	QString sKey;
+	sKey.sprintf("%dx%d@%d-%llx-%x-%x-%d:%d:%d:%d:%d:%d:%d:%d-%d/%d",
+		w, h, int(100.0 * dpr), dial->palette.cacheKey(),
+		iState | (bSliderDown ? 0x80000000 : 0), uint(dial->subControls),
+		int(dial->direction), dial->minimum, dial->maximum,
+		dial->tickInterval, dial->pageStep, dial->singleStep,
+		int(dial->notchTarget), int(dial->upsideDown) | (int(dial->dialWrapping) << 1),
+		dial->fontMetrics.height(), iStep, iSteps);
+
+	QPixmap *pSprite = m_sprites.object(sKey);
+	if (pSprite == NULL) {
+		// Render the sprite right away...
+		pSprite = new QPixmap(qRound(w * dpr), qRound(h * dpr));
+	#if QT_VERSION >= 0x050000
+		pSprite->setDevicePixelRatio(dpr);
+	#endif
+		pSprite->fill(Qt::transparent);
+		QStyleOptionSlider opt2(*dial);
+		opt2.rect = QRect(0, 0, w, h);
+		opt2.sliderValue = iValue;
+		opt2.sliderPosition = iValue;
+		QPainter painter(pSprite);
+		painter.setFont(p->font());
+		drawDial(&opt2, &painter, widget);
+		painter.end();
+		m_sprites.insert(sKey, pSprite, (iCost > 0 ? iCost : 1));
+	}
+
+	p->drawPixmap(dial->rect.topLeft(), *pSprite);
+}
+
+
+// end of qsynthDialStyle.cpp
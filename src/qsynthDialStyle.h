@@ -0,0 +1,73 @@
+// qsynthDialStyle.h
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qsynthDialStyle_h
+#define __qsynthDialStyle_h
+
+#include <QCommonStyle>
+#include <QPixmap>
+#include <QCache>
+
+
+// Forward declarations.
+class QStyleOptionSlider;
+
+
+//-------------------------------------------------------------------------
+// qsynthDialStyle - Knob dial style base, with a sprite cache.
+//
+// Each dial is rendered once per size, device pixel ratio, palette,
+// state and angle step, into a sprite that gets blitted from then on;
+// sprites go away along with the style itself (ie. on style change)
+// or else when least recently used, while palette changes just make
+// for different sprites.
+
+class qsynthDialStyle : public QCommonStyle
+{
+public:
+
+	// Constructor.
+	qsynthDialStyle();
+	// Destructor.
+	virtual ~qsynthDialStyle();
+
+	// Complex control drawing, dials from the sprite cache.
+	virtual void drawComplexControl(ComplexControl cc,
+		const QStyleOptionComplex *opt, QPainter *p,
+		const QWidget *widget = 0) const;
+
+protected:
+
+	// Actual dial drawing (cache miss), to be implemented by each style.
+	virtual void drawDial(const QStyleOptionSlider *dial, QPainter *p,
+		const QWidget *widget) const = 0;
+
+private:
+
+	// Sprite cache (GUI thread only).
+	mutable QCache<QString, QPixmap> m_sprites;
+};
+
+
+#endif  // __qsynthDialStyle_h
+
+
+// end of qsynthDialStyle.h
@@ -35,18 +35,8 @@
 #define DIAL_RANGE    (DIAL_MAX - DIAL_MIN)
 
 void 
-qsynthDialVokiStyle::drawComplexControl(ComplexControl cc, const QStyleOptionComplex *opt, QPainter *p, const QWidget *widget) const
+qsynthDialVokiStyle::drawDial(const QStyleOptionSlider *dial, QPainter *p, const QWidget */*widget*/) const
 {
-	if (cc != QStyle::CC_Dial)
-	{
-		QCommonStyle::drawComplexControl(cc, opt, p, widget);
-		return;
-	}
-	
-	const QStyleOptionSlider *dial = qstyleoption_cast<const QStyleOptionSlider *>(opt); 
-	if (dial == NULL)
-		return;
-	
 	double angle = DIAL_MIN // offset
 		+ (DIAL_RANGE *
 			(double(dial->sliderValue - dial->minimum) /
@@ -69,7 +59,7 @@ qsynthDialVokiStyle::drawComplexControl(ComplexControl cc, const QStyleOptionCom
 	int shadowShift = shineCenter * 2;
 	int meterWidth = side - 2 * scaleShadowWidth;
 	
-	QPalette pal = opt->palette;
+	QPalette pal = dial->palette;
 	QColor knobColor = pal.mid().color();
 	QColor borderColor = knobColor.light();
 	QColor meterColor = (dial->state & State_Enabled) ? 
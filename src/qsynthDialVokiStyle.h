@@ -25,17 +25,19 @@
 #ifndef VOKISTYLE_H_
 #define VOKISTYLE_H_
 
-#include <QCommonStyle>
+#include "qsynthDialStyle.h"
 
-class qsynthDialVokiStyle : public QCommonStyle
+class qsynthDialVokiStyle : public qsynthDialStyle
 {
 public:
 	qsynthDialVokiStyle() {};
 	virtual ~qsynthDialVokiStyle() {};
 	
-    virtual void drawComplexControl(ComplexControl cc, const QStyleOptionComplex *opt, QPainter *p,
-                            		const QWidget *widget = 0) const;
-	
+
+protected:
+
+	virtual void drawDial(const QStyleOptionSlider *dial, QPainter *p,
+		const QWidget *widget) const;
 };
 
 #endif /*VOKISTYLE_H_*/
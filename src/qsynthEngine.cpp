@@ -19,7 +19,33 @@
 
 *****************************************************************************/
 
+#include "qsynthAbout.h"
 #include "qsynthEngine.h"
+#include "qsynthLevels.h"
+
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <string.h>
+#include <math.h>
+
+#include <new>
+
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(WIN32)
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+
+// MIDI event types and controllers of interest, for channel activity.
+#define QSYNTH_MIDI_NOTE_OFF            0x80
+#define QSYNTH_MIDI_NOTE_ON             0x90
+#define QSYNTH_MIDI_CONTROL_CHANGE      0xb0
+#define QSYNTH_MIDI_PROGRAM_CHANGE      0xc0
+
+#define QSYNTH_MIDI_CC_BANK_SELECT_MSB  0x00
+#define QSYNTH_MIDI_CC_BANK_SELECT_LSB  0x20
+#define QSYNTH_MIDI_CC_ALL_SOUND_OFF    0x78
 
 
 //-------------------------------------------------------------------------
@@ -48,18 +74,106 @@ qsynthEngine::qsynthEngine ( qsynthOptions *pOptions, const QString& sName )
 	pPlayer      = NULL;
 	pServer      = NULL;
 
+	pSoundFontLoader = NULL;
+
+	m_state  = Stopped;
+	bRestart = false;
+
+	bProcess   = false;
+	pSwapSynth = NULL;
+
+	pDriverSettings  = NULL;
+	pRetiredSettings = NULL;
+
+	m_pProcessSynth = NULL;
+	m_pFadeSynth    = NULL;
+	m_iFadeFrames   = 0;
+	m_iFadePos      = 0;
+	m_pfFadeBuffer  = NULL;
+	m_pOldSynth     = NULL;
+
+	for (int i = 0; i < QSYNTH_ENGINE_MAX_PORTS; ++i)
+		m_ppFadeBuffers[i] = NULL;
+
 	iMidiEvent = 0;
 	iMidiState = 0;
 
-	bMeterEnabled  = false;
-	fMeterValue[0] = 0.0f;
-	fMeterValue[1] = 0.0f;
+	bMeterEnabled = false;
+	iMeterPorts   = 2;
+	iMeterVoices  = 0;
+
+	for (int i = 0; i < QSYNTH_ENGINE_MAX_PORTS; ++i) {
+		fMeterValue[i] = 0.0f;
+		fMeterRms[i]   = 0.0f;
+	}
+
+	::memset(&m_pending, 0, sizeof(m_pending));
+	m_iMidiEventsLast = 0;
+
+	::memset(&m_drained, 0, sizeof(m_drained));
+	m_bDrained = false;
+
+	m_pChannelsAlloc = NULL;
+	m_pChannels = NULL;
+	m_iChannels = 0;
+
+	::memset(m_trackers, 0, sizeof(m_trackers));
+	m_iChannelsOn = 0;
+
+	m_pMidiTap = NULL;
+	m_midiTapTime.start();
+
+	// Activity wakeup self-pipe...
+	m_fdWakeup[0] = m_fdWakeup[1] = -1;
+	m_pWakeupNotifier = NULL;
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(WIN32)
+	if (::pipe(m_fdWakeup) == 0) {
+		::fcntl(m_fdWakeup[0], F_SETFL,
+			::fcntl(m_fdWakeup[0], F_GETFL) | O_NONBLOCK);
+		::fcntl(m_fdWakeup[1], F_SETFL,
+			::fcntl(m_fdWakeup[1], F_GETFL) | O_NONBLOCK);
+		m_pWakeupNotifier = new QSocketNotifier(
+			m_fdWakeup[0], QSocketNotifier::Read, this);
+		QObject::connect(m_pWakeupNotifier,
+			SIGNAL(activated(int)),
+			SLOT(wakeupNotifySlot()));
+	} else {
+		m_fdWakeup[0] = m_fdWakeup[1] = -1;
+	}
+#endif
+	// No self-pipe: poll the wakeup flag instead, while armed...
+	m_pWakeupTimer = NULL;
+	if (m_pWakeupNotifier == NULL) {
+		m_pWakeupTimer = new QTimer(this);
+		QObject::connect(m_pWakeupTimer,
+			SIGNAL(timeout()),
+			SLOT(wakeupTimerSlot()));
+	}
 }
 
 
 // Default destructor.
 qsynthEngine::~qsynthEngine (void)
 {
+	if (m_pfFadeBuffer)
+		delete [] m_pfFadeBuffer;
+
+	setMidiChannels(0);
+
+	if (m_pMidiTap)
+		delete m_pMidiTap;
+
+	if (m_pWakeupNotifier)
+		delete m_pWakeupNotifier;
+	if (m_pWakeupTimer)
+		delete m_pWakeupTimer;
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(WIN32)
+	if (m_fdWakeup[0] >= 0)
+		::close(m_fdWakeup[0]);
+	if (m_fdWakeup[1] >= 0)
+		::close(m_fdWakeup[1]);
+#endif
+
 	if (!m_bDefault && m_pSetup) {
 		delete m_pSetup;
 		m_pSetup = NULL;
@@ -91,4 +205,691 @@ void qsynthEngine::setName ( const QString& sName )
 }
 
 
+// Engine lifecycle state accessors (GUI thread).
+qsynthEngine::State qsynthEngine::state (void) const
+{
+	return m_state;
+}
+
+void qsynthEngine::setState ( State state )
+{
+	if (m_state == state)
+		return;
+
+	m_state = state;
+
+	emit stateChanged(int(m_state));
+
+	if (m_state == Running)
+		emit started();
+	else
+	if (m_state == Stopped)
+		emit stopped();
+}
+
+
+// Whether in transition (neither stopped nor running).
+bool qsynthEngine::isBusy (void) const
+{
+	return (m_state != Stopped && m_state != Running);
+}
+
+
+// Audio process callback (audio thread).
+int qsynthEngine::process (
+	int nframes, int nin, float **in, int nout, float **out )
+{
+	// Any new synth to take over?
+	fluid_synth_t *pNextSynth = m_pNextSynth.fetchAndStoreAcquire(NULL);
+	if (pNextSynth) {
+		m_pFadeSynth    = m_pProcessSynth;
+		m_pProcessSynth = pNextSynth;
+		m_iFadePos      = 0;
+		if (m_pFadeSynth == NULL || nout > QSYNTH_ENGINE_MAX_PORTS) {
+			m_pFadeSynth = NULL;
+			m_iFadeDone.storeRelease(1);
+		}
+	}
+
+	// Call the synthesizer process function to fill
+	// the output buffers with its audio output.
+	if (::fluid_synth_process(m_pProcessSynth, nframes, nin, in, nout, out) != 0)
+		return -1;
+
+	// Fade out the old synth on top, if any...
+	if (m_pFadeSynth) {
+		const float fDelta = 1.0f / float(m_iFadeFrames);
+		int iOffset = 0;
+		while (iOffset < nframes && m_iFadePos < m_iFadeFrames) {
+			int iFrames = nframes - iOffset;
+			if (iFrames > QSYNTH_ENGINE_FADE_CHUNK)
+				iFrames = QSYNTH_ENGINE_FADE_CHUNK;
+			if (iFrames > m_iFadeFrames - m_iFadePos)
+				iFrames = m_iFadeFrames - m_iFadePos;
+			::fluid_synth_process(m_pFadeSynth,
+				iFrames, 0, NULL, nout, m_ppFadeBuffers);
+			const float fGain0 = 1.0f - fDelta * float(m_iFadePos);
+			for (int i = 0; i < nout; ++i) {
+				float *pOut = out[i] + iOffset;
+				const float *pFade = m_ppFadeBuffers[i];
+				float fGain = fGain0;
+				for (int j = 0; j < iFrames; ++j) {
+					pOut[j] += fGain * pFade[j];
+					fGain -= fDelta;
+				}
+			}
+			iOffset    += iFrames;
+			m_iFadePos += iFrames;
+		}
+		if (m_iFadePos >= m_iFadeFrames) {
+			m_pFadeSynth = NULL;
+			m_iFadeDone.storeRelease(1);
+		}
+	}
+
+	// Now publish the levels for this buffer run...
+	if (bMeterEnabled)
+		processMeter(nframes, nout, out);
+
+	return 0;
+}
+
+
+// Reset the audio process state, before the audio driver gets created
+// or after it's gone (GUI thread).
+void qsynthEngine::resetProcess (void)
+{
+	m_pNextSynth    = NULL;
+	m_iFadeDone     = 0;
+	m_pMidiSynth.fetchAndStoreOrdered(pSynth);
+	m_pProcessSynth = pSynth;
+	m_pFadeSynth    = NULL;
+	m_iFadePos      = 0;
+}
+
+
+// Seamless restart: the new synth takes over on the very next
+// audio buffer, while the current one fades out (GUI thread).
+void qsynthEngine::swapSynth ( fluid_synth_t *pNewSynth, int iFadeFrames )
+{
+	if (m_pfFadeBuffer == NULL) {
+		m_pfFadeBuffer = new float [QSYNTH_ENGINE_MAX_PORTS
+			* QSYNTH_ENGINE_FADE_CHUNK];
+		for (int i = 0; i < QSYNTH_ENGINE_MAX_PORTS; ++i)
+			m_ppFadeBuffers[i] = m_pfFadeBuffer + i * QSYNTH_ENGINE_FADE_CHUNK;
+	}
+
+	m_pOldSynth   = pSynth;
+	m_iFadeFrames = (iFadeFrames > 0 ? iFadeFrames : 1);
+	m_iFadeDone   = 0;
+
+	pSynth = pNewSynth;
+
+	m_pNextSynth.storeRelease(pNewSynth);
+	m_pMidiSynth.fetchAndStoreOrdered(pNewSynth);
+}
+
+
+bool qsynthEngine::isSwapping (void) const
+{
+	return (m_pOldSynth != NULL);
+}
+
+
+// The old synth, once faded out, or right away when forced (only
+// when the audio driver is gone); ownership goes to the caller.
+fluid_synth_t *qsynthEngine::retiredSynth ( bool bForce )
+{
+	if (m_pOldSynth == NULL)
+		return NULL;
+	if (!bForce && m_iFadeDone.loadAcquire() == 0)
+		return NULL;
+	// Any MIDI event still in flight may well be on the old synth...
+	if (!bForce && m_iMidiBusy.fetchAndAddOrdered(0) > 0)
+		return NULL;
+
+	fluid_synth_t *pOldSynth = m_pOldSynth;
+	m_pOldSynth = NULL;
+
+	if (bForce)
+		resetProcess();
+
+	return pOldSynth;
+}
+
+
+// MIDI router output (MIDI thread), on to the current synth; the
+// in-flight count is raised before the synth gets picked, so that
+// once it's seen back to zero after a swap (GUI thread), no event
+// can be on the old synth anymore.
+int qsynthEngine::handleMidiEvent ( fluid_midi_event_t *pMidiEvent )
+{
+	m_iMidiBusy.ref();
+
+	fluid_synth_t *pMidiSynth = m_pMidiSynth.loadAcquire();
+	const int iResult = (pMidiSynth
+		? ::fluid_synth_handle_midi_event(pMidiSynth, pMidiEvent)
+		: FLUID_FAILED);
+
+	m_iMidiBusy.deref();
+
+	return iResult;
+}
+
+
+// Channel state snapshot (bank/program, controllers, pitch bend).
+void qsynthEngine::saveChannels (
+	fluid_synth_t *pSynth, QVector<ChannelState>& channels )
+{
+	channels.clear();
+
+	const int iChannels = ::fluid_synth_count_midi_channels(pSynth);
+	for (int iChan = 0; iChan < iChannels; ++iChan) {
+		ChannelState state;
+		::memset(&state, 0, sizeof(state));
+		state.iChan = iChan;
+	#ifdef CONFIG_FLUID_CHANNEL_INFO
+		fluid_synth_channel_info_t info;
+		::memset(&info, 0, sizeof(info));
+		::fluid_synth_get_channel_info(pSynth, iChan, &info);
+		if (info.assigned) {
+			state.bPreset = true;
+			state.iBank = info.bank;
+		#ifdef CONFIG_FLUID_BANK_OFFSET
+			state.iBank += ::fluid_synth_get_bank_offset(pSynth, info.sfont_id);
+		#endif
+			state.iProg = info.program;
+		}
+	#else
+		fluid_preset_t *pPreset = ::fluid_synth_get_channel_preset(pSynth, iChan);
+		if (pPreset) {
+			state.bPreset = true;
+			state.iBank = pPreset->get_banknum(pPreset);
+		#ifdef CONFIG_FLUID_BANK_OFFSET
+			state.iBank += ::fluid_synth_get_bank_offset(pSynth, (pPreset->sfont)->id);
+		#endif
+			state.iProg = pPreset->get_num(pPreset);
+		}
+	#endif
+		for (int iCC = 0; iCC < 128; ++iCC)
+			::fluid_synth_get_cc(pSynth, iChan, iCC, &state.aiCC[iCC]);
+		::fluid_synth_get_pitch_bend(pSynth, iChan, &state.iPitchBend);
+		channels.append(state);
+	}
+}
+
+
+void qsynthEngine::loadChannels (
+	fluid_synth_t *pSynth, const QVector<ChannelState>& channels )
+{
+	const int iChannels = ::fluid_synth_count_midi_channels(pSynth);
+
+	QVectorIterator<ChannelState> iter(channels);
+	while (iter.hasNext()) {
+		const ChannelState& state = iter.next();
+		if (state.iChan >= iChannels || !state.bPreset)
+			continue;
+		::fluid_synth_bank_select(pSynth, state.iChan, state.iBank);
+		::fluid_synth_program_change(pSynth, state.iChan, state.iProg);
+	}
+
+	// Recommended to post-stabilize things around.
+	::fluid_synth_program_reset(pSynth);
+
+	iter.toFront();
+	while (iter.hasNext()) {
+		const ChannelState& state = iter.next();
+		if (state.iChan >= iChannels)
+			continue;
+		// Skip bank selects, (N)RPN and data entry, and channel modes...
+		for (int iCC = 1; iCC < 120; ++iCC) {
+			if (iCC == 6 || iCC == 32 || iCC == 38 || (iCC >= 96 && iCC <= 101))
+				continue;
+			::fluid_synth_cc(pSynth, state.iChan, iCC, state.aiCC[iCC]);
+		}
+		::fluid_synth_pitch_bend(pSynth, state.iChan, state.iPitchBend);
+	}
+}
+
+
+// Preset catalogue, built on demand (GUI thread).
+const qsynthPresetIndex& qsynthEngine::presetIndex (void)
+{
+	if (!m_presetIndex.isValid(pSynth))
+		m_presetIndex.build(pSynth);
+
+	return m_presetIndex;
+}
+
+
+// Invalidate it, whenever the soundfont stack changes.
+void qsynthEngine::resetPresetIndex (void)
+{
+	m_presetIndex.clear();
+}
+
+
+// Telemetry producer: publish a frame on each audio buffer run
+// (audio thread; must never block nor allocate).
+void qsynthEngine::processMeter ( int nframes, int nout, float **out )
+{
+	qsynthEngineFrame& frame = m_pending;
+
+	int nports = nout;
+	if (nports > QSYNTH_ENGINE_MAX_PORTS)
+		nports = QSYNTH_ENGINE_MAX_PORTS;
+	if (frame.iPorts < nports)
+		frame.iPorts = nports;
+
+	// Absolute peak and sum of squares, all buffers in one go...
+	qsynth_levels(nout, out, nframes, nports, frame.fPeak, frame.fSumSq);
+	for (int i = 0; i < nout; ++i)
+		frame.iSamples[i % nports] += nframes;
+
+	const int iMidiEvents = m_iMidiEvents.load();
+	frame.iMidiEvents += iMidiEvents - m_iMidiEventsLast;
+	m_iMidiEventsLast  = iMidiEvents;
+
+	// Wake up the GUI on audible output, if armed...
+	if (m_iWakeupMeter.load()) {
+		for (int i = 0; i < frame.iPorts; ++i) {
+			if (frame.fPeak[i] > QSYNTH_ENGINE_WAKEUP_PEAK) {
+				if (m_iWakeupMeter.testAndSetOrdered(1, 0))
+					notifyWakeup();
+				break;
+			}
+		}
+	}
+
+	// Whenever the ring is full, keep accumulating
+	// on the pending frame, so that no peak gets lost...
+	if (m_frames.write(frame))
+		::memset(&m_pending, 0, sizeof(m_pending));
+}
+
+
+// Telemetry consumer: merge all frames published so far
+// (GUI thread); returns false if there was none.
+bool qsynthEngine::drainMeter ( qsynthEngineFrame& frame )
+{
+	// Start off from those drained ahead of time, if any...
+	bool bDrain = m_bDrained;
+	if (bDrain)
+		frame = m_drained;
+	else
+		::memset(&frame, 0, sizeof(frame));
+	m_bDrained = false;
+
+	qsynthEngineFrame item;
+	while (m_frames.read(item)) {
+		if (frame.iPorts < item.iPorts)
+			frame.iPorts = item.iPorts;
+		for (int i = 0; i < item.iPorts; ++i) {
+			if (frame.fPeak[i] < item.fPeak[i])
+				frame.fPeak[i] = item.fPeak[i];
+			frame.fSumSq[i]   += item.fSumSq[i];
+			frame.iSamples[i] += item.iSamples[i];
+		}
+		frame.iMidiEvents += item.iMidiEvents;
+		bDrain = true;
+	}
+
+	return bDrain;
+}
+
+
+// Drain and update current peak and RMS levels (GUI thread);
+// returns false if nothing was published since last time.
+bool qsynthEngine::updateMeter (void)
+{
+	qsynthEngineFrame frame;
+	const bool bDrain = drainMeter(frame);
+	if (bDrain) {
+		if (frame.iPorts > 0)
+			iMeterPorts = frame.iPorts;
+		// Voice count is queried here, as it takes the synth API
+		// lock, which the audio thread must never wait on...
+		if (pSynth)
+			iMeterVoices = ::fluid_synth_get_active_voice_count(pSynth);
+	}
+
+	for (int i = 0; i < iMeterPorts; ++i) {
+		fMeterValue[i] = frame.fPeak[i];
+		fMeterRms[i] = (frame.iSamples[i] > 0
+			? ::sqrtf(frame.fSumSq[i] / float(frame.iSamples[i])) : 0.0f);
+	}
+
+	return bDrain;
+}
+
+
+// Discard any stale frames (GUI thread).
+void qsynthEngine::resetMeter (void)
+{
+	m_frames.flush();
+	m_bDrained = false;
+
+	for (int i = 0; i < QSYNTH_ENGINE_MAX_PORTS; ++i) {
+		fMeterValue[i] = 0.0f;
+		fMeterRms[i]   = 0.0f;
+	}
+
+	iMeterVoices = 0;
+}
+
+
+// MIDI channel activity counters allocation, as many as the synth
+// MIDI channels (GUI thread; only while there's no MIDI thread).
+void qsynthEngine::setMidiChannels ( int iChannels )
+{
+	if (iChannels > QSYNTH_ENGINE_MAX_CHANNELS)
+		iChannels = QSYNTH_ENGINE_MAX_CHANNELS;
+	if (iChannels < 0)
+		iChannels = 0;
+
+	if (iChannels == m_iChannels)
+		return;
+
+	if (m_pChannels) {
+		for (int i = 0; i < m_iChannels; ++i)
+			m_pChannels[i].~qsynthEngineChannel();
+		delete [] m_pChannelsAlloc;
+		m_pChannelsAlloc = NULL;
+		m_pChannels = NULL;
+	}
+
+	m_iChannels = iChannels;
+
+	if (m_iChannels > 0) {
+		// Over-allocate and align by hand: plain new won't do it.
+		m_pChannelsAlloc = new char [m_iChannels * sizeof(qsynthEngineChannel)
+			+ QSYNTH_ENGINE_CACHE_LINE - 1];
+		const quintptr p = quintptr(m_pChannelsAlloc);
+		m_pChannels = reinterpret_cast<qsynthEngineChannel *> (
+			(p + QSYNTH_ENGINE_CACHE_LINE - 1)
+			& ~quintptr(QSYNTH_ENGINE_CACHE_LINE - 1));
+		for (int i = 0; i < m_iChannels; ++i)
+			new (&m_pChannels[i]) qsynthEngineChannel();
+	}
+
+	::memset(m_trackers, 0, sizeof(m_trackers));
+	m_iChannelsOn = 0;
+}
+
+
+int qsynthEngine::midiChannels (void) const
+{
+	return m_iChannels;
+}
+
+
+// MIDI channel activity tracker (MIDI thread).
+void qsynthEngine::midiChannelEvent ( fluid_midi_event_t *pMidiEvent )
+{
+	const int iChan = ::fluid_midi_event_get_channel(pMidiEvent);
+	if (iChan < 0 || iChan >= m_iChannels)
+		return;
+
+	qsynthEngineChannel& channel = m_pChannels[iChan];
+
+	switch (::fluid_midi_event_get_type(pMidiEvent)) {
+	case QSYNTH_MIDI_CONTROL_CHANGE: {
+		// Avoid bank selects or global control changes...
+		const int iCC = ::fluid_midi_event_get_control(pMidiEvent);
+		if (iCC == QSYNTH_MIDI_CC_BANK_SELECT_MSB ||
+			iCC == QSYNTH_MIDI_CC_BANK_SELECT_LSB ||
+			iCC >= QSYNTH_MIDI_CC_ALL_SOUND_OFF)
+			break;
+	}	// Fall thru...
+	case QSYNTH_MIDI_PROGRAM_CHANGE:
+		channel.iChanges.ref();
+		// Fall thru...
+	case QSYNTH_MIDI_NOTE_ON:
+	case QSYNTH_MIDI_NOTE_OFF:
+		channel.iEvents.ref();
+		break;
+	}
+}
+
+
+// MIDI channel activity breakout (GUI thread);
+// returns the channel state changes since last call.
+int qsynthEngine::updateMidiChannel ( int iChan )
+{
+	if (iChan < 0 || iChan >= m_iChannels)
+		return 0;
+
+	const qsynthEngineChannel& channel = m_pChannels[iChan];
+	ChannelTracker& tracker = m_trackers[iChan];
+
+	int iFlags = 0;
+
+	const int iEvent = channel.iEvents.load();
+	if (iEvent != tracker.iEvent) {
+		tracker.iEvent = iEvent;
+		// Activity tracking...
+		if (tracker.iState == 0) {
+			tracker.iState++;
+			m_iChannelsOn++;
+			iFlags |= ChannelOn;
+		}
+		// Control and/or program change...
+		const int iChange = channel.iChanges.load();
+		if (iChange != tracker.iChange) {
+			tracker.iChange = iChange;
+			iFlags |= ChannelChange;
+		}
+	}   // Activity fallback...
+	else if (tracker.iState > 0) {
+		if (--tracker.iState == 0) {
+			m_iChannelsOn--;
+			iFlags |= ChannelOff;
+		}
+	}
+
+	return iFlags;
+}
+
+
+bool qsynthEngine::isMidiChannelOn ( int iChan ) const
+{
+	if (iChan < 0 || iChan >= m_iChannels)
+		return false;
+
+	return (m_trackers[iChan].iState > 0);
+}
+
+
+int qsynthEngine::midiChannelsOn (void) const
+{
+	return m_iChannelsOn;
+}
+
+
+// Arm a one-shot wakeup() on the next MIDI event and/or on the
+// next audible output (GUI thread; disarmed with false/false).
+void qsynthEngine::setWakeup ( bool bMidi, bool bMeter )
+{
+	m_iWakeupMidi.store(bMidi ? 1 : 0);
+	m_iWakeupMeter.store(bMeter ? 1 : 0);
+
+	// No self-pipe: only poll while armed...
+	if (m_pWakeupTimer) {
+		m_iWakeupPosted.store(0);
+		if (bMidi || bMeter)
+			m_pWakeupTimer->start(QSYNTH_ENGINE_WAKEUP_MSECS);
+		else
+			m_pWakeupTimer->stop();
+	}
+}
+
+
+// Whether there's been any activity the armed wakeup may have
+// missed, ie. since last update and just before arming it (GUI thread).
+bool qsynthEngine::isWakeupPending (void)
+{
+	// Any MIDI events, if armed?
+	if (m_iWakeupMidi.load()) {
+		if (midiEvents() != iMidiEvent)
+			return true;
+		for (int iChan = 0; iChan < m_iChannels; ++iChan) {
+			if (m_pChannels[iChan].iEvents.load() != m_trackers[iChan].iEvent)
+				return true;
+		}
+	}
+
+	// Any audible output, if armed? Keep the drained frames for later...
+	if (m_iWakeupMeter.load() && drainMeter(m_drained)) {
+		m_bDrained = true;
+		for (int i = 0; i < m_drained.iPorts; ++i) {
+			if (m_drained.fPeak[i] > QSYNTH_ENGINE_WAKEUP_PEAK)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+
+// Activity wakeup poster (audio or MIDI thread).
+void qsynthEngine::notifyWakeup (void)
+{
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(WIN32)
+	if (m_fdWakeup[1] >= 0) {
+		// Never mind when full: a wakeup is pending anyway...
+		const char c = 1;
+		const ssize_t n = ::write(m_fdWakeup[1], &c, sizeof(c));
+		Q_UNUSED(n);
+		return;
+	}
+#endif
+	// No self-pipe: just raise the flag, to be polled...
+	m_iWakeupPosted.storeRelease(1);
+}
+
+
+// Activity wakeup self-pipe reader (GUI thread).
+void qsynthEngine::wakeupNotifySlot (void)
+{
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(WIN32)
+	char buf[64];
+	while (::read(m_fdWakeup[0], buf, sizeof(buf)) > 0)
+		;
+#endif
+	emit wakeup();
+}
+
+
+// Activity wakeup flag poller (GUI thread).
+void qsynthEngine::wakeupTimerSlot (void)
+{
+	if (m_iWakeupPosted.loadAcquire() == 0)
+		return;
+
+	m_iWakeupPosted.store(0);
+	m_pWakeupTimer->stop();
+
+	emit wakeup();
+}
+
+
+// MIDI event tap (MIDI thread -> GUI), on demand.
+void qsynthEngine::setMidiTap ( bool bMidiTap )
+{
+	if (bMidiTap && !isMidiTap()) {
+		// Kept once allocated, the MIDI thread might still be at it...
+		if (m_pMidiTap == NULL)
+			m_pMidiTap = new qsynthRingBuffer<qsynthMidiTapEvent> (
+				QSYNTH_ENGINE_MIDI_TAP);
+		else
+			m_pMidiTap->flush();
+	}
+
+	m_iMidiTap.storeRelease(bMidiTap ? 1 : 0);
+}
+
+
+// MIDI event tap producer (MIDI thread).
+void qsynthEngine::midiTap ( fluid_midi_event_t *pMidiEvent )
+{
+	if (m_pMidiTap == NULL)
+		return;
+
+	qsynthMidiTapEvent event;
+	event.iTime   = m_midiTapTime.nsecsElapsed() / 1000;
+	event.type    = (unsigned char) ::fluid_midi_event_get_type(pMidiEvent);
+	event.channel = (unsigned char) ::fluid_midi_event_get_channel(pMidiEvent);
+	event.param1  = (unsigned short) ::fluid_midi_event_get_control(pMidiEvent);
+	event.param2  = ::fluid_midi_event_get_value(pMidiEvent);
+
+	if (!m_pMidiTap->write(event))
+		m_iMidiTapDropped.ref();
+}
+
+
+// MIDI event tap consumer (GUI thread).
+bool qsynthEngine::drainMidiTap ( qsynthMidiTapEvent& event )
+{
+	return (m_pMidiTap ? m_pMidiTap->read(event) : false);
+}
+
+
+int qsynthEngine::midiTapReadable (void) const
+{
+	return (m_pMidiTap ? int(m_pMidiTap->readable()) : 0);
+}
+
+
+int qsynthEngine::midiTapDropped (void) const
+{
+	return m_iMidiTapDropped.load();
+}
+
+
+// MIDI event tap record decoders.
+QString qsynthEngine::midiTapType ( const qsynthMidiTapEvent& event )
+{
+	switch (event.type) {
+	case 0x80:
+		return tr("Note off");
+	case 0x90:
+		return tr("Note on");
+	case 0xa0:
+		return tr("Key pressure");
+	case 0xb0:
+		return tr("Controller");
+	case 0xc0:
+		return tr("Program change");
+	case 0xd0:
+		return tr("Channel pressure");
+	case 0xe0:
+		return tr("Pitch bend");
+	default:
+		return QString("0x%1").arg(int(event.type), 2, 16, QChar('0'));
+	}
+}
+
+
+QString qsynthEngine::midiTapText ( const qsynthMidiTapEvent& event )
+{
+	QString sText = QString("%1.%2 ")
+		.arg(event.iTime / 1000000)
+		.arg(event.iTime % 1000000, 6, 10, QChar('0'));
+	sText += tr("ch=%1").arg(int(event.channel) + 1) + ' ';
+	sText += midiTapType(event) + ' ';
+	sText += QString::number(event.param1);
+	switch (event.type) {
+	case 0x80:
+	case 0x90:
+	case 0xa0:
+	case 0xb0:
+		sText += ' ' + QString::number(event.param2);
+		break;
+	default:
+		break;
+	}
+	return sText;
+}
+
+
 // end of qsynthEngine.cpp
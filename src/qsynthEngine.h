@@ -24,13 +24,96 @@
 
 #include "qsynthOptions.h"
 
+#include "qsynthRingBuffer.h"
+#include "qsynthPresetIndex.h"
+
+#include <QObject>
+#include <QVector>
+#include <QElapsedTimer>
+
+
+// Forward declarations.
+class qsynthSoundFontLoader;
+
+class QSocketNotifier;
+class QTimer;
+
+
+// Maximum number of metered output ports (buffers beyond wrap around).
+#define QSYNTH_ENGINE_MAX_PORTS 32
+
+// Seamless restart fade-out length (msecs) and chunk size (frames).
+#define QSYNTH_ENGINE_FADE_MSECS 200
+#define QSYNTH_ENGINE_FADE_CHUNK 1024
+
+// MIDI event tap ring size (events).
+#define QSYNTH_ENGINE_MIDI_TAP 16384
+
+// Maximum number of MIDI channels tracked for activity
+// (as many as synth.midi-channels, up to this).
+#define QSYNTH_ENGINE_MAX_CHANNELS 256
+
+// Assumed cache line size (bytes).
+#define QSYNTH_ENGINE_CACHE_LINE 64
+
+// Output peak level (linear) above which the GUI gets a wakeup.
+#define QSYNTH_ENGINE_WAKEUP_PEAK 0.001f
+
+// Activity wakeup poll period (msecs; only where there's no self-pipe).
+#define QSYNTH_ENGINE_WAKEUP_MSECS 100
+
+
+//-------------------------------------------------------------------------
+// qsynthEngineFrame - Audio thread telemetry frame.
+//
+
+struct qsynthEngineFrame
+{
+	int   iPorts;                             // Number of ports in use.
+	float fPeak[QSYNTH_ENGINE_MAX_PORTS];     // Peak level over the frame.
+	float fSumSq[QSYNTH_ENGINE_MAX_PORTS];    // Sum of squares (for RMS).
+	int   iSamples[QSYNTH_ENGINE_MAX_PORTS];  // Number of samples summed.
+	int   iMidiEvents;                        // MIDI events over the frame.
+};
+
+
+//-------------------------------------------------------------------------
+// qsynthMidiTapEvent - MIDI thread event tap record.
+//
+
+struct qsynthMidiTapEvent
+{
+	qint64         iTime;     // Microseconds since engine creation.
+	unsigned char  type;      // MIDI status, without channel.
+	unsigned char  channel;   // MIDI channel (0-based).
+	unsigned short param1;    // Key, controller, program, pitch bend...
+	int            param2;    // Velocity, controller value...
+};
+
+
+//-------------------------------------------------------------------------
+// qsynthEngineChannel - MIDI thread channel activity counters.
+//
+// Monotonic counters, padded to a whole cache line each and allocated
+// on a cache line boundary (see setMidiChannels), so that the MIDI
+// thread never shares one with any other channel.
+
+struct qsynthEngineChannel
+{
+	qsynthAtomicInt iEvents;       // Note and change events.
+	qsynthAtomicInt iChanges;      // Program and control changes.
+	char       pad[QSYNTH_ENGINE_CACHE_LINE - 2 * sizeof(qsynthAtomicInt)];
+};
+
 
 //-------------------------------------------------------------------------
 // qsynthEngine - Meta-fluidsynth engine structure class.
 //
 
-class qsynthEngine
+class qsynthEngine : public QObject
 {
+	Q_OBJECT
+
 public:
 
 	// Constructor.
@@ -48,6 +131,19 @@ public:
 	const QString& name() const;
 	void setName(const QString& sName);
 
+	// Engine lifecycle states.
+	enum State { Stopped = 0, Loading, Starting, Running, Stopping };
+
+	// Engine lifecycle state accessors (GUI thread).
+	State state() const;
+	void setState(State state);
+
+	// Whether in transition (neither stopped nor running).
+	bool isBusy() const;
+
+	// Re-start as soon as stopped.
+	bool bRestart;
+
 	// Engine member public variables.
 	fluid_synth_t        *pSynth;
 	fluid_audio_driver_t *pAudioDriver;
@@ -56,13 +152,157 @@ public:
 	fluid_player_t       *pPlayer;
 	fluid_server_t       *pServer;
 
-	// Dirty MIDI event trackers.
+	// Soundfont background loader, while starting up.
+	qsynthSoundFontLoader *pSoundFontLoader;
+
+	// Audio process callback (audio thread).
+	int process(int nframes, int nin, float **in, int nout, float **out);
+	void resetProcess();
+
+	// Whether the audio driver runs through process().
+	bool bProcess;
+
+	// Seamless restart: the new synth takes over on the very next
+	// audio buffer, while the current one fades out (GUI thread).
+	void swapSynth(fluid_synth_t *pNewSynth, int iFadeFrames);
+	bool isSwapping() const;
+
+	// The old synth, once faded out and no longer in use by the MIDI
+	// thread, or right away when forced (only when the audio and MIDI
+	// drivers are gone); ownership goes to the caller.
+	fluid_synth_t *retiredSynth(bool bForce = false);
+
+	// MIDI router output (MIDI thread), on to the current synth.
+	int handleMidiEvent(fluid_midi_event_t *pMidiEvent);
+
+	// New synth being built for a seamless restart.
+	fluid_synth_t *pSwapSynth;
+
+	// Fluidsynth settings still in use by the running drivers and
+	// by the retired synth, whenever detached from the setup.
+	fluid_settings_t *pDriverSettings;
+	fluid_settings_t *pRetiredSettings;
+
+	// Audio/MIDI driver settings signature, as last started.
+	QString sDriverKey;
+
+	// Channel state snapshot (bank/program, controllers, pitch bend).
+	struct ChannelState
+	{
+		int  iChan;
+		bool bPreset;
+		int  iBank;
+		int  iProg;
+		int  iPitchBend;
+		int  aiCC[128];
+	};
+
+	static void saveChannels(fluid_synth_t *pSynth,
+		QVector<ChannelState>& channels);
+	static void loadChannels(fluid_synth_t *pSynth,
+		const QVector<ChannelState>& channels);
+
+	// Preset catalogue, built on demand (GUI thread).
+	const qsynthPresetIndex& presetIndex();
+	// Invalidate it, whenever the soundfont stack changes.
+	void resetPresetIndex();
+
+	// MIDI event tracker (MIDI thread).
+	void midiEvent()
+	{
+		m_iMidiEvents.ref();
+		if (m_iWakeupMidi.load() && m_iWakeupMidi.testAndSetOrdered(1, 0))
+			notifyWakeup();
+	}
+	int midiEvents() const { return m_iMidiEvents.load(); }
+
+	// Arm a one-shot wakeup() on the next MIDI event and/or on the
+	// next audible output (GUI thread; disarmed with false/false).
+	void setWakeup(bool bMidi, bool bMeter);
+
+	// Whether there's been any activity the armed wakeup may have
+	// missed, ie. since last update and just before arming it
+	// (GUI thread; any frames drained here are kept for later).
+	bool isWakeupPending();
+
+	// MIDI channel activity counters allocation, as many as the synth
+	// MIDI channels (GUI thread; only while there's no MIDI thread).
+	void setMidiChannels(int iChannels);
+	int midiChannels() const;
+
+	// MIDI channel activity tracker (MIDI thread).
+	void midiChannelEvent(fluid_midi_event_t *pMidiEvent);
+
+	// MIDI channel activity breakout (GUI thread);
+	// returns the channel state changes since last call.
+	enum { ChannelOn = 1, ChannelOff = 2, ChannelChange = 4 };
+	int updateMidiChannel(int iChan);
+	bool isMidiChannelOn(int iChan) const;
+	int midiChannelsOn() const;
+
+	// MIDI event tap (MIDI thread -> GUI), on demand;
+	// its ring gets allocated on first enable only.
+	void setMidiTap(bool bMidiTap);
+	bool isMidiTap() const { return (m_iMidiTap.loadAcquire() != 0); }
+
+	// MIDI event tap producer (MIDI thread).
+	void midiTap(fluid_midi_event_t *pMidiEvent);
+
+	// MIDI event tap consumer (GUI thread).
+	bool drainMidiTap(qsynthMidiTapEvent& event);
+	int midiTapReadable() const;
+	int midiTapDropped() const;
+
+	// MIDI event tap record decoders.
+	static QString midiTapType(const qsynthMidiTapEvent& event);
+	static QString midiTapText(const qsynthMidiTapEvent& event);
+
+	// Telemetry producer (audio thread).
+	void processMeter(int nframes, int nout, float **out);
+
+	// Telemetry consumer (GUI thread).
+	bool drainMeter(qsynthEngineFrame& frame);
+	bool updateMeter();
+	void resetMeter();
+
+	// Dirty MIDI event trackers (GUI thread;
+	// iMidiEvent is the last seen midiEvents() count).
 	int iMidiEvent;
 	int iMidiState;
 
-	// Current peak level meters (pseudo-stereo).
+	// Current peak level meters (one per output port).
 	bool  bMeterEnabled;
-	float fMeterValue[2];
+	int   iMeterPorts;
+	float fMeterValue[QSYNTH_ENGINE_MAX_PORTS];
+
+	// Last drained RMS levels and voice count.
+	float fMeterRms[QSYNTH_ENGINE_MAX_PORTS];
+	int   iMeterVoices;
+
+signals:
+
+	// Engine lifecycle signals.
+	void stateChanged(int iState);
+	void started();
+	void stopped();
+
+	// Activity wakeup, once armed (GUI thread).
+	void wakeup();
+
+protected slots:
+
+	// Activity wakeup self-pipe reader (GUI thread).
+	void wakeupNotifySlot();
+
+	// Activity wakeup flag poller (GUI thread; no self-pipe only).
+	void wakeupTimerSlot();
+
+protected:
+
+	// Activity wakeup poster (audio or MIDI thread); just a byte
+	// written down a non-blocking self-pipe, or else an atomic flag
+	// raised for the GUI to poll; no allocations, locks nor signals.
+	void notifyWakeup();
 
 private:
 
@@ -70,6 +310,79 @@ private:
 	bool           m_bDefault;
 	qsynthSetup   *m_pSetup;
 	QString        m_sName;
+	State          m_state;
+
+	// Telemetry channel (audio thread -> GUI).
+	qsynthRingBuffer<qsynthEngineFrame> m_frames;
+
+	// Pending frame, whenever the ring is full (audio thread).
+	qsynthEngineFrame m_pending;
+	int               m_iMidiEventsLast;
+
+	// Frames drained ahead of time (GUI thread).
+	qsynthEngineFrame m_drained;
+	bool              m_bDrained;
+
+	// Monotonic MIDI event counter (MIDI thread).
+	qsynthAtomicInt        m_iMidiEvents;
+
+	// MIDI channel activity (MIDI thread -> GUI),
+	// cache line aligned within its raw allocation.
+	char                *m_pChannelsAlloc;
+	qsynthEngineChannel *m_pChannels;
+	int                  m_iChannels;
+
+	// MIDI channel activity trackers (GUI thread).
+	struct ChannelTracker
+	{
+		int iEvent;     // Last seen events count.
+		int iChange;    // Last seen changes count.
+		int iState;     // Activity state tracker.
+	};
+
+	ChannelTracker m_trackers[QSYNTH_ENGINE_MAX_CHANNELS];
+	int            m_iChannelsOn;
+
+	// Activity wakeup triggers (GUI -> audio/MIDI thread).
+	qsynthAtomicInt     m_iWakeupMidi;
+	qsynthAtomicInt     m_iWakeupMeter;
+
+	// Activity wakeup self-pipe (audio/MIDI thread -> GUI).
+	int              m_fdWakeup[2];
+	QSocketNotifier *m_pWakeupNotifier;
+
+	// Activity wakeup flag and poller, whenever there's no self-pipe.
+	qsynthAtomicInt  m_iWakeupPosted;
+	QTimer          *m_pWakeupTimer;
+
+	// MIDI event tap (MIDI thread -> GUI).
+	qsynthRingBuffer<qsynthMidiTapEvent> *m_pMidiTap;
+	QElapsedTimer     m_midiTapTime;
+	qsynthAtomicInt        m_iMidiTap;
+	qsynthAtomicInt        m_iMidiTapDropped;
+
+	// Seamless restart hand-over (GUI -> audio thread -> GUI).
+	qsynthAtomicPointer<fluid_synth_t> m_pNextSynth;
+	qsynthAtomicInt        m_iFadeDone;
+
+	// Seamless restart hand-over (GUI -> MIDI thread); events still
+	// in flight (on whatever synth they've picked) are counted in.
+	qsynthAtomicPointer<fluid_synth_t> m_pMidiSynth;
+	qsynthAtomicInt        m_iMidiBusy;
+
+	// Seamless restart fade-out state (audio thread).
+	fluid_synth_t    *m_pProcessSynth;
+	fluid_synth_t    *m_pFadeSynth;
+	int               m_iFadeFrames;
+	int               m_iFadePos;
+	float            *m_pfFadeBuffer;
+	float            *m_ppFadeBuffers[QSYNTH_ENGINE_MAX_PORTS];
+
+	// The old synth, while fading out (GUI thread).
+	fluid_synth_t    *m_pOldSynth;
+
+	// Preset catalogue (GUI thread).
+	qsynthPresetIndex m_presetIndex;
 };
 
 
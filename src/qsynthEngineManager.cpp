@@ -0,0 +1,1460 @@
+// qsynthEngineManager.cpp
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qsynthAbout.h"
+#include "qsynthEngineManager.h"
+#include "qsynthEngine.h"
+#include "qsynthSoundFontCache.h"
+#include "qsynthSoundFontMeta.h"
+#include "qsynthSoundFontLoader.h"
+#include "qsynthRender.h"
+
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+
+
+// Seamless restart fade-out polling period.
+#define QSYNTH_SWAP_MSECS  100
+
+// MIDI event taps drain period.
+#define QSYNTH_MIDI_TAP_MSECS  50
+
+
+#ifdef CONFIG_FLUID_SERVER
+
+// Hold last shell/server port in use.
+static int g_iLastShellPort = 0;
+
+
+// Needed for server mode.
+static fluid_cmd_handler_t* qsynth_newclient ( void* data, char* )
+{
+	return ::new_fluid_cmd_handler((fluid_synth_t*) data);
+}
+
+#endif
+
+
+//-------------------------------------------------------------------------
+// Audio driver processing stub.
+
+int qsynth_process ( void *pvData, int len,
+	int nin, float **in, int nout, float **out )
+{
+	qsynthEngine *pEngine = (qsynthEngine *) pvData;
+	// Have the engine synth(s) fill the output buffers
+	// with their audio output, and meter those too...
+	return pEngine->process(len, nin, in, nout, out);
+}
+
+
+// Audio/MIDI driver settings signature (seamless restart
+// is only possible while these are left unchanged; the MIDI
+// channel count is here too, as the engine channel counters
+// are sized on the driver start).
+static QString qsynth_driver_key ( qsynthSetup *pSetup )
+{
+	QStringList keys;
+
+	keys << pSetup->sAudioDriver
+		<< pSetup->sAudioDevice
+		<< pSetup->sJackName
+		<< QString::number(int(pSetup->bJackAutoConnect))
+		<< QString::number(int(pSetup->bJackMulti))
+		<< QString::number(pSetup->iAudioChannels)
+		<< QString::number(pSetup->iAudioGroups)
+		<< QString::number(pSetup->iAudioBufSize)
+		<< QString::number(pSetup->iAudioBufCount)
+		<< pSetup->sSampleFormat
+		<< QString::number(pSetup->fSampleRate)
+		<< QString::number(int(pSetup->bMidiIn))
+		<< pSetup->sMidiDriver
+		<< pSetup->sMidiDevice
+		<< pSetup->sMidiName
+		<< QString::number(int(pSetup->bMidiDump))
+		<< QString::number(pSetup->iMidiChannels)
+		<< QString::number(int(pSetup->bServer))
+		<< pSetup->options;
+
+	return keys.join("\n");
+}
+
+
+//-------------------------------------------------------------------------
+// Midi router stubs to have some midi activity feedback.
+
+static void qsynth_midi_event ( qsynthEngine *pEngine,
+	fluid_midi_event_t *pMidiEvent )
+{
+	pEngine->midiEvent();
+	pEngine->midiChannelEvent(pMidiEvent);
+
+	if (pEngine->isMidiTap())
+		pEngine->midiTap(pMidiEvent);
+}
+
+
+static int qsynth_handle_midi_event ( void *pvData,
+	fluid_midi_event_t *pMidiEvent )
+{
+	qsynthEngine *pEngine = (qsynthEngine *) pvData;
+	qsynth_midi_event(pEngine, pMidiEvent);
+	return pEngine->handleMidiEvent(pMidiEvent);
+}
+
+
+// Shared soundfont cache memory accounting report.
+static QString qsynth_sfcache_status (void)
+{
+	qsynthSoundFontCache *pCache = qsynthSoundFontCache::getInstance();
+	if (pCache == NULL)
+		return QString();
+
+	return QObject::tr("Soundfont cache: %1 file(s) (%2 pending), %3 reference(s), "
+		"%4 MB in memory (%5 MB shared).")
+		.arg(pCache->fileCount())
+		.arg(pCache->lazyCount())
+		.arg(pCache->refCount())
+		.arg(double(pCache->memoryUsage()) / (1024.0 * 1024.0), 0, 'f', 1)
+		.arg(double(pCache->memorySaved()) / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
+
+//-------------------------------------------------------------------------
+// qsynthEngineManager - GUI independent engine lifecycle management.
+//
+
+// Constructor.
+qsynthEngineManager::qsynthEngineManager (
+	qsynthOptions *pOptions, QObject *pParent ) : QObject(pParent)
+{
+	m_pOptions = pOptions;
+
+	m_pCurrentEngine = NULL;
+
+	m_bEcho = false;
+	m_bSwapTimer = false;
+
+	m_pMonitorEngine = NULL;
+
+	m_pMidiTapTimer = new QTimer(this);
+	QObject::connect(m_pMidiTapTimer,
+		SIGNAL(timeout()),
+		SLOT(midiTapTimerSlot()));
+}
+
+
+// Destructor.
+qsynthEngineManager::~qsynthEngineManager (void)
+{
+	stopAllEngines();
+}
+
+
+// Engine registry.
+void qsynthEngineManager::addEngine ( qsynthEngine *pEngine )
+{
+	if (pEngine == NULL || m_engines.contains(pEngine))
+		return;
+
+	QObject::connect(pEngine,
+		SIGNAL(stopped()),
+		SLOT(engineStopped()));
+
+	m_engines.append(pEngine);
+}
+
+
+void qsynthEngineManager::removeEngine ( qsynthEngine *pEngine )
+{
+	if (pEngine == NULL)
+		return;
+
+	QObject::disconnect(pEngine, NULL, this, NULL);
+
+	if (m_pCurrentEngine == pEngine)
+		m_pCurrentEngine = NULL;
+
+	m_engines.removeAll(pEngine);
+
+	m_midiTapDropped.remove(pEngine);
+
+	pEngine->setMidiTap(false);
+	if (m_pMonitorEngine == pEngine)
+		m_pMonitorEngine = NULL;
+	updateMidiTaps();
+}
+
+
+const QList<qsynthEngine *>& qsynthEngineManager::engines (void) const
+{
+	return m_engines;
+}
+
+
+// Current selected engine (panel settings are owned by the GUI).
+void qsynthEngineManager::setCurrentEngine ( qsynthEngine *pEngine )
+{
+	m_pCurrentEngine = pEngine;
+}
+
+
+qsynthEngine *qsynthEngineManager::currentEngine (void) const
+{
+	return m_pCurrentEngine;
+}
+
+
+// Echo all messages to stdout/stderr (headless mode).
+void qsynthEngineManager::setEcho ( bool bEcho )
+{
+	m_bEcho = bEcho;
+}
+
+
+bool qsynthEngineManager::isEcho (void) const
+{
+	return m_bEcho;
+}
+
+
+// Messages output methods.
+void qsynthEngineManager::appendMessages ( const QString& s )
+{
+	if (m_bEcho)
+		QTextStream(stdout) << s << endl;
+
+	emit messages(s, QString());
+}
+
+
+void qsynthEngineManager::appendMessagesColor (
+	const QString& s, const QString& c )
+{
+	if (m_bEcho)
+		QTextStream(stdout) << s << endl;
+
+	emit messages(s, c);
+}
+
+
+void qsynthEngineManager::appendMessagesError ( const QString& s )
+{
+	if (m_bEcho)
+		QTextStream(stderr) << s.simplified() << endl;
+
+	emit messagesError(s);
+}
+
+
+// Start all registered engines.
+void qsynthEngineManager::startAllEngines (void)
+{
+	QListIterator<qsynthEngine *> iter(m_engines);
+	while (iter.hasNext())
+		startEngine(iter.next());
+}
+
+
+// Stop all registered engines.
+void qsynthEngineManager::stopAllEngines (void)
+{
+	QListIterator<qsynthEngine *> iter(m_engines);
+	while (iter.hasNext()) {
+		qsynthEngine *pEngine = iter.next();
+		pEngine->bRestart = false;
+		stopEngine(pEngine);
+	}
+}
+
+
+// MIDI monitored engine (NULL for none).
+void qsynthEngineManager::setMidiMonitor ( qsynthEngine *pEngine )
+{
+	if (m_pMonitorEngine == pEngine)
+		return;
+
+	m_pMonitorEngine = pEngine;
+
+	updateMidiTaps();
+}
+
+
+qsynthEngine *qsynthEngineManager::midiMonitor (void) const
+{
+	return m_pMonitorEngine;
+}
+
+
+// MIDI event taps are on for the monitored and dumping engines only.
+void qsynthEngineManager::updateMidiTaps (void)
+{
+	bool bMidiTaps = false;
+
+	QListIterator<qsynthEngine *> iter(m_engines);
+	while (iter.hasNext()) {
+		qsynthEngine *pEngine = iter.next();
+		qsynthSetup *pSetup = pEngine->setup();
+		const bool bMidiTap = (pEngine == m_pMonitorEngine
+			|| (pSetup && pSetup->bMidiDump));
+		pEngine->setMidiTap(bMidiTap);
+		if (bMidiTap)
+			bMidiTaps = true;
+	}
+
+	if (bMidiTaps && !m_pMidiTapTimer->isActive())
+		m_pMidiTapTimer->start(QSYNTH_MIDI_TAP_MSECS);
+	else
+	if (!bMidiTaps && m_pMidiTapTimer->isActive())
+		m_pMidiTapTimer->stop();
+}
+
+
+// MIDI event taps drain (dump and monitor).
+void qsynthEngineManager::midiTapTimerSlot (void)
+{
+	QListIterator<qsynthEngine *> iter(m_engines);
+	while (iter.hasNext()) {
+		qsynthEngine *pEngine = iter.next();
+		if (!pEngine->isMidiTap())
+			continue;
+		const int iReadable = pEngine->midiTapReadable();
+		if (iReadable < 1)
+			continue;
+		QVector<qsynthMidiTapEvent> events;
+		events.reserve(iReadable);
+		qsynthMidiTapEvent event;
+		while (events.count() < iReadable && pEngine->drainMidiTap(event))
+			events.append(event);
+		// Dump mode, as text...
+		qsynthSetup *pSetup = pEngine->setup();
+		if (pSetup && pSetup->bMidiDump) {
+			const QString sPrefix = pEngine->name() + ": ";
+			QVectorIterator<qsynthMidiTapEvent> event_iter(events);
+			while (event_iter.hasNext()) {
+				appendMessagesColor(sPrefix
+					+ qsynthEngine::midiTapText(event_iter.next()), "#669999");
+			}
+		}
+		// Lost any?
+		const int iDropped = pEngine->midiTapDropped();
+		if (iDropped != m_midiTapDropped.value(pEngine, 0)) {
+			m_midiTapDropped.insert(pEngine, iDropped);
+			appendMessagesColor(pEngine->name() + ": "
+				+ tr("MIDI event tap overrun (%1 events dropped).")
+				.arg(iDropped), "#996633");
+		}
+		emit midiTapEvents(pEngine, events);
+	}
+}
+
+
+// Realize the engine effects and gain settings, as in setup.
+void qsynthEngineManager::realizeEngineSettings ( qsynthEngine *pEngine )
+{
+	qsynthSetup *pSetup = pEngine->setup();
+	if (pSetup == NULL)
+		return;
+
+	setEngineReverbOn(pEngine,
+		pSetup->bReverbActive);
+	setEngineChorusOn(pEngine,
+		pSetup->bChorusActive);
+	setEngineGain(pEngine,
+		pSetup->fGain);
+	setEngineReverb(pEngine,
+		pSetup->fReverbRoom,
+		pSetup->fReverbDamp,
+		pSetup->fReverbWidth,
+		pSetup->fReverbLevel);
+	setEngineChorus(pEngine,
+		pSetup->iChorusNr,
+		pSetup->fChorusLevel,
+		pSetup->fChorusSpeed,
+		pSetup->fChorusDepth,
+		pSetup->iChorusType);
+}
+
+
+// Seamless restart: destroy previous synths, once faded out.
+void qsynthEngineManager::swapTimerSlot (void)
+{
+	m_bSwapTimer = false;
+
+	int iSwapping = 0;
+	QListIterator<qsynthEngine *> iter(m_engines);
+	while (iter.hasNext()) {
+		qsynthEngine *pEngine = iter.next();
+		fluid_synth_t *pOldSynth = pEngine->retiredSynth();
+		if (pOldSynth) {
+			deleteEngineSynth(pEngine, pOldSynth);
+			if (pEngine->pRetiredSettings) {
+				::delete_fluid_settings(pEngine->pRetiredSettings);
+				pEngine->pRetiredSettings = NULL;
+			}
+			appendMessages(pEngine->name() + ": "
+				+ tr("Synthesizer engine restarted."));
+			pEngine->setState(qsynthEngine::Running);
+		}
+		else
+		if (pEngine->isSwapping())
+			++iSwapping;
+	}
+
+	// Still fading out?
+	if (iSwapping > 0) {
+		m_bSwapTimer = true;
+		QTimer::singleShot(QSYNTH_SWAP_MSECS, this, SLOT(swapTimerSlot()));
+	}
+}
+
+
+// Add dropped files to playlist or soundfont stack.
+void qsynthEngineManager::playLoadFiles ( qsynthEngine *pEngine,
+	const QStringList& files, bool bSetup )
+{
+	if (pEngine == NULL)
+		return;
+	if (pEngine->pSynth == NULL)
+		return;
+
+	qsynthSetup *pSetup = pEngine->setup();
+	if (pSetup == NULL)
+		return;
+
+	// Add each list item to Soundfont stack or MIDI player playlist...
+	const QString sPrefix  = pEngine->name() + ": ";
+	const QString sElipsis = "...";
+	int   iSoundFonts = 0;
+	int   iMidiFiles  = 0;
+	QStringListIterator iter(files);
+	while (iter.hasNext()) {
+		const QString& sFilename = iter.next();
+		// Is it a soundfont file...
+		if (qsynthSoundFontMeta::isSoundFont(sFilename)) {
+			if (bSetup || !pSetup->soundfonts.contains(sFilename)) {
+				appendMessagesColor(sPrefix +
+					tr("Loading soundfont: \"%1\"")
+					.arg(sFilename) + sElipsis, "#999933");
+				if (::fluid_synth_sfload(
+						pEngine->pSynth, sFilename.toLocal8Bit().data(), 1) >= 0) {
+					iSoundFonts++;
+					if (!bSetup) {
+						pSetup->soundfonts.append(sFilename);
+						pSetup->bankoffsets.append("0");
+					}
+				} else {
+					appendMessagesError(sPrefix +
+						tr("Failed to load the soundfont: \"%1\".")
+						.arg(sFilename));
+				}
+			}
+		}
+		else  // Or is it a bare midifile?
+		if (::fluid_is_midifile(sFilename.toLocal8Bit().data()) && pEngine->pPlayer) {
+			appendMessagesColor(sPrefix +
+				tr("Playing MIDI file: \"%1\"")
+				.arg(sFilename) + sElipsis, "#99cc66");
+			if (::fluid_player_add(
+					pEngine->pPlayer, sFilename.toLocal8Bit().data()) >= 0) {
+				iMidiFiles++;
+			} else {
+				appendMessagesError(sPrefix +
+					tr("Failed to play MIDI file: \"%1\".")
+					.arg(sFilename));
+			}
+		}
+	}
+
+	// Reset all presets, if applicable...
+	if (!bSetup && iSoundFonts > 0) {
+		resetEngine(pEngine);
+		pEngine->resetPresetIndex();
+		emit enginePresetsChanged(pEngine);
+	}
+
+	// Start playing, if any...
+	if (pEngine->pPlayer && iMidiFiles > 0)
+		::fluid_player_play(pEngine->pPlayer);
+}
+
+
+// Engine stop completion slot (re-start, if so requested).
+void qsynthEngineManager::engineStopped (void)
+{
+	qsynthEngine *pEngine = qobject_cast<qsynthEngine *> (sender());
+	if (pEngine && pEngine->bRestart) {
+		pEngine->bRestart = false;
+		startEngine(pEngine);
+	}
+}
+
+
+// Start the fluidsynth clone, based on given settings.
+bool qsynthEngineManager::startEngine ( qsynthEngine *pEngine )
+{
+	if (pEngine == NULL)
+		return false;
+	if (pEngine->pSynth || pEngine->state() != qsynthEngine::Stopped)
+		return true;
+
+	qsynthSetup *pSetup = pEngine->setup();
+	if (pSetup == NULL)
+		return false;
+
+	pEngine->setState(qsynthEngine::Loading);
+
+	// Start realizing settings...
+	pSetup->realize();
+
+	// MIDI event tap, if dumping...
+	updateMidiTaps();
+
+	const QString sPrefix  = pEngine->name() + ": ";
+	const QString sElipsis = "...";
+
+	// Create the synthesizer.
+	appendMessages(sPrefix + tr("Creating synthesizer engine") + sElipsis);
+	pEngine->pSynth = ::new_fluid_synth(pSetup->fluid_settings());
+	if (pEngine->pSynth == NULL) {
+		appendMessagesError(sPrefix
+			+ tr("Failed to create the synthesizer.\n\nCannot continue without it."));
+		pEngine->setState(qsynthEngine::Stopped);
+		return false;
+	}
+
+	// Load soundfonts in the background, whenever possible;
+	// the rest will follow as soon as all are ready...
+	if (loadEngineSoundFontsAsync(pEngine, pEngine->pSynth))
+		return true;
+
+	// Load soundfonts, right away...
+	loadEngineSoundFonts(pEngine, pEngine->pSynth, NULL);
+
+	return startEngineDrivers(pEngine);
+}
+
+
+// Add the shared cache loader to a new engine synth, so that fonts
+// already in use by another engine get loaded only once, then start
+// loading its soundfonts in the background, if any (true).
+bool qsynthEngineManager::loadEngineSoundFontsAsync (
+	qsynthEngine *pEngine, fluid_synth_t *pSynth )
+{
+	qsynthSetup *pSetup = pEngine->setup();
+	if (pSetup == NULL)
+		return false;
+
+	const QString sPrefix  = pEngine->name() + ": ";
+	const QString sElipsis = "...";
+
+	qsynthSoundFontCache *pCache = qsynthSoundFontCache::getInstance();
+	const qsynthSoundFontCache::LoadMode loadMode
+		= qsynthSoundFontCache::LoadMode(pSetup->iSoundFontLoad);
+	bool bCacheLoader = false;
+	if (pCache) {
+		fluid_sfloader_t *pLoader = pCache->createLoader(loadMode);
+		if (pLoader) {
+			::fluid_synth_add_sfloader(pSynth, pLoader);
+			bCacheLoader = true;
+		}
+	}
+
+	if (bCacheLoader && !pSetup->soundfonts.isEmpty()) {
+		appendMessagesColor(sPrefix +
+			tr("Loading %1 soundfont(s) in the background")
+			.arg(pSetup->soundfonts.count()) + sElipsis, "#999933");
+		qsynthSoundFontLoader *pLoader
+			= new qsynthSoundFontLoader(pEngine, pSetup->soundfonts, loadMode);
+		QObject::connect(pLoader,
+			SIGNAL(fileStarted(int)),
+			SLOT(soundFontLoaderProgress()));
+		QObject::connect(pLoader,
+			SIGNAL(fileFinished(int)),
+			SLOT(soundFontLoaderProgress()));
+		QObject::connect(pLoader,
+			SIGNAL(finished()),
+			SLOT(soundFontLoaderFinished()));
+		pEngine->pSoundFontLoader = pLoader;
+		pLoader->start();
+		emit soundFontProgress();
+		return true;
+	}
+
+	return false;
+}
+
+
+// Load the soundfonts into the engine synth; the ones already done
+// by the background loader are just shared from the cache.
+void qsynthEngineManager::loadEngineSoundFonts ( qsynthEngine *pEngine,
+	fluid_synth_t *pSynth, qsynthSoundFontLoader *pLoader )
+{
+	qsynthSetup *pSetup = pEngine->setup();
+	if (pSetup == NULL)
+		return;
+
+	const QString sPrefix  = pEngine->name() + ": ";
+	const QString sElipsis = "...";
+
+	int i = 0;
+	QStringListIterator iter(pSetup->soundfonts);
+	while (iter.hasNext()) {
+		const QString& sFilename = iter.next();
+		// Is it a soundfont file...
+		if (qsynthSoundFontMeta::isSoundFont(sFilename)) {
+			const int iBankOffset = pSetup->bankoffsets[i].toInt();
+			qsynthSoundFontLoader::State state = qsynthSoundFontLoader::Pending;
+			if (pLoader && i < pLoader->fileCount()
+				&& pLoader->filename(i) == sFilename)
+				state = pLoader->state(i);
+			if (state == qsynthSoundFontLoader::Cancelled) {
+				appendMessagesColor(sPrefix +
+					tr("Soundfont loading cancelled: \"%1\".")
+					.arg(sFilename), "#999933");
+			}
+			else
+			if (state == qsynthSoundFontLoader::Failed) {
+				appendMessagesError(sPrefix +
+					tr("Failed to load the soundfont: \"%1\".")
+					.arg(sFilename));
+			}
+			else {
+				appendMessagesColor(sPrefix +
+					tr("Loading soundfont: \"%1\" (bank offset %2)")
+					.arg(sFilename).arg(iBankOffset) + sElipsis, "#999933");
+				const int iSFID = ::fluid_synth_sfload(
+					pSynth, sFilename.toLocal8Bit().data(), 1);
+				if (iSFID < 0)
+					appendMessagesError(sPrefix +
+						tr("Failed to load the soundfont: \"%1\".")
+						.arg(sFilename));
+			#ifdef CONFIG_FLUID_BANK_OFFSET
+				else
+				if (::fluid_synth_set_bank_offset(
+					pSynth, iSFID, iBankOffset) < 0) {
+					appendMessagesError(sPrefix +
+						tr("Failed to set bank offset (%1) for soundfont: \"%2\".")
+						.arg(iBankOffset).arg(sFilename));
+				}
+			#endif
+			}
+		}
+		++i;
+	}
+
+	// Shared soundfont cache status...
+	const QString& sCacheStatus = qsynth_sfcache_status();
+	if (!sCacheStatus.isEmpty())
+		appendMessagesColor(sPrefix + sCacheStatus, "#999933");
+}
+
+
+// Start the engine drivers, once all soundfonts are loaded.
+bool qsynthEngineManager::startEngineDrivers ( qsynthEngine *pEngine )
+{
+	qsynthSetup *pSetup = pEngine->setup();
+	if (pSetup == NULL)
+		return false;
+
+	const QString sPrefix  = pEngine->name() + ": ";
+	const QString sElipsis = "...";
+
+	pEngine->setState(qsynthEngine::Starting);
+
+	// Start the synthesis thread...
+	appendMessages(sPrefix +
+		tr("Creating audio driver (%1)")
+		.arg(pSetup->sAudioDriver) + sElipsis);
+	pEngine->pAudioDriver  = NULL;
+	pEngine->bMeterEnabled = false;
+	pEngine->bProcess      = false;
+	pEngine->resetMeter();
+	pEngine->resetProcess();
+	pEngine->setMidiChannels(
+		::fluid_synth_count_midi_channels(pEngine->pSynth));
+	if (m_pOptions->bOutputMeters || m_pOptions->bSeamlessRestart) {
+		pEngine->pAudioDriver  = ::new_fluid_audio_driver2(
+			pSetup->fluid_settings(), qsynth_process, pEngine);
+		pEngine->bProcess      = (pEngine->pAudioDriver != NULL);
+		pEngine->bMeterEnabled = (pEngine->bProcess && m_pOptions->bOutputMeters);
+	}
+	if (pEngine->pAudioDriver == NULL)
+		pEngine->pAudioDriver = ::new_fluid_audio_driver(
+			pSetup->fluid_settings(), pEngine->pSynth);
+	if (pEngine->pAudioDriver == NULL) {
+		appendMessagesError(sPrefix +
+			tr("Failed to create the audio driver (%1).\n\n"
+			"Cannot continue without it.")
+			.arg(pSetup->sAudioDriver));
+		stopEngine(pEngine);
+		return false;
+	}
+
+	pEngine->sDriverKey = qsynth_driver_key(pSetup);
+
+	// Start the midi router and link it to the synth...
+	if (pSetup->bMidiIn) {
+		// In dump mode, events coming out of the router are captured
+		// through the engine MIDI event tap (see midiTapTimerSlot)...
+		appendMessages(sPrefix +
+			tr("Creating MIDI router (%1)")
+			.arg(pSetup->sMidiDriver) + sElipsis);
+		pEngine->pMidiRouter = ::new_fluid_midi_router(
+			pSetup->fluid_settings(),
+			qsynth_handle_midi_event,
+			(void *) pEngine);
+		if (pEngine->pMidiRouter == NULL) {
+			appendMessagesError(sPrefix +
+				tr("Failed to create the MIDI input router (%1).\n\n"
+				"No MIDI input will be available.")
+				.arg(pSetup->sMidiDriver));
+		} else {
+		#ifdef CONFIG_FLUID_MIDI_ROUTER
+			::fluid_synth_set_midi_router(pEngine->pSynth, pEngine->pMidiRouter);
+		#endif
+			appendMessages(sPrefix +
+				tr("Creating MIDI driver (%1)")
+				.arg(pSetup->sMidiDriver) + sElipsis);
+			pEngine->pMidiDriver = ::new_fluid_midi_driver(
+				pSetup->fluid_settings(),
+				::fluid_midi_router_handle_midi_event,
+				static_cast<void *> (pEngine->pMidiRouter));
+			if (pEngine->pMidiDriver == NULL)
+				appendMessagesError(sPrefix +
+					tr("Failed to create the MIDI driver (%1).\n\n"
+					"No MIDI input will be available.")
+					.arg(pSetup->sMidiDriver));
+		}
+	}
+
+	// Create the MIDI player.
+	appendMessages(sPrefix + tr("Creating MIDI player") + sElipsis);
+	pEngine->pPlayer = ::new_fluid_player(pEngine->pSynth);
+	if (pEngine->pPlayer == NULL) {
+		appendMessagesError(sPrefix +
+			tr("Failed to create the MIDI player.\n\n"
+			"Continuing without a player."));
+	} else {
+		// Play the midi files, if any.
+		playLoadFiles(pEngine, pSetup->midifiles, false);
+	}
+
+	// Run the server, if requested.
+	if (pSetup->bServer) {
+	#ifdef CONFIG_FLUID_SERVER
+		appendMessages(sPrefix + tr("Creating server") + sElipsis);
+		// Server port must be different for each engine...
+		char szShellPort[] = "shell.port";
+		if (g_iLastShellPort > 0) {
+			g_iLastShellPort++;
+		} else {
+			g_iLastShellPort = 0;
+			::fluid_settings_getint(
+				pSetup->fluid_settings(), szShellPort, &g_iLastShellPort);
+			if (g_iLastShellPort == 0) {
+				g_iLastShellPort = ::fluid_settings_getint_default(
+					pSetup->fluid_settings(), szShellPort);
+			}
+		}
+		// Set the (new) server port for this engne...
+		::fluid_settings_setint(
+			pSetup->fluid_settings(), szShellPort, g_iLastShellPort);
+		// Create the server now...
+		pEngine->pServer = ::new_fluid_server(
+			pSetup->fluid_settings(), qsynth_newclient, pEngine->pSynth);
+		if (pEngine->pServer == NULL)
+			appendMessagesError(sPrefix +
+				tr("Failed to create the server.\n\n"
+				"Continuing without it."));
+	#else
+		appendMessagesError(sPrefix +
+			tr("Server mode disabled.\n\n"
+			"Continuing without it."));
+	#endif
+	}
+
+	// Make an initial program reset.
+	m_pOptions->loadPreset(pEngine, pSetup->sDefPreset);
+
+	// The current one gets its settings from the GUI panel...
+	if (pEngine != currentEngine())
+		realizeEngineSettings(pEngine);
+
+	// Show up our efforts...
+	pEngine->resetPresetIndex();
+	emit engineReady(pEngine, true);
+
+	// All is right.
+	appendMessages(sPrefix + tr("Synthesizer engine started."));
+
+	pEngine->setState(qsynthEngine::Running);
+
+	return true;
+}
+
+
+// Soundfont background loader progress slot.
+void qsynthEngineManager::soundFontLoaderProgress (void)
+{
+	emit soundFontProgress();
+}
+
+
+// Soundfont background loader completion slot.
+void qsynthEngineManager::soundFontLoaderFinished (void)
+{
+	qsynthSoundFontLoader *pLoader
+		= qobject_cast<qsynthSoundFontLoader *> (sender());
+	if (pLoader == NULL)
+		return;
+
+	// Carry on with the engine start, if still around...
+	qsynthEngine *pEngine = pLoader->engine();
+	if (pEngine && pEngine->pSoundFontLoader == pLoader) {
+		pEngine->pSoundFontLoader = NULL;
+		if (pEngine->pSwapSynth) {
+			loadEngineSoundFonts(pEngine, pEngine->pSwapSynth, pLoader);
+			swapEngineSynth(pEngine);
+		} else {
+			loadEngineSoundFonts(pEngine, pEngine->pSynth, pLoader);
+			startEngineDrivers(pEngine);
+		}
+	}
+
+	// The engine synth holds its own references by now...
+	pLoader->release();
+	pLoader->deleteLater();
+
+	emit soundFontProgress();
+}
+
+
+// Cancel all soundfont background loading (slot).
+void qsynthEngineManager::cancelSoundFontLoaders (void)
+{
+	QListIterator<qsynthEngine *> iter(m_engines);
+	while (iter.hasNext()) {
+		qsynthEngine *pEngine = iter.next();
+		if (pEngine->pSoundFontLoader)
+			pEngine->pSoundFontLoader->cancel();
+	}
+}
+
+
+// Stop the fluidsynth clone.
+void qsynthEngineManager::stopEngine ( qsynthEngine *pEngine )
+{
+	if (pEngine == NULL)
+		return;
+	if (pEngine->pSynth == NULL)
+		return;
+
+	pEngine->setState(qsynthEngine::Stopping);
+
+	// Cancel any soundfont loading still in progress;
+	// the loader will get rid of itself when finished...
+	if (pEngine->pSoundFontLoader) {
+		pEngine->pSoundFontLoader->cancel();
+		pEngine->pSoundFontLoader->setEngine(NULL);
+		pEngine->pSoundFontLoader = NULL;
+		emit soundFontProgress();
+	}
+
+	// Drop any seamless restart synth still being built...
+	if (pEngine->pSwapSynth) {
+		deleteEngineSynth(pEngine, pEngine->pSwapSynth);
+		pEngine->pSwapSynth = NULL;
+	}
+
+	// Only if there's a legal audio driver (and setup)...
+	qsynthSetup *pSetup = pEngine->setup();
+	if (pEngine->pAudioDriver && pSetup) {
+		// Before all else save current engine panel settings...
+		emit setupAboutToSave(pEngine);
+		// Make those settings persist over...
+		m_pOptions->saveSetup(pSetup, pEngine->isDefault()
+			? QString::null : pEngine->name());
+	}
+
+	const QString sPrefix  = pEngine->name() + ": ";
+	const QString sElipsis = "...";
+
+#ifdef CONFIG_FLUID_SERVER
+	// Destroy server.
+	if (pEngine->pServer) {
+	//  Server join is not necessary, causes seg fault when multiple engines.
+	//  appendMessages(sPrefix + tr("Waiting for server to terminate") + sElipsis);
+	//  ::fluid_server_join(pEngine->pServer);
+		appendMessages(sPrefix + tr("Destroying server") + sElipsis);
+		::delete_fluid_server(pEngine->pServer);
+		pEngine->pServer = NULL;
+	}
+#endif
+
+	// Destroy player.
+	if (pEngine->pPlayer) {
+		appendMessages(sPrefix + tr("Stopping MIDI player") + sElipsis);
+		::fluid_player_stop(pEngine->pPlayer);
+		appendMessages(sPrefix + tr("Waiting for MIDI player to terminate") + sElipsis);
+		::fluid_player_join(pEngine->pPlayer);
+		appendMessages(sPrefix + tr("Destroying MIDI player") + sElipsis);
+		::delete_fluid_player(pEngine->pPlayer);
+		pEngine->pPlayer = NULL;
+	}
+
+	// Destroy MIDI router.
+	if (pEngine->pMidiRouter) {
+		if (pEngine->pMidiDriver) {
+			appendMessages(sPrefix + tr("Destroying MIDI driver") + sElipsis);
+			::delete_fluid_midi_driver(pEngine->pMidiDriver);
+			pEngine->pMidiDriver = NULL;
+		}
+		appendMessages(sPrefix + tr("Destroying MIDI router") + sElipsis);
+		::delete_fluid_midi_router(pEngine->pMidiRouter);
+		pEngine->pMidiRouter = NULL;
+	}
+
+	// Destroy audio driver.
+	if (pEngine->pAudioDriver) {
+		appendMessages(sPrefix + tr("Destroying audio driver") + sElipsis);
+		::delete_fluid_audio_driver(pEngine->pAudioDriver);
+		pEngine->pAudioDriver = NULL;
+		pEngine->bMeterEnabled = false;
+		pEngine->bProcess = false;
+	}
+
+	// Destroy the previous synth, if still fading out...
+	fluid_synth_t *pOldSynth = pEngine->retiredSynth(true);
+	if (pOldSynth)
+		deleteEngineSynth(pEngine, pOldSynth);
+	if (pEngine->pRetiredSettings) {
+		::delete_fluid_settings(pEngine->pRetiredSettings);
+		pEngine->pRetiredSettings = NULL;
+	}
+
+	// And finally, destroy the synthesizer engine.
+	if (pEngine->pSynth) {
+		deleteEngineSynth(pEngine, pEngine->pSynth);
+		pEngine->pSynth = NULL;
+		pEngine->resetPresetIndex();
+		// We're done.
+		appendMessages(sPrefix + tr("Synthesizer engine terminated."));
+	}
+
+	// Settings left over from a seamless restart, if any.
+	if (pEngine->pDriverSettings) {
+		::delete_fluid_settings(pEngine->pDriverSettings);
+		pEngine->pDriverSettings = NULL;
+	}
+
+	// Shared soundfont cache status...
+	const QString& sCacheStatus = qsynth_sfcache_status();
+	if (!sCacheStatus.isEmpty())
+		appendMessagesColor(sPrefix + sCacheStatus, "#999933");
+
+	// Done (may well get re-started right away).
+	pEngine->setState(qsynthEngine::Stopped);
+}
+
+
+// Unload all soundfonts and destroy an engine synth.
+void qsynthEngineManager::deleteEngineSynth (
+	qsynthEngine *pEngine, fluid_synth_t *pSynth )
+{
+	const QString sPrefix  = pEngine->name() + ": ";
+	const QString sElipsis = "...";
+
+	// Unload soundfonts from actual synth stack...
+	const int iSoundFonts = ::fluid_synth_sfcount(pSynth);
+	for (int i = 0; i < iSoundFonts; ++i) {
+		fluid_sfont_t *pSoundFont = ::fluid_synth_get_sfont(pSynth, i);
+		if (pSoundFont) {
+			const int iSFID = pSoundFont->id;
+			const QString sName = pSoundFont->get_name(pSoundFont);
+			appendMessagesColor(sPrefix +
+				tr("Unloading soundfont: \"%1\" (SFID=%2)")
+				.arg(sName).arg(iSFID) + sElipsis, "#999933");
+			if (::fluid_synth_sfunload(pSynth, iSFID, 0) < 0)
+				appendMessagesError(sPrefix +
+					tr("Failed to unload the soundfont: \"%1\".")
+					.arg(sName));
+		}
+	}
+
+	appendMessages(sPrefix + tr("Destroying synthesizer engine") + sElipsis);
+	::delete_fluid_synth(pSynth);
+}
+
+
+// Apply changed setup values in place, on a running engine, if all
+// are realtime-capable (false when a full restart is needed instead).
+bool qsynthEngineManager::updateEngineSetup (
+	qsynthEngine *pEngine, const QStringList& changes )
+{
+	if (pEngine == NULL || pEngine->state() != qsynthEngine::Running)
+		return false;
+
+	qsynthSetup *pSetup = pEngine->setup();
+	if (pSetup == NULL)
+		return false;
+
+	QStringListIterator iter(changes);
+	while (iter.hasNext()) {
+		if (!pSetup->isRealtime(iter.next()))
+			return false;
+	}
+
+	const QString sPrefix = pEngine->name() + ": ";
+
+	bool bSoundFonts = false;
+	iter.toFront();
+	while (iter.hasNext()) {
+		const QString& sKey = iter.next();
+		if (sKey == "qsynth.soundfonts" || sKey == "qsynth.bankoffsets")
+			bSoundFonts = true;
+		else
+		if (!sKey.startsWith("qsynth.")) {
+			const QString& sVal = pSetup->values().value(sKey);
+			appendMessagesColor(sPrefix +
+				tr("Updating setting: %1 = %2")
+				.arg(sKey).arg(sVal), "#996666");
+			if (!pSetup->update(sKey))
+				appendMessagesError(sPrefix +
+					tr("Failed to update setting: %1 = %2.")
+					.arg(sKey).arg(sVal));
+		}
+	}
+
+	// Soundfonts stack changes...
+	if (bSoundFonts)
+		reloadEngineSoundFonts(pEngine);
+
+	// Make those settings persist over...
+	m_pOptions->saveSetup(pSetup, pEngine->isDefault()
+		? QString::null : pEngine->name());
+
+	return true;
+}
+
+
+// Reload the soundfonts stack in place; the ones still in use
+// are just shared from the cache, never loaded all over again.
+void qsynthEngineManager::reloadEngineSoundFonts ( qsynthEngine *pEngine )
+{
+	fluid_synth_t *pSynth = pEngine->pSynth;
+	if (pSynth == NULL)
+		return;
+
+	const QString sPrefix  = pEngine->name() + ": ";
+	const QString sElipsis = "...";
+
+	// Current soundfonts, to be unloaded later...
+	QList<int> sfids;
+	const int iSoundFonts = ::fluid_synth_sfcount(pSynth);
+	for (int i = 0; i < iSoundFonts; ++i) {
+		fluid_sfont_t *pSoundFont = ::fluid_synth_get_sfont(pSynth, i);
+		if (pSoundFont)
+			sfids.append(pSoundFont->id);
+	}
+
+	// Load the new ones on top...
+	loadEngineSoundFonts(pEngine, pSynth, NULL);
+
+	// Now get rid of the old ones...
+	QListIterator<int> iter(sfids);
+	while (iter.hasNext()) {
+		const int iSFID = iter.next();
+		fluid_sfont_t *pSoundFont = ::fluid_synth_get_sfont_by_id(pSynth, iSFID);
+		const QString sName = (pSoundFont
+			? pSoundFont->get_name(pSoundFont) : QString::number(iSFID));
+		appendMessagesColor(sPrefix +
+			tr("Unloading soundfont: \"%1\" (SFID=%2)")
+			.arg(sName).arg(iSFID) + sElipsis, "#999933");
+		if (::fluid_synth_sfunload(pSynth, iSFID, 0) < 0)
+			appendMessagesError(sPrefix +
+				tr("Failed to unload the soundfont: \"%1\".")
+				.arg(sName));
+	}
+
+	// Re-select all channel presets, from the new stack.
+	::fluid_synth_program_reset(pSynth);
+
+	// Show up our efforts...
+	pEngine->resetPresetIndex();
+	emit enginePresetsChanged(pEngine);
+}
+
+
+// Seamless engine restart: build a brand new synth out of the current
+// setup, while the running one keeps playing; the new one then takes
+// over on the fly (see swapEngineSynth()). Only possible while the
+// audio/MIDI driver settings stay the same (false otherwise).
+bool qsynthEngineManager::swapEngine ( qsynthEngine *pEngine )
+{
+	if (pEngine == NULL)
+		return false;
+	if (pEngine->state() != qsynthEngine::Running || !pEngine->bProcess)
+		return false;
+	if (pEngine->isSwapping() || pEngine->pSwapSynth)
+		return false;
+
+	qsynthSetup *pSetup = pEngine->setup();
+	if (pSetup == NULL)
+		return false;
+	if (qsynth_driver_key(pSetup) != pEngine->sDriverKey)
+		return false;
+
+	// The MIDI player can't be handed over while playing: it would
+	// start all over again on the new synth; do it the regular way...
+	if (pEngine->pPlayer
+		&& ::fluid_player_get_status(pEngine->pPlayer) == FLUID_PLAYER_PLAYING)
+		return false;
+
+	// Before all else save current engine panel settings...
+	emit setupAboutToSave(pEngine);
+	// Make those settings persist over...
+	m_pOptions->saveSetup(pSetup, pEngine->isDefault()
+		? QString::null : pEngine->name());
+
+	const QString sPrefix  = pEngine->name() + ": ";
+	const QString sElipsis = "...";
+
+	// Current settings are still in use by the running drivers,
+	// or else by the running synth only, soon to be retired...
+	fluid_settings_t *pSettings = pSetup->detach_fluid_settings();
+	if (pEngine->pDriverSettings == NULL)
+		pEngine->pDriverSettings = pSettings;
+	else
+		pEngine->pRetiredSettings = pSettings;
+
+	pEngine->setState(qsynthEngine::Loading);
+
+	// Start realizing (new) settings...
+	pSetup->realize();
+
+	// Create the new synthesizer.
+	appendMessages(sPrefix
+		+ tr("Creating synthesizer engine (seamless restart)") + sElipsis);
+	pEngine->pSwapSynth = ::new_fluid_synth(pSetup->fluid_settings());
+	if (pEngine->pSwapSynth == NULL) {
+		appendMessagesError(sPrefix
+			+ tr("Failed to create the synthesizer."));
+		pEngine->setState(qsynthEngine::Running);
+		return false;
+	}
+
+	// Load soundfonts in the background, whenever possible...
+	if (!loadEngineSoundFontsAsync(pEngine, pEngine->pSwapSynth)) {
+		loadEngineSoundFonts(pEngine, pEngine->pSwapSynth, NULL);
+		swapEngineSynth(pEngine);
+	}
+
+	return true;
+}
+
+
+// Seamless engine restart: hand over to the new synth, once all its
+// soundfonts are loaded; the old one fades out and gets destroyed
+// later, from the swap timer slot.
+void qsynthEngineManager::swapEngineSynth ( qsynthEngine *pEngine )
+{
+	fluid_synth_t *pNewSynth = pEngine->pSwapSynth;
+	if (pNewSynth == NULL)
+		return;
+
+	pEngine->pSwapSynth = NULL;
+
+	qsynthSetup *pSetup = pEngine->setup();
+	if (pSetup == NULL)
+		return;
+
+	const QString sPrefix  = pEngine->name() + ": ";
+	const QString sElipsis = "...";
+
+	pEngine->setState(qsynthEngine::Starting);
+
+	// Carry on with the current channel state...
+	QVector<qsynthEngine::ChannelState> channels;
+	qsynthEngine::saveChannels(pEngine->pSynth, channels);
+	qsynthEngine::loadChannels(pNewSynth, channels);
+
+	// The old synth settings (see swapEngine())...
+	fluid_settings_t *pOldSettings = pEngine->pRetiredSettings;
+	if (pOldSettings == NULL)
+		pOldSettings = pEngine->pDriverSettings;
+
+	// Server and player are bound to the old synth...
+#ifdef CONFIG_FLUID_SERVER
+	char szShellPort[] = "shell.port";
+	int iShellPort = 0;
+	if (pEngine->pServer) {
+		::fluid_settings_getint(pOldSettings, szShellPort, &iShellPort);
+		appendMessages(sPrefix + tr("Destroying server") + sElipsis);
+		::delete_fluid_server(pEngine->pServer);
+		pEngine->pServer = NULL;
+	}
+#endif
+	if (pEngine->pPlayer) {
+		::fluid_player_stop(pEngine->pPlayer);
+		::fluid_player_join(pEngine->pPlayer);
+		::delete_fluid_player(pEngine->pPlayer);
+		pEngine->pPlayer = NULL;
+	}
+
+	// Swap it in, on the very next audio buffer...
+	pEngine->swapSynth(pNewSynth,
+		int(pSetup->fSampleRate * QSYNTH_ENGINE_FADE_MSECS / 1000));
+
+	// Have the old one destroyed, once faded out...
+	if (!m_bSwapTimer) {
+		m_bSwapTimer = true;
+		QTimer::singleShot(QSYNTH_SWAP_MSECS, this, SLOT(swapTimerSlot()));
+	}
+
+#ifdef CONFIG_FLUID_MIDI_ROUTER
+	if (pEngine->pMidiRouter)
+		::fluid_synth_set_midi_router(pNewSynth, pEngine->pMidiRouter);
+#endif
+
+	// Re-create the MIDI player (idle: the midi files were
+	// played already, not to be replayed on a seamless restart).
+	appendMessages(sPrefix + tr("Creating MIDI player") + sElipsis);
+	pEngine->pPlayer = ::new_fluid_player(pNewSynth);
+	if (pEngine->pPlayer == NULL) {
+		appendMessagesError(sPrefix +
+			tr("Failed to create the MIDI player.\n\n"
+			"Continuing without a player."));
+	}
+
+#ifdef CONFIG_FLUID_SERVER
+	// Re-create the server, on the very same port.
+	if (iShellPort > 0) {
+		appendMessages(sPrefix + tr("Creating server") + sElipsis);
+		::fluid_settings_setint(
+			pSetup->fluid_settings(), szShellPort, iShellPort);
+		pEngine->pServer = ::new_fluid_server(
+			pSetup->fluid_settings(), qsynth_newclient, pNewSynth);
+		if (pEngine->pServer == NULL)
+			appendMessagesError(sPrefix +
+				tr("Failed to create the server.\n\n"
+				"Continuing without it."));
+	}
+#endif
+
+	// The current one gets its settings from the GUI panel...
+	if (pEngine != currentEngine())
+		realizeEngineSettings(pEngine);
+
+	// Show up our efforts...
+	pEngine->resetPresetIndex();
+	emit engineReady(pEngine, false);
+
+	appendMessages(sPrefix
+		+ tr("Synthesizer engine swapped; fading out the previous one") + sElipsis);
+}
+
+
+// Restart an engine, without prompting; it gets started
+// over again as soon as it's stopped (see engineStopped()).
+void qsynthEngineManager::restartEngineNow ( qsynthEngine *pEngine )
+{
+	if (pEngine == NULL)
+		return;
+
+	// Try to get it restarted seamlessly, first...
+	if (m_pOptions->bSeamlessRestart && swapEngine(pEngine))
+		return;
+
+	if (pEngine->state() == qsynthEngine::Stopped) {
+		startEngine(pEngine);
+	} else {
+		pEngine->bRestart = true;
+		stopEngine(pEngine);
+	}
+}
+
+
+// Engine reset (all channels program reset).
+void qsynthEngineManager::resetEngine ( qsynthEngine *pEngine )
+{
+	if (pEngine && pEngine->pSynth) {
+		appendMessagesColor(pEngine->name()
+			+ ": fluid_synth_program_reset()", "#996666");
+		::fluid_synth_program_reset(pEngine->pSynth);
+	}
+}
+
+
+// Engine gain settings.
+void qsynthEngineManager::setEngineGain ( qsynthEngine *pEngine, float fGain )
+{
+	appendMessagesColor(pEngine->name()
+		+ ": fluid_synth_set_gain("
+		+ QString::number(fGain) + ")", "#6699cc");
+
+	::fluid_synth_set_gain(pEngine->pSynth, fGain);
+}
+
+
+// Engine reverb settings.
+void qsynthEngineManager::setEngineReverbOn ( qsynthEngine *pEngine, bool bActive )
+{
+	appendMessagesColor(pEngine->name()
+		+ ": fluid_synth_set_reverb_on("
+		+ QString::number((int) bActive) + ")", "#99cc33");
+
+	::fluid_synth_set_reverb_on(pEngine->pSynth, (int) bActive);
+}
+
+
+void qsynthEngineManager::setEngineReverb ( qsynthEngine *pEngine,
+	double fRoom, double fDamp, double fWidth, double fLevel )
+{
+	appendMessagesColor(pEngine->name()
+		+ ": fluid_synth_set_reverb("
+		+ QString::number(fRoom)  + ","
+		+ QString::number(fDamp)  + ","
+		+ QString::number(fWidth) + ","
+		+ QString::number(fLevel) + ")", "#99cc66");
+
+	::fluid_synth_set_reverb(pEngine->pSynth, fRoom, fDamp, fWidth, fLevel);
+}
+
+
+// Engine chorus settings.
+void qsynthEngineManager::setEngineChorusOn ( qsynthEngine *pEngine, bool bActive )
+{
+	appendMessagesColor(pEngine->name()
+		+ ": fluid_synth_set_chorus_on("
+		+ QString::number((int) bActive) + ")", "#cc9933");
+
+	::fluid_synth_set_chorus_on(pEngine->pSynth, (int) bActive);
+}
+
+
+void qsynthEngineManager::setEngineChorus ( qsynthEngine *pEngine,
+	int iNr, double fLevel, double fSpeed, double fDepth, int iType )
+{
+	appendMessagesColor(pEngine->name()
+		+ ": fluid_synth_set_chorus("
+		+ QString::number(iNr)    + ","
+		+ QString::number(fLevel) + ","
+		+ QString::number(fSpeed) + ","
+		+ QString::number(fDepth) + ","
+		+ QString::number(iType)  + ")", "#cc9966");
+
+	::fluid_synth_set_chorus(pEngine->pSynth, iNr, fLevel, fSpeed, fDepth, iType);
+}
+
+
+//-------------------------------------------------------------------------
+// Offline MIDI file rendering.
+
+void qsynthEngineManager::startRender ( qsynthRender *pRender )
+{
+	if (pRender == NULL)
+		return;
+
+	QObject::connect(pRender,
+		SIGNAL(jobStarted(int)),
+		SLOT(renderJobStarted(int)));
+	QObject::connect(pRender,
+		SIGNAL(jobFinished(int)),
+		SLOT(renderJobFinished(int)));
+	QObject::connect(pRender,
+		SIGNAL(finished()),
+		SLOT(renderJobsFinished()));
+
+	appendMessagesColor(
+		tr("Rendering %1 file(s) offline")
+		.arg(pRender->jobCount()) + "...", "#999933");
+
+	pRender->start();
+}
+
+
+void qsynthEngineManager::renderJobStarted ( int iJob )
+{
+	qsynthRender *pRender = qobject_cast<qsynthRender *> (sender());
+	if (pRender == NULL)
+		return;
+
+	appendMessagesColor(pRender->name(iJob) + ": " +
+		tr("Rendering \"%1\" into \"%2\"")
+		.arg(pRender->midiFile(iJob))
+		.arg(pRender->outputFile(iJob)) + "...", "#999933");
+}
+
+
+void qsynthEngineManager::renderJobFinished ( int iJob )
+{
+	qsynthRender *pRender = qobject_cast<qsynthRender *> (sender());
+	if (pRender == NULL)
+		return;
+
+	const QString sPrefix = pRender->name(iJob) + ": ";
+	const float fSeconds = pRender->seconds(iJob);
+	const float fElapsed = pRender->elapsed(iJob);
+
+	switch (pRender->state(iJob)) {
+	case qsynthRender::Done:
+		appendMessagesColor(sPrefix +
+			tr("Rendered \"%1\" (%2 s in %3 s, %4x realtime).")
+			.arg(pRender->outputFile(iJob))
+			.arg(fSeconds, 0, 'f', 1)
+			.arg(fElapsed, 0, 'f', 1)
+			.arg(fElapsed > 0.0f ? fSeconds / fElapsed : 0.0f, 0, 'f', 1),
+			"#999933");
+		break;
+	case qsynthRender::Failed:
+		appendMessagesError(sPrefix +
+			tr("Failed to render \"%1\".")
+			.arg(pRender->midiFile(iJob)) + "\n\n" + pRender->error(iJob));
+		break;
+	case qsynthRender::Cancelled:
+		appendMessagesColor(sPrefix +
+			tr("Rendering cancelled: \"%1\".")
+			.arg(pRender->midiFile(iJob)), "#999933");
+		break;
+	default:
+		break;
+	}
+}
+
+
+void qsynthEngineManager::renderJobsFinished (void)
+{
+	qsynthRender *pRender = qobject_cast<qsynthRender *> (sender());
+	if (pRender == NULL)
+		return;
+
+	appendMessagesColor(
+		tr("Offline rendering done (%1 of %2 file(s) failed).")
+		.arg(pRender->failedCount())
+		.arg(pRender->jobCount()), "#999933");
+
+	emit renderFinished(pRender);
+}
+
+
+// end of qsynthEngineManager.cpp
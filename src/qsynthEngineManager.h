@@ -0,0 +1,197 @@
+// qsynthEngineManager.h
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qsynthEngineManager_h
+#define __qsynthEngineManager_h
+
+#include "qsynthEngine.h"
+
+#include <QObject>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QVector>
+
+
+// Forward declarations.
+class qsynthOptions;
+class qsynthSoundFontLoader;
+class qsynthRender;
+class QTimer;
+
+
+//-------------------------------------------------------------------------
+// qsynthEngineManager - GUI independent engine lifecycle management.
+//
+// Engines are started, stopped, restarted (seamlessly or not) and
+// set up in place here, all driven by the Qt event loop, whether the
+// main form (see qsynthMainForm) or a plain core application (headless
+// mode) is running. Engines are not owned here, just registered.
+
+class qsynthEngineManager : public QObject
+{
+	Q_OBJECT
+
+public:
+
+	// Constructor.
+	qsynthEngineManager(qsynthOptions *pOptions, QObject *pParent = NULL);
+	// Destructor.
+	~qsynthEngineManager();
+
+	// Engine registry.
+	void addEngine(qsynthEngine *pEngine);
+	void removeEngine(qsynthEngine *pEngine);
+
+	const QList<qsynthEngine *>& engines() const;
+
+	// Current selected engine (panel settings are owned by the GUI).
+	void setCurrentEngine(qsynthEngine *pEngine);
+	qsynthEngine *currentEngine() const;
+
+	// Echo all messages to stdout/stderr (headless mode).
+	void setEcho(bool bEcho);
+	bool isEcho() const;
+
+	// Engine lifecycle.
+	bool startEngine(qsynthEngine *pEngine);
+	void stopEngine(qsynthEngine *pEngine);
+	void restartEngineNow(qsynthEngine *pEngine);
+	void resetEngine(qsynthEngine *pEngine);
+
+	void startAllEngines();
+	void stopAllEngines();
+
+	// Apply changed setup values in place, if possible.
+	bool updateEngineSetup(qsynthEngine *pEngine,
+		const QStringList& changes);
+
+	// Add files to the soundfont stack or MIDI player playlist.
+	void playLoadFiles(qsynthEngine *pEngine,
+		const QStringList& files, bool bSetup);
+
+	// Realtime engine settings.
+	void setEngineGain(qsynthEngine *pEngine, float fGain);
+	void setEngineReverbOn(qsynthEngine *pEngine, bool bActive);
+	void setEngineReverb(qsynthEngine *pEngine,
+		double fRoom, double fDamp, double fWidth, double fLevel);
+	void setEngineChorusOn(qsynthEngine *pEngine, bool bActive);
+	void setEngineChorus(qsynthEngine *pEngine,
+		int iNr, double fLevel, double fSpeed, double fDepth, int iType);
+
+	// MIDI monitored engine (NULL for none).
+	void setMidiMonitor(qsynthEngine *pEngine);
+	qsynthEngine *midiMonitor() const;
+
+	// Offline MIDI file rendering, reported through messages
+	// (the renderer is not owned here either).
+	void startRender(qsynthRender *pRender);
+
+signals:
+
+	// Message output (color may be empty).
+	void messages(const QString& s, const QString& c);
+	void messagesError(const QString& s);
+
+	// Engine setup is about to be saved (eg. panel settings).
+	void setupAboutToSave(qsynthEngine *pEngine);
+
+	// Engine started or swapped (panel and presets may need a refresh).
+	void engineReady(qsynthEngine *pEngine, bool bReset);
+
+	// Engine soundfont stack/presets changed.
+	void enginePresetsChanged(qsynthEngine *pEngine);
+
+	// Soundfont background loading progress.
+	void soundFontProgress();
+
+	// MIDI event tap batch (monitored and dumping engines).
+	void midiTapEvents(qsynthEngine *pEngine,
+		const QVector<qsynthMidiTapEvent>& events);
+
+	// Offline rendering done with (all jobs reported).
+	void renderFinished(qsynthRender *pRender);
+
+public slots:
+
+	void cancelSoundFontLoaders();
+
+protected slots:
+
+	void engineStopped();
+
+	void soundFontLoaderProgress();
+	void soundFontLoaderFinished();
+
+	void swapTimerSlot();
+
+	void midiTapTimerSlot();
+
+	void renderJobStarted(int iJob);
+	void renderJobFinished(int iJob);
+	void renderJobsFinished();
+
+protected:
+
+	// Messages output methods.
+	void appendMessages(const QString& s);
+	void appendMessagesColor(const QString& s, const QString& c);
+	void appendMessagesError(const QString& s);
+
+	bool loadEngineSoundFontsAsync(qsynthEngine *pEngine,
+		fluid_synth_t *pSynth);
+	void loadEngineSoundFonts(qsynthEngine *pEngine,
+		fluid_synth_t *pSynth, qsynthSoundFontLoader *pLoader);
+	bool startEngineDrivers(qsynthEngine *pEngine);
+
+	void realizeEngineSettings(qsynthEngine *pEngine);
+
+	void updateMidiTaps();
+
+	void reloadEngineSoundFonts(qsynthEngine *pEngine);
+
+	bool swapEngine(qsynthEngine *pEngine);
+	void swapEngineSynth(qsynthEngine *pEngine);
+	void deleteEngineSynth(qsynthEngine *pEngine, fluid_synth_t *pSynth);
+
+private:
+
+	// Instance variables.
+	qsynthOptions *m_pOptions;
+
+	QList<qsynthEngine *> m_engines;
+
+	qsynthEngine *m_pCurrentEngine;
+
+	bool m_bEcho;
+	bool m_bSwapTimer;
+
+	// MIDI event taps.
+	qsynthEngine *m_pMonitorEngine;
+	QTimer *m_pMidiTapTimer;
+	QHash<qsynthEngine *, int> m_midiTapDropped;
+};
+
+
+#endif  // __qsynthEngineManager_h
+
+
+// end of qsynthEngineManager.h
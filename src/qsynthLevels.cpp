@@ -0,0 +1,251 @@
+// qsynthLevels.cpp
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qsynthLevels.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QSYNTH_LEVELS_X86
+#include <immintrin.h>
+#endif
+
+
+// Single buffer kernel prototype.
+typedef void (*qsynth_levels_func) ( const float *pBuffer, int nframes,
+	float *pfPeak, float *pfSumSq );
+
+
+//-------------------------------------------------------------------------
+// Scalar (portable) kernel.
+
+static void qsynth_levels_scalar ( const float *pBuffer, int nframes,
+	float *pfPeak, float *pfSumSq )
+{
+	float fPeak  = 0.0f;
+	float fSumSq = 0.0f;
+
+	for (int j = 0; j < nframes; ++j) {
+		const float fValue = pBuffer[j];
+		const float fAbs = ::fabsf(fValue);
+		if (fPeak < fAbs)
+			fPeak = fAbs;
+		fSumSq += fValue * fValue;
+	}
+
+	if (*pfPeak < fPeak)
+		*pfPeak = fPeak;
+	*pfSumSq += fSumSq;
+}
+
+
+#ifdef QSYNTH_LEVELS_X86
+
+//-------------------------------------------------------------------------
+// SSE2 kernel (4 floats wide, two accumulators).
+
+__attribute__((target("sse2")))
+static void qsynth_levels_sse2 ( const float *pBuffer, int nframes,
+	float *pfPeak, float *pfSumSq )
+{
+	const __m128 vMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+	__m128 vPeak0 = _mm_setzero_ps();
+	__m128 vPeak1 = _mm_setzero_ps();
+	__m128 vSum0  = _mm_setzero_ps();
+	__m128 vSum1  = _mm_setzero_ps();
+
+	int j = 0;
+	for ( ; j + 8 <= nframes; j += 8) {
+		const __m128 v0 = _mm_loadu_ps(pBuffer + j);
+		const __m128 v1 = _mm_loadu_ps(pBuffer + j + 4);
+		vPeak0 = _mm_max_ps(vPeak0, _mm_and_ps(v0, vMask));
+		vPeak1 = _mm_max_ps(vPeak1, _mm_and_ps(v1, vMask));
+		vSum0  = _mm_add_ps(vSum0, _mm_mul_ps(v0, v0));
+		vSum1  = _mm_add_ps(vSum1, _mm_mul_ps(v1, v1));
+	}
+
+	vPeak0 = _mm_max_ps(vPeak0, vPeak1);
+	vSum0  = _mm_add_ps(vSum0, vSum1);
+
+	float afPeak[4], afSum[4];
+	_mm_storeu_ps(afPeak, vPeak0);
+	_mm_storeu_ps(afSum,  vSum0);
+
+	float fPeak = afPeak[0];
+	for (int k = 1; k < 4; ++k) {
+		if (fPeak < afPeak[k])
+			fPeak = afPeak[k];
+	}
+
+	float fSumSq = (afSum[0] + afSum[1]) + (afSum[2] + afSum[3]);
+
+	// Remainder...
+	for ( ; j < nframes; ++j) {
+		const float fValue = pBuffer[j];
+		const float fAbs = ::fabsf(fValue);
+		if (fPeak < fAbs)
+			fPeak = fAbs;
+		fSumSq += fValue * fValue;
+	}
+
+	if (*pfPeak < fPeak)
+		*pfPeak = fPeak;
+	*pfSumSq += fSumSq;
+}
+
+
+//-------------------------------------------------------------------------
+// AVX2 kernel (8 floats wide, two accumulators).
+
+__attribute__((target("avx2")))
+static void qsynth_levels_avx2 ( const float *pBuffer, int nframes,
+	float *pfPeak, float *pfSumSq )
+{
+	const __m256 vMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+	__m256 vPeak0 = _mm256_setzero_ps();
+	__m256 vPeak1 = _mm256_setzero_ps();
+	__m256 vSum0  = _mm256_setzero_ps();
+	__m256 vSum1  = _mm256_setzero_ps();
+
+	int j = 0;
+	for ( ; j + 16 <= nframes; j += 16) {
+		const __m256 v0 = _mm256_loadu_ps(pBuffer + j);
+		const __m256 v1 = _mm256_loadu_ps(pBuffer + j + 8);
+		vPeak0 = _mm256_max_ps(vPeak0, _mm256_and_ps(v0, vMask));
+		vPeak1 = _mm256_max_ps(vPeak1, _mm256_and_ps(v1, vMask));
+		vSum0  = _mm256_add_ps(vSum0, _mm256_mul_ps(v0, v0));
+		vSum1  = _mm256_add_ps(vSum1, _mm256_mul_ps(v1, v1));
+	}
+
+	vPeak0 = _mm256_max_ps(vPeak0, vPeak1);
+	vSum0  = _mm256_add_ps(vSum0, vSum1);
+
+	// Fold down to 128 bits...
+	__m128 vPeak = _mm_max_ps(
+		_mm256_castps256_ps128(vPeak0), _mm256_extractf128_ps(vPeak0, 1));
+	__m128 vSum = _mm_add_ps(
+		_mm256_castps256_ps128(vSum0), _mm256_extractf128_ps(vSum0, 1));
+
+	float afPeak[4], afSum[4];
+	_mm_storeu_ps(afPeak, vPeak);
+	_mm_storeu_ps(afSum,  vSum);
+
+	float fPeak = afPeak[0];
+	for (int k = 1; k < 4; ++k) {
+		if (fPeak < afPeak[k])
+			fPeak = afPeak[k];
+	}
+
+	float fSumSq = (afSum[0] + afSum[1]) + (afSum[2] + afSum[3]);
+
+	// Remainder...
+	for ( ; j < nframes; ++j) {
+		const float fValue = pBuffer[j];
+		const float fAbs = ::fabsf(fValue);
+		if (fPeak < fAbs)
+			fPeak = fAbs;
+		fSumSq += fValue * fValue;
+	}
+
+	if (*pfPeak < fPeak)
+		*pfPeak = fPeak;
+	*pfSumSq += fSumSq;
+}
+
+#endif	// QSYNTH_LEVELS_X86
+
+
+//-------------------------------------------------------------------------
+// Runtime dispatch.
+
+static qsynth_levels_func g_pLevelsFunc = qsynth_levels_scalar;
+static const char        *g_pszLevelsName = "scalar";
+
+
+// Select the best kernel for the running CPU.
+void qsynth_levels_init (void)
+{
+#ifdef QSYNTH_LEVELS_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		g_pLevelsFunc   = qsynth_levels_avx2;
+		g_pszLevelsName = "avx2";
+	}
+	else
+	if (__builtin_cpu_supports("sse2")) {
+		g_pLevelsFunc   = qsynth_levels_sse2;
+		g_pszLevelsName = "sse2";
+	}
+#endif
+}
+
+
+// Name of the selected kernel.
+const char *qsynth_levels_name (void)
+{
+	return g_pszLevelsName;
+}
+
+
+// Select some kernel by name instead.
+bool qsynth_levels_select ( const char *pszName )
+{
+	if (::strcmp(pszName, "scalar") == 0) {
+		g_pLevelsFunc   = qsynth_levels_scalar;
+		g_pszLevelsName = "scalar";
+		return true;
+	}
+#ifdef QSYNTH_LEVELS_X86
+	__builtin_cpu_init();
+	if (::strcmp(pszName, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+		g_pLevelsFunc   = qsynth_levels_sse2;
+		g_pszLevelsName = "sse2";
+		return true;
+	}
+	if (::strcmp(pszName, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+		g_pLevelsFunc   = qsynth_levels_avx2;
+		g_pszLevelsName = "avx2";
+		return true;
+	}
+#endif
+	return false;
+}
+
+
+// Accumulate absolute peak and sum of squares of all buffers in one pass.
+void qsynth_levels ( int nbuffers, float **ppBuffers, int nframes,
+	int nports, float *pfPeak, float *pfSumSq )
+{
+	if (nports < 1)
+		return;
+
+	for (int i = 0; i < nbuffers; ++i) {
+		const int iPort = i % nports;
+		(*g_pLevelsFunc)(ppBuffers[i], nframes,
+			&pfPeak[iPort], &pfSumSq[iPort]);
+	}
+}
+
+
+// end of qsynthLevels.cpp
@@ -0,0 +1,50 @@
+// qsynthLevels.h
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qsynthLevels_h
+#define __qsynthLevels_h
+
+
+//-------------------------------------------------------------------------
+// Output level metering kernel (absolute peak and sum of squares).
+//
+// Buffer i is accumulated into port (i % nports), that is, pfPeak[] gets
+// the maximum absolute sample value and pfSumSq[] gets the sum of squares
+// added to whatever was there before. Realtime safe.
+
+void qsynth_levels ( int nbuffers, float **ppBuffers, int nframes,
+	int nports, float *pfPeak, float *pfSumSq );
+
+// Select the best kernel for the running CPU (call once, early).
+void qsynth_levels_init (void);
+
+// Name of the selected kernel (eg. "avx2", "sse2", "scalar").
+const char *qsynth_levels_name (void);
+
+// Select some kernel by name instead (eg. for benchmarking);
+// false if not available on the running CPU.
+bool qsynth_levels_select ( const char *pszName );
+
+
+#endif  // __qsynthLevels_h
+
+
+// end of qsynthLevels.h
@@ -22,7 +22,12 @@
 #include "qsynthAbout.h"
 #include "qsynthMainForm.h"
 #include "qsynthEngine.h"
+#include "qsynthEngineManager.h"
 #include "qsynthTabBar.h"
+#include "qsynthSoundFontLoader.h"
+#include "qsynthSoundFontMeta.h"
+#include "qsynthStdoutReader.h"
+#include "qsynthRender.h"
 
 #ifdef CONFIG_SYSTEM_TRAY
 #include "qsynthSystemTray.h"
@@ -33,6 +38,7 @@
 #include "qsynthOptionsForm.h"
 #include "qsynthMessagesForm.h"
 #include "qsynthChannelsForm.h"
+#include "qsynthMidiMonitorForm.h"
 
 #include "qsynthDialClassicStyle.h"
 #include "qsynthDialVokiStyle.h"
@@ -40,9 +46,13 @@
 #include "qsynthDialSkulptureStyle.h"
 
 #include <QApplication>
-#include <QSocketNotifier>
 #include <QMessageBox>
 #include <QSettings>
+#include <QProgressDialog>
+#include <QFileDialog>
+#include <QInputDialog>
+#include <QThread>
+#include <QFileInfo>
 #include <QDateTime>
 #include <QRegExp>
 #include <QTimer>
@@ -50,6 +60,7 @@
 #include <QUrl>
 
 #include <QCloseEvent>
+#include <QShowEvent>
 #include <QContextMenuEvent>
 #include <QDragEnterEvent>
 #include <QDropEvent>
@@ -67,8 +78,10 @@ const WindowFlags WindowCloseButtonHint = WindowFlags(0x08000000);
 #endif
 
 
-// Timer constant stuff.
+// Timer constant stuff (the frame rate is only
+// in effect while the output meters are moving).
 #define QSYNTH_TIMER_MSECS  100
+#define QSYNTH_FRAME_MSECS  33
 #define QSYNTH_DELAY_MSECS  300
 
 // Scale factors.
@@ -93,6 +106,10 @@ const WindowFlags WindowCloseButtonHint = WindowFlags(0x08000000);
 #define QSYNTH_FDNIL     -1
 #define QSYNTH_FDREAD     0
 #define QSYNTH_FDWRITE    1
+
+// Captured stdout pipe capacity, if it can be set (Linux).
+#define QSYNTH_STDOUT_PIPESIZE  (1024 * 1024)
+
 static int g_fdStdout[2] = { QSYNTH_FDNIL, QSYNTH_FDNIL };
 #endif
 
@@ -118,128 +135,6 @@ static inline long lroundf ( float x )
 static qsynthEngine *g_pCurrentEngine = NULL;
 
 
-#ifdef CONFIG_FLUID_SERVER
-
-// Hold last shell/server port in use.
-static int g_iLastShellPort = 0;
-
-
-// Needed for server mode.
-static fluid_cmd_handler_t* qsynth_newclient ( void* data, char* )
-{
-	return ::new_fluid_cmd_handler((fluid_synth_t*) data);
-}
-
-#endif
-
-
-//-------------------------------------------------------------------------
-// Audio driver processing stub.
-
-int qsynth_process ( void *pvData, int len,
-	int nin, float **in, int nout, float **out )
-{
-	qsynthEngine *pEngine = (qsynthEngine *) pvData;
-	// Call the synthesizer process function to fill
-	// the output buffers with its audio output.
-	if (::fluid_synth_process(pEngine->pSynth, len, nin, in, nout, out) != 0)
-		return -1;
-	// Now find the peak level for this buffer run...
-	if (pEngine == g_pCurrentEngine) {
-		for (int i = 0; i < nout; ++i) {
-			float *out_i = out[i];
-			for (int j = 0; j < len; ++j) {
-				float fValue = out_i[j];
-				if (pEngine->fMeterValue[i & 1] < fValue)
-					pEngine->fMeterValue[i & 1] = fValue;
-			}
-		}
-	}
-	// Surely a success :)
-	return 0;
-}
-
-
-//-------------------------------------------------------------------------
-// Midi router stubs to have some midi activity feedback.
-
-#define QSYNTH_MIDI_NOTE_OFF            0x80
-#define QSYNTH_MIDI_NOTE_ON             0x90
-#define QSYNTH_MIDI_CONTROL_CHANGE      0xb0
-#define QSYNTH_MIDI_PROGRAM_CHANGE      0xc0
-
-#define QSYNTH_MIDI_CC_BANK_SELECT_MSB  0x00
-#define QSYNTH_MIDI_CC_BANK_SELECT_LSB  0x20
-#define QSYNTH_MIDI_CC_ALL_SOUND_OFF    0x78
-
-
-struct qsynth_midi_channel
-{
-	int iEvent;     // Event occurrence accumulator.
-	int iState;     // Activity state tracker.
-	int iChange;    // Change activity accumulator.
-};
-
-
-static int                  g_iMidiChannels  = 0;
-static qsynth_midi_channel *g_pMidiChannels  = NULL;
-
-
-static void qsynth_midi_event ( qsynthEngine *pEngine,
-	fluid_midi_event_t *pMidiEvent )
-{
-	pEngine->iMidiEvent++;
-
-	if (g_pMidiChannels && pEngine == g_pCurrentEngine) {
-		const int iChan = ::fluid_midi_event_get_channel(pMidiEvent);
-	#ifdef CONFIG_DEBUG
-		const int iType = ::fluid_midi_event_get_type(pMidiEvent);
-		const int iKey  = ::fluid_midi_event_get_control(pMidiEvent);
-		const int iVal  = ::fluid_midi_event_get_value(pMidiEvent);
-		fprintf(stderr, "Type=%03d (0x%02x) Chan=%02d Key=%03d (0x%02x) Val=%03d (0x%02x).\n",
-			iType, iType, iChan, iKey, iKey, iVal, iVal);
-	#endif
-		if (iChan >= 0 && iChan < g_iMidiChannels) {
-			switch (::fluid_midi_event_get_type(pMidiEvent)) {
-			case QSYNTH_MIDI_CONTROL_CHANGE: {
-				// Avoid bank selects or global control changes...
-				const int iCC = ::fluid_midi_event_get_control(pMidiEvent);
-				if (iCC == QSYNTH_MIDI_CC_BANK_SELECT_MSB ||
-					iCC == QSYNTH_MIDI_CC_BANK_SELECT_LSB ||
-					iCC >= QSYNTH_MIDI_CC_ALL_SOUND_OFF)
-					break;
-			}	// Fall thru...
-			case QSYNTH_MIDI_PROGRAM_CHANGE:
-				g_pMidiChannels[iChan].iChange++;
-				// Fall thru...
-			case QSYNTH_MIDI_NOTE_ON:
-			case QSYNTH_MIDI_NOTE_OFF:
-				g_pMidiChannels[iChan].iEvent++;
-				break;
-			}
-		}
-	}
-}
-
-
-static int qsynth_dump_postrouter ( void *pvData,
-	fluid_midi_event_t *pMidiEvent )
-{
-	qsynthEngine *pEngine = (qsynthEngine *) pvData;
-	qsynth_midi_event(pEngine, pMidiEvent);
-	return ::fluid_midi_dump_postrouter(pEngine->pSynth, pMidiEvent);
-}
-
-
-static int qsynth_handle_midi_event ( void *pvData,
-	fluid_midi_event_t *pMidiEvent )
-{
-	qsynthEngine *pEngine = (qsynthEngine *) pvData;
-	qsynth_midi_event(pEngine, pMidiEvent);
-	return ::fluid_synth_handle_midi_event(pEngine->pSynth, pMidiEvent);
-}
-
-
 //-------------------------------------------------------------------------
 // Scaling & Clipping helpers.
 
@@ -276,79 +171,6 @@ static float qsynth_get_range_value ( QSpinBox *pSpinBox, float fScale )
 }
 
 
-#ifdef QSYNTH_CUSTOM_LOADER
-//-------------------------------------------------------------------------
-// (EXPERIMENTAL) Soundfont loader: feature to avoid loading
-// duplicate soundfonts for multiple engines.
-
-static
-struct qsynthEngineNode
-{
-	qsynthEngine     *pEngine;
-	qsynthEngineNode *pPrev;
-	qsynthEngineNode *pNext;
-
-} *g_pEngineList = NULL;
-
-
-static int qsynth_sfont_free ( fluid_sfont_t *pSoundFont )
-{
-#ifdef CONFIG_DEBUG
-	fprintf(stderr, "qsynth_sfont_free(%p)\n", pSoundFont);
-#endif
-	if (pSoundFont)	::free(pSoundFont);
-	return 0;
-}
-
-static int qsynth_sfloader_free ( fluid_sfloader_t * pLoader )
-{
-#ifdef CONFIG_DEBUG
-	fprintf(stderr, "qsynth_sfloader_free(%p)\n", pLoader);
-#endif
-	if (pLoader) ::free(pLoader);
-	return 0;
-}
-
-
-static fluid_sfont_t *qsynth_sfloader_load (
-	fluid_sfloader_t *pLoader, const char *pszFilename )
-{
-#ifdef CONFIG_DEBUG
-	fprintf(stderr, "qsynth_sfloader_load(%p, \"%s\")\n", pLoader, pszFilename);
-#endif
-
-	if (pLoader == NULL)
-		return NULL;
-
-	// Look thru all the synths' sfonts for the requested one...
-	qsynthEngineNode *pNode = g_pEngineList;
-	while (pNode) {
-		fluid_synth_t *pSynth = (pNode->pEngine)->pSynth;
-		const int iSoundFonts = ::fluid_synth_sfcount(pSynth);
-		for (int i = 0; i < iSoundFonts; ++i) {
-			fluid_sfont_t *pSoundFont = ::fluid_synth_get_sfont(pSynth, i);
-			// Somehow get the name of this sfont...
-			char *pszName = pSoundFont->get_name(pSoundFont);
-			// Create a dup sfont node with our 'free' routine,
-			// when we have a match
-			if (::strcmp(pszName, pszFilename) == 0) {
-				fluid_sfont_t *pNewSoundFont
-					= (fluid_sfont_t *) ::malloc(sizeof(fluid_sfont_t));
-				::memcpy(pNewSoundFont, pSoundFont, sizeof(fluid_sfont_t));
-				pNewSoundFont->free = qsynth_sfont_free;
-				return pNewSoundFont;
-			}
-		}
-		pNode = pNode->pNext;
-	}
-
-	// fluidsynth will call next (or default) loader...
-	return NULL;
-}
-
-#endif	// QSYNTH_CUSTOM_LOADER
-
-
 //----------------------------------------------------------------------------
 // qsynthMainForm -- UI wrapper form.
 
@@ -368,11 +190,23 @@ qsynthMainForm::qsynthMainForm (
 
 	m_pOptions = NULL;
 
+	m_pEngineManager = NULL;
+
 	m_iTimerDelay = 0;
 
+	// The adaptive refresh timer, stopped while idle.
+	m_pTimer = new QTimer(this);
+	QObject::connect(m_pTimer,
+		SIGNAL(timeout()),
+		SLOT(timerSlot()));
+
 	m_iCurrentTab = -1;
 
-	m_pStdoutNotifier = NULL;
+	m_pStdoutReader = NULL;
+
+	m_pSoundFontProgress = NULL;
+
+	m_pRender = NULL;
 
 	m_iGainChanged   = 0;
 	m_iReverbChanged = 0;
@@ -385,6 +219,7 @@ qsynthMainForm::qsynthMainForm (
 	// All forms are to be created later on setup.
 	m_pMessagesForm  = NULL;
 	m_pChannelsForm  = NULL;
+	m_pMidiMonitorForm = NULL;
 
 #ifdef CONFIG_SYSTEM_TRAY
 	// The eventual system tray widget.
@@ -529,12 +364,24 @@ qsynthMainForm::qsynthMainForm (
 // Destructor.
 qsynthMainForm::~qsynthMainForm (void)
 {
+	// Cancel any offline rendering still in progress.
+	if (m_pRender) {
+		delete m_pRender;
+		m_pRender = NULL;
+	}
+
 	// Stop the press!
-	const int iTabCount = m_ui.TabBar->count();
-	for (int iTab = 0; iTab < iTabCount; ++iTab) {
-		qsynthEngine *pEngine = m_ui.TabBar->engine(iTab);
-		if (pEngine)
-			stopEngine(pEngine);
+	if (m_pEngineManager) {
+		m_pEngineManager->stopAllEngines();
+		delete m_pEngineManager;
+		m_pEngineManager = NULL;
+	}
+
+	// No more stdout/stderr capture reader.
+	if (m_pStdoutReader) {
+		m_pStdoutReader->stop();
+		delete m_pStdoutReader;
+		m_pStdoutReader = NULL;
 	}
 
 	// No more options descriptor.
@@ -545,6 +392,8 @@ qsynthMainForm::~qsynthMainForm (void)
 		delete m_pMessagesForm;
 	if (m_pChannelsForm)
 		delete m_pChannelsForm;
+	if (m_pMidiMonitorForm)
+		delete m_pMidiMonitorForm;
 
 #ifdef CONFIG_SYSTEM_TRAY
 	// Quit off system tray widget.
@@ -590,16 +439,44 @@ void qsynthMainForm::setup ( qsynthOptions *pOptions )
 	// All forms are to be created right now.
 	m_pMessagesForm = new qsynthMessagesForm(pParent, wflags);
 	m_pChannelsForm = new qsynthChannelsForm(pParent, wflags);
+	m_pMidiMonitorForm = new qsynthMidiMonitorForm(pParent, wflags);
 
 	// Setup appropriately...
 	m_pMessagesForm->setLogging(m_pOptions->bMessagesLog, m_pOptions->sMessagesLogPath);
 
+	// The engine manager, with all its message and state feedback.
+	m_pEngineManager = new qsynthEngineManager(m_pOptions, this);
+	QObject::connect(m_pEngineManager,
+		SIGNAL(messages(const QString&, const QString&)),
+		SLOT(engineMessages(const QString&, const QString&)));
+	QObject::connect(m_pEngineManager,
+		SIGNAL(messagesError(const QString&)),
+		SLOT(engineMessagesError(const QString&)));
+	QObject::connect(m_pEngineManager,
+		SIGNAL(setupAboutToSave(qsynthEngine *)),
+		SLOT(engineSetupAboutToSave(qsynthEngine *)));
+	QObject::connect(m_pEngineManager,
+		SIGNAL(engineReady(qsynthEngine *, bool)),
+		SLOT(engineReady(qsynthEngine *, bool)));
+	QObject::connect(m_pEngineManager,
+		SIGNAL(enginePresetsChanged(qsynthEngine *)),
+		SLOT(enginePresetsChanged(qsynthEngine *)));
+	QObject::connect(m_pEngineManager,
+		SIGNAL(soundFontProgress()),
+		SLOT(updateSoundFontProgress()));
+	QObject::connect(m_pEngineManager,
+		SIGNAL(midiTapEvents(qsynthEngine *, const QVector<qsynthMidiTapEvent>&)),
+		SLOT(midiMonitorEvents(qsynthEngine *, const QVector<qsynthMidiTapEvent>&)));
+	QObject::connect(m_pEngineManager,
+		SIGNAL(renderFinished(qsynthRender *)),
+		SLOT(renderFinished(qsynthRender *)));
+
 	// Get the default setup and dummy instace tab.
-	m_ui.TabBar->addEngine(new qsynthEngine(m_pOptions));
+	addEngine(new qsynthEngine(m_pOptions));
 	// And all additional custom ones...
 	QStringListIterator iter(m_pOptions->engines);
 	while (iter.hasNext())
-		m_ui.TabBar->addEngine(new qsynthEngine(m_pOptions, iter.next()));
+		addEngine(new qsynthEngine(m_pOptions, iter.next()));
 
 	// Try to restore old window positioning.
 	m_pOptions->loadWidgetGeometry(this, true);
@@ -607,6 +484,7 @@ void qsynthMainForm::setup ( qsynthOptions *pOptions )
 	// And for the whole widget gallore...
 	m_pOptions->loadWidgetGeometry(m_pMessagesForm);
 	m_pOptions->loadWidgetGeometry(m_pChannelsForm);
+	m_pOptions->loadWidgetGeometry(m_pMidiMonitorForm);
 
 	// Set defaults...
 	updateMessagesFont();
@@ -624,11 +502,15 @@ void qsynthMainForm::setup ( qsynthOptions *pOptions )
 		::dup2(g_fdStdout[QSYNTH_FDWRITE], STDOUT_FILENO);
 		::dup2(g_fdStdout[QSYNTH_FDWRITE], STDERR_FILENO);
 		stdoutBlock(g_fdStdout[QSYNTH_FDWRITE], false);
-		m_pStdoutNotifier = new QSocketNotifier(
-			g_fdStdout[QSYNTH_FDREAD], QSocketNotifier::Read, this);
-		QObject::connect(m_pStdoutNotifier,
-			SIGNAL(activated(int)),
-			SLOT(stdoutNotifySlot(int)));
+	#ifdef F_SETPIPE_SZ
+		::fcntl(g_fdStdout[QSYNTH_FDWRITE], F_SETPIPE_SZ, QSYNTH_STDOUT_PIPESIZE);
+	#endif
+		m_pStdoutReader = new qsynthStdoutReader(
+			g_fdStdout[QSYNTH_FDREAD], this);
+		QObject::connect(m_pStdoutReader,
+			SIGNAL(linesReady()),
+			SLOT(stdoutLinesSlot()));
+		m_pStdoutReader->start();
 	}
 #endif
 
@@ -648,7 +530,7 @@ void qsynthMainForm::setup ( qsynthOptions *pOptions )
 		SLOT(tabContextMenu(int, const QPoint &)));
 
 	// Register the initial timer slot.
-	QTimer::singleShot(QSYNTH_TIMER_MSECS, this, SLOT(timerSlot()));
+	m_pTimer->start(QSYNTH_TIMER_MSECS);
 }
 
 
@@ -739,6 +621,7 @@ bool qsynthMainForm::queryClose (void)
 		// Try to save current positioning.
 		if (bQueryClose) {
 			m_pOptions->saveWidgetGeometry(m_pChannelsForm);
+			m_pOptions->saveWidgetGeometry(m_pMidiMonitorForm);
 			m_pOptions->saveWidgetGeometry(m_pMessagesForm);
 			m_pOptions->saveWidgetGeometry(this, true);
 			// Close popup widgets.
@@ -746,6 +629,8 @@ bool qsynthMainForm::queryClose (void)
 				m_pMessagesForm->close();
 			if (m_pChannelsForm)
 				m_pChannelsForm->close();
+			if (m_pMidiMonitorForm)
+				m_pMidiMonitorForm->close();
 		#if 0//CONFIG_SYSTEM_TRAY_0
 			// And the system tray icon too.
 			if (m_pSystemTray)
@@ -776,72 +661,29 @@ void qsynthMainForm::closeEvent ( QCloseEvent *pCloseEvent )
 }
 
 
-// Add dropped files to playlist or soundfont stack.
-void qsynthMainForm::playLoadFiles ( qsynthEngine *pEngine,
-	const QStringList& files, bool bSetup )
+// Window show and state change event handlers
+// (output meters may be visible again).
+void qsynthMainForm::showEvent ( QShowEvent *pShowEvent )
 {
-	if (pEngine == NULL)
-		return;
-	if (pEngine->pSynth == NULL)
-		return;
+	QWidget::showEvent(pShowEvent);
 
-	qsynthSetup *pSetup = pEngine->setup();
-	if (pSetup == NULL)
-		return;
+	timerWakeup();
+}
 
-	// Add each list item to Soundfont stack or MIDI player playlist...
-	const QString sPrefix  = pEngine->name() + ": ";
-	const QString sElipsis = "...";
-	int   iSoundFonts = 0;
-	int   iMidiFiles  = 0;
-	QStringListIterator iter(files);
-	while (iter.hasNext()) {
-		const QString& sFilename = iter.next();
-		// Is it a soundfont file...
-		if (::fluid_is_soundfont(sFilename.toLocal8Bit().data())) {
-			if (bSetup || !pSetup->soundfonts.contains(sFilename)) {
-				appendMessagesColor(sPrefix +
-					tr("Loading soundfont: \"%1\"")
-					.arg(sFilename) + sElipsis, "#999933");
-				if (::fluid_synth_sfload(
-						pEngine->pSynth, sFilename.toLocal8Bit().data(), 1) >= 0) {
-					iSoundFonts++;
-					if (!bSetup) {
-						pSetup->soundfonts.append(sFilename);
-						pSetup->bankoffsets.append("0");
-					}
-				} else {
-					appendMessagesError(sPrefix +
-						tr("Failed to load the soundfont: \"%1\".")
-						.arg(sFilename));
-				}
-			}
-		}
-		else  // Or is it a bare midifile?
-		if (::fluid_is_midifile(sFilename.toLocal8Bit().data()) && pEngine->pPlayer) {
-			appendMessagesColor(sPrefix +
-				tr("Playing MIDI file: \"%1\"")
-				.arg(sFilename) + sElipsis, "#99cc66");
-			if (::fluid_player_add(
-					pEngine->pPlayer, sFilename.toLocal8Bit().data()) >= 0) {
-				iMidiFiles++;
-			} else {
-				appendMessagesError(sPrefix +
-					tr("Failed to play MIDI file: \"%1\".")
-					.arg(sFilename));
-			}
-		}
-	}
 
-	// Reset all presets, if applicable...
-	if (!bSetup && iSoundFonts > 0) {
-		resetEngine(pEngine);
-		resetChannelsForm(pEngine, false);
-	}
+void qsynthMainForm::changeEvent ( QEvent *pEvent )
+{
+	QWidget::changeEvent(pEvent);
 
-	// Start playing, if any...
-	if (pEngine->pPlayer && iMidiFiles > 0)
-		::fluid_player_play(pEngine->pPlayer);
+	if (pEvent->type() == QEvent::WindowStateChange)
+		timerWakeup();
+}
+
+
+// Whether the main window is actually showing (not hidden nor minimized).
+bool qsynthMainForm::isShowing (void) const
+{
+	return (isVisible() && !isMinimized());
 }
 
 
@@ -860,7 +702,7 @@ void qsynthMainForm::dragEnterEvent ( QDragEnterEvent* pDragEnterEvent )
 					const QByteArray aFilename = sFilename.toLocal8Bit();
 					const char *pszFilename = aFilename.constData();
 					if (::fluid_is_midifile(pszFilename) ||
-						::fluid_is_soundfont(pszFilename))
+						qsynthSoundFontMeta::isSoundFont(sFilename))
 						bAccept = true;
 				}
 			}
@@ -889,7 +731,7 @@ void qsynthMainForm::dropEvent ( QDropEvent* pDropEvent )
 			if (!sFilename.isEmpty())
 				files.append(sFilename);
 		}
-		playLoadFiles(currentEngine(), files, false);
+		m_pEngineManager->playLoadFiles(currentEngine(), files, false);
 	}
 
 }
@@ -911,53 +753,37 @@ bool qsynthMainForm::stdoutBlock ( int fd, bool bBlock ) const
 }
 
 
-// Own stdout/stderr socket notifier slot.
-void qsynthMainForm::stdoutNotifySlot ( int fd )
+// Own stdout/stderr captured lines slot.
+void qsynthMainForm::stdoutLinesSlot (void)
 {
- #if !defined(__WIN32__) && !defined(_WIN32) && !defined(WIN32)
-	// Set non-blocking reads, if not already...
-	const bool bBlock = stdoutBlock(fd, false);
-	// Read as much as is available...
-	QString sTemp;
-	char achBuffer[1024];
-	const int cchBuffer = sizeof(achBuffer) - 1;
-	int cchRead = ::read(fd, achBuffer, cchBuffer);
-	while (cchRead > 0) {
-		achBuffer[cchRead] = (char) 0;
-		sTemp.append(achBuffer);
-		cchRead = (bBlock ? 0 : ::read(fd, achBuffer, cchBuffer));
-	}
-	// Needs to be non-empty...
-	if (!sTemp.isEmpty())
-		appendStdoutBuffer(sTemp);
-#endif
-}
+	if (m_pStdoutReader == NULL)
+		return;
 
+	int iDropped = 0;
+	bool bBackpressure = false;
+	const QStringList& lines
+		= m_pStdoutReader->takeLines(&iDropped, &bBackpressure);
 
-// Stdout buffer handler -- now splitted by complete new-lines...
-void qsynthMainForm::appendStdoutBuffer ( const QString& s )
-{
-	m_sStdoutBuffer.append(s);
+	QStringListIterator iter(lines);
+	while (iter.hasNext())
+		appendMessagesText(iter.next());
 
-	const int iLength = m_sStdoutBuffer.lastIndexOf('\n');
-	if (iLength > 0) {
-		const QString& sTemp = m_sStdoutBuffer.left(iLength);
-		m_sStdoutBuffer.remove(0, iLength + 1);
-		QStringList list = sTemp.split('\n');
-		QStringListIterator iter(list);
-		while (iter.hasNext())
-			appendMessagesText(iter.next());
+	if (iDropped > 0) {
+		appendMessagesColor(
+			tr("(%1 output lines dropped)").arg(iDropped), "#996666");
 	}
+
+	// Reader falling behind?
+	if (bBackpressure && m_pMessagesForm)
+		m_pMessagesForm->notifyBackpressure();
 }
 
 
 // Stdout flusher -- show up any unfinished line...
 void qsynthMainForm::flushStdoutBuffer (void)
 {
-	if (!m_sStdoutBuffer.isEmpty()) {
-		appendMessagesText(m_sStdoutBuffer);
-		m_sStdoutBuffer.truncate(0);
-	}
+	if (m_pStdoutReader)
+		m_pStdoutReader->flush();
 }
 
 
@@ -1124,8 +950,15 @@ void qsynthMainForm::contextMenu ( const QPoint& pos )
 	pAction->setCheckable(true);
 	pAction->setChecked(m_pChannelsForm && m_pChannelsForm->isVisible());
 	pAction->setEnabled(bEnabled);
+	pAction = menu.addAction(QIcon(":/images/messages1.png"),
+		tr("MIDI &Monitor"), this, SLOT(toggleMidiMonitorForm()));
+	pAction->setCheckable(true);
+	pAction->setChecked(m_pMidiMonitorForm && m_pMidiMonitorForm->isVisible());
 	pAction = menu.addAction(QIcon(":/images/setup1.png"),
 		tr("Set&up..."), this, SLOT(showSetupForm()));
+	pAction = menu.addAction(
+		tr("Re&nder..."), this, SLOT(renderMidiFiles()));
+	pAction->setEnabled(pEngine && m_pRender == NULL);
 	menu.addSeparator();
 
 	// Construct the actual engines menu,
@@ -1212,7 +1045,7 @@ void qsynthMainForm::stabilizeForm (void)
 	} else {
 		m_ui.RestartPushButton->setText(tr("&Start"));
 	}
-	m_ui.RestartPushButton->setEnabled(true);
+	m_ui.RestartPushButton->setEnabled(pEngine == NULL || !pEngine->isBusy());
 
 	m_ui.DeleteEngineToolButton->setEnabled(pEngine && !pEngine->isDefault());
 
@@ -1220,6 +1053,15 @@ void qsynthMainForm::stabilizeForm (void)
 		m_pMessagesForm && m_pMessagesForm->isVisible());
 	m_ui.ChannelsPushButton->setChecked(
 		m_pChannelsForm && m_pChannelsForm->isVisible());
+
+	// Only tap the engine being monitored, if any...
+	if (m_pMidiMonitorForm) {
+		m_pMidiMonitorForm->setEngine(pEngine);
+		if (m_pEngineManager) {
+			m_pEngineManager->setMidiMonitor(
+				m_pMidiMonitorForm->isVisible() ? pEngine : NULL);
+		}
+	}
 }
 
 
@@ -1228,7 +1070,7 @@ void qsynthMainForm::programReset (void)
 {
 	m_ui.ProgramResetPushButton->setEnabled(false);
 
-	resetEngine(currentEngine());
+	m_pEngineManager->resetEngine(currentEngine());
 	if (m_pChannelsForm)
 		m_pChannelsForm->resetAllChannels(true);
 	stabilizeForm();
@@ -1290,7 +1132,7 @@ void qsynthMainForm::newEngine (void)
 	pEngine = new qsynthEngine(m_pOptions, sName);
 	if (setupEngineTab(pEngine, -1)) {
 		// Success, add a new tab...
-		const int iTab = m_ui.TabBar->addEngine(pEngine);
+		const int iTab = addEngine(pEngine);
 		// And try to be persistent...
 		m_pOptions->newEngine(pEngine);
 		// Update bar...
@@ -1331,7 +1173,8 @@ bool qsynthMainForm::deleteEngineTab ( qsynthEngine *pEngine, int iTab )
 
 	if (bResult) {
 		// First we try to stop the angine.
-		stopEngine(pEngine);
+		m_pEngineManager->stopEngine(pEngine);
+		m_pEngineManager->removeEngine(pEngine);
 		// Better nullify the current reference, if applicable.
 		if (g_pCurrentEngine == pEngine)
 			g_pCurrentEngine = NULL;
@@ -1375,8 +1218,9 @@ bool qsynthMainForm::setupEngineTab ( qsynthEngine *pEngine, int iTab )
 		m_ui.TabBar->setTabText(iTab, pEngine->name());
 	}
 
-	// Now we may restart this.
-	restartEngine(pEngine);
+	// Now we may apply changes in place, or else restart this.
+	if (!m_pEngineManager->updateEngineSetup(pEngine, setupForm.changes()))
+		restartEngine(pEngine);
 
 	// Done.
 	return true;
@@ -1452,6 +1296,34 @@ void qsynthMainForm::toggleChannelsForm (void)
 }
 
 
+// MIDI monitor form requester slot.
+void qsynthMainForm::toggleMidiMonitorForm (void)
+{
+	if (m_pOptions == NULL)
+		return;
+
+	if (m_pMidiMonitorForm) {
+		m_pOptions->saveWidgetGeometry(m_pMidiMonitorForm);
+		if (m_pMidiMonitorForm->isVisible()) {
+			m_pMidiMonitorForm->hide();
+		} else {
+			m_pMidiMonitorForm->show();
+			m_pMidiMonitorForm->raise();
+			m_pMidiMonitorForm->activateWindow();
+		}
+	}
+}
+
+
+// MIDI monitor tapped events slot.
+void qsynthMainForm::midiMonitorEvents ( qsynthEngine *pEngine,
+	const QVector<qsynthMidiTapEvent>& events )
+{
+	if (m_pMidiMonitorForm && m_pMidiMonitorForm->engine() == pEngine)
+		m_pMidiMonitorForm->appendEvents(events);
+}
+
+
 // Instance dialog requester slot.
 void qsynthMainForm::showSetupForm (void)
 {
@@ -1578,6 +1450,7 @@ void qsynthMainForm::tabSelect ( int iTab )
 		if (pEngine) {
 			// Set current engine reference hack.
 			g_pCurrentEngine = pEngine;
+			m_pEngineManager->setCurrentEngine(pEngine);
 			// And do the change.
 			setWindowTitle(QSYNTH_TITLE " - " + tr(QSYNTH_SUBTITLE)
 				+ " [" + pEngine->name() + "]");
@@ -1609,32 +1482,159 @@ void qsynthMainForm::tabContextMenu ( int iTab, const QPoint& pos )
 	pAction = menu.addAction(QIcon(":/images/setup1.png"),
 		tr("Set&up..."), this, SLOT(showSetupForm()));
 	pAction->setEnabled(pEngine != NULL);
+	pAction = menu.addAction(
+		tr("Re&nder..."), this, SLOT(renderMidiFiles()));
+	pAction->setEnabled(pEngine && m_pRender == NULL);
 
 	menu.exec(pos);
 }
 
 
+// Offline MIDI file rendering (faster than realtime).
+void qsynthMainForm::renderMidiFiles (void)
+{
+	if (m_pOptions == NULL || m_pEngineManager == NULL)
+		return;
+	if (m_pRender)
+		return;
+
+	qsynthEngine *pEngine = currentEngine();
+	if (pEngine == NULL)
+		return;
+
+	qsynthSetup *pSetup = pEngine->setup();
+	if (pSetup == NULL)
+		return;
+
+	const QString sTitle = QSYNTH_TITLE ": " + tr("Render");
+
+	if (!qsynthRender::isAvailable()) {
+		QMessageBox::warning(this, sTitle,
+			tr("Offline rendering is not supported"
+				" by this fluidsynth library."));
+		return;
+	}
+
+	// Which midifiles (start from the playlist, if any)...
+	QString sMidiDir;
+	if (!pSetup->midifiles.isEmpty())
+		sMidiDir = QFileInfo(pSetup->midifiles.first()).absolutePath();
+	const QStringList& files = QFileDialog::getOpenFileNames(
+		this,										// Parent.
+		sTitle + " - " + tr("MIDI files"),			// Caption.
+		sMidiDir,									// Start here.
+		tr("MIDI files") + " (*.mid *.MID *.midi *.kar *.smf)" // Filter files.
+	);
+	if (files.isEmpty())
+		return;
+
+	// Where to...
+	const QString& sOutputDir = QFileDialog::getExistingDirectory(
+		this,										// Parent.
+		sTitle + " - " + tr("Output folder"),		// Caption.
+		QFileInfo(files.first()).absolutePath()		// Start here.
+	);
+	if (sOutputDir.isEmpty())
+		return;
+
+	// Which format...
+	QStringList formats;
+	formats << "wav" << "flac";
+	int iFormat = formats.indexOf(m_pOptions->sRenderFormat);
+	if (iFormat < 0)
+		iFormat = 0;
+	bool bOk = false;
+	const QString& sFormat = QInputDialog::getItem(this, sTitle,
+		tr("Audio file format:"), formats, iFormat, false, &bOk);
+	if (!bOk || sFormat.isEmpty())
+		return;
+	m_pOptions->sRenderFormat = sFormat;
+
+	// Through the current engine only, or all of them...
+	QList<qsynthEngine *> engines;
+	engines.append(pEngine);
+	const int iTabCount = m_ui.TabBar->count();
+	if (iTabCount > 1 && QMessageBox::question(this, sTitle,
+		tr("Render through all engines?"),
+		QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes) {
+		engines.clear();
+		for (int iTab = 0; iTab < iTabCount; ++iTab) {
+			pEngine = m_ui.TabBar->engine(iTab);
+			if (pEngine)
+				engines.append(pEngine);
+		}
+	}
+
+	// Go for it, all files in parallel...
+	m_pRender = new qsynthRender(QThread::idealThreadCount());
+	m_pRender->addJobs(engines, files, sOutputDir, sFormat);
+	m_pEngineManager->startRender(m_pRender);
+}
+
+
+// Offline MIDI file rendering done with.
+void qsynthMainForm::renderFinished ( qsynthRender *pRender )
+{
+	if (pRender != m_pRender)
+		return;
+
+	m_pRender->deleteLater();
+	m_pRender = NULL;
+}
+
+
 // Timer callback funtion.
 void qsynthMainForm::timerSlot (void)
 {
+	// Whether the timer should keep going (slow or fast)...
+	int  iTimerMsecs = 0;
+	bool bMeters = false;
+
+	// Output meters are only worth it while being shown.
+	const bool bShowing = isShowing();
+
 	// Is it the first shot on synth start after a one slot delay?
 	if (m_iTimerDelay < QSYNTH_DELAY_MSECS) {
-		m_iTimerDelay += QSYNTH_TIMER_MSECS;
+		m_iTimerDelay += m_pTimer->interval();
 		if (m_iTimerDelay >= QSYNTH_DELAY_MSECS) {
 			// Start the press!
-			const int iTabCount = m_ui.TabBar->count();
-			for (int iTab = 0; iTab < iTabCount; ++iTab)
-				startEngine(m_ui.TabBar->engine(iTab));
+			m_pEngineManager->startAllEngines();
+		} else {
+			iTimerMsecs = QSYNTH_TIMER_MSECS;
 		}
 	}
 
+	// Wakeup statistics...
+	if (m_pMessagesForm)
+		m_pMessagesForm->notifyTimerWakeup();
+
 	// Some global MIDI activity?
 	int iTabUpdate = 0;
 	const int iTabCount = m_ui.TabBar->count();
 	for (int iTab = 0; iTab < iTabCount; ++iTab) {
 		qsynthEngine *pEngine = m_ui.TabBar->engine(iTab);
-		if (pEngine->iMidiEvent > 0) {
-			pEngine->iMidiEvent = 0;
+		// Output level indicator, for each and every engine...
+		if (pEngine->bMeterEnabled && bShowing) {
+			const int iMeterVoices = pEngine->iMeterVoices;
+			pEngine->updateMeter();
+			float fLevel = 0.0f;
+			for (int i = 0; i < pEngine->iMeterPorts; ++i) {
+				if (fLevel < pEngine->fMeterValue[i])
+					fLevel = pEngine->fMeterValue[i];
+			}
+			if (fLevel > QSYNTH_ENGINE_WAKEUP_PEAK)
+				bMeters = true;
+			m_ui.TabBar->setLevel(iTab, fLevel);
+			if (pEngine == g_pCurrentEngine
+				&& pEngine->iMeterVoices != iMeterVoices) {
+				m_ui.OutputMeter->setToolTip(
+					tr("Output peak level (%1 active voices)")
+					.arg(pEngine->iMeterVoices));
+			}
+		}
+		const int iMidiEvent = pEngine->midiEvents();
+		if (pEngine->iMidiEvent != iMidiEvent) {
+			pEngine->iMidiEvent = iMidiEvent;
 			if (pEngine->iMidiState == 0) {
 				pEngine->iMidiState++;
 				m_ui.TabBar->setOn(iTab, true);
@@ -1648,7 +1648,7 @@ void qsynthMainForm::timerSlot (void)
 			#endif
 			}
 		}
-		else if (pEngine->iMidiEvent == 0 && pEngine->iMidiState > 0) {
+		else if (pEngine->iMidiState > 0) {
 			if (--(pEngine->iMidiState) == 0) {
 				m_ui.TabBar->setOn(iTab, false);
 				iTabUpdate++;
@@ -1661,34 +1661,34 @@ void qsynthMainForm::timerSlot (void)
 			}
 		#endif
 		}
-	}
-	// Have we an update?
-	if (iTabUpdate > 0)
-		m_ui.TabBar->update();
-
-	// MIDI Channel activity breakout...
-	if (m_pChannelsForm) {
-		for (int iChan = 0; iChan < g_iMidiChannels; ++iChan) {
-			if (g_pMidiChannels[iChan].iEvent > 0) {
-				g_pMidiChannels[iChan].iEvent = 0;
-				// Activity tracking...
-				if (g_pMidiChannels[iChan].iState == 0) {
+		// MIDI Channel activity breakout, only when due...
+		if (pEngine->iMidiState > 0 || pEngine->midiChannelsOn() > 0) {
+			const bool bChannelsForm
+				= (m_pChannelsForm && pEngine == g_pCurrentEngine);
+			const int iChannels = pEngine->midiChannels();
+			for (int iChan = 0; iChan < iChannels; ++iChan) {
+				const int iFlags = pEngine->updateMidiChannel(iChan);
+				if (iFlags == 0 || !bChannelsForm)
+					continue;
+				if (iFlags & qsynthEngine::ChannelOn)
 					m_pChannelsForm->setChannelOn(iChan, true);
-					g_pMidiChannels[iChan].iState++;
-				}
-				// Control and/or program change...
-				if (g_pMidiChannels[iChan].iChange > 0) {
-					g_pMidiChannels[iChan].iChange = 0;
-					m_pChannelsForm->updateChannel(iChan);
-				}
-			}   // Activity fallback...
-			else if (g_pMidiChannels[iChan].iEvent == 0
-				&& g_pMidiChannels[iChan].iState > 0) {
-				if (--(g_pMidiChannels[iChan].iState) == 0)
+				else
+				if (iFlags & qsynthEngine::ChannelOff)
 					m_pChannelsForm->setChannelOn(iChan, false);
+				if (iFlags & qsynthEngine::ChannelChange)
+					m_pChannelsForm->updateChannel(iChan);
 			}
+			// All channel changes at once...
+			if (bChannelsForm)
+				m_pChannelsForm->flushChannels();
 		}
+		// Still settling down?
+		if (pEngine->iMidiState > 0 || pEngine->midiChannelsOn() > 0)
+			iTimerMsecs = QSYNTH_TIMER_MSECS;
 	}
+	// Have we an update?
+	if (iTabUpdate > 0)
+		m_ui.TabBar->update();
 
 	// Gain changes?
 	if (m_iGainChanged > 0)
@@ -1703,16 +1703,61 @@ void qsynthMainForm::timerSlot (void)
 		updateChorus();
 
 	// Meter update.
-	if (g_pCurrentEngine && g_pCurrentEngine->bMeterEnabled) {
-		m_ui.OutputMeter->setValue(0, g_pCurrentEngine->fMeterValue[0]);
-		m_ui.OutputMeter->setValue(1, g_pCurrentEngine->fMeterValue[1]);
+	qsynthEngine *pEngine = currentEngine();
+	if (pEngine && pEngine->bMeterEnabled && bShowing) {
+		if (m_ui.OutputMeter->portCount() != pEngine->iMeterPorts)
+			m_ui.OutputMeter->setPortCount(pEngine->iMeterPorts);
+		for (int i = 0; i < pEngine->iMeterPorts; ++i)
+			m_ui.OutputMeter->setValue(i, pEngine->fMeterValue[i]);
 	//	m_ui.OutputMeter->refresh();
-		g_pCurrentEngine->fMeterValue[0] = 0.0f;
-		g_pCurrentEngine->fMeterValue[1] = 0.0f;
+		if (m_ui.OutputMeter->isActive())
+			bMeters = true;
 	}
 
-	// Register for the next timer slot.
-	QTimer::singleShot(QSYNTH_TIMER_MSECS, this, SLOT(timerSlot()));
+	// Meters still falling off?
+	if (bShowing && m_ui.TabBar->isLevelActive())
+		bMeters = true;
+
+	// Register for the next timer slot, if any...
+	if (bMeters)
+		iTimerMsecs = QSYNTH_FRAME_MSECS;
+	if (iTimerMsecs > 0) {
+		if (!m_pTimer->isActive() || m_pTimer->interval() != iTimerMsecs)
+			m_pTimer->start(iTimerMsecs);
+	} else {
+		// Nothing else to do, until some activity wakes us up...
+		m_pTimer->stop();
+		bool bMidiWakeup = bShowing
+			|| (m_pChannelsForm && m_pChannelsForm->isVisible());
+	#ifdef CONFIG_SYSTEM_TRAY
+		if (m_pSystemTray)
+			bMidiWakeup = true;
+	#endif
+		for (int iTab = 0; iTab < iTabCount; ++iTab)
+			m_ui.TabBar->engine(iTab)->setWakeup(bMidiWakeup, bShowing);
+		// Now armed, re-check for any activity that slipped through
+		// in the meantime, as it won't ever get us woken up...
+		for (int iTab = 0; iTab < iTabCount; ++iTab) {
+			if (m_ui.TabBar->engine(iTab)->isWakeupPending()) {
+				timerWakeup();
+				break;
+			}
+		}
+	}
+}
+
+
+// Activity wakeup slot (also on any other pending change).
+void qsynthMainForm::timerWakeup (void)
+{
+	if (m_pEngineManager == NULL || m_pTimer->isActive())
+		return;
+
+	const int iTabCount = m_ui.TabBar->count();
+	for (int iTab = 0; iTab < iTabCount; ++iTab)
+		m_ui.TabBar->engine(iTab)->setWakeup(false, false);
+
+	m_pTimer->start(QSYNTH_FRAME_MSECS);
 }
 
 
@@ -1723,350 +1768,141 @@ qsynthEngine *qsynthMainForm::currentEngine (void) const
 }
 
 
-// Start the fluidsynth clone, based on given settings.
-bool qsynthMainForm::startEngine ( qsynthEngine *pEngine )
+// Add a new engine tab, tracking its lifecycle.
+int qsynthMainForm::addEngine ( qsynthEngine *pEngine )
 {
-	if (pEngine == NULL)
-		return false;
-	if (pEngine->pSynth)
-		return true;
+	QObject::connect(pEngine,
+		SIGNAL(stateChanged(int)),
+		SLOT(engineStateChanged(int)));
+	QObject::connect(pEngine,
+		SIGNAL(wakeup()),
+		SLOT(timerWakeup()));
 
-	qsynthSetup *pSetup = pEngine->setup();
-	if (pSetup == NULL)
-		return false;
+	m_pEngineManager->addEngine(pEngine);
 
-	// Start realizing settings...
-	pSetup->realize();
+	return m_ui.TabBar->addEngine(pEngine);
+}
 
-	const QString sPrefix  = pEngine->name() + ": ";
-	const QString sElipsis = "...";
 
-	// Create the synthesizer.
-	appendMessages(sPrefix + tr("Creating synthesizer engine") + sElipsis);
-	pEngine->pSynth = ::new_fluid_synth(pSetup->fluid_settings());
-	if (pEngine->pSynth == NULL) {
-		appendMessagesError(sPrefix
-			+ tr("Failed to create the synthesizer.\n\nCannot continue without it."));
-		return false;
-	}
+// Engine lifecycle state change slot.
+void qsynthMainForm::engineStateChanged ( int iState )
+{
+	qsynthEngine *pEngine = qobject_cast<qsynthEngine *> (sender());
+	if (pEngine == NULL)
+		return;
 
-#ifdef QSYNTH_CUSTOM_LOADER
-	// Add special loader to mirror fonts in use by another engine...
-	fluid_sfloader_t *pLoader
-		= (fluid_sfloader_t *) ::malloc(sizeof(fluid_sfloader_t));
-	pLoader->data = (void *) pEngine;
-	pLoader->load = qsynth_sfloader_load;
-	pLoader->free = qsynth_sfloader_free;
-	::fluid_synth_add_sfloader(pEngine->pSynth, pLoader);
-	// Push on to engine list.
-	qsynthEngineNode *pNode = new qsynthEngineNode;
-	pNode->pEngine = pEngine;
-	pNode->pNext   = g_pEngineList;
-	pNode->pPrev   = NULL;
-	if (g_pEngineList)
-		g_pEngineList->pPrev = pNode;
-	g_pEngineList = pNode;
-#endif
+	// Flush anything that maybe pending...
+	if (iState == qsynthEngine::Stopping)
+		flushStdoutBuffer();
 
-	// Load soundfonts...
-	int i = 0;
-	QStringListIterator iter(pSetup->soundfonts);
-	while (iter.hasNext()) {
-		const QString& sFilename = iter.next();
-		// Is it a soundfont file...
-		if (::fluid_is_soundfont(sFilename.toLocal8Bit().data())) {
-			const int iBankOffset = pSetup->bankoffsets[i].toInt();
-			appendMessagesColor(sPrefix +
-				tr("Loading soundfont: \"%1\" (bank offset %2)")
-				.arg(sFilename).arg(iBankOffset) + sElipsis, "#999933");
-			const int iSFID = ::fluid_synth_sfload(
-				pEngine->pSynth, sFilename.toLocal8Bit().data(), 1);
-			if (iSFID < 0)
-				appendMessagesError(sPrefix +
-					tr("Failed to load the soundfont: \"%1\".")
-					.arg(sFilename));
-		#ifdef CONFIG_FLUID_BANK_OFFSET
-			else
-			if (::fluid_synth_set_bank_offset(
-				pEngine->pSynth, iSFID, iBankOffset) < 0) {
-				appendMessagesError(sPrefix +
-					tr("Failed to set bank offset (%1) for soundfont: \"%2\".")
-					.arg(iBankOffset).arg(sFilename));
-			}
-		#endif
-		}
-		++i;
+	// Show up our efforts, if we're currently selected :p
+	if (pEngine == currentEngine()) {
+		if (iState == qsynthEngine::Stopped)
+			resetChannelsForm(pEngine, true);
+		stabilizeForm();
 	}
+}
 
-	// Start the synthesis thread...
-	appendMessages(sPrefix +
-		tr("Creating audio driver (%1)")
-		.arg(pSetup->sAudioDriver) + sElipsis);
-	pEngine->pAudioDriver  = NULL;
-	pEngine->bMeterEnabled = false;
-	if (m_pOptions->bOutputMeters) {
-		pEngine->pAudioDriver  = ::new_fluid_audio_driver2(
-			pSetup->fluid_settings(), qsynth_process, pEngine);
-		pEngine->bMeterEnabled = (pEngine->pAudioDriver != NULL);
-	}
-	if (pEngine->pAudioDriver == NULL)
-		pEngine->pAudioDriver = ::new_fluid_audio_driver(
-			pSetup->fluid_settings(), pEngine->pSynth);
-	if (pEngine->pAudioDriver == NULL) {
-		appendMessagesError(sPrefix +
-			tr("Failed to create the audio driver (%1).\n\n"
-			"Cannot continue without it.")
-			.arg(pSetup->sAudioDriver));
-		stopEngine(pEngine);
-		return false;
-	}
 
-	// Start the midi router and link it to the synth...
-	if (pSetup->bMidiIn) {
-		// In dump mode, text output is generated for events going into
-		// and out of the router. The example dump functions are put into
-		// the chain before and after the router..
-		appendMessages(sPrefix +
-			tr("Creating MIDI router (%1)")
-			.arg(pSetup->sMidiDriver) + sElipsis);
-		pEngine->pMidiRouter = ::new_fluid_midi_router(
-			pSetup->fluid_settings(), pSetup->bMidiDump
-			? qsynth_dump_postrouter
-			: qsynth_handle_midi_event,
-			(void *) pEngine);
-		if (pEngine->pMidiRouter == NULL) {
-			appendMessagesError(sPrefix +
-				tr("Failed to create the MIDI input router (%1).\n\n"
-				"No MIDI input will be available.")
-				.arg(pSetup->sMidiDriver));
-		} else {
-		#ifdef CONFIG_FLUID_MIDI_ROUTER
-			::fluid_synth_set_midi_router(pEngine->pSynth, pEngine->pMidiRouter);
-		#endif
-			appendMessages(sPrefix +
-				tr("Creating MIDI driver (%1)")
-				.arg(pSetup->sMidiDriver) + sElipsis);
-			pEngine->pMidiDriver = ::new_fluid_midi_driver(
-				pSetup->fluid_settings(), pSetup->bMidiDump
-				? ::fluid_midi_dump_prerouter
-				: ::fluid_midi_router_handle_midi_event,
-				static_cast<void *> (pEngine->pMidiRouter));
-			if (pEngine->pMidiDriver == NULL)
-				appendMessagesError(sPrefix +
-					tr("Failed to create the MIDI driver (%1).\n\n"
-					"No MIDI input will be available.")
-					.arg(pSetup->sMidiDriver));
-		}
-	}
+// Engine manager message slots.
+void qsynthMainForm::engineMessages ( const QString& s, const QString& c )
+{
+	if (c.isEmpty())
+		appendMessages(s);
+	else
+		appendMessagesColor(s, c);
+}
 
-	// Create the MIDI player.
-	appendMessages(sPrefix + tr("Creating MIDI player") + sElipsis);
-	pEngine->pPlayer = ::new_fluid_player(pEngine->pSynth);
-	if (pEngine->pPlayer == NULL) {
-		appendMessagesError(sPrefix +
-			tr("Failed to create the MIDI player.\n\n"
-			"Continuing without a player."));
-	} else {
-		// Play the midi files, if any.
-		playLoadFiles(pEngine, pSetup->midifiles, false);
-	}
 
-	// Run the server, if requested.
-	if (pSetup->bServer) {
-	#ifdef CONFIG_FLUID_SERVER
-		appendMessages(sPrefix + tr("Creating server") + sElipsis);
-		// Server port must be different for each engine...
-		char szShellPort[] = "shell.port";
-		if (g_iLastShellPort > 0) {
-			g_iLastShellPort++;
-		} else {
-			g_iLastShellPort = 0;
-			::fluid_settings_getint(
-				pSetup->fluid_settings(), szShellPort, &g_iLastShellPort);
-			if (g_iLastShellPort == 0) {
-				g_iLastShellPort = ::fluid_settings_getint_default(
-					pSetup->fluid_settings(), szShellPort);
-			}
-		}
-		// Set the (new) server port for this engne...
-		::fluid_settings_setint(
-			pSetup->fluid_settings(), szShellPort, g_iLastShellPort);
-		// Create the server now...
-		pEngine->pServer = ::new_fluid_server(
-			pSetup->fluid_settings(), qsynth_newclient, pEngine->pSynth);
-		if (pEngine->pServer == NULL)
-			appendMessagesError(sPrefix +
-				tr("Failed to create the server.\n\n"
-				"Continuing without it."));
-	#else
-		appendMessagesError(sPrefix +
-			tr("Server mode disabled.\n\n"
-			"Continuing without it."));
-	#endif
-	}
+void qsynthMainForm::engineMessagesError ( const QString& s )
+{
+	appendMessagesError(s);
+}
+
+
+// Engine manager feedback slots.
+void qsynthMainForm::engineSetupAboutToSave ( qsynthEngine *pEngine )
+{
+	if (pEngine == currentEngine())
+		savePanelSettings(pEngine);
+}
 
-	// Make an initial program reset.
-	m_pOptions->loadPreset(pEngine, pSetup->sDefPreset);
 
-	// Show up our efforts, if we're currently selected :)
+void qsynthMainForm::engineReady ( qsynthEngine *pEngine, bool bReset )
+{
 	if (pEngine == currentEngine()) {
 		loadPanelSettings(pEngine, true);
-		resetChannelsForm(pEngine, true);
+		resetChannelsForm(pEngine, bReset);
 		stabilizeForm();
-	} else {
-		setEngineReverbOn(pEngine,
-			pSetup->bReverbActive);
-		setEngineChorusOn(pEngine,
-			pSetup->bChorusActive);
-		setEngineGain(pEngine,
-			pSetup->fGain);
-		setEngineReverb(pEngine,
-			pSetup->fReverbRoom,
-			pSetup->fReverbDamp,
-			pSetup->fReverbWidth,
-			pSetup->fReverbLevel);
-		setEngineChorus(pEngine,
-			pSetup->iChorusNr,
-			pSetup->fChorusLevel,
-			pSetup->fChorusSpeed,
-			pSetup->fChorusDepth,
-			pSetup->iChorusType);
 	}
-
-	// All is right.
-	appendMessages(sPrefix + tr("Synthesizer engine started."));
-
-	return true;
 }
 
 
-// Stop the fluidsynth clone.
-void qsynthMainForm::stopEngine ( qsynthEngine *pEngine )
+void qsynthMainForm::enginePresetsChanged ( qsynthEngine *pEngine )
 {
-	if (pEngine == NULL)
-		return;
-	if (pEngine->pSynth == NULL)
-		return;
-
-	qsynthSetup *pSetup = pEngine->setup();
-	if (pSetup == NULL)
-		return;
+	if (pEngine == currentEngine())
+		resetChannelsForm(pEngine, false);
+}
 
-	// Only if there's a legal audio driver...
-	if (pEngine->pAudioDriver) {
-		// Before all else save current engine panel settings...
-		if (pEngine == currentEngine())
-			savePanelSettings(pEngine);
-		// Make those settings persist over...
-		m_pOptions->saveSetup(pSetup, pEngine->isDefault()
-			? QString::null : pEngine->name());
-	}
 
-	// Flush anything that maybe pending...
-	flushStdoutBuffer();
-
-	const QString sPrefix  = pEngine->name() + ": ";
-	const QString sElipsis = "...";
-
-#ifdef CONFIG_FLUID_SERVER
-	// Destroy server.
-	if (pEngine->pServer) {
-	//  Server join is not necessary, causes seg fault when multiple engines.
-	//  appendMessages(sPrefix + tr("Waiting for server to terminate") + sElipsis);
-	//  ::fluid_server_join(pEngine->pServer);
-		appendMessages(sPrefix + tr("Destroying server") + sElipsis);
-		::delete_fluid_server(pEngine->pServer);
-		pEngine->pServer = NULL;
-	}
-#endif
+// Soundfont background loader cancel slot.
+void qsynthMainForm::soundFontLoaderCancel (void)
+{
+	m_pEngineManager->cancelSoundFontLoaders();
+}
 
-	// Destroy player.
-	if (pEngine->pPlayer) {
-		appendMessages(sPrefix + tr("Stopping MIDI player") + sElipsis);
-		::fluid_player_stop(pEngine->pPlayer);
-		appendMessages(sPrefix + tr("Waiting for MIDI player to terminate") + sElipsis);
-		::fluid_player_join(pEngine->pPlayer);
-		appendMessages(sPrefix + tr("Destroying MIDI player") + sElipsis);
-		::delete_fluid_player(pEngine->pPlayer);
-		pEngine->pPlayer = NULL;
-	}
 
-	// Destroy MIDI router.
-	if (pEngine->pMidiRouter) {
-		if (pEngine->pMidiDriver) {
-			appendMessages(sPrefix + tr("Destroying MIDI driver") + sElipsis);
-			::delete_fluid_midi_driver(pEngine->pMidiDriver);
-			pEngine->pMidiDriver = NULL;
-		}
-		appendMessages(sPrefix + tr("Destroying MIDI router") + sElipsis);
-		::delete_fluid_midi_router(pEngine->pMidiRouter);
-		pEngine->pMidiRouter = NULL;
-	}
-
-	// Destroy audio driver.
-	if (pEngine->pAudioDriver) {
-		appendMessages(sPrefix + tr("Destroying audio driver") + sElipsis);
-		::delete_fluid_audio_driver(pEngine->pAudioDriver);
-		pEngine->pAudioDriver = NULL;
-		pEngine->bMeterEnabled = false;
-	}
+// Soundfont background loading progress (per engine and file).
+void qsynthMainForm::updateSoundFontProgress (void)
+{
+	QStringList lines;
+	int iFileCount = 0;
+	int iDoneCount = 0;
 
-	// Unload soundfonts from actual synth stack...
-	const int iSoundFonts = ::fluid_synth_sfcount(pEngine->pSynth);
-	for (int i = 0; i < iSoundFonts; ++i) {
-		fluid_sfont_t *pSoundFont
-			= ::fluid_synth_get_sfont(pEngine->pSynth, i);
-		if (pSoundFont) {
-			const int iSFID = pSoundFont->id;
-			const QString sName = pSoundFont->get_name(pSoundFont);
-			appendMessagesColor(sPrefix +
-				tr("Unloading soundfont: \"%1\" (SFID=%2)")
-				.arg(sName).arg(iSFID) + sElipsis, "#999933");
-			if (::fluid_synth_sfunload(pEngine->pSynth, iSFID, 0) < 0)
-				appendMessagesError(sPrefix +
-					tr("Failed to unload the soundfont: \"%1\".")
-					.arg(sName));
+	const int iTabCount = m_ui.TabBar->count();
+	for (int iTab = 0; iTab < iTabCount; ++iTab) {
+		qsynthEngine *pEngine = m_ui.TabBar->engine(iTab);
+		if (pEngine == NULL || pEngine->pSoundFontLoader == NULL)
+			continue;
+		qsynthSoundFontLoader *pLoader = pEngine->pSoundFontLoader;
+		const int iFiles = pLoader->fileCount();
+		const int iDone  = pLoader->doneCount();
+		QString sLine = tr("%1: %2 of %3 soundfont(s)")
+			.arg(pEngine->name()).arg(iDone).arg(iFiles);
+		for (int i = 0; i < iFiles; ++i) {
+			if (pLoader->state(i) == qsynthSoundFontLoader::Loading)
+				sLine += "\n    " + QFileInfo(pLoader->filename(i)).fileName();
 		}
+		lines.append(sLine);
+		iFileCount += iFiles;
+		iDoneCount += iDone;
 	}
 
-	// And finally, destroy the synthesizer engine.
-	if (pEngine->pSynth) {
-		appendMessages(sPrefix + tr("Destroying synthesizer engine") + sElipsis);
-		::delete_fluid_synth(pEngine->pSynth);
-		pEngine->pSynth = NULL;
-		// We're done.
-		appendMessages(sPrefix + tr("Synthesizer engine terminated."));
-	}
-
-#ifdef QSYNTH_CUSTOM_LOADER
-	// Remove engine from custom loader list, if any...
-	qsynthEngineNode *pNode = g_pEngineList;
-	while (pNode) {
-		if (pNode->pEngine == pEngine ) {
-			if (pNode->pPrev)
-				(pNode->pPrev)->pNext = pNode->pNext;
-			else
-				g_pEngineList = pNode->pNext;
-			if (pNode->pNext)
-				(pNode->pNext)->pPrev = pNode->pPrev;
-			delete pNode;
-			break;
+	// All done?
+	if (lines.isEmpty()) {
+		if (m_pSoundFontProgress) {
+			delete m_pSoundFontProgress;
+			m_pSoundFontProgress = NULL;
 		}
-		pNode = pNode->pNext;
+		return;
 	}
-#endif
 
-	// Show up our efforts, if we're currently selected :p
-	if (pEngine == currentEngine()) {
-		resetChannelsForm(pEngine, true);
-		stabilizeForm();
+	// Only shows up if it's taking a while...
+	if (m_pSoundFontProgress == NULL) {
+		m_pSoundFontProgress = new QProgressDialog(this);
+		m_pSoundFontProgress->setWindowTitle(
+			QSYNTH_TITLE ": " + tr("Loading soundfonts"));
+		m_pSoundFontProgress->setMinimumDuration(1000);
+		m_pSoundFontProgress->setAutoClose(false);
+		m_pSoundFontProgress->setAutoReset(false);
+		QObject::connect(m_pSoundFontProgress,
+			SIGNAL(canceled()),
+			SLOT(soundFontLoaderCancel()));
 	}
 
-	// Wait a litle bit before continue...
-	QTime t;
-	t.start();
-	while (t.elapsed() < QSYNTH_DELAY_MSECS)
-		QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+	m_pSoundFontProgress->setLabelText(lines.join("\n"));
+	m_pSoundFontProgress->setMaximum(iFileCount);
+	m_pSoundFontProgress->setValue(iDoneCount);
 }
 
 
@@ -2074,6 +1910,8 @@ void qsynthMainForm::stopEngine ( qsynthEngine *pEngine )
 void qsynthMainForm::startAllEngines (void)
 {
 	m_iTimerDelay = 0;
+
+	timerWakeup();
 }
 
 
@@ -2092,14 +1930,13 @@ void qsynthMainForm::restartAllEngines (void)
 
 	// Just restart every engine out there...
 	if (bRestart) {
-		// Restarting means stopping an engine...
-		const int iTabCount = m_ui.TabBar->count();
-		for (int iTab = 0; iTab < iTabCount; ++iTab)
-			stopEngine(m_ui.TabBar->engine(iTab));
 		// Must make this one grayed out for a while...
 		m_ui.RestartPushButton->setEnabled(false);
-		// And making room for immediate restart...
-		startAllEngines();
+		// Restarting means stopping an engine, then all
+		// get started over again, in parallel...
+		const int iTabCount = m_ui.TabBar->count();
+		for (int iTab = 0; iTab < iTabCount; ++iTab)
+			m_pEngineManager->restartEngineNow(m_ui.TabBar->engine(iTab));
 	}
 }
 
@@ -2128,84 +1965,11 @@ void qsynthMainForm::restartEngine ( qsynthEngine *pEngine )
 		if (pEngine == currentEngine())
 			m_ui.RestartPushButton->setEnabled(false);
 		// Restarting means stopping the engine...
-		stopEngine(pEngine);
-		// And making room for immediate restart...
-		startAllEngines();
+		m_pEngineManager->restartEngineNow(pEngine);
 	}
 }
 
 
-// Engine reset (all channels program reset).
-void qsynthMainForm::resetEngine ( qsynthEngine *pEngine )
-{
-	if (pEngine && pEngine->pSynth) {
-		appendMessagesColor(pEngine->name()
-			+ ": fluid_synth_program_reset()", "#996666");
-		::fluid_synth_program_reset(pEngine->pSynth);
-	}
-}
-
-
-// Engine gain settings.
-void qsynthMainForm::setEngineGain ( qsynthEngine *pEngine, float fGain )
-{
-	appendMessagesColor(pEngine->name()
-		+ ": fluid_synth_set_gain("
-		+ QString::number(fGain) + ")", "#6699cc");
-
-	::fluid_synth_set_gain(pEngine->pSynth, fGain);
-}
-
-
-// Engine reverb settings.
-void qsynthMainForm::setEngineReverbOn ( qsynthEngine *pEngine, bool bActive )
-{
-	appendMessagesColor(pEngine->name()
-		+ ": fluid_synth_set_reverb_on("
-		+ QString::number((int) bActive) + ")", "#99cc33");
-
-	::fluid_synth_set_reverb_on(pEngine->pSynth, (int) bActive);
-}
-
-void qsynthMainForm::setEngineReverb ( qsynthEngine *pEngine,
-	double fRoom, double fDamp, double fWidth, double fLevel )
-{
-	appendMessagesColor(pEngine->name()
-		+ ": fluid_synth_set_reverb("
-		+ QString::number(fRoom)  + ","
-		+ QString::number(fDamp)  + ","
-		+ QString::number(fWidth) + ","
-		+ QString::number(fLevel) + ")", "#99cc66");
-
-	::fluid_synth_set_reverb(pEngine->pSynth, fRoom, fDamp, fWidth, fLevel);
-}
-
-
-// Engine chorus settings.
-void qsynthMainForm::setEngineChorusOn ( qsynthEngine *pEngine, bool bActive )
-{
-	appendMessagesColor(pEngine->name()
-		+ ": fluid_synth_set_chorus_on("
-		+ QString::number((int) bActive) + ")", "#cc9933");
-
-	::fluid_synth_set_chorus_on(pEngine->pSynth, (int) bActive);
-}
-
-void qsynthMainForm::setEngineChorus ( qsynthEngine *pEngine,
-	int iNr, double fLevel, double fSpeed, double fDepth, int iType )
-{
-	appendMessagesColor(pEngine->name()
-		+ ": fluid_synth_set_chorus("
-		+ QString::number(iNr)    + ","
-		+ QString::number(fLevel) + ","
-		+ QString::number(fSpeed) + ","
-		+ QString::number(fDepth) + ","
-		+ QString::number(iType)  + ")", "#cc9966");
-
-	::fluid_synth_set_chorus(pEngine->pSynth, iNr, fLevel, fSpeed, fDepth, iType);
-}
-
-
 // Front panel state load routine.
 void qsynthMainForm::loadPanelSettings ( qsynthEngine *pEngine, bool bUpdate )
 {
@@ -2257,6 +2021,7 @@ void qsynthMainForm::loadPanelSettings ( qsynthEngine *pEngine, bool bUpdate )
 		m_iGainChanged++;
 		m_iReverbChanged++;
 		m_iChorusChanged++;
+		timerWakeup();
 	}
 
 	// Let them get updated, possibly on next tick.
@@ -2309,26 +2074,9 @@ void qsynthMainForm::resetChannelsForm ( qsynthEngine *pEngine, bool bPreset )
 	if (m_pChannelsForm == NULL)
 		return;
 
-	// Setup the channels view window.
+	// Setup the channels view window
+	// (channel activity is tracked by the engine itself).
 	m_pChannelsForm->setup(m_pOptions, pEngine, bPreset);
-
-	// Reset the channel event state flaggers.
-	if (g_pMidiChannels)
-		delete [] g_pMidiChannels;
-	g_pMidiChannels = NULL;
-	g_iMidiChannels = 0;
-	// Prepare the new channel event state flaggers.
-	if (pEngine && pEngine->pSynth)
-		g_iMidiChannels = ::fluid_synth_count_midi_channels(pEngine->pSynth);
-	if (g_iMidiChannels > 0)
-		g_pMidiChannels = new qsynth_midi_channel [g_iMidiChannels];
-	if (g_pMidiChannels) {
-		for (int iChan = 0; iChan < g_iMidiChannels; ++iChan) {
-			g_pMidiChannels[iChan].iEvent  = 0;
-			g_pMidiChannels[iChan].iState  = 0;
-			g_pMidiChannels[iChan].iChange = 0;
-		}
-	}
 }
 
 
@@ -2344,7 +2092,7 @@ void qsynthMainForm::reverbActivate ( bool bActive )
 	if (pEngine->pSynth == NULL)
 		return;
 
-	setEngineReverbOn(pEngine, bActive);
+	m_pEngineManager->setEngineReverbOn(pEngine, bActive);
 
 	if (bActive)
 		refreshReverb();
@@ -2365,7 +2113,7 @@ void qsynthMainForm::chorusActivate ( bool bActive )
 	if (pEngine->pSynth == NULL)
 		return;
 
-	setEngineChorusOn(pEngine, bActive);
+	m_pEngineManager->setEngineChorusOn(pEngine, bActive);
 
 	if (bActive)
 		refreshChorus();
@@ -2377,24 +2125,30 @@ void qsynthMainForm::chorusActivate ( bool bActive )
 // Increment gain change flag.
 void qsynthMainForm::gainChanged (int)
 {
-	if (m_iGainUpdated == 0)
+	if (m_iGainUpdated == 0) {
 		m_iGainChanged++;
+		timerWakeup();
+	}
 }
 
 
 // Increment reverb change flag.
 void qsynthMainForm::reverbChanged (int)
 {
-	if (m_iReverbUpdated == 0)
+	if (m_iReverbUpdated == 0) {
 		m_iReverbChanged++;
+		timerWakeup();
+	}
 }
 
 
 // Increment chorus change flag.
 void qsynthMainForm::chorusChanged (int)
 {
-	if (m_iChorusUpdated == 0)
+	if (m_iChorusUpdated == 0) {
 		m_iChorusChanged++;
+		timerWakeup();
+	}
 }
 
 
@@ -2414,7 +2168,7 @@ void qsynthMainForm::updateGain (void)
 	const float fGain= qsynth_get_range_value(
 		m_ui.GainSpinBox, QSYNTH_MASTER_GAIN_SCALE);
 
-	setEngineGain(pEngine, fGain);
+	m_pEngineManager->setEngineGain(pEngine, fGain);
 	refreshGain();
 
 	m_iGainUpdated--;
@@ -2444,7 +2198,7 @@ void qsynthMainForm::updateReverb (void)
 	const double fReverbLevel = qsynth_get_range_value(
 		m_ui.ReverbLevelSpinBox, QSYNTH_REVERB_LEVEL_SCALE);
 
-	setEngineReverb(pEngine,
+	m_pEngineManager->setEngineReverb(pEngine,
 		fReverbRoom, fReverbDamp, fReverbWidth, fReverbLevel);
 
 	refreshReverb();
@@ -2476,7 +2230,7 @@ void qsynthMainForm::updateChorus (void)
 		m_ui.ChorusDepthSpinBox, QSYNTH_CHORUS_DEPTH_SCALE);
 	const int    iChorusType  = m_ui.ChorusTypeComboBox->currentIndex();
 
-	setEngineChorus(pEngine,
+	m_pEngineManager->setEngineChorus(pEngine,
 		iChorusNr, fChorusLevel, fChorusSpeed, fChorusDepth, iChorusType);
 
 	refreshChorus();
@@ -29,14 +29,19 @@
 class qsynthOptions;
 class qsynthMessagesForm;
 class qsynthChannelsForm;
+class qsynthMidiMonitorForm;
+class qsynthEngineManager;
+class qsynthStdoutReader;
+class qsynthRender;
 
 #ifdef CONFIG_SYSTEM_TRAY
 class qsynthSystemTray;
 #endif
 
-class QSocketNotifier;
 class QSessionManager;
 class QMimeSource;
+class QProgressDialog;
+class QTimer;
 
 
 //----------------------------------------------------------------------------
@@ -67,12 +72,8 @@ public:
 
 	void startAllEngines();
 
-	bool startEngine(qsynthEngine *pEngine);
-	void stopEngine(qsynthEngine *pEngine);
-
 	void restartAllEngines();
 	void restartEngine(qsynthEngine *pEngine);
-	void resetEngine(qsynthEngine *pEngine);
 
 	enum KnobStyle { Classic, Vokimon, Peppino, Skulpture, Legacy };
 
@@ -82,7 +83,7 @@ public slots:
 
 protected slots:
 
-	void stdoutNotifySlot(int);
+	void stdoutLinesSlot();
 
 	void contextMenu(const QPoint&);
 
@@ -96,16 +97,36 @@ protected slots:
 	void toggleMainForm();
 	void toggleMessagesForm();
 	void toggleChannelsForm();
+	void toggleMidiMonitorForm();
 
 	void showSetupForm();
 	void showOptionsForm();
 	void showAboutForm();
 
+	void renderMidiFiles();
+	void renderFinished(qsynthRender *pRender);
+
 	void tabSelect(int);
 
 	void tabContextMenu(int, const QPoint&);
 
 	void timerSlot();
+	void timerWakeup();
+
+	void engineStateChanged(int);
+
+	void engineMessages(const QString&, const QString&);
+	void engineMessagesError(const QString&);
+
+	void engineSetupAboutToSave(qsynthEngine *pEngine);
+	void engineReady(qsynthEngine *pEngine, bool bReset);
+	void enginePresetsChanged(qsynthEngine *pEngine);
+
+	void midiMonitorEvents(qsynthEngine *pEngine,
+		const QVector<qsynthMidiTapEvent>& events);
+
+	void updateSoundFontProgress();
+	void soundFontLoaderCancel();
 
 	void reverbActivate(bool);
 	void chorusActivate(bool);
@@ -126,13 +147,15 @@ protected:
 
 	void closeEvent(QCloseEvent *pCloseEvent);
 
-	void appendStdoutBuffer(const QString&);
+	void showEvent(QShowEvent *pShowEvent);
+	void changeEvent(QEvent *pEvent);
+
+	bool isShowing() const;
+
 	void flushStdoutBuffer();
 
 	bool stdoutBlock(int fd, bool bBlock) const;
 
-	void playLoadFiles( qsynthEngine *pEngine, const QStringList& files, bool bSetup);
-
 	bool decodeDragFiles(const QMimeSource * pEvent, QStringList& files);
 	void dragEnterEvent(QDragEnterEvent *pDragEnterEvent);
 	void dropEvent(QDropEvent *pDropEvent);
@@ -146,13 +169,7 @@ protected:
 
 	qsynthEngine *currentEngine() const;
 
-	void setEngineGain(qsynthEngine *pEngine, float fGain);
-	void setEngineReverbOn(qsynthEngine *pEngine, bool bActive);
-	void setEngineReverb(qsynthEngine *pEngine,
-		double fRoom, double fDamp, double fWidth, double fLevel);
-	void setEngineChorusOn(qsynthEngine *pEngine, bool bActive);
-	void setEngineChorus(qsynthEngine *pEngine,
-		int iNr, double fLevel, double fSpeed, double fDepth, int iType);
+	int addEngine(qsynthEngine *pEngine);
 
 	void loadPanelSettings(qsynthEngine *pEngine, bool bUpdate);
 	void savePanelSettings(qsynthEngine *pEngine);
@@ -179,13 +196,17 @@ private:
 	// Instance variables.
 	qsynthOptions *m_pOptions;
 
+	qsynthEngineManager *m_pEngineManager;
+
 	int m_iTimerDelay;
+	QTimer *m_pTimer;
 	int m_iCurrentTab;
 
-	QSocketNotifier *m_pStdoutNotifier;
+	qsynthStdoutReader *m_pStdoutReader;
 
 	qsynthMessagesForm *m_pMessagesForm;
 	qsynthChannelsForm *m_pChannelsForm;
+	qsynthMidiMonitorForm *m_pMidiMonitorForm;
 
 	int m_iGainChanged;
 	int m_iReverbChanged;
@@ -194,7 +215,10 @@ private:
 	int m_iReverbUpdated;
 	int m_iChorusUpdated;
 
-	QString m_sStdoutBuffer;
+	QProgressDialog *m_pSoundFontProgress;
+
+	// Offline rendering, one at a time.
+	qsynthRender *m_pRender;
 
 #ifdef CONFIG_SYSTEM_TRAY
 	qsynthSystemTray *m_pSystemTray;
@@ -25,18 +25,35 @@
 #include "qsynthMainForm.h"
 
 #include <QFile>
+#include <QTimer>
+#include <QAction>
 #include <QDateTime>
-#include <QTextBlock>
-#include <QTextCursor>
+#include <QScrollBar>
+#include <QClipboard>
+#include <QApplication>
+#include <QTextDocument>
+#include <QTextDocumentFragment>
 #include <QTextStream>
 
 #include <QShowEvent>
 #include <QHideEvent>
 
+#include <algorithm>
+
 
 // The maximum number of message lines.
 #define QSYNTH_MESSAGES_MAXLINES  1000
 
+// The message records ring capacity, when unlimited.
+#define QSYNTH_MESSAGES_MAXRING   100000
+
+// The maximum number of message lines shown per second;
+// any excess gets dropped from view (but still logged).
+#define QSYNTH_MESSAGES_MAXRATE   500
+
+// Statistics and log file flush period (msecs).
+#define QSYNTH_MESSAGES_MSECS     1000
+
 
 //----------------------------------------------------------------------------
 // qsynthMessagesForm -- UI wrapper form.
@@ -49,13 +66,69 @@ qsynthMessagesForm::qsynthMessagesForm (
 	// Setup UI struct...
 	m_ui.setupUi(this);
 
-//  m_ui.MessagesTextView->setTextFormat(Qt::LogText);
+	// Message records ring, viewed through a filter only when needed.
+	m_pMessagesModel  = new qsynthMessagesModel(QSYNTH_MESSAGES_MAXLINES, this);
+	m_pMessagesFilter = new qsynthMessagesFilter(this);
+	m_pMessagesFilter->setSourceModel(m_pMessagesModel);
+	m_ui.MessagesListView->setModel(m_pMessagesModel);
+
+	// Filter criteria...
+	m_ui.EngineComboBox->addItem(tr("(All)"));
+	m_ui.SeverityComboBox->addItem(tr("(All)"), -1);
+	m_ui.SeverityComboBox->addItem(tr("Errors"),
+		int(qsynthMessagesModel::Error));
+	m_ui.SeverityComboBox->addItem(tr("Notices"),
+		int(qsynthMessagesModel::Notice));
+	m_ui.SeverityComboBox->addItem(tr("Information"),
+		int(qsynthMessagesModel::Info));
+	m_ui.SeverityComboBox->addItem(tr("Output"),
+		int(qsynthMessagesModel::Output));
+
+	// Copy selected lines to clipboard.
+	QAction *pCopyAction = new QAction(tr("&Copy"), m_ui.MessagesListView);
+	pCopyAction->setShortcut(QKeySequence::Copy);
+	pCopyAction->setShortcutContext(Qt::WidgetShortcut);
+	m_ui.MessagesListView->addAction(pCopyAction);
+	m_ui.MessagesListView->setContextMenuPolicy(Qt::ActionsContextMenu);
 
 	// Initialize default message limit.
-	m_iMessagesLines = 0;
 	setMessagesLimit(QSYNTH_MESSAGES_MAXLINES);
 
 	m_pMessagesLog = NULL;
+
+	// Pending lines are flushed once per event loop tick.
+	m_pFlushTimer = new QTimer(this);
+	m_pFlushTimer->setSingleShot(true);
+	m_pFlushTimer->setInterval(0);
+	QObject::connect(m_pFlushTimer,
+		SIGNAL(timeout()),
+		SLOT(flushMessages()));
+
+	// Rate limit and statistics.
+	m_iRateLines    = 0;
+	m_iRateDropped  = 0;
+	m_iRateDeferred = 0;
+	m_iRateWakeups  = 0;
+	m_iTotalDropped = 0;
+
+	m_pStatsTimer = new QTimer(this);
+	QObject::connect(m_pStatsTimer,
+		SIGNAL(timeout()),
+		SLOT(statsTimerSlot()));
+	m_pStatsTimer->start(QSYNTH_MESSAGES_MSECS);
+
+	statsTimerSlot();
+
+	// UI signal/slot connections...
+	QObject::connect(m_ui.EngineComboBox,
+		SIGNAL(activated(int)),
+		SLOT(filterChanged()));
+	QObject::connect(m_ui.SeverityComboBox,
+		SIGNAL(activated(int)),
+		SLOT(filterChanged()));
+	QObject::connect(pCopyAction,
+		SIGNAL(triggered(bool)),
+		SLOT(copyMessages()));
 }
 
 
@@ -100,12 +173,12 @@ void qsynthMessagesForm::closeEvent ( QCloseEvent * /*pCloseEvent*/ )
 // Messages view font accessors.
 QFont qsynthMessagesForm::messagesFont (void) const
 {
-	return m_ui.MessagesTextView->font();
+	return m_ui.MessagesListView->font();
 }
 
 void qsynthMessagesForm::setMessagesFont ( const QFont & font )
 {
-	m_ui.MessagesTextView->setFont(font);
+	m_ui.MessagesListView->setFont(font);
 }
 
 
@@ -118,9 +191,9 @@ int qsynthMessagesForm::messagesLimit (void) const
 void qsynthMessagesForm::setMessagesLimit ( int iMessagesLimit )
 {
 	m_iMessagesLimit = iMessagesLimit;
-	m_iMessagesHigh  = iMessagesLimit + (iMessagesLimit / 3);
 
-//	m_ui.MessagesTextView->setMaxLogLines(iMessagesLimit);
+	m_pMessagesModel->setCapacity(iMessagesLimit < 0
+		? QSYNTH_MESSAGES_MAXRING : iMessagesLimit);
 }
 
 
@@ -135,6 +208,7 @@ void qsynthMessagesForm::setLogging ( bool bEnabled, const QString& sFilename )
 	if (m_pMessagesLog) {
 		appendMessages(tr("Logging stopped --- %1 ---")
 			.arg(QDateTime::currentDateTime().toString()));
+		flushMessages();
 		m_pMessagesLog->close();
 		delete m_pMessagesLog;
 		m_pMessagesLog = NULL;
@@ -153,36 +227,144 @@ void qsynthMessagesForm::setLogging ( bool bEnabled, const QString& sFilename )
 }
 
 
-// Messages log output method.
+// Messages log output method (batched).
 void qsynthMessagesForm::appendMessagesLog ( const QString& s )
 {
 	if (m_pMessagesLog) {
-		QTextStream(m_pMessagesLog) << s << endl;
-		m_pMessagesLog->flush();
+		m_pendingLog.append(s);
+		if (!m_pFlushTimer->isActive())
+			m_pFlushTimer->start();
 	}
 }
 
-// Messages widget output method.
-void qsynthMessagesForm::appendMessagesLine ( const QString& s )
-{
-	// Check for message line limit...
-	if (m_iMessagesLines > m_iMessagesHigh) {
-		m_ui.MessagesTextView->setUpdatesEnabled(false);
-		QTextCursor textCursor(m_ui.MessagesTextView->document()->begin());
-		while (m_iMessagesLines > m_iMessagesLimit) {
-			// Move cursor extending selection
-			// from start to next line-block...
-			textCursor.movePosition(
-				QTextCursor::NextBlock, QTextCursor::KeepAnchor);
-			m_iMessagesLines--;
-		}
-		// Remove the excessive line-blocks...
-		textCursor.removeSelectedText();
-		m_ui.MessagesTextView->setUpdatesEnabled(true);
+// Messages widget output method (batched, rate limited).
+void qsynthMessagesForm::appendMessagesRecord (
+	const qsynthMessagesModel::Record& rec )
+{
+	if (m_iRateLines >= QSYNTH_MESSAGES_MAXRATE) {
+		++m_iRateDropped;
+		++m_iTotalDropped;
+		return;
+	}
+
+	++m_iRateLines;
+
+	// Any new engine to filter on?
+	if (!rec.sEngine.isEmpty()
+		&& m_ui.EngineComboBox->findText(rec.sEngine) < 0)
+		m_ui.EngineComboBox->addItem(rec.sEngine);
+
+	m_pendingRecords.append(rec);
+	if (!m_pFlushTimer->isActive())
+		m_pFlushTimer->start();
+}
+
+
+// Flush all pending records, in one single model update.
+void qsynthMessagesForm::flushMessages (void)
+{
+	m_pFlushTimer->stop();
+
+	// Log file lines first (file gets flushed periodically)...
+	if (m_pMessagesLog && !m_pendingLog.isEmpty()) {
+		QTextStream ts(m_pMessagesLog);
+		QStringListIterator log_iter(m_pendingLog);
+		while (log_iter.hasNext())
+			ts << log_iter.next() << '\n';
+	}
+	m_pendingLog.clear();
+
+	if (m_pendingRecords.isEmpty())
+		return;
+
+	QListView *pListView = m_ui.MessagesListView;
+	QScrollBar *pScrollBar = pListView->verticalScrollBar();
+	const bool bScrollEnd = (pScrollBar->value() >= pScrollBar->maximum());
+
+	m_pMessagesModel->appendRecords(m_pendingRecords);
+	m_pendingRecords.clear();
+
+	if (bScrollEnd)
+		pListView->scrollToBottom();
+}
+
+
+// Producer could not keep up (eg. stdout reader falling behind).
+void qsynthMessagesForm::notifyBackpressure (void)
+{
+	++m_iRateDeferred;
+}
+
+
+// Main window refresh timer has woken up (statistics only).
+void qsynthMessagesForm::notifyTimerWakeup (void)
+{
+	++m_iRateWakeups;
+}
+
+
+// Per second statistics and log file flush.
+void qsynthMessagesForm::statsTimerSlot (void)
+{
+	if (m_pMessagesLog)
+		m_pMessagesLog->flush();
+
+	QString sText = tr("%1 lines/s").arg(m_iRateLines);
+	if (m_iRateDropped > 0 || m_iTotalDropped > 0) {
+		sText += ", " + tr("%1 dropped/s (%2 total)")
+			.arg(m_iRateDropped).arg(m_iTotalDropped);
 	}
+	if (m_iRateDeferred > 0)
+		sText += ", " + tr("%1 full stdout reads/s").arg(m_iRateDeferred);
+	sText += ", " + tr("%1 refresh wakeups/s").arg(m_iRateWakeups);
+	m_ui.MessagesStatusLabel->setText(sText);
+
+	m_iRateLines    = 0;
+	m_iRateDropped  = 0;
+	m_iRateDeferred = 0;
+	m_iRateWakeups  = 0;
+}
+
+
+// Engine and severity filter changed.
+void qsynthMessagesForm::filterChanged (void)
+{
+	QString sEngine;
+	if (m_ui.EngineComboBox->currentIndex() > 0)
+		sEngine = m_ui.EngineComboBox->currentText();
+
+	const int iSeverity = m_ui.SeverityComboBox->itemData(
+		m_ui.SeverityComboBox->currentIndex()).toInt();
+
+	m_pMessagesFilter->setFilter(sEngine, iSeverity);
+
+	// Unfiltered view goes straight to the ring model...
+	QAbstractItemModel *pModel = m_pMessagesModel;
+	if (m_pMessagesFilter->isFiltering())
+		pModel = m_pMessagesFilter;
+	if (m_ui.MessagesListView->model() != pModel)
+		m_ui.MessagesListView->setModel(pModel);
+
+	m_ui.MessagesListView->scrollToBottom();
+}
+
+
+// Copy selected message lines to clipboard.
+void qsynthMessagesForm::copyMessages (void)
+{
+	QModelIndexList list
+		= m_ui.MessagesListView->selectionModel()->selectedIndexes();
+	if (list.isEmpty())
+		return;
+
+	std::sort(list.begin(), list.end());
+
+	QStringList lines;
+	QListIterator<QModelIndex> iter(list);
+	while (iter.hasNext())
+		lines.append(iter.next().data().toString());
 
-	m_ui.MessagesTextView->append(s);
-	m_iMessagesLines++;
+	QApplication::clipboard()->setText(lines.join("\n"));
 }
 
 
@@ -194,15 +376,40 @@ void qsynthMessagesForm::appendMessages( const QString& s )
 
 void qsynthMessagesForm::appendMessagesColor( const QString& s, const QString& c )
 {
-	QString sText = QTime::currentTime().toString("hh:mm:ss.zzz") + ' ' + s;
-	
-	appendMessagesLine("<font color=\"" + c + "\">" + sText + "</font>");
-	appendMessagesLog(sText);
+	qsynthMessagesModel::Record rec;
+	rec.iTime = QTime(0, 0).msecsTo(QTime::currentTime());
+	rec.sText = s;
+	rec.color = QColor(c);
+
+	// Severity, as told by color...
+	if (c == "#ff0000")
+		rec.severity = qsynthMessagesModel::Error;
+	else
+	if (c == "#999999")
+		rec.severity = qsynthMessagesModel::Info;
+	else
+		rec.severity = qsynthMessagesModel::Notice;
+
+	// Engine messages are all prefixed by its name...
+	const int iEngine = s.indexOf(": ");
+	if (iEngine > 0 && iEngine < 32 && s.lastIndexOf(' ', iEngine - 1) < 0)
+		rec.sEngine = s.left(iEngine);
+
+	appendMessagesRecord(rec);
+	appendMessagesLog(qsynthMessagesModel::recordText(rec));
 }
 
 void qsynthMessagesForm::appendMessagesText( const QString& s )
 {
-	appendMessagesLine(s);
+	qsynthMessagesModel::Record rec;
+	rec.iTime = QTime(0, 0).msecsTo(QTime::currentTime());
+	rec.severity = qsynthMessagesModel::Output;
+	if (Qt::mightBeRichText(s))
+		rec.sText = QTextDocumentFragment::fromHtml(s).toPlainText();
+	else
+		rec.sText = s;
+
+	appendMessagesRecord(rec);
 	appendMessagesLog(s);
 }
 
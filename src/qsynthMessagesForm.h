@@ -24,8 +24,13 @@
 
 #include "ui_qsynthMessagesForm.h"
 
+#include "qsynthMessagesModel.h"
+
+#include <QStringList>
+
 // Forward declarations.
 class QFile;
+class QTimer;
 
 
 //----------------------------------------------------------------------------
@@ -55,9 +60,27 @@ public:
 	void appendMessagesColor(const QString& s, const QString& c);
 	void appendMessagesText(const QString& s);
 
+	// Producer could not keep up (eg. stdout reader falling behind).
+	void notifyBackpressure();
+
+	// Main window refresh timer has woken up (statistics only).
+	void notifyTimerWakeup();
+
+public slots:
+
+	// Flush all pending message lines, right away.
+	void flushMessages();
+
+protected slots:
+
+	void statsTimerSlot();
+
+	void filterChanged();
+	void copyMessages();
+
 protected:
 
-	void appendMessagesLine(const QString& s);
+	void appendMessagesRecord(const qsynthMessagesModel::Record& rec);
 	void appendMessagesLog(const QString& s);
 
 	void showEvent(QShowEvent *);
@@ -70,9 +93,25 @@ private:
 	Ui::qsynthMessagesForm m_ui;
 
 	// Instance variables.
-	int m_iMessagesLines;
 	int m_iMessagesLimit;
-	int m_iMessagesHigh;
+
+	// Message records ring and filter.
+	qsynthMessagesModel  *m_pMessagesModel;
+	qsynthMessagesFilter *m_pMessagesFilter;
+
+	// Pending records, coalesced until the next event loop tick.
+	QList<qsynthMessagesModel::Record> m_pendingRecords;
+	QStringList m_pendingLog;
+
+	QTimer *m_pFlushTimer;
+	QTimer *m_pStatsTimer;
+
+	// Per second rate limit and statistics.
+	int m_iRateLines;
+	int m_iRateDropped;
+	int m_iRateDeferred;
+	int m_iRateWakeups;
+	unsigned long m_iTotalDropped;
 
 	// Logging stuff.
 	QFile *m_pMessagesLog;
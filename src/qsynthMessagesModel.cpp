@@ -0,0 +1,357 @@
+// qsynthMessagesModel.cpp
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qsynthAbout.h"
+#include "qsynthMessagesModel.h"
+
+#include <QTime>
+
+
+//-------------------------------------------------------------------------
+// qsynthMessagesModel - Fixed capacity ring buffer of message records.
+//
+
+// Constructor.
+qsynthMessagesModel::qsynthMessagesModel ( int iCapacity, QObject *pParent )
+	: QAbstractListModel(pParent)
+{
+	m_iHead  = 0;
+	m_iCount = 0;
+
+	m_iSerial = 0;
+
+	m_records.resize(iCapacity > 0 ? iCapacity : 1);
+}
+
+
+// Ring capacity (keeps the most recent records).
+void qsynthMessagesModel::setCapacity ( int iCapacity )
+{
+	if (iCapacity < 1)
+		iCapacity = 1;
+
+	const int iOldCapacity = m_records.count();
+	if (iCapacity == iOldCapacity)
+		return;
+
+	beginResetModel();
+
+	const int iCount = (m_iCount < iCapacity ? m_iCount : iCapacity);
+	QVector<Record> records(iCapacity);
+	for (int i = 0; i < iCount; ++i) {
+		records[i] = m_records.at(
+			(m_iHead + m_iCount - iCount + i) % iOldCapacity);
+	}
+
+	m_records = records;
+	m_iSerial += (m_iCount - iCount);
+	m_iHead  = 0;
+	m_iCount = iCount;
+
+	endResetModel();
+}
+
+
+int qsynthMessagesModel::capacity (void) const
+{
+	return m_records.count();
+}
+
+
+// Append a batch of records, evicting the oldest ones if full.
+void qsynthMessagesModel::appendRecords ( const QList<Record>& records )
+{
+	const int iCapacity = m_records.count();
+
+	// Never mind the ones that wouldn't fit anyway...
+	int iFirst = records.count() - iCapacity;
+	if (iFirst < 0)
+		iFirst = 0;
+	const int iAppend = records.count() - iFirst;
+	if (iAppend < 1)
+		return;
+
+	// Evict the oldest ones, just by moving the head...
+	const int iEvict = m_iCount + iAppend - iCapacity;
+	if (iEvict > 0) {
+		beginRemoveRows(QModelIndex(), 0, iEvict - 1);
+		m_iHead = (m_iHead + iEvict) % iCapacity;
+		m_iCount -= iEvict;
+		m_iSerial += iEvict;
+		endRemoveRows();
+	}
+
+	beginInsertRows(QModelIndex(), m_iCount, m_iCount + iAppend - 1);
+	for (int i = iFirst; i < records.count(); ++i) {
+		m_records[(m_iHead + m_iCount) % iCapacity] = records.at(i);
+		++m_iCount;
+	}
+	endInsertRows();
+}
+
+
+// Record accessor (row relative to the oldest one).
+const qsynthMessagesModel::Record& qsynthMessagesModel::record ( int iRow ) const
+{
+	return m_records.at((m_iHead + iRow) % m_records.count());
+}
+
+
+// Serial number of the oldest record (ever increasing).
+qint64 qsynthMessagesModel::serial (void) const
+{
+	return m_iSerial;
+}
+
+
+// Record display text.
+QString qsynthMessagesModel::recordText ( const Record& rec )
+{
+	if (rec.severity == Output)
+		return rec.sText;
+
+	return QTime(0, 0).addMSecs(rec.iTime).toString("hh:mm:ss.zzz")
+		+ ' ' + rec.sText;
+}
+
+
+// Model interface.
+int qsynthMessagesModel::rowCount ( const QModelIndex& parent ) const
+{
+	return (parent.isValid() ? 0 : m_iCount);
+}
+
+
+QVariant qsynthMessagesModel::data ( const QModelIndex& index, int role ) const
+{
+	if (!index.isValid() || index.row() >= m_iCount)
+		return QVariant();
+
+	const Record& rec = record(index.row());
+
+	switch (role) {
+	case Qt::DisplayRole:
+		return recordText(rec);
+	case Qt::ForegroundRole:
+		if (rec.color.isValid())
+			return rec.color;
+		break;
+	case SeverityRole:
+		return int(rec.severity);
+	case EngineRole:
+		return rec.sEngine;
+	default:
+		break;
+	}
+
+	return QVariant();
+}
+
+
+//-------------------------------------------------------------------------
+// qsynthMessagesFilter - Engine and severity filter proxy.
+//
+
+// Constructor.
+qsynthMessagesFilter::qsynthMessagesFilter ( QObject *pParent )
+	: QAbstractListModel(pParent)
+{
+	m_pModel = NULL;
+
+	m_iSeverity = -1;
+
+	m_iHead  = 0;
+	m_iCount = 0;
+}
+
+
+// Source ring model.
+void qsynthMessagesFilter::setSourceModel ( qsynthMessagesModel *pModel )
+{
+	if (m_pModel)
+		QObject::disconnect(m_pModel, NULL, this, NULL);
+
+	m_pModel = pModel;
+
+	if (m_pModel) {
+		QObject::connect(m_pModel,
+			SIGNAL(rowsInserted(const QModelIndex&, int, int)),
+			SLOT(sourceRowsInserted(const QModelIndex&, int, int)));
+		QObject::connect(m_pModel,
+			SIGNAL(rowsRemoved(const QModelIndex&, int, int)),
+			SLOT(sourceRowsRemoved(const QModelIndex&, int, int)));
+		QObject::connect(m_pModel,
+			SIGNAL(modelReset()),
+			SLOT(sourceModelReset()));
+	}
+
+	refilter();
+}
+
+
+qsynthMessagesModel *qsynthMessagesFilter::sourceModel (void) const
+{
+	return m_pModel;
+}
+
+
+// Filter criteria (empty engine or negative severity means any).
+void qsynthMessagesFilter::setFilter ( const QString& sEngine, int iSeverity )
+{
+	if (m_sEngine == sEngine && m_iSeverity == iSeverity)
+		return;
+
+	m_sEngine   = sEngine;
+	m_iSeverity = iSeverity;
+
+	refilter();
+}
+
+
+const QString& qsynthMessagesFilter::engine (void) const
+{
+	return m_sEngine;
+}
+
+
+int qsynthMessagesFilter::severity (void) const
+{
+	return m_iSeverity;
+}
+
+
+bool qsynthMessagesFilter::isFiltering (void) const
+{
+	return (!m_sEngine.isEmpty() || m_iSeverity >= 0);
+}
+
+
+// Model interface.
+int qsynthMessagesFilter::rowCount ( const QModelIndex& parent ) const
+{
+	return (parent.isValid() ? 0 : m_iCount);
+}
+
+
+QVariant qsynthMessagesFilter::data ( const QModelIndex& index, int role ) const
+{
+	if (m_pModel == NULL || !index.isValid() || index.row() >= m_iCount)
+		return QVariant();
+
+	const qint64 iSerial
+		= m_serials.at((m_iHead + index.row()) % m_serials.count());
+	const int iSourceRow = int(iSerial - m_pModel->serial());
+
+	return m_pModel->data(m_pModel->index(iSourceRow), role);
+}
+
+
+// Newly appended source records: accept the matching ones.
+void qsynthMessagesFilter::sourceRowsInserted (
+	const QModelIndex& /*parent*/, int iFirst, int iLast )
+{
+	QList<qint64> serials;
+	for (int iRow = iFirst; iRow <= iLast; ++iRow) {
+		if (filterAcceptsRecord(m_pModel->record(iRow)))
+			serials.append(m_pModel->serial() + iRow);
+	}
+
+	if (serials.isEmpty())
+		return;
+
+	const int iCapacity = m_serials.count();
+	beginInsertRows(QModelIndex(), m_iCount, m_iCount + serials.count() - 1);
+	QListIterator<qint64> iter(serials);
+	while (iter.hasNext()) {
+		m_serials[(m_iHead + m_iCount) % iCapacity] = iter.next();
+		++m_iCount;
+	}
+	endInsertRows();
+}
+
+
+// Evicted source records: drop the ones older than the source head.
+void qsynthMessagesFilter::sourceRowsRemoved (
+	const QModelIndex& /*parent*/, int /*iFirst*/, int /*iLast*/ )
+{
+	const int iCapacity = m_serials.count();
+	const qint64 iSerial = m_pModel->serial();
+
+	int iEvict = 0;
+	while (iEvict < m_iCount
+		&& m_serials.at((m_iHead + iEvict) % iCapacity) < iSerial)
+		++iEvict;
+
+	if (iEvict < 1)
+		return;
+
+	beginRemoveRows(QModelIndex(), 0, iEvict - 1);
+	m_iHead = (m_iHead + iEvict) % iCapacity;
+	m_iCount -= iEvict;
+	endRemoveRows();
+}
+
+
+// Source capacity changed or else.
+void qsynthMessagesFilter::sourceModelReset (void)
+{
+	refilter();
+}
+
+
+// Filter predicate, straight on the ring records.
+bool qsynthMessagesFilter::filterAcceptsRecord (
+	const qsynthMessagesModel::Record& rec ) const
+{
+	if (m_iSeverity >= 0 && int(rec.severity) != m_iSeverity)
+		return false;
+
+	if (!m_sEngine.isEmpty() && rec.sEngine != m_sEngine)
+		return false;
+
+	return true;
+}
+
+
+// Rebuild the accepted serials ring from scratch.
+void qsynthMessagesFilter::refilter (void)
+{
+	beginResetModel();
+
+	m_iHead  = 0;
+	m_iCount = 0;
+
+	if (m_pModel) {
+		const int iRows = m_pModel->rowCount();
+		m_serials.resize(m_pModel->capacity());
+		for (int iRow = 0; iRow < iRows; ++iRow) {
+			if (filterAcceptsRecord(m_pModel->record(iRow)))
+				m_serials[m_iCount++] = m_pModel->serial() + iRow;
+		}
+	} else {
+		m_serials.resize(1);
+	}
+
+	endResetModel();
+}
+
+
+// end of qsynthMessagesModel.cpp
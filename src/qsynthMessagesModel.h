@@ -0,0 +1,157 @@
+// qsynthMessagesModel.h
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qsynthMessagesModel_h
+#define __qsynthMessagesModel_h
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <QColor>
+
+
+//-------------------------------------------------------------------------
+// qsynthMessagesModel - Fixed capacity ring buffer of message records.
+//
+// Rows are addressed relative to the ring head, so that appending new
+// records and evicting the oldest ones are both constant time, whatever
+// the capacity (ie. messages line limit).
+
+class qsynthMessagesModel : public QAbstractListModel
+{
+public:
+
+	// Record severities.
+	enum Severity { Output = 0, Info = 1, Notice = 2, Error = 3 };
+
+	// Custom item data roles.
+	enum { SeverityRole = Qt::UserRole + 1, EngineRole };
+
+	// Parsed message record.
+	struct Record
+	{
+		int      iTime;     // Milliseconds since midnight.
+		Severity severity;
+		QString  sEngine;   // Empty if not engine specific.
+		QString  sText;
+		QColor   color;     // Invalid for plain output.
+	};
+
+	// Constructor.
+	qsynthMessagesModel(int iCapacity, QObject *pParent = NULL);
+
+	// Ring capacity (keeps the most recent records).
+	void setCapacity(int iCapacity);
+	int capacity() const;
+
+	// Append a batch of records, evicting the oldest ones if full.
+	void appendRecords(const QList<Record>& records);
+
+	// Record accessor (row relative to the oldest one).
+	const Record& record(int iRow) const;
+
+	// Serial number of the oldest record (ever increasing).
+	qint64 serial() const;
+
+	// Record display text.
+	static QString recordText(const Record& rec);
+
+	// Model interface.
+	int rowCount(const QModelIndex& parent = QModelIndex()) const;
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+
+private:
+
+	// Instance variables.
+	QVector<Record> m_records;
+
+	int m_iHead;
+	int m_iCount;
+
+	qint64 m_iSerial;
+};
+
+
+//-------------------------------------------------------------------------
+// qsynthMessagesFilter - Engine and severity filter proxy.
+//
+// Keeps its own ring of the accepted record serials, so that appending
+// and evicting records costs just as many rows as those affected; only
+// changing the filter criteria rescans the whole (bounded) source ring.
+
+class qsynthMessagesFilter : public QAbstractListModel
+{
+	Q_OBJECT
+
+public:
+
+	// Constructor.
+	qsynthMessagesFilter(QObject *pParent = NULL);
+
+	// Source ring model.
+	void setSourceModel(qsynthMessagesModel *pModel);
+	qsynthMessagesModel *sourceModel() const;
+
+	// Filter criteria (empty engine or negative severity means any).
+	void setFilter(const QString& sEngine, int iSeverity);
+
+	const QString& engine() const;
+	int severity() const;
+
+	bool isFiltering() const;
+
+	// Model interface.
+	int rowCount(const QModelIndex& parent = QModelIndex()) const;
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+
+protected slots:
+
+	// Source ring model changes.
+	void sourceRowsInserted(const QModelIndex& parent, int iFirst, int iLast);
+	void sourceRowsRemoved(const QModelIndex& parent, int iFirst, int iLast);
+	void sourceModelReset();
+
+protected:
+
+	// Filter predicate.
+	bool filterAcceptsRecord(const qsynthMessagesModel::Record& rec) const;
+
+	// Rebuild the accepted serials ring from scratch.
+	void refilter();
+
+private:
+
+	// Instance variables.
+	qsynthMessagesModel *m_pModel;
+
+	QString m_sEngine;
+	int     m_iSeverity;
+
+	QVector<qint64> m_serials;
+
+	int m_iHead;
+	int m_iCount;
+};
+
+
+#endif  // __qsynthMessagesModel_h
+
+
+// end of qsynthMessagesModel.h
@@ -27,6 +27,7 @@
 #include <QLabel>
 
 #include <QHBoxLayout>
+#include <QPaintEvent>
 
 #include <math.h>
 
@@ -149,10 +150,17 @@ void qsynthMeterValue::peakReset (void)
 }
 
 
+// Whether still showing anything (value or peak).
+bool qsynthMeterValue::isActive (void) const
+{
+	return (m_iValue > 0 || m_iPeak > 0);
+}
+
+
 // Value refreshment.
 void qsynthMeterValue::refresh (void)
 {
-	if (m_fValue < 0.001f && m_iPeak < 1)
+	if (m_fValue < 0.001f && m_iValue < 1 && m_iPeak < 1)
 		return;
 
 	float dB = QSYNTH_METER_MINDB;
@@ -195,74 +203,72 @@ void qsynthMeterValue::refresh (void)
 	if (iValue == m_iValue && iPeak == m_iPeak)
 		return;
 
+	// Only repaint what has actually changed...
+	const int w = QWidget::width();
+	const int h = QWidget::height();
+
+	if (iValue != m_iValue) {
+		const int y1 = (iValue > m_iValue ? iValue : m_iValue);
+		const int y2 = (iValue > m_iValue ? m_iValue : iValue);
+		QWidget::update(0, h - y1, w, y1 - y2);
+	}
+
+	if (iPeak != m_iPeak) {
+		QWidget::update(0, h - m_iPeak, w, 1);
+		QWidget::update(0, h - iPeak, w, 1);
+	}
+
 	m_iValue = iValue;
 	m_iPeak  = iPeak;
-
-	update();
 }
 
 
 
-// Paint event handler.
-void qsynthMeterValue::paintEvent ( QPaintEvent * )
+// Paint event handler; only the dirty rectangle gets copied
+// from the pre-rendered band images (lit below the current
+// value, background above), then the peak line on top.
+void qsynthMeterValue::paintEvent ( QPaintEvent *pPaintEvent )
 {
 	QPainter painter(this);
 
 	const int w = QWidget::width();
 	const int h = QWidget::height();
 
-	int y;
+	const QRect& rect = pPaintEvent->rect();
 
-	if (isEnabled()) {
-		painter.fillRect(0, 0, w, h,
-			m_pMeter->color(qsynthMeter::ColorBack));
-		y = m_pMeter->iec_level(qsynthMeter::Color0dB);
-		painter.setPen(m_pMeter->color(qsynthMeter::ColorFore));
-		painter.drawLine(0, h - y, w, h - y);
-	} else {
-		painter.fillRect(0, 0, w, h, QWidget::palette().dark().color());
-	}
+	const int y = h - m_iValue;
 
-#ifdef CONFIG_GRADIENT
-	painter.drawPixmap(0, h - m_iValue,
-		m_pMeter->pixmap(), 0, h - m_iValue, w, m_iValue);
-#else
-	y = m_iValue;
-
-	int y_over = 0;
-	int y_curr = 0;
-
-	for (int i = qsynthMeter::Color10dB;
-			i > qsynthMeter::ColorOver && y >= y_over; --i) {
-		y_curr = m_pMeter->iec_level(i);
-		if (y < y_curr) {
-			painter.fillRect(0, h - y, w, y - y_over,
-				m_pMeter->color(i));
-		} else {
-			painter.fillRect(0, h - y_curr, w, y_curr - y_over,
-				m_pMeter->color(i));
-		}
-		y_over = y_curr;
+	const QRect rectBack = rect.intersected(QRect(0, 0, w, y));
+	if (!rectBack.isEmpty()) {
+		const int iBand = (isEnabled()
+			? qsynthMeter::BandBack : qsynthMeter::BandOff);
+		painter.drawPixmap(rectBack,
+			m_pMeter->bandPixmap(iBand, w, h), rectBack);
 	}
 
-	if (y > y_over) {
-		painter.fillRect(0, h - y, w, y - y_over,
-			m_pMeter->color(qsynthMeter::ColorOver));
+	const QRect rectLit = rect.intersected(QRect(0, y, w, m_iValue));
+	if (!rectLit.isEmpty()) {
+		painter.drawPixmap(rectLit,
+			m_pMeter->bandPixmap(qsynthMeter::BandLit, w, h), rectLit);
 	}
-#endif
 
-	painter.setPen(m_pMeter->color(m_iPeakColor));
-	painter.drawLine(0, h - m_iPeak, w, h - m_iPeak);
+	const int y_peak = h - m_iPeak;
+	if (y_peak >= rect.top() && y_peak <= rect.bottom()) {
+		painter.setPen(m_pMeter->color(m_iPeakColor));
+		painter.drawLine(rect.left(), y_peak, rect.right(), y_peak);
+	}
 }
 
 
 // Resize event handler.
 void qsynthMeterValue::resizeEvent ( QResizeEvent *pResizeEvent )
 {
-	m_iPeak = 0;
+	// Scale has changed: start all over...
+	m_iValue = 0;
+	m_iPeak  = 0;
 
 	QWidget::resizeEvent(pResizeEvent);
-//	QWidget::repaint(true);
+	QWidget::update();
 }
 
 
@@ -273,17 +279,13 @@ void qsynthMeterValue::resizeEvent ( QResizeEvent *pResizeEvent )
 qsynthMeter::qsynthMeter ( QWidget *pParent )
 	: QWidget(pParent)
 {
-	m_iPortCount   = 2;	// FIXME: Default port count.
-	m_iScaleCount  = m_iPortCount;
+	m_iPortCount   = 0;
+	m_iScaleCount  = 0;
 	m_ppValues     = NULL;
 	m_ppScales     = NULL;
 
 	m_fScale = 0.0f;
 
-#ifdef CONFIG_GRADIENT
-	m_pPixmap = new QPixmap();
-#endif
-
 	m_iPeakFalloff = QSYNTH_METER_PEAK_FALLOFF;
 
 	for (int i = 0; i < LevelCount; i++)
@@ -304,50 +306,70 @@ qsynthMeter::qsynthMeter ( QWidget *pParent )
 
 	QWidget::setBackgroundRole(QPalette::NoRole);
 
-	if (m_iPortCount > 0) {
-		if (m_iPortCount > 1)
-			m_iScaleCount--;
-		m_ppValues = new qsynthMeterValue *[m_iPortCount];
-		m_ppScales = new qsynthMeterScale *[m_iScaleCount];
-		for (int iPort = 0; iPort < m_iPortCount; iPort++) {
-			m_ppValues[iPort] = new qsynthMeterValue(this);
-			m_pHBoxLayout->addWidget(m_ppValues[iPort]);
-			if (iPort < m_iScaleCount) {
-				m_ppScales[iPort] = new qsynthMeterScale(this);
-				m_pHBoxLayout->addWidget(m_ppScales[iPort]);
-			}
-		}
-		int iStripCount = 2 * m_iPortCount;
-		if (m_iPortCount > 1)
-			--iStripCount;
-		QWidget::setMinimumSize(12 * iStripCount, 120);
-		QWidget::setMaximumWidth(16 * iStripCount);
-	} else {
-		QWidget::setMinimumSize(2, 120);
-		QWidget::setMaximumWidth(4);
-	}
-
 	QWidget::setSizePolicy(
 		QSizePolicy(QSizePolicy::Minimum, QSizePolicy::Expanding));
+
+	// Default port count (pseudo-stereo).
+	setPortCount(2);
 }
 
 
 // Default destructor.
 qsynthMeter::~qsynthMeter (void)
 {
-#ifdef CONFIG_GRADIENT
-	delete m_pPixmap;
-#endif
-	for (int iPort = 0; iPort < m_iPortCount; iPort++) {
+	setPortCount(0);
+
+	delete m_pHBoxLayout;
+}
+
+
+// Port count (re)allocation; one scale goes in the middle of each
+// stereo pair, so that a multi-channel bridge reads pair-wise.
+void qsynthMeter::setPortCount ( int iPortCount )
+{
+	if (iPortCount == m_iPortCount)
+		return;
+
+	int iPort;
+
+	for (iPort = 0; iPort < m_iPortCount; ++iPort)
 		delete m_ppValues[iPort];
-		if (iPort < m_iScaleCount)
-			delete m_ppScales[iPort];
-	}
+	for (iPort = 0; iPort < m_iScaleCount; ++iPort)
+		delete m_ppScales[iPort];
 
 	delete [] m_ppScales;
 	delete [] m_ppValues;
 
-	delete m_pHBoxLayout;
+	m_ppValues = NULL;
+	m_ppScales = NULL;
+
+	m_iPortCount  = iPortCount;
+	m_iScaleCount = (m_iPortCount > 1 ? (m_iPortCount >> 1) : m_iPortCount);
+
+	if (m_iPortCount > 0) {
+		m_ppValues = new qsynthMeterValue *[m_iPortCount];
+		m_ppScales = new qsynthMeterScale *[m_iScaleCount];
+		int iScale = 0;
+		for (iPort = 0; iPort < m_iPortCount; ++iPort) {
+			m_ppValues[iPort] = new qsynthMeterValue(this);
+			m_pHBoxLayout->addWidget(m_ppValues[iPort]);
+			if ((iPort & 1) == 0 && iScale < m_iScaleCount) {
+				m_ppScales[iScale] = new qsynthMeterScale(this);
+				m_pHBoxLayout->addWidget(m_ppScales[iScale]);
+				++iScale;
+			}
+		}
+		const int iStripCount = m_iPortCount + m_iScaleCount;
+		QWidget::setMinimumSize(12 * iStripCount, 120);
+		QWidget::setMaximumWidth(16 * iStripCount);
+		for (iPort = 0; iPort < m_iPortCount; ++iPort)
+			m_ppValues[iPort]->show();
+		for (iPort = 0; iPort < m_iScaleCount; ++iPort)
+			m_ppScales[iPort]->show();
+	} else {
+		QWidget::setMinimumSize(2, 120);
+		QWidget::setMaximumWidth(4);
+	}
 }
 
 
@@ -408,30 +430,56 @@ void qsynthMeter::peakReset (void)
 }
 
 
-#ifdef CONFIG_GRADIENT
-// Gradient pixmap accessor.
-const QPixmap& qsynthMeter::pixmap (void) const
+// Pre-rendered band image accessor (cached per strip size).
+const QPixmap& qsynthMeter::bandPixmap ( int iBand, int w, int h )
 {
-	return *m_pPixmap;
-}
+	const quint64 iKey = (quint64(w) << 32) | (quint64(h) << 2) | iBand;
 
-void qsynthMeter::updatePixmap (void)
-{
-	const int w = QWidget::width();
-	const int h = QWidget::height();
+	QHash<quint64, QPixmap>::Iterator iter = m_bands.find(iKey);
+	if (iter != m_bands.end())
+		return iter.value();
+
+	QPixmap pixmap(w, h);
+	QPainter painter(&pixmap);
 
-	QLinearGradient grad(0, 0, 0, h);
-	grad.setColorAt(0.2f, color(ColorOver));
-	grad.setColorAt(0.3f, color(Color0dB));
-	grad.setColorAt(0.4f, color(Color3dB));
-	grad.setColorAt(0.6f, color(Color6dB));
-	grad.setColorAt(0.8f, color(Color10dB));
+	if (iBand == BandOff) {
+		painter.fillRect(0, 0, w, h, QWidget::palette().dark().color());
+	}
+	else
+	if (iBand == BandBack) {
+		painter.fillRect(0, 0, w, h, color(ColorBack));
+		const int y = iec_level(Color0dB);
+		painter.setPen(color(ColorFore));
+		painter.drawLine(0, h - y, w, h - y);
+	}
+	else {
+	#ifdef CONFIG_GRADIENT
+		QLinearGradient grad(0, 0, 0, h);
+		grad.setColorAt(0.2f, color(ColorOver));
+		grad.setColorAt(0.3f, color(Color0dB));
+		grad.setColorAt(0.4f, color(Color3dB));
+		grad.setColorAt(0.6f, color(Color6dB));
+		grad.setColorAt(0.8f, color(Color10dB));
+		painter.fillRect(0, 0, w, h, grad);
+	#else
+		int y_over = 0;
+		int y_curr = 0;
+		for (int i = Color10dB; i > ColorOver && h >= y_over; --i) {
+			y_curr = iec_level(i);
+			if (h < y_curr)
+				y_curr = h;
+			painter.fillRect(0, h - y_curr, w, y_curr - y_over, color(i));
+			y_over = y_curr;
+		}
+		if (h > y_over)
+			painter.fillRect(0, 0, w, h - y_over, color(ColorOver));
+	#endif
+	}
 
-	*m_pPixmap = QPixmap(w, h);
+	painter.end();
 
-	QPainter(m_pPixmap).fillRect(0, 0, w, h, grad);
+	return m_bands.insert(iKey, pixmap).value();
 }
-#endif
 
 
 // Slot refreshment.
@@ -442,6 +490,18 @@ void qsynthMeter::refresh (void)
 }
 
 
+// Whether any port is still showing anything.
+bool qsynthMeter::isActive (void) const
+{
+	for (int iPort = 0; iPort < m_iPortCount; iPort++) {
+		if (m_ppValues[iPort]->isActive())
+			return true;
+	}
+
+	return false;
+}
+
+
 // Resize event handler.
 void qsynthMeter::resizeEvent ( QResizeEvent * )
 {
@@ -452,16 +512,16 @@ void qsynthMeter::resizeEvent ( QResizeEvent * )
 	m_levels[Color6dB]  = iec_scale( -6.0f);
 	m_levels[Color10dB] = iec_scale(-10.0f);
 
-#ifdef CONFIG_GRADIENT
-	updatePixmap();
-#endif
+	// Band images are all stale now.
+	m_bands.clear();
 }
 
 
 // Meter value proxy.
 void qsynthMeter::setValue ( int iPort, float fValue )
 {
-	m_ppValues[iPort]->setValue(fValue);
+	if (iPort >= 0 && iPort < m_iPortCount)
+		m_ppValues[iPort]->setValue(fValue);
 }
 
 
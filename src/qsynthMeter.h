@@ -23,6 +23,8 @@
 #define __qsynthMeter_h
 
 #include <QFrame>
+#include <QPixmap>
+#include <QHash>
 
 // Forward declarations.
 class qsynthMeter;
@@ -81,6 +83,9 @@ public:
 	// Reset peak holder.
 	void peakReset();
 
+	// Whether still showing anything (value or peak).
+	bool isActive() const;
+
 protected:
 
 	// Specific event handlers.
@@ -119,7 +124,8 @@ public:
 	// Default destructor.
 	~qsynthMeter();
 
-	// Port count accessor.
+	// Port count accessors.
+	void setPortCount(int iPortCount);
 	int portCount() const;
 
 	// Value proxy.    
@@ -129,10 +135,11 @@ public:
 	int iec_scale(float dB) const;
 	int iec_level(int iIndex) const;
 
-#ifdef CONFIG_GRADIENT
-	const QPixmap& pixmap() const;
-	void updatePixmap();
-#endif
+	// Band image states.
+	enum { BandBack = 0, BandLit = 1, BandOff = 2 };
+
+	// Pre-rendered band image accessor (cached per strip size).
+	const QPixmap& bandPixmap(int iBand, int w, int h);
 
 	// Slot refreshment.
 	void refresh();
@@ -160,6 +167,9 @@ public:
 	// Reset peak holder.
 	void peakReset();
 
+	// Whether any port is still showing anything.
+	bool isActive() const;
+
 protected:
 
 	// Specific event handlers.
@@ -179,9 +189,8 @@ private:
 	int     m_levels[LevelCount];
 	QColor  m_colors[ColorCount];
 
-#ifdef CONFIG_GRADIENT
-	QPixmap *m_pPixmap;
-#endif
+	// Pre-rendered band images (per strip size and state).
+	QHash<quint64, QPixmap> m_bands;
 
 	// Peak falloff mode setting (0=no peak falloff).
 	int m_iPeakFalloff;
@@ -0,0 +1,380 @@
+// qsynthMidiMonitorForm.cpp
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qsynthAbout.h"
+#include "qsynthMidiMonitorForm.h"
+
+#include "qsynthMainForm.h"
+
+#include <QAbstractTableModel>
+#include <QSortFilterProxyModel>
+#include <QHeaderView>
+#include <QScrollBar>
+
+#include <QShowEvent>
+#include <QHideEvent>
+
+
+// The maximum number of monitored events kept.
+#define QSYNTH_MIDI_MONITOR_MAXEVENTS  10000
+
+
+//----------------------------------------------------------------------------
+// qsynthMidiMonitorModel -- Fixed capacity ring of tapped events.
+//
+// Events are kept as tapped (binary) and only decoded on display.
+
+class qsynthMidiMonitorModel : public QAbstractTableModel
+{
+public:
+
+	// Columns.
+	enum { Time = 0, Channel, Type, Param1, Param2, Columns };
+
+	// Constructor.
+	qsynthMidiMonitorModel(QObject *pParent = NULL)
+		: QAbstractTableModel(pParent), m_iHead(0), m_iCount(0)
+		{ m_events.resize(QSYNTH_MIDI_MONITOR_MAXEVENTS); }
+
+	// Append a batch of events, evicting the oldest ones if full.
+	void appendEvents(const QVector<qsynthMidiTapEvent>& events)
+	{
+		const int iCapacity = m_events.count();
+		int iFirst = events.count() - iCapacity;
+		if (iFirst < 0)
+			iFirst = 0;
+		const int iAppend = events.count() - iFirst;
+		if (iAppend < 1)
+			return;
+		const int iEvict = m_iCount + iAppend - iCapacity;
+		if (iEvict > 0) {
+			beginRemoveRows(QModelIndex(), 0, iEvict - 1);
+			m_iHead = (m_iHead + iEvict) % iCapacity;
+			m_iCount -= iEvict;
+			endRemoveRows();
+		}
+		beginInsertRows(QModelIndex(), m_iCount, m_iCount + iAppend - 1);
+		for (int i = iFirst; i < events.count(); ++i) {
+			m_events[(m_iHead + m_iCount) % iCapacity] = events.at(i);
+			++m_iCount;
+		}
+		endInsertRows();
+	}
+
+	// Remove all events.
+	void clear()
+	{
+		beginResetModel();
+		m_iHead  = 0;
+		m_iCount = 0;
+		endResetModel();
+	}
+
+	// Event accessor (row relative to the oldest one).
+	const qsynthMidiTapEvent& event(int iRow) const
+		{ return m_events.at((m_iHead + iRow) % m_events.count()); }
+
+	// Model interface.
+	int rowCount(const QModelIndex& parent = QModelIndex()) const
+		{ return (parent.isValid() ? 0 : m_iCount); }
+	int columnCount(const QModelIndex& parent = QModelIndex()) const
+		{ return (parent.isValid() ? 0 : Columns); }
+
+	QVariant headerData(int section, Qt::Orientation orient, int role) const
+	{
+		if (orient != Qt::Horizontal || role != Qt::DisplayRole)
+			return QVariant();
+		switch (section) {
+		case Time:
+			return qsynthMidiMonitorForm::tr("Time");
+		case Channel:
+			return qsynthMidiMonitorForm::tr("Ch");
+		case Type:
+			return qsynthMidiMonitorForm::tr("Event");
+		case Param1:
+			return qsynthMidiMonitorForm::tr("Data 1");
+		case Param2:
+			return qsynthMidiMonitorForm::tr("Data 2");
+		default:
+			return QVariant();
+		}
+	}
+
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const
+	{
+		if (!index.isValid() || index.row() >= m_iCount)
+			return QVariant();
+		if (role == Qt::TextAlignmentRole && index.column() != Type)
+			return int(Qt::AlignRight | Qt::AlignVCenter);
+		if (role != Qt::DisplayRole)
+			return QVariant();
+		const qsynthMidiTapEvent& ev = event(index.row());
+		switch (index.column()) {
+		case Time:
+			return QString("%1.%2")
+				.arg(ev.iTime / 1000000)
+				.arg(ev.iTime % 1000000, 6, 10, QChar('0'));
+		case Channel:
+			return int(ev.channel) + 1;
+		case Type:
+			return qsynthEngine::midiTapType(ev);
+		case Param1:
+			return int(ev.param1);
+		case Param2:
+			if (ev.type >= 0x80 && ev.type < 0xc0)
+				return ev.param2;
+			// Fall thru...
+		default:
+			return QVariant();
+		}
+	}
+
+private:
+
+	// Instance variables.
+	QVector<qsynthMidiTapEvent> m_events;
+
+	int m_iHead;
+	int m_iCount;
+};
+
+
+//----------------------------------------------------------------------------
+// qsynthMidiMonitorFilter -- Channel and type filter proxy.
+
+class qsynthMidiMonitorFilter : public QSortFilterProxyModel
+{
+public:
+
+	// Constructor.
+	qsynthMidiMonitorFilter(QObject *pParent = NULL)
+		: QSortFilterProxyModel(pParent), m_iChannel(-1), m_iType(-1)
+		{ setDynamicSortFilter(true); }
+
+	// Filter criteria (negative means any).
+	void setFilter(int iChannel, int iType)
+	{
+		if (m_iChannel == iChannel && m_iType == iType)
+			return;
+		m_iChannel = iChannel;
+		m_iType = iType;
+		invalidateFilter();
+	}
+
+	bool isFiltering() const
+		{ return (m_iChannel >= 0 || m_iType >= 0); }
+
+protected:
+
+	// Filter predicate, straight on the ring events.
+	bool filterAcceptsRow(int iSourceRow, const QModelIndex& /*parent*/) const
+	{
+		const qsynthMidiMonitorModel *pModel
+			= static_cast<const qsynthMidiMonitorModel *> (sourceModel());
+		if (pModel == NULL)
+			return false;
+		const qsynthMidiTapEvent& ev = pModel->event(iSourceRow);
+		if (m_iChannel >= 0 && int(ev.channel) != m_iChannel)
+			return false;
+		if (m_iType >= 0 && int(ev.type) != m_iType)
+			return false;
+		return true;
+	}
+
+private:
+
+	// Instance variables.
+	int m_iChannel;
+	int m_iType;
+};
+
+
+//----------------------------------------------------------------------------
+// qsynthMidiMonitorForm -- UI wrapper form.
+
+// Constructor.
+qsynthMidiMonitorForm::qsynthMidiMonitorForm (
+	QWidget *pParent, Qt::WindowFlags wflags )
+	: QWidget(pParent, wflags)
+{
+	// Setup UI struct...
+	m_ui.setupUi(this);
+
+	m_pEngine = NULL;
+
+	// Tapped events ring, viewed through a filter only when needed.
+	m_pMonitorModel  = new qsynthMidiMonitorModel(this);
+	m_pMonitorFilter = new qsynthMidiMonitorFilter(this);
+	m_pMonitorFilter->setSourceModel(m_pMonitorModel);
+	m_ui.MonitorTreeView->setModel(m_pMonitorModel);
+
+	QHeaderView *pHeader = m_ui.MonitorTreeView->header();
+	pHeader->setDefaultAlignment(Qt::AlignLeft);
+	pHeader->setStretchLastSection(true);
+	const int iCharWidth = m_ui.MonitorTreeView->fontMetrics().width('0');
+	m_ui.MonitorTreeView->setColumnWidth(qsynthMidiMonitorModel::Time, 14 * iCharWidth);
+	m_ui.MonitorTreeView->setColumnWidth(qsynthMidiMonitorModel::Channel, 5 * iCharWidth);
+	m_ui.MonitorTreeView->setColumnWidth(qsynthMidiMonitorModel::Type, 16 * iCharWidth);
+	m_ui.MonitorTreeView->setColumnWidth(qsynthMidiMonitorModel::Param1, 7 * iCharWidth);
+
+	// Event type filter...
+	m_ui.TypeComboBox->addItem(tr("(All)"), -1);
+	static const int s_aTypes[] = {
+		0x90, 0x80, 0xa0, 0xb0, 0xc0, 0xd0, 0xe0, 0 };
+	for (int i = 0; s_aTypes[i]; ++i) {
+		qsynthMidiTapEvent ev;
+		ev.type = (unsigned char) s_aTypes[i];
+		m_ui.TypeComboBox->addItem(qsynthEngine::midiTapType(ev), s_aTypes[i]);
+	}
+
+	m_iRateEvents = 0;
+	m_rateTime.start();
+
+	// UI signal/slot connections...
+	QObject::connect(m_ui.ChannelSpinBox,
+		SIGNAL(valueChanged(int)),
+		SLOT(filterChanged()));
+	QObject::connect(m_ui.TypeComboBox,
+		SIGNAL(activated(int)),
+		SLOT(filterChanged()));
+	QObject::connect(m_ui.ClearPushButton,
+		SIGNAL(clicked()),
+		SLOT(clear()));
+}
+
+
+// Destructor.
+qsynthMidiMonitorForm::~qsynthMidiMonitorForm (void)
+{
+}
+
+
+// Notify our parent that we're emerging.
+void qsynthMidiMonitorForm::showEvent ( QShowEvent *pShowEvent )
+{
+	qsynthMainForm *pMainForm = qsynthMainForm::getInstance();
+	if (pMainForm)
+		pMainForm->stabilizeForm();
+
+	QWidget::showEvent(pShowEvent);
+}
+
+// Notify our parent that we're closing.
+void qsynthMidiMonitorForm::hideEvent ( QHideEvent *pHideEvent )
+{
+	QWidget::hideEvent(pHideEvent);
+
+	qsynthMainForm *pMainForm = qsynthMainForm::getInstance();
+	if (pMainForm)
+		pMainForm->stabilizeForm();
+}
+
+// Just about to notify main-window that we're closing.
+void qsynthMidiMonitorForm::closeEvent ( QCloseEvent * /*pCloseEvent*/ )
+{
+	QWidget::hide();
+
+	qsynthMainForm *pMainForm = qsynthMainForm::getInstance();
+	if (pMainForm)
+		pMainForm->stabilizeForm();
+}
+
+
+// Monitored engine (events are cleared on change).
+void qsynthMidiMonitorForm::setEngine ( qsynthEngine *pEngine )
+{
+	if (m_pEngine == pEngine)
+		return;
+
+	m_pEngine = pEngine;
+
+	QString sTitle = QSYNTH_TITLE ": " + tr("MIDI Monitor");
+	if (m_pEngine)
+		sTitle += " [" + m_pEngine->name() + "]";
+	setWindowTitle(sTitle);
+
+	clear();
+}
+
+
+qsynthEngine *qsynthMidiMonitorForm::engine (void) const
+{
+	return m_pEngine;
+}
+
+
+// Append a batch of tapped events.
+void qsynthMidiMonitorForm::appendEvents (
+	const QVector<qsynthMidiTapEvent>& events )
+{
+	QTreeView *pTreeView = m_ui.MonitorTreeView;
+	QScrollBar *pScrollBar = pTreeView->verticalScrollBar();
+	const bool bScrollEnd = (pScrollBar->value() >= pScrollBar->maximum());
+
+	m_pMonitorModel->appendEvents(events);
+
+	if (bScrollEnd)
+		pTreeView->scrollToBottom();
+
+	// Throughput, about once a second...
+	m_iRateEvents += events.count();
+	const qint64 iElapsed = m_rateTime.elapsed();
+	if (iElapsed >= 1000) {
+		m_ui.StatusTextLabel->setText(tr("%1 events/s")
+			.arg((1000 * qint64(m_iRateEvents)) / iElapsed));
+		m_iRateEvents = 0;
+		m_rateTime.restart();
+	}
+}
+
+
+// Remove all events.
+void qsynthMidiMonitorForm::clear (void)
+{
+	m_pMonitorModel->clear();
+
+	m_iRateEvents = 0;
+	m_rateTime.restart();
+	m_ui.StatusTextLabel->clear();
+}
+
+
+// Channel and type filter changed.
+void qsynthMidiMonitorForm::filterChanged (void)
+{
+	const int iChannel = m_ui.ChannelSpinBox->value() - 1;
+	const int iType = m_ui.TypeComboBox->itemData(
+		m_ui.TypeComboBox->currentIndex()).toInt();
+
+	m_pMonitorFilter->setFilter(iChannel, iType);
+
+	// Unfiltered view goes straight to the ring model...
+	QAbstractItemModel *pModel = m_pMonitorModel;
+	if (m_pMonitorFilter->isFiltering())
+		pModel = m_pMonitorFilter;
+	if (m_ui.MonitorTreeView->model() != pModel)
+		m_ui.MonitorTreeView->setModel(pModel);
+
+	m_ui.MonitorTreeView->scrollToBottom();
+}
+
+
+// end of qsynthMidiMonitorForm.cpp
@@ -0,0 +1,90 @@
+// qsynthMidiMonitorForm.h
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qsynthMidiMonitorForm_h
+#define __qsynthMidiMonitorForm_h
+
+#include "ui_qsynthMidiMonitorForm.h"
+
+#include "qsynthEngine.h"
+
+
+// Forward declarations.
+class qsynthMidiMonitorModel;
+class qsynthMidiMonitorFilter;
+
+
+//----------------------------------------------------------------------------
+// qsynthMidiMonitorForm -- UI wrapper form.
+
+class qsynthMidiMonitorForm : public QWidget
+{
+	Q_OBJECT
+
+public:
+
+	// Constructor.
+	qsynthMidiMonitorForm(QWidget *pParent = 0, Qt::WindowFlags wflags = 0);
+	// Destructor.
+	~qsynthMidiMonitorForm();
+
+	// Monitored engine (events are cleared on change).
+	void setEngine(qsynthEngine *pEngine);
+	qsynthEngine *engine() const;
+
+	// Append a batch of tapped events.
+	void appendEvents(const QVector<qsynthMidiTapEvent>& events);
+
+public slots:
+
+	void clear();
+
+protected slots:
+
+	void filterChanged();
+
+protected:
+
+	void showEvent(QShowEvent *);
+	void hideEvent(QHideEvent *);
+	void closeEvent(QCloseEvent *);
+
+private:
+
+	// The Qt-designer UI struct...
+	Ui::qsynthMidiMonitorForm m_ui;
+
+	// Instance variables.
+	qsynthEngine *m_pEngine;
+
+	qsynthMidiMonitorModel  *m_pMonitorModel;
+	qsynthMidiMonitorFilter *m_pMonitorFilter;
+
+	// Throughput statistics.
+	QElapsedTimer m_rateTime;
+	int m_iRateEvents;
+};
+
+
+#endif	// __qsynthMidiMonitorForm_h
+
+
+// end of qsynthMidiMonitorForm.h
@@ -23,6 +23,8 @@
 #include "qsynthOptions.h"
 
 #include "qsynthEngine.h"
+#include "qsynthSoundFontMeta.h"
+#include "qsynthSoundFontCache.h"
 
 #include <QTextStream>
 #include <QComboBox>
@@ -41,6 +43,11 @@ qsynthOptions::qsynthOptions (void)
 	// Load previous/default fluidsynth settings...
 	loadSetup(m_pDefaultSetup, QString::null);
 
+	// No offline rendering, unless told so on command line.
+	bRender        = false;
+	iRenderJobs    = 0;
+	bRenderEngines = false;
+
 	loadOptions();
 }
 
@@ -70,6 +77,7 @@ void qsynthOptions::loadOptions (void)
 	bKeepOnTop      = m_settings.value("/KeepOnTop", false).toBool();
 	bStdoutCapture  = m_settings.value("/StdoutCapture", true).toBool();
 	bOutputMeters   = m_settings.value("/OutputMeters", false).toBool();
+	bSeamlessRestart = m_settings.value("/SeamlessRestart", false).toBool();
 	bSystemTray     = m_settings.value("/SystemTray", false).toBool();
 	bSystemTrayQueryClose = m_settings.value("/SystemTrayQueryClose", true).toBool();
 	bStartMinimized = m_settings.value("/StartMinimized", false).toBool();
@@ -82,6 +90,8 @@ void qsynthOptions::loadOptions (void)
 	m_settings.beginGroup("/Defaults");
 	sSoundFontDir  = m_settings.value("/SoundFontDir").toString();
 	bPresetPreview = m_settings.value("/PresetPreview", false).toBool();
+	iWarmPresets   = m_settings.value("/WarmPresets", 0).toInt();
+	sRenderFormat  = m_settings.value("/RenderFormat", "wav").toString();
 	m_settings.endGroup();
 
 	// Load custom additional engines.
@@ -123,6 +133,8 @@ void qsynthOptions::saveOptions (void)
 	m_settings.beginGroup("/Defaults");
 	m_settings.setValue("/SoundFontDir", sSoundFontDir);
 	m_settings.setValue("/PresetPreview", bPresetPreview);
+	m_settings.setValue("/WarmPresets", iWarmPresets);
+	m_settings.setValue("/RenderFormat", sRenderFormat);
 	m_settings.endGroup();
 
 	// Save last display options.
@@ -136,6 +148,7 @@ void qsynthOptions::saveOptions (void)
 	m_settings.setValue("/KeepOnTop", bKeepOnTop);
 	m_settings.setValue("/StdoutCapture", bStdoutCapture);
 	m_settings.setValue("/OutputMeters", bOutputMeters);
+	m_settings.setValue("/SeamlessRestart", bSeamlessRestart);
 	m_settings.setValue("/SystemTray", bSystemTray);
 	m_settings.setValue("/SystemTrayQueryClose", bSystemTrayQueryClose);
 	m_settings.setValue("/StartMinimized", bStartMinimized);
@@ -207,6 +220,17 @@ void qsynthOptions::print_usage ( const QString& arg0 )
 		QObject::tr("Dump midi router events") + sEol;
 	out << "  -v, --verbose" + sEot +
 		QObject::tr("Print out verbose messages about midi events") + sEol;
+	out << "  --headless" + sEot +
+		QObject::tr("Run all engines without any GUI (stops on SIGINT/SIGTERM)") + sEol;
+	out << "  --render[=dir]" + sEot +
+		QObject::tr("Render the midifiles offline, as fast as possible, into audio files"
+			" (in dir or else next to each midifile) and quit") + sEol;
+	out << "  --render-format=[format]" + sEot +
+		QObject::tr("The audio file format to render into [wav,flac, default = wav]") + sEol;
+	out << "  --render-jobs=[num]" + sEot +
+		QObject::tr("The number of files to render in parallel [default = all cores]") + sEol;
+	out << "  --render-engines" + sEot +
+		QObject::tr("Render through all engines, not just the default one") + sEol;
 	out << "  -h, --help" + sEot +
 		QObject::tr("Show help about command line options") + sEol;
 	out << "  -V, --version" + sEot +
@@ -361,6 +385,36 @@ bool qsynthOptions::parse_args ( const QStringList& args )
 		else if (sArg == "-v" || sArg == "--verbose") {
 			m_pDefaultSetup->bVerbose = true;
 		}
+		else if (sArg == "--headless") {
+			// Just ignore this (handled in main)...
+		}
+		else if (sArg == "--render") {
+			// Mostly handled in main (optional value must be given with '=')...
+			bRender = true;
+			if (iEqual >= 0)
+				sRenderDir = sVal;
+		}
+		else if (sArg == "--render-format") {
+			if (sVal.isEmpty()) {
+				out << QObject::tr("Option --render-format requires an argument (format).") + sEol;
+				return false;
+			}
+			sRenderFormatArg = sVal;
+			if (iEqual < 0)
+				i++;
+		}
+		else if (sArg == "--render-jobs") {
+			if (sVal.isEmpty()) {
+				out << QObject::tr("Option --render-jobs requires an argument (num).") + sEol;
+				return false;
+			}
+			iRenderJobs = sVal.toInt();
+			if (iEqual < 0)
+				i++;
+		}
+		else if (sArg == "--render-engines") {
+			bRenderEngines = true;
+		}
 		else if (sArg == "-h" || sArg == "--help") {
 			print_usage(args.at(0));
 			return false;
@@ -376,7 +430,7 @@ bool qsynthOptions::parse_args ( const QStringList& args )
 		else {
 			const QByteArray tmp = args.at(i).toUtf8();
 			const char *name = tmp.constData();
-			if (::fluid_is_soundfont(name)) {
+			if (qsynthSoundFontMeta::isSoundFont(args.at(i))) {
 				if (++iSoundFontOverride == 1) {
 					m_pDefaultSetup->soundfonts.clear();
 					m_pDefaultSetup->bankoffsets.clear();
@@ -430,11 +484,15 @@ bool qsynthOptions::renameEngine ( qsynthEngine *pEngine )
 	if (sOldName == sNewName)
 		return false;
 
+	// Channel presets must survive the key group change...
+	loadPresetTable(pEngine);
+
 	pEngine->setName(sNewName);
 
 	if (!pEngine->isDefault()) {
 		engines = engines.replaceInStrings(sOldName, sNewName);
 		m_settings.remove("/Engine/" + sOldName);
+		savePresetTable(pEngine);
 	}
 
 	return true;
@@ -535,6 +593,7 @@ void qsynthOptions::loadSetup ( qsynthSetup *pSetup, const QString& sName )
 		pSetup->soundfonts.append(sSoundFont);
 		pSetup->bankoffsets.append(sBankOffset);
 	}
+	pSetup->iSoundFontLoad = m_settings.value("/SoundFontLoad", 0).toInt();
 	m_settings.endGroup();
 
 	// Load channel presets list.
@@ -550,6 +609,10 @@ void qsynthOptions::loadSetup ( qsynthSetup *pSetup, const QString& sName )
 	}
 	m_settings.endGroup();
 
+	// Channel presets table gets (re)loaded on demand.
+	pSetup->presetTable.clear();
+	pSetup->bPresetTable = false;
+
 	// Done with the key group?
 	if (!sName.isEmpty())
 		m_settings.endGroup();
@@ -597,6 +660,7 @@ void qsynthOptions::saveSetup ( qsynthSetup *pSetup, const QString& sName )
 		m_settings.remove(sSoundFontPrefix.arg(i));
 		m_settings.remove(sBankOffsetPrefix.arg(i));
 	}
+	m_settings.setValue("/SoundFontLoad", pSetup->iSoundFontLoad);
 	m_settings.endGroup();
 
 	// Save last fluidsynth m_settings.
@@ -644,6 +708,207 @@ void qsynthOptions::saveSetup ( qsynthSetup *pSetup, const QString& sName )
 }
 
 
+//---------------------------------------------------------------------------
+// Channel presets table helpers.
+//
+// Each preset is kept as one compact binary snapshot: a four byte
+// header (magic and version), followed by three bytes per channel
+// (bank, as 16 bit little-endian, and program); unset channels
+// have bank 0xffff. Snapshots are stored as one single "/Data"
+// value per preset group; old "/ChanN" string entries are still
+// read whenever there's no such value, and dropped on next save.
+
+#define QSYNTH_PRESET_MAGIC0   'Q'
+#define QSYNTH_PRESET_MAGIC1   'S'
+#define QSYNTH_PRESET_MAGIC2   'P'
+#define QSYNTH_PRESET_VERSION  1
+#define QSYNTH_PRESET_HEADER   4
+#define QSYNTH_PRESET_ENTRY    3
+#define QSYNTH_PRESET_UNSET    0xffff
+
+
+// Snapshot channel count (-1 if invalid).
+static int qsynth_preset_channels ( const QByteArray& data )
+{
+	if (data.size() < QSYNTH_PRESET_HEADER
+		|| data.at(0) != QSYNTH_PRESET_MAGIC0
+		|| data.at(1) != QSYNTH_PRESET_MAGIC1
+		|| data.at(2) != QSYNTH_PRESET_MAGIC2
+		|| data.at(3) != QSYNTH_PRESET_VERSION)
+		return -1;
+
+	return (data.size() - QSYNTH_PRESET_HEADER) / QSYNTH_PRESET_ENTRY;
+}
+
+
+// Snapshot (empty) initializer.
+static void qsynth_preset_init ( QByteArray& data, int iChannels )
+{
+	data.fill(char(0xff), QSYNTH_PRESET_HEADER
+		+ iChannels * QSYNTH_PRESET_ENTRY);
+
+	data[0] = QSYNTH_PRESET_MAGIC0;
+	data[1] = QSYNTH_PRESET_MAGIC1;
+	data[2] = QSYNTH_PRESET_MAGIC2;
+	data[3] = QSYNTH_PRESET_VERSION;
+}
+
+
+// Snapshot channel entry accessors.
+static bool qsynth_preset_get ( const QByteArray& data, int iChan,
+	int& iBank, int& iProg )
+{
+	const unsigned char *p = (const unsigned char *) data.constData()
+		+ QSYNTH_PRESET_HEADER + iChan * QSYNTH_PRESET_ENTRY;
+
+	iBank = int(p[0]) | (int(p[1]) << 8);
+	iProg = int(p[2]);
+
+	return (iBank != QSYNTH_PRESET_UNSET);
+}
+
+static void qsynth_preset_set ( QByteArray& data, int iChan,
+	int iBank, int iProg )
+{
+	char *p = data.data()
+		+ QSYNTH_PRESET_HEADER + iChan * QSYNTH_PRESET_ENTRY;
+
+	p[0] = char(iBank & 0xff);
+	p[1] = char((iBank >> 8) & 0xff);
+	p[2] = char(iProg & 0x7f);
+}
+
+
+// Current channel bank/program, bank offset included (false if unset).
+static bool qsynth_channel_preset ( fluid_synth_t *pSynth, int iChan,
+	int& iBank, int& iProg )
+{
+#ifdef CONFIG_FLUID_CHANNEL_INFO
+	fluid_synth_channel_info_t info;
+	::memset(&info, 0, sizeof(info));
+	::fluid_synth_get_channel_info(pSynth, iChan, &info);
+	if (!info.assigned)
+		return false;
+	iBank = info.bank;
+#ifdef CONFIG_FLUID_BANK_OFFSET
+	iBank += ::fluid_synth_get_bank_offset(pSynth, info.sfont_id);
+#endif
+	iProg = info.program;
+#else
+	fluid_preset_t *pPreset = ::fluid_synth_get_channel_preset(pSynth, iChan);
+	if (pPreset == NULL)
+		return false;
+	iBank = pPreset->get_banknum(pPreset);
+#ifdef CONFIG_FLUID_BANK_OFFSET
+	iBank += ::fluid_synth_get_bank_offset(pSynth, (pPreset->sfont)->id);
+#endif
+	iProg = pPreset->get_num(pPreset);
+#endif
+	return true;
+}
+
+
+// Apply a channel bank/program, only if not already there.
+static bool qsynth_channel_apply ( fluid_synth_t *pSynth, int iChan,
+	int iBank, int iProg )
+{
+	int iCurBank = 0;
+	int iCurProg = 0;
+	if (qsynth_channel_preset(pSynth, iChan, iCurBank, iCurProg)
+		&& iCurBank == iBank && iCurProg == iProg)
+		return false;
+
+	::fluid_synth_bank_select(pSynth, iChan, iBank);
+	::fluid_synth_program_change(pSynth, iChan, iProg);
+
+	return true;
+}
+
+
+// Preset key group, as in settings.
+QString qsynthOptions::presetGroup (
+	qsynthEngine *pEngine, const QString& sPreset ) const
+{
+	QString sGroup;
+	if (!pEngine->isDefault())
+		sGroup = "/Engine/" + pEngine->name();
+	sGroup += "/Preset";
+	if (!sPreset.isEmpty()) {
+		sGroup += '/';
+		sGroup += sPreset;
+	}
+	return sGroup;
+}
+
+
+// Load all engine presets into the table, once.
+void qsynthOptions::loadPresetTable ( qsynthEngine *pEngine )
+{
+	qsynthSetup *pSetup = pEngine->setup();
+	if (pSetup == NULL || pSetup->bPresetTable)
+		return;
+
+	pSetup->presetTable.clear();
+
+	QStringList presets(pSetup->presets);
+	presets.prepend(QString());
+
+	QStringListIterator iter(presets);
+	while (iter.hasNext()) {
+		const QString& sPreset = iter.next();
+		m_settings.beginGroup(presetGroup(pEngine, sPreset));
+		QByteArray data = m_settings.value("/Data").toByteArray();
+		if (qsynth_preset_channels(data) < 0) {
+			// Old style entries ("/ChanN" = "chan:bank:prog")...
+			QMap<int, QString> entries;
+			QStringListIterator keys(m_settings.childKeys());
+			while (keys.hasNext()) {
+				const QString& sKey = keys.next();
+				if (!sKey.startsWith("Chan"))
+					continue;
+				const QString& sEntry = m_settings.value(sKey).toString();
+				const QStringList& fields = sEntry.split(':');
+				if (fields.count() < 3)
+					continue;
+				const int iChan = fields.at(0).toInt();
+				if (iChan + 1 == sKey.mid(4).toInt()
+					&& iChan >= 0 && iChan < QSYNTH_ENGINE_MAX_CHANNELS)
+					entries.insert(iChan, sEntry);
+			}
+			qsynth_preset_init(data, entries.isEmpty()
+				? 0 : entries.lastKey() + 1);
+			QMapIterator<int, QString> iter2(entries);
+			while (iter2.hasNext()) {
+				iter2.next();
+				const QStringList& fields = iter2.value().split(':');
+				qsynth_preset_set(data, iter2.key(),
+					fields.at(1).toInt(), fields.at(2).toInt());
+			}
+		}
+		m_settings.endGroup();
+		pSetup->presetTable.insert(sPreset, data);
+	}
+
+	pSetup->bPresetTable = true;
+}
+
+
+// Save all engine presets from the table (eg. on engine rename).
+void qsynthOptions::savePresetTable ( qsynthEngine *pEngine )
+{
+	qsynthSetup *pSetup = pEngine->setup();
+	if (pSetup == NULL)
+		return;
+
+	QHashIterator<QString, QByteArray> iter(pSetup->presetTable);
+	while (iter.hasNext()) {
+		iter.next();
+		m_settings.setValue(
+			presetGroup(pEngine, iter.key()) + "/Data", iter.value());
+	}
+}
+
+
 //---------------------------------------------------------------------------
 // Preset management methods.
 
@@ -656,62 +921,65 @@ bool qsynthOptions::loadPreset ( qsynthEngine *pEngine, const QString& sPreset )
 	if (pSetup == NULL)
 		return false;
 
-	QString sSuffix;
+	QString sKey;
 	if (sPreset != pSetup->sDefPresetName && !sPreset.isEmpty()) {
-		sSuffix = '/' + sPreset;
+		sKey = sPreset;
 		// Check if on list.
 		if (!pSetup->presets.contains(sPreset))
 				return false;
 	}
 
-	// Begin at key group?
-	if (!pEngine->isDefault())
-		m_settings.beginGroup("/Engine/" + pEngine->name());
+	// Get the whole table in, if not already...
+	loadPresetTable(pEngine);
+
+	const QByteArray& data = pSetup->presetTable.value(sKey);
+	int iDataChannels = qsynth_preset_channels(data);
+	if (iDataChannels < 0)
+		iDataChannels = 0;
 
-	// Load as current presets.
+	// Load as current presets,
+	// only changing what needs to be changed.
+	fluid_synth_t *pSynth = pEngine->pSynth;
+	bool bChanged = false;
 #ifdef CONFIG_FLUID_UNSET_PROGRAM
 	int iChannelsSet = 0;
 #endif
-	const QString sPrefix = "/Chan%1";
-	m_settings.beginGroup("/Preset" + sSuffix);
-	int iChannels = ::fluid_synth_count_midi_channels(pEngine->pSynth);
-	for (int iChan = 0; iChan < iChannels; iChan++) {
-		QString sEntry = m_settings.value(sPrefix.arg(iChan + 1)).toString();
-		if (!sEntry.isEmpty() && iChan == sEntry.section(':', 0, 0).toInt()) {
-			::fluid_synth_bank_select(pEngine->pSynth, iChan,
-				sEntry.section(':', 1, 1).toInt());
-			::fluid_synth_program_change(pEngine->pSynth, iChan,
-				sEntry.section(':', 2, 2).toInt());
+	int iBank = 0;
+	int iProg = 0;
+	const int iChannels = ::fluid_synth_count_midi_channels(pSynth);
+	for (int iChan = 0; iChan < iChannels; ++iChan) {
+		if (iChan < iDataChannels
+			&& qsynth_preset_get(data, iChan, iBank, iProg)) {
+			if (qsynth_channel_apply(pSynth, iChan, iBank, iProg))
+				bChanged = true;
 		#ifdef CONFIG_FLUID_UNSET_PROGRAM
 			++iChannelsSet;
 		#endif
 		}
 	#ifdef CONFIG_FLUID_UNSET_PROGRAM
-		else ::fluid_synth_unset_program(pEngine->pSynth, iChan);
+		else if (qsynth_channel_preset(pSynth, iChan, iBank, iProg)) {
+			::fluid_synth_unset_program(pSynth, iChan);
+			bChanged = true;
+		}
 	#endif
 	}
-	m_settings.endGroup();
-
-	// Done with the key group?
-	if (!pEngine->isDefault())
-		m_settings.endGroup();
 
 #ifdef CONFIG_FLUID_UNSET_PROGRAM
 	// If there's none channels set (eg. empty/blank preset)
 	// then fallback to old default fill up all the channels
 	// according to available soundfont stack.
 	if (iChannelsSet < 1) {
-		int iProg = 0;
-		for (int iChan = 0; iChan < iChannels; iChan++) {
-			::fluid_synth_bank_select(pEngine->pSynth, iChan, 0);
-			::fluid_synth_program_change(pEngine->pSynth, iChan, iProg);
-			++iProg;
+		for (int iChan = 0; iChan < iChannels; ++iChan) {
+			if (qsynth_channel_apply(pSynth, iChan, 0, iChan))
+				bChanged = true;
 		}
 	}
 #endif
 
-	// Recommended to post-stabilize things around.
-	::fluid_synth_program_reset(pEngine->pSynth);
+	// Recommended to post-stabilize things around,
+	// but only when anything has actually changed.
+	if (bChanged)
+		::fluid_synth_program_reset(pSynth);
 
 	return true;
 }
@@ -725,65 +993,45 @@ bool qsynthOptions::savePreset ( qsynthEngine *pEngine, const QString& sPreset )
 	if (pSetup == NULL)
 		return false;
 
-	QString sSuffix;
+	QString sKey;
 	if (sPreset != pSetup->sDefPresetName && !sPreset.isEmpty()) {
-		sSuffix = '/' + sPreset;
+		sKey = sPreset;
 		// Append to list if not already.
 		if (!pSetup->presets.contains(sPreset))
 				pSetup->presets.prepend(sPreset);
 	}
 
-	// Begin at key group?
-	if (!pEngine->isDefault())
-		m_settings.beginGroup("/Engine/" + pEngine->name());
-
-	// Unload current presets.
-	const QString sPrefix = "/Chan%1";
-	m_settings.beginGroup("/Preset" + sSuffix);
-	int iChannels = ::fluid_synth_count_midi_channels(pEngine->pSynth);
-	int iChan = 0;
-	for ( ; iChan < iChannels; iChan++) {
-	#ifdef CONFIG_FLUID_CHANNEL_INFO
-		fluid_synth_channel_info_t info;
-		::memset(&info, 0, sizeof(info));
-		::fluid_synth_get_channel_info(pEngine->pSynth, iChan, &info);
-		if (info.assigned) {
-		#ifdef CONFIG_FLUID_BANK_OFFSET
-			info.bank += ::fluid_synth_get_bank_offset(pEngine->pSynth, info.sfont_id);
-		#endif
-			QString sEntry = QString::number(iChan);
-			sEntry += ':';
-			sEntry += QString::number(info.bank);
-			sEntry += ':';
-			sEntry += QString::number(info.program);
-			m_settings.setValue(sPrefix.arg(iChan + 1), sEntry);
-		}
-	#else
-		fluid_preset_t *pPreset = ::fluid_synth_get_channel_preset(pEngine->pSynth, iChan);
-		if (pPreset) {
-			int iBank = pPreset->get_banknum(pPreset);
-		#ifdef CONFIG_FLUID_BANK_OFFSET
-			iBank += ::fluid_synth_get_bank_offset(pEngine->pSynth, (pPreset->sfont)->id);
-		#endif
-			QString sEntry = QString::number(iChan);
-			sEntry += ':';
-			sEntry += QString::number(iBank);
-			sEntry += ':';
-			sEntry += QString::number(pPreset->get_num(pPreset));
-			m_settings.setValue(sPrefix.arg(iChan + 1), sEntry);
+	// Get the whole table in, if not already...
+	loadPresetTable(pEngine);
+
+	// Snapshot current presets.
+	fluid_synth_t *pSynth = pEngine->pSynth;
+	const int iChannels = ::fluid_synth_count_midi_channels(pSynth);
+	QByteArray data;
+	qsynth_preset_init(data, iChannels);
+	int iBank = 0;
+	int iProg = 0;
+	for (int iChan = 0; iChan < iChannels; ++iChan) {
+		if (qsynth_channel_preset(pSynth, iChan, iBank, iProg))
+			qsynth_preset_set(data, iChan, iBank, iProg);
+	}
+
+	pSetup->presetTable.insert(sKey, data);
+
+	// Store it, all in one go...
+	m_settings.beginGroup(presetGroup(pEngine, sKey));
+	m_settings.setValue("/Data", data);
+	// Cleanup old style entries, if any...
+	if (m_settings.contains("/Chan1")) {
+		QStringListIterator keys(m_settings.childKeys());
+		while (keys.hasNext()) {
+			const QString& sChanKey = keys.next();
+			if (sChanKey.startsWith("Chan"))
+				m_settings.remove(sChanKey);
 		}
-	#endif
-		else m_settings.remove(sPrefix.arg(iChan + 1));
 	}
-	// Cleanup old entries, if any...
-	while (!m_settings.value(sPrefix.arg(++iChan)).toString().isEmpty())
-		m_settings.remove(sPrefix.arg(iChan));
 	m_settings.endGroup();
 
-	// Done with the key group?
-	if (!pEngine->isDefault())
-		m_settings.endGroup();
-
 	return true;
 }
 
@@ -796,22 +1044,93 @@ bool qsynthOptions::deletePreset ( qsynthEngine *pEngine, const QString& sPreset
 	if (pSetup == NULL)
 		return false;
 
-	QString sPrefix;
-	if (!pEngine->isDefault())
-		sPrefix = "/Engine/" + pEngine->name();
-	QString sSuffix;
 	if (sPreset != pSetup->sDefPresetName && !sPreset.isEmpty()) {
-		sSuffix = "/" + sPreset;
 		int iPreset = pSetup->presets.indexOf(sPreset);
 		if (iPreset < 0)
 				return false;
 		pSetup->presets.removeAt(iPreset);
-		m_settings.remove(sPrefix + "/Preset" + sSuffix);
+		pSetup->presetTable.remove(sPreset);
+		m_settings.remove(presetGroup(pEngine, sPreset));
 	}
 
 	return true;
 }
 
+bool qsynthOptions::warmPreset ( qsynthEngine *pEngine,
+	const QString& sPreset, bool *pbFailed )
+{
+	if (pEngine == NULL || pEngine->pSynth == NULL)
+		return true;
+
+	qsynthSetup *pSetup = pEngine->setup();
+	if (pSetup == NULL)
+		return true;
+
+	qsynthSoundFontCache *pCache = qsynthSoundFontCache::getInstance();
+	if (pCache == NULL)
+		return true;
+
+	QString sKey;
+	if (sPreset != pSetup->sDefPresetName && !sPreset.isEmpty()) {
+		sKey = sPreset;
+		// Nothing to warm up, if not on list.
+		if (!pSetup->presets.contains(sPreset))
+			return true;
+	}
+
+	// Get the whole table in, if not already...
+	loadPresetTable(pEngine);
+
+	const QByteArray& data = pSetup->presetTable.value(sKey);
+	int iDataChannels = qsynth_preset_channels(data);
+	if (iDataChannels < 0)
+		iDataChannels = 0;
+
+	// Which soundfonts are going to be needed (see loadPreset)...
+	fluid_synth_t *pSynth = pEngine->pSynth;
+	const qsynthPresetIndex& presets = pEngine->presetIndex();
+	QList<int> sfids;
+#ifdef CONFIG_FLUID_UNSET_PROGRAM
+	int iChannelsSet = 0;
+#endif
+	int iBank = 0;
+	int iProg = 0;
+	const int iChannels = ::fluid_synth_count_midi_channels(pSynth);
+	for (int iChan = 0; iChan < iChannels; ++iChan) {
+		if (iChan >= iDataChannels
+			|| !qsynth_preset_get(data, iChan, iBank, iProg))
+			continue;
+	#ifdef CONFIG_FLUID_UNSET_PROGRAM
+		++iChannelsSet;
+	#endif
+		const int iPreset = presets.findPreset(iBank, iProg);
+		if (iPreset >= 0 && !sfids.contains(presets.preset(iPreset).iSFID))
+			sfids.append(presets.preset(iPreset).iSFID);
+	}
+
+#ifdef CONFIG_FLUID_UNSET_PROGRAM
+	if (iChannelsSet < 1) {
+		for (int iChan = 0; iChan < iChannels; ++iChan) {
+			const int iPreset = presets.findPreset(0, iChan);
+			if (iPreset >= 0 && !sfids.contains(presets.preset(iPreset).iSFID))
+				sfids.append(presets.preset(iPreset).iSFID);
+		}
+	}
+#endif
+
+	// Have them all realized, if not already...
+	bool bReady = true;
+	QListIterator<int> iter(sfids);
+	while (iter.hasNext()) {
+		fluid_sfont_t *pSoundFont
+			= ::fluid_synth_get_sfont_by_id(pSynth, iter.next());
+		if (!pCache->prefetch(pSoundFont, pbFailed))
+			bReady = false;
+	}
+
+	return bReady;
+}
+
 
 //---------------------------------------------------------------------------
 // Combo box history persistence helper implementation.
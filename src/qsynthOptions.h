@@ -66,6 +66,7 @@ public:
 	bool    bKeepOnTop;
 	bool    bStdoutCapture;
 	bool    bOutputMeters;
+	bool    bSeamlessRestart;
 	bool    bSystemTray;
 	bool    bSystemTrayQueryClose;
 	bool    bStartMinimized;
@@ -76,6 +77,15 @@ public:
 	// Default options...
 	QString sSoundFontDir;
 	bool    bPresetPreview;
+	int     iWarmPresets;
+	QString sRenderFormat;
+
+	// Offline rendering command line options.
+	bool    bRender;
+	QString sRenderDir;
+	QString sRenderFormatArg;
+	int     iRenderJobs;
+	bool    bRenderEngines;
 
 	// Available custom engines list.
 	QStringList engines;
@@ -94,6 +104,12 @@ public:
 	bool savePreset(qsynthEngine *pEngine, const QString& sPreset);
 	bool deletePreset(qsynthEngine *pEngine, const QString& sPreset);
 
+	// Get the soundfonts of a preset loaded in the background;
+	// returns whether they're all ready to be switched to, and if
+	// not, pbFailed tells whether any of them failed to load.
+	bool warmPreset(qsynthEngine *pEngine, const QString& sPreset,
+		bool *pbFailed = NULL);
+
 	// Combo box history persistence helper prototypes.
 	void loadComboBoxHistory(QComboBox *pComboBox, int iLimit = 8);
 	void saveComboBoxHistory(QComboBox *pComboBox, int iLimit = 8);
@@ -104,6 +120,11 @@ public:
 
 private:
 
+	// Channel presets table helpers.
+	QString presetGroup(qsynthEngine *pEngine, const QString& sPreset) const;
+	void loadPresetTable(qsynthEngine *pEngine);
+	void savePresetTable(qsynthEngine *pEngine);
+
 	// Settings member variables.
 	QSettings m_settings;
 	
@@ -79,6 +79,9 @@ qsynthOptionsForm::qsynthOptionsForm (
 	QObject::connect(m_ui.OutputMetersCheckBox,
 		SIGNAL(stateChanged(int)),
 		SLOT(optionsChanged()));
+	QObject::connect(m_ui.SeamlessRestartCheckBox,
+		SIGNAL(stateChanged(int)),
+		SLOT(optionsChanged()));
 #ifdef CONFIG_SYSTEM_TRAY
 	QObject::connect(m_ui.SystemTrayCheckBox,
 		SIGNAL(stateChanged(int)),
@@ -161,6 +164,7 @@ void qsynthOptionsForm::setup ( qsynthOptions *pOptions )
 	m_ui.KeepOnTopCheckBox->setChecked(m_pOptions->bKeepOnTop);
 	m_ui.StdoutCaptureCheckBox->setChecked(m_pOptions->bStdoutCapture);
 	m_ui.OutputMetersCheckBox->setChecked(m_pOptions->bOutputMeters);
+	m_ui.SeamlessRestartCheckBox->setChecked(m_pOptions->bSeamlessRestart);
 #ifdef CONFIG_SYSTEM_TRAY
 	m_ui.SystemTrayCheckBox->setChecked(m_pOptions->bSystemTray);
 	m_ui.SystemTrayQueryCloseCheckBox->setChecked(m_pOptions->bSystemTrayQueryClose);
@@ -211,6 +215,7 @@ void qsynthOptionsForm::accept (void)
 		m_pOptions->bKeepOnTop      = m_ui.KeepOnTopCheckBox->isChecked();
 		m_pOptions->bStdoutCapture  = m_ui.StdoutCaptureCheckBox->isChecked();
 		m_pOptions->bOutputMeters   = m_ui.OutputMetersCheckBox->isChecked();
+		m_pOptions->bSeamlessRestart = m_ui.SeamlessRestartCheckBox->isChecked();
 	#ifdef CONFIG_SYSTEM_TRAY
 		m_pOptions->bSystemTray     = m_ui.SystemTrayCheckBox->isChecked();
 		m_pOptions->bSystemTrayQueryClose = m_ui.SystemTrayQueryCloseCheckBox->isChecked();
@@ -23,10 +23,10 @@
 #include "qsynthPresetForm.h"
 
 #include "qsynthOptions.h"
+#include "qsynthEngine.h"
 
 #include <QHeaderView>
 #include <QPushButton>
-#include <QFileInfo>
 
 
 // Custom list-view item (as for numerical sort purposes...)
@@ -66,6 +66,7 @@ qsynthPresetForm::qsynthPresetForm (
 	m_ui.setupUi(this);
 
 	m_pSynth = NULL;
+	m_pPresetIndex = NULL;
 	m_iChan  = 0;
 	m_iBank  = 0;
 	m_iProg  = 0;
@@ -110,6 +111,9 @@ qsynthPresetForm::qsynthPresetForm (
 	QObject::connect(m_ui.PreviewCheckBox,
 		SIGNAL(toggled(bool)),
 		SLOT(previewChanged()));
+	QObject::connect(m_ui.SearchLineEdit,
+		SIGNAL(textChanged(const QString&)),
+		SLOT(searchChanged(const QString&)));
 //	QObject::connect(m_ui.ProgListView,
 //		SIGNAL(itemActivated(QTreeWidgetItem*,int)),
 //		SLOT(accept()));
@@ -132,11 +136,11 @@ qsynthPresetForm::~qsynthPresetForm (void)
 
 
 // Dialog setup loader.
-void qsynthPresetForm::setup ( qsynthOptions *pOptions, fluid_synth_t *pSynth, int iChan )
+void qsynthPresetForm::setup ( qsynthOptions *pOptions, qsynthEngine *pEngine, int iChan )
 {
 	// Set our internal stuff...
 	m_pOptions = pOptions;
-	m_pSynth = pSynth;
+	m_pSynth = pEngine->pSynth;
 	m_iChan  = iChan;
 
 	// We'll goinfg to changes the whole thing...
@@ -146,36 +150,11 @@ void qsynthPresetForm::setup ( qsynthOptions *pOptions, fluid_synth_t *pSynth, i
 	setWindowTitle(QSYNTH_TITLE ": "
 		+ tr("Channel %1").arg(m_iChan + 1));
 
-	// Load bank list from actual synth stack...
-	m_ui.BankListView->setUpdatesEnabled(false);
-	m_ui.BankListView->setSortingEnabled(false);
-	m_ui.BankListView->clear();
-	fluid_preset_t preset;
-	QTreeWidgetItem *pBankItem = NULL;
-	// For all soundfonts (in reversed stack order) fill the available banks...
-	int cSoundFonts = ::fluid_synth_sfcount(m_pSynth);
-	for (int i = 0; i < cSoundFonts; ++i) {
-		fluid_sfont_t *pSoundFont = ::fluid_synth_get_sfont(m_pSynth, i);
-		if (pSoundFont) {
-		#ifdef CONFIG_FLUID_BANK_OFFSET
-			int iBankOffset = ::fluid_synth_get_bank_offset(m_pSynth, pSoundFont->id);
-		#endif
-			pSoundFont->iteration_start(pSoundFont);
-			while (pSoundFont->iteration_next(pSoundFont, &preset)) {
-				int iBank = preset.get_banknum(&preset);
-			#ifdef CONFIG_FLUID_BANK_OFFSET
-				iBank += iBankOffset;
-			#endif
-				if (!findBankItem(iBank)) {
-					pBankItem = new qsynthPresetItem(m_ui.BankListView, pBankItem);
-					if (pBankItem)
-						pBankItem->setText(0, QString::number(iBank));
-				}
-			}
-		}
-	}
-	m_ui.BankListView->setSortingEnabled(true);
-	m_ui.BankListView->setUpdatesEnabled(true);
+	// Load bank list from the engine preset catalogue...
+	m_pPresetIndex = &(pEngine->presetIndex());
+	m_sSearch.clear();
+	m_search.clear();
+	refreshBanks();
 
 	// Set the selected bank.
 	m_iBank = 0;
@@ -199,7 +178,7 @@ void qsynthPresetForm::setup ( qsynthOptions *pOptions, fluid_synth_t *pSynth, i
 	}
 #endif
 
-	pBankItem = findBankItem(m_iBank);
+	QTreeWidgetItem *pBankItem = findBankItem(m_iBank);
 	m_ui.BankListView->setCurrentItem(pBankItem);
 //  m_ui.BankListView->ensureItemVisible(pBankItem);
 	bankChanged();
@@ -292,38 +271,64 @@ void qsynthPresetForm::reject (void)
 // Find the bank item of given bank number id.
 QTreeWidgetItem *qsynthPresetForm::findBankItem ( int iBank )
 {
-	QList<QTreeWidgetItem *> banks
-		= m_ui.BankListView->findItems(
-			QString::number(iBank), Qt::MatchExactly, 0);
-
-	QListIterator<QTreeWidgetItem *> iter(banks);
-	if (iter.hasNext())
-		return iter.next();
-	else
-		return NULL;
+	return m_bankItems.value(iBank, NULL);
 }
 
 
 // Find the program item of given program number id.
 QTreeWidgetItem *qsynthPresetForm::findProgItem ( int iProg )
 {
-	QList<QTreeWidgetItem *> progs
-		= m_ui.ProgListView->findItems(
-			QString::number(iProg), Qt::MatchExactly, 0);
-
-	QListIterator<QTreeWidgetItem *> iter(progs);
-	if (iter.hasNext())
-		return iter.next();
-	else
-		return NULL;
+	return m_progItems.value(iProg, NULL);
 }
 
 
+// Load the bank list, all or just the ones with matching presets.
+void qsynthPresetForm::refreshBanks (void)
+{
+	if (m_pPresetIndex == NULL)
+		return;
+
+	const bool bBlockSignals = m_ui.BankListView->blockSignals(true);
+
+	m_ui.BankListView->setUpdatesEnabled(false);
+	m_ui.BankListView->setSortingEnabled(false);
+	m_ui.BankListView->clear();
+	m_bankItems.clear();
+
+	QVector<int> banks;
+	if (m_sSearch.isEmpty()) {
+		banks = m_pPresetIndex->banks();
+	} else {
+		QVectorIterator<int> iter(m_search);
+		while (iter.hasNext()) {
+			const int iBank = m_pPresetIndex->preset(iter.next()).iBank;
+			if (banks.isEmpty() || banks.last() != iBank)
+				banks.append(iBank);
+		}
+	}
+
+	QTreeWidgetItem *pBankItem = NULL;
+	QVectorIterator<int> iter(banks);
+	while (iter.hasNext()) {
+		const int iBank = iter.next();
+		pBankItem = new qsynthPresetItem(m_ui.BankListView, pBankItem);
+		if (pBankItem) {
+			pBankItem->setText(0, QString::number(iBank));
+			m_bankItems.insert(iBank, pBankItem);
+		}
+	}
+
+	m_ui.BankListView->setSortingEnabled(true);
+	m_ui.BankListView->setUpdatesEnabled(true);
+
+	m_ui.BankListView->blockSignals(bBlockSignals);
+}
+
 
 // Bank change slot.
 void qsynthPresetForm::bankChanged (void)
 {
-	if (m_pSynth == NULL)
+	if (m_pSynth == NULL || m_pPresetIndex == NULL)
 		return;
 
 	QTreeWidgetItem *pBankItem = m_ui.BankListView->currentItem();
@@ -335,34 +340,33 @@ void qsynthPresetForm::bankChanged (void)
 	m_ui.ProgListView->setUpdatesEnabled(false);
 	m_ui.ProgListView->setSortingEnabled(false);
 	m_ui.ProgListView->clear();
-	fluid_preset_t preset;
+	m_progItems.clear();
+
+	// All bank programs, or just the matching ones...
+	QVector<int> presets;
+	if (m_sSearch.isEmpty()) {
+		presets = m_pPresetIndex->bankPresets(iBankSelected);
+	} else {
+		QVectorIterator<int> iter(m_search);
+		while (iter.hasNext()) {
+			const int iPreset = iter.next();
+			if (m_pPresetIndex->preset(iPreset).iBank == iBankSelected)
+				presets.append(iPreset);
+		}
+	}
+
 	QTreeWidgetItem *pProgItem = NULL;
-	// For all soundfonts (in reversed stack order) fill the available programs...
-	int cSoundFonts = ::fluid_synth_sfcount(m_pSynth);
-	for (int i = 0; i < cSoundFonts; ++i) {
-		fluid_sfont_t *pSoundFont = ::fluid_synth_get_sfont(m_pSynth, i);
-		if (pSoundFont) {
-#ifdef CONFIG_FLUID_BANK_OFFSET
-			int iBankOffset = ::fluid_synth_get_bank_offset(m_pSynth, pSoundFont->id);
-#endif
-			pSoundFont->iteration_start(pSoundFont);
-			while (pSoundFont->iteration_next(pSoundFont, &preset)) {
-				int iBank = preset.get_banknum(&preset);
-#ifdef CONFIG_FLUID_BANK_OFFSET
-				iBank += iBankOffset;
-#endif
-				int iProg = preset.get_num(&preset);
-				if (iBank == iBankSelected && !findProgItem(iProg)) {
-					pProgItem = new qsynthPresetItem(m_ui.ProgListView, pProgItem);
-					if (pProgItem) {
-						pProgItem->setText(0, QString::number(iProg));
-						pProgItem->setText(1, preset.get_name(&preset));
-						pProgItem->setText(2, QString::number(pSoundFont->id));
-						pProgItem->setText(3, QFileInfo(
-							pSoundFont->get_name(pSoundFont)).baseName());
-					}
-				}
-			}
+	QVectorIterator<int> iter(presets);
+	while (iter.hasNext()) {
+		const qsynthPresetIndex::Preset& preset
+			= m_pPresetIndex->preset(iter.next());
+		pProgItem = new qsynthPresetItem(m_ui.ProgListView, pProgItem);
+		if (pProgItem) {
+			pProgItem->setText(0, QString::number(preset.iProg));
+			pProgItem->setText(1, preset.sName);
+			pProgItem->setText(2, QString::number(preset.iSFID));
+			pProgItem->setText(3, m_pPresetIndex->soundFontName(preset.iSFID));
+			m_progItems.insert(preset.iProg, pProgItem);
 		}
 	}
 	m_ui.ProgListView->setSortingEnabled(true);
@@ -373,6 +377,54 @@ void qsynthPresetForm::bankChanged (void)
 }
 
 
+// Search text change slot (incremental).
+void qsynthPresetForm::searchChanged ( const QString& sText )
+{
+	if (m_pPresetIndex == NULL)
+		return;
+
+	const QString sSearch = sText.trimmed();
+	if (sSearch == m_sSearch)
+		return;
+
+	// Just narrow the last result, if the text was only extended...
+	if (!m_sSearch.isEmpty() && sSearch.startsWith(m_sSearch))
+		m_search = m_pPresetIndex->search(sSearch, &m_search);
+	else
+	if (!sSearch.isEmpty())
+		m_search = m_pPresetIndex->search(sSearch);
+	else
+		m_search.clear();
+
+	m_sSearch = sSearch;
+
+	// Try to keep the current selection...
+	QTreeWidgetItem *pBankItem = m_ui.BankListView->currentItem();
+	QTreeWidgetItem *pProgItem = m_ui.ProgListView->currentItem();
+	const int iBank = (pBankItem ? pBankItem->text(0).toInt() : -1);
+	const int iProg = (pProgItem ? pProgItem->text(0).toInt() : -1);
+
+	refreshBanks();
+
+	pBankItem = findBankItem(iBank);
+	if (pBankItem == NULL && m_ui.BankListView->topLevelItemCount() > 0)
+		pBankItem = m_ui.BankListView->topLevelItem(0);
+	if (pBankItem) {
+		// Will call bankChanged()...
+		m_ui.BankListView->setCurrentItem(pBankItem);
+	} else {
+		// Nothing found...
+		m_ui.ProgListView->clear();
+		m_progItems.clear();
+		stabilizeForm();
+	}
+
+	pProgItem = findProgItem(iProg);
+	if (pProgItem)
+		m_ui.ProgListView->setCurrentItem(pProgItem);
+}
+
+
 // Program change slot.
 void qsynthPresetForm::progChanged (void)
 {
@@ -26,8 +26,13 @@
 
 #include <fluidsynth.h>
 
+#include <QHash>
+#include <QVector>
+
 // Forward declarations.
 class qsynthOptions;
+class qsynthEngine;
+class qsynthPresetIndex;
 
 
 //----------------------------------------------------------------------------
@@ -45,7 +50,7 @@ public:
 	~qsynthPresetForm();
 
 
-	void setup(qsynthOptions *pOptions, fluid_synth_t *pSynth, int iChan);
+	void setup(qsynthOptions *pOptions, qsynthEngine *pEngine, int iChan);
 
 public slots:
 
@@ -53,6 +58,7 @@ public slots:
 	void bankChanged();
 	void progChanged();
 	void previewChanged();
+	void searchChanged(const QString& sText);
 
 protected slots:
 
@@ -63,6 +69,8 @@ protected:
 
 	void setBankProg(int iBank, int iProg);
 
+	void refreshBanks();
+
 	QTreeWidgetItem *findBankItem(int iBank);
 	QTreeWidgetItem *findProgItem(int iProg);
 
@@ -77,6 +85,17 @@ private:
 	qsynthOptions *m_pOptions;
 	fluid_synth_t *m_pSynth;
 
+	// Engine preset catalogue (while in setup).
+	const qsynthPresetIndex *m_pPresetIndex;
+
+	// Current search text and matching presets.
+	QString      m_sSearch;
+	QVector<int> m_search;
+
+	// Bank and program items, by number.
+	QHash<int, QTreeWidgetItem *> m_bankItems;
+	QHash<int, QTreeWidgetItem *> m_progItems;
+
 	int m_iChan;
 	int m_iBank;
 	int m_iProg;
@@ -0,0 +1,247 @@
+// qsynthPresetIndex.cpp
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qsynthAbout.h"
+#include "qsynthPresetIndex.h"
+
+#include <QFileInfo>
+
+#include <algorithm>
+
+
+// Bank/program lookup key.
+#define QSYNTH_PRESET_KEY(bank, prog)  (((bank) << 8) | ((prog) & 0xff))
+
+
+// Bank/program order predicate.
+static bool qsynth_preset_less (
+	const qsynthPresetIndex::Preset& p1, const qsynthPresetIndex::Preset& p2 )
+{
+	if (p1.iBank != p2.iBank)
+		return (p1.iBank < p2.iBank);
+	else
+		return (p1.iProg < p2.iProg);
+}
+
+
+//-------------------------------------------------------------------------
+// qsynthPresetIndex - Engine preset catalogue (bank/program index).
+//
+
+// Constructor.
+qsynthPresetIndex::qsynthPresetIndex (void)
+{
+	m_pSynth = NULL;
+	m_bValid = false;
+}
+
+
+// (Re)build the whole catalogue from the synth soundfont stack.
+void qsynthPresetIndex::build ( fluid_synth_t *pSynth )
+{
+	clear();
+
+	m_pSynth = pSynth;
+	m_bValid = true;
+
+	if (m_pSynth == NULL)
+		return;
+
+	m_stack = stackKey(m_pSynth);
+
+	// For all soundfonts (in reversed stack order) collect all presets...
+	fluid_preset_t preset;
+	const int cSoundFonts = ::fluid_synth_sfcount(m_pSynth);
+	for (int i = 0; i < cSoundFonts; ++i) {
+		fluid_sfont_t *pSoundFont = ::fluid_synth_get_sfont(m_pSynth, i);
+		if (pSoundFont == NULL)
+			continue;
+		m_soundfonts.insert(pSoundFont->id,
+			QFileInfo(pSoundFont->get_name(pSoundFont)).baseName());
+	#ifdef CONFIG_FLUID_BANK_OFFSET
+		const int iBankOffset
+			= ::fluid_synth_get_bank_offset(m_pSynth, pSoundFont->id);
+	#endif
+		pSoundFont->iteration_start(pSoundFont);
+		while (pSoundFont->iteration_next(pSoundFont, &preset)) {
+			Preset rec;
+			rec.iBank = preset.get_banknum(&preset);
+		#ifdef CONFIG_FLUID_BANK_OFFSET
+			rec.iBank += iBankOffset;
+		#endif
+			rec.iProg = preset.get_num(&preset);
+			// First one wins, as with the synth itself...
+			const int iKey = QSYNTH_PRESET_KEY(rec.iBank, rec.iProg);
+			if (m_index.contains(iKey))
+				continue;
+			m_index.insert(iKey, -1);
+			rec.iSFID = pSoundFont->id;
+			rec.sName = preset.get_name(&preset);
+			rec.sKey  = rec.sName.toCaseFolded();
+			m_presets.append(rec);
+		}
+	}
+
+	// Bank/program order, then the actual index...
+	std::sort(m_presets.begin(), m_presets.end(), qsynth_preset_less);
+
+	const int iPresets = m_presets.count();
+	for (int iPreset = 0; iPreset < iPresets; ++iPreset) {
+		const Preset& rec = m_presets.at(iPreset);
+		m_index.insert(QSYNTH_PRESET_KEY(rec.iBank, rec.iProg), iPreset);
+		if (m_banks.isEmpty() || m_banks.last() != rec.iBank)
+			m_banks.append(rec.iBank);
+	}
+}
+
+
+// Invalidate the catalogue (eg. on soundfont stack changes).
+void qsynthPresetIndex::clear (void)
+{
+	m_pSynth = NULL;
+	m_bValid = false;
+
+	m_stack.clear();
+	m_presets.clear();
+	m_banks.clear();
+	m_index.clear();
+	m_soundfonts.clear();
+}
+
+
+// Whether the catalogue is built for the given synth.
+bool qsynthPresetIndex::isValid ( fluid_synth_t *pSynth ) const
+{
+	if (!m_bValid || m_pSynth != pSynth)
+		return false;
+
+	return (m_pSynth == NULL || stackKey(m_pSynth) == m_stack);
+}
+
+
+// Soundfont stack signature (ids and bank offsets, in stack order).
+QVector<int> qsynthPresetIndex::stackKey ( fluid_synth_t *pSynth )
+{
+	QVector<int> key;
+
+	const int cSoundFonts = ::fluid_synth_sfcount(pSynth);
+	key.reserve(cSoundFonts << 1);
+	for (int i = 0; i < cSoundFonts; ++i) {
+		fluid_sfont_t *pSoundFont = ::fluid_synth_get_sfont(pSynth, i);
+		if (pSoundFont == NULL)
+			continue;
+		key.append(pSoundFont->id);
+	#ifdef CONFIG_FLUID_BANK_OFFSET
+		key.append(::fluid_synth_get_bank_offset(pSynth, pSoundFont->id));
+	#else
+		key.append(0);
+	#endif
+	}
+
+	return key;
+}
+
+
+// Catalogue accessors.
+int qsynthPresetIndex::presetCount (void) const
+{
+	return m_presets.count();
+}
+
+
+const qsynthPresetIndex::Preset& qsynthPresetIndex::preset ( int iPreset ) const
+{
+	return m_presets.at(iPreset);
+}
+
+
+// Sorted bank numbers.
+const QVector<int>& qsynthPresetIndex::banks (void) const
+{
+	return m_banks;
+}
+
+
+// Presets of a bank (indexes, sorted by program number).
+QVector<int> qsynthPresetIndex::bankPresets ( int iBank ) const
+{
+	QVector<int> presets;
+
+	// Presets are in bank/program order, so just find the first one...
+	Preset rec;
+	rec.iBank = iBank;
+	rec.iProg = -1;
+	QVector<Preset>::ConstIterator iter
+		= std::lower_bound(m_presets.constBegin(), m_presets.constEnd(),
+			rec, qsynth_preset_less);
+
+	int iPreset = int(iter - m_presets.constBegin());
+	const int iPresets = m_presets.count();
+	for ( ; iPreset < iPresets && m_presets.at(iPreset).iBank == iBank; ++iPreset)
+		presets.append(iPreset);
+
+	return presets;
+}
+
+
+// Preset lookup (index or -1 if not found).
+int qsynthPresetIndex::findPreset ( int iBank, int iProg ) const
+{
+	return m_index.value(QSYNTH_PRESET_KEY(iBank, iProg), -1);
+}
+
+
+// Soundfont name (base file name) by id.
+QString qsynthPresetIndex::soundFontName ( int iSFID ) const
+{
+	return m_soundfonts.value(iSFID);
+}
+
+
+// Preset name search (indexes, in bank/program order).
+QVector<int> qsynthPresetIndex::search (
+	const QString& sText, const QVector<int> *pCandidates ) const
+{
+	QVector<int> presets;
+
+	const QString& sKey = sText.trimmed().toCaseFolded();
+
+	if (pCandidates) {
+		QVectorIterator<int> iter(*pCandidates);
+		while (iter.hasNext()) {
+			const int iPreset = iter.next();
+			if (iPreset >= 0 && iPreset < m_presets.count()
+				&& m_presets.at(iPreset).sKey.contains(sKey))
+				presets.append(iPreset);
+		}
+	} else {
+		const int iPresets = m_presets.count();
+		for (int iPreset = 0; iPreset < iPresets; ++iPreset) {
+			if (m_presets.at(iPreset).sKey.contains(sKey))
+				presets.append(iPreset);
+		}
+	}
+
+	return presets;
+}
+
+
+// end of qsynthPresetIndex.cpp
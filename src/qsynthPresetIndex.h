@@ -0,0 +1,112 @@
+// qsynthPresetIndex.h
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qsynthPresetIndex_h
+#define __qsynthPresetIndex_h
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+
+#include <fluidsynth.h>
+
+
+//-------------------------------------------------------------------------
+// qsynthPresetIndex - Engine preset catalogue (bank/program index).
+//
+// All presets of the whole soundfont stack are collected in one pass,
+// first one wins (ie. top of stack), as with the synth itself; banks
+// and programs are then looked up in constant time, and name searches
+// are made over the pre-folded names, optionally narrowing a previous
+// search result, as for incremental searching.
+
+class qsynthPresetIndex
+{
+public:
+
+	// Constructor.
+	qsynthPresetIndex();
+
+	// Preset catalogue record.
+	struct Preset
+	{
+		int     iBank;      // Bank number (bank offset applied).
+		int     iProg;      // Program number.
+		int     iSFID;      // Soundfont id.
+		QString sName;      // Preset name.
+		QString sKey;       // Preset name, case folded (for searching).
+	};
+
+	// (Re)build the whole catalogue from the synth soundfont stack.
+	void build(fluid_synth_t *pSynth);
+
+	// Invalidate the catalogue (eg. on soundfont stack changes).
+	void clear();
+
+	// Whether the catalogue is built for the given synth, and its
+	// current soundfont stack (eg. not changed via the shell server).
+	bool isValid(fluid_synth_t *pSynth) const;
+
+	// Catalogue accessors.
+	int presetCount() const;
+	const Preset& preset(int iPreset) const;
+
+	// Sorted bank numbers.
+	const QVector<int>& banks() const;
+
+	// Presets of a bank (indexes, sorted by program number).
+	QVector<int> bankPresets(int iBank) const;
+
+	// Preset lookup (index or -1 if not found).
+	int findPreset(int iBank, int iProg) const;
+
+	// Soundfont name (base file name) by id.
+	QString soundFontName(int iSFID) const;
+
+	// Preset name search (indexes, in bank/program order); an empty
+	// text matches all; a previous result may be given as the only
+	// candidates to look at (ie. when the text was just extended).
+	QVector<int> search(const QString& sText,
+		const QVector<int> *pCandidates = NULL) const;
+
+private:
+
+	// Soundfont stack signature (ids and bank offsets, in stack order).
+	static QVector<int> stackKey(fluid_synth_t *pSynth);
+
+	// Instance variables.
+	fluid_synth_t *m_pSynth;
+	bool           m_bValid;
+
+	QVector<int>   m_stack;
+
+	QVector<Preset> m_presets;
+	QVector<int>    m_banks;
+
+	QHash<int, int>     m_index;
+	QHash<int, QString> m_soundfonts;
+};
+
+
+#endif  // __qsynthPresetIndex_h
+
+
+// end of qsynthPresetIndex.h
@@ -0,0 +1,487 @@
+// qsynthRender.cpp
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qsynthAbout.h"
+#include "qsynthRender.h"
+
+#include "qsynthEngine.h"
+#include "qsynthSoundFontCache.h"
+
+#include <QRunnable>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QDir>
+
+
+//-------------------------------------------------------------------------
+// qsynthRender::Job - Render job descriptor.
+//
+// A snapshot of all the engine setup needed (taken on the GUI thread),
+// so that the worker thread never touches the engine setup itself.
+
+struct qsynthRender::Job
+{
+	QString        sName;
+	QString        sMidiFile;
+	QString        sOutputFile;
+
+	fluid_settings_t *pSettings;
+
+	QStringList    soundfonts;
+	QStringList    bankoffsets;
+
+	bool           bReverbActive;
+	double         fReverbRoom;
+	double         fReverbDamp;
+	double         fReverbWidth;
+	double         fReverbLevel;
+	bool           bChorusActive;
+	int            iChorusNr;
+	double         fChorusLevel;
+	double         fChorusSpeed;
+	double         fChorusDepth;
+	int            iChorusType;
+	float          fGain;
+
+	qsynthAtomicInt     iState;
+
+	// Results (worker thread; valid once done with).
+	QString        sError;
+	qint64         iFrames;
+	float          fSampleRate;
+	qint64         iElapsed;
+};
+
+
+//-------------------------------------------------------------------------
+// qsynthRender::Task - Worker thread task.
+//
+
+class qsynthRender::Task : public QRunnable
+{
+public:
+
+	// Constructor.
+	Task(qsynthRender *pRender, int iJob)
+		: m_pRender(pRender), m_iJob(iJob) {}
+
+	// Task runner.
+	void run() { m_pRender->run(m_iJob); }
+
+private:
+
+	// Instance variables.
+	qsynthRender *m_pRender;
+	int m_iJob;
+};
+
+
+//-------------------------------------------------------------------------
+// qsynthRender - Offline (faster than realtime) MIDI file renderer.
+//
+
+// Constructor.
+qsynthRender::qsynthRender ( int iThreads, QObject *pParent )
+	: QObject(pParent)
+{
+	if (iThreads > 0)
+		m_threadPool.setMaxThreadCount(iThreads);
+}
+
+
+// Destructor (cancels and waits for all jobs).
+qsynthRender::~qsynthRender (void)
+{
+	cancel();
+
+	m_threadPool.waitForDone();
+
+	QListIterator<Job *> iter(m_jobs);
+	while (iter.hasNext()) {
+		Job *pJob = iter.next();
+		if (pJob->pSettings)
+			::delete_fluid_settings(pJob->pSettings);
+		delete pJob;
+	}
+	m_jobs.clear();
+}
+
+
+// Whether offline rendering is supported at all.
+bool qsynthRender::isAvailable (void)
+{
+#ifdef CONFIG_FLUID_FILE_RENDERER
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+// Add a render job, from an engine setup snapshot (GUI thread).
+int qsynthRender::addJob ( qsynthSetup *pSetup,
+	const QString& sMidiFile, const QString& sOutputFile )
+{
+	Job *pJob = new Job;
+
+	pJob->sName         = pSetup->sDisplayName;
+	pJob->sMidiFile     = sMidiFile;
+	pJob->sOutputFile   = sOutputFile;
+	pJob->soundfonts    = pSetup->soundfonts;
+	pJob->bankoffsets   = pSetup->bankoffsets;
+	pJob->bReverbActive = pSetup->bReverbActive;
+	pJob->fReverbRoom   = pSetup->fReverbRoom;
+	pJob->fReverbDamp   = pSetup->fReverbDamp;
+	pJob->fReverbWidth  = pSetup->fReverbWidth;
+	pJob->fReverbLevel  = pSetup->fReverbLevel;
+	pJob->bChorusActive = pSetup->bChorusActive;
+	pJob->iChorusNr     = pSetup->iChorusNr;
+	pJob->fChorusLevel  = pSetup->fChorusLevel;
+	pJob->fChorusSpeed  = pSetup->fChorusSpeed;
+	pJob->fChorusDepth  = pSetup->fChorusDepth;
+	pJob->iChorusType   = pSetup->iChorusType;
+	pJob->fGain         = pSetup->fGain;
+	pJob->iState        = Pending;
+	pJob->iFrames       = 0;
+	pJob->fSampleRate   = 44100.0f;
+	pJob->iElapsed      = 0;
+
+	// Same fluidsynth settings as the engine, but for the output file
+	// and the MIDI player, which must follow the synth sample clock...
+	pJob->pSettings = ::new_fluid_settings();
+	pSetup->realize(pJob->pSettings);
+
+	// We'll need these to avoid pedandic compiler warnings...
+	char *pszKey;
+	char *pszVal;
+
+	pszKey = (char *) "audio.file.name";
+	::fluid_settings_setstr(pJob->pSettings, pszKey,
+		sOutputFile.toLocal8Bit().data());
+
+	const QString& sSuffix = QFileInfo(sOutputFile).suffix().toLower();
+	pszKey = (char *) "audio.file.type";
+	if (sSuffix == "wav" || sSuffix == "flac") {
+		::fluid_settings_setstr(pJob->pSettings, pszKey,
+			sSuffix.toLocal8Bit().data());
+	} else {
+		pszVal = (char *) "auto";
+		::fluid_settings_setstr(pJob->pSettings, pszKey, pszVal);
+	}
+
+	pszKey = (char *) "player.timing-source";
+	pszVal = (char *) "sample";
+	::fluid_settings_setstr(pJob->pSettings, pszKey, pszVal);
+
+	pszKey = (char *) "synth.lock-memory";
+	::fluid_settings_setint(pJob->pSettings, pszKey, 0);
+
+	double fSampleRate = 0.0;
+	pszKey = (char *) "synth.sample-rate";
+	if (::fluid_settings_getnum(pJob->pSettings, pszKey, &fSampleRate)
+		&& fSampleRate > 0.0)
+		pJob->fSampleRate = float(fSampleRate);
+
+	m_jobs.append(pJob);
+
+	return m_jobs.count() - 1;
+}
+
+
+// Add all files through all engines.
+void qsynthRender::addJobs ( const QList<qsynthEngine *>& engines,
+	const QStringList& files, const QString& sOutputDir,
+	const QString& sFormat )
+{
+	QStringListIterator iter(files);
+	while (iter.hasNext()) {
+		const QString& sMidiFile = iter.next();
+		const QFileInfo info(sMidiFile);
+		const QDir dir(sOutputDir.isEmpty() ? info.absolutePath() : sOutputDir);
+		QListIterator<qsynthEngine *> eiter(engines);
+		while (eiter.hasNext()) {
+			qsynthEngine *pEngine = eiter.next();
+			qsynthSetup *pSetup = pEngine->setup();
+			if (pSetup == NULL)
+				continue;
+			QString sOutputName = info.completeBaseName();
+			if (engines.count() > 1)
+				sOutputName += '-' + pEngine->name();
+			sOutputName += '.' + sFormat.toLower();
+			addJob(pSetup, sMidiFile, dir.absoluteFilePath(sOutputName));
+		}
+	}
+}
+
+
+// Start rendering (GUI thread).
+void qsynthRender::start (void)
+{
+	const int iJobCount = m_jobs.count();
+	m_iRunning = iJobCount;
+
+	if (iJobCount < 1) {
+		emit finished();
+		return;
+	}
+
+	for (int iJob = 0; iJob < iJobCount; ++iJob)
+		m_threadPool.start(new Task(this, iJob));
+}
+
+
+// Cancel all jobs (the ones rendering stop at the next block).
+void qsynthRender::cancel (void)
+{
+	m_iCancel = 1;
+}
+
+bool qsynthRender::isCancelled (void) const
+{
+	return (m_iCancel.load() > 0);
+}
+
+
+// Whether all jobs are done with.
+bool qsynthRender::isFinished (void) const
+{
+	return (m_iRunning.loadAcquire() < 1);
+}
+
+
+// Job accessors.
+int qsynthRender::jobCount (void) const
+{
+	return m_jobs.count();
+}
+
+const QString& qsynthRender::name ( int iJob ) const
+{
+	return m_jobs.at(iJob)->sName;
+}
+
+const QString& qsynthRender::midiFile ( int iJob ) const
+{
+	return m_jobs.at(iJob)->sMidiFile;
+}
+
+const QString& qsynthRender::outputFile ( int iJob ) const
+{
+	return m_jobs.at(iJob)->sOutputFile;
+}
+
+qsynthRender::State qsynthRender::state ( int iJob ) const
+{
+	return State(m_jobs.at(iJob)->iState.loadAcquire());
+}
+
+
+// Job results (only valid once done with).
+const QString& qsynthRender::error ( int iJob ) const
+{
+	return m_jobs.at(iJob)->sError;
+}
+
+float qsynthRender::seconds ( int iJob ) const
+{
+	const Job *pJob = m_jobs.at(iJob);
+	return float(pJob->iFrames) / pJob->fSampleRate;
+}
+
+float qsynthRender::elapsed ( int iJob ) const
+{
+	return 0.001f * float(m_jobs.at(iJob)->iElapsed);
+}
+
+
+// Number of jobs done with (done, failed or cancelled)...
+int qsynthRender::doneCount (void) const
+{
+	int iDoneCount = 0;
+
+	QListIterator<Job *> iter(m_jobs);
+	while (iter.hasNext()) {
+		if (iter.next()->iState.loadAcquire() > Rendering)
+			++iDoneCount;
+	}
+
+	return iDoneCount;
+}
+
+// ...and of the ones which have failed.
+int qsynthRender::failedCount (void) const
+{
+	int iFailedCount = 0;
+
+	QListIterator<Job *> iter(m_jobs);
+	while (iter.hasNext()) {
+		if (iter.next()->iState.loadAcquire() == Failed)
+			++iFailedCount;
+	}
+
+	return iFailedCount;
+}
+
+
+// Actual rendering (worker thread).
+void qsynthRender::run ( int iJob )
+{
+	Job *pJob = m_jobs.at(iJob);
+
+	if (isCancelled()) {
+		pJob->iState.storeRelease(Cancelled);
+	} else {
+		pJob->iState.storeRelease(Rendering);
+		emit jobStarted(iJob);
+		QElapsedTimer timer;
+		timer.start();
+		const State state = render(pJob);
+		pJob->iElapsed = timer.elapsed();
+		pJob->iState.storeRelease(state);
+	}
+
+	emit jobFinished(iJob);
+
+	if (!m_iRunning.deref())
+		emit finished();
+}
+
+
+// Render one MIDI file through its own synth, as fast as it goes.
+qsynthRender::State qsynthRender::render ( Job *pJob )
+{
+#ifdef CONFIG_FLUID_FILE_RENDERER
+
+	fluid_synth_t *pSynth = ::new_fluid_synth(pJob->pSettings);
+	if (pSynth == NULL) {
+		pJob->sError = tr("Failed to create the synthesizer.");
+		return Failed;
+	}
+
+	// Soundfonts shared through the cache, if any...
+	qsynthSoundFontCache *pCache = qsynthSoundFontCache::getInstance();
+	if (pCache) {
+		fluid_sfloader_t *pLoader
+			= pCache->createLoader(qsynthSoundFontCache::LoadEager);
+		if (pLoader)
+			::fluid_synth_add_sfloader(pSynth, pLoader);
+	}
+
+	const int iSoundFonts = pJob->soundfonts.count();
+	for (int i = 0; i < iSoundFonts; ++i) {
+		const QString& sFilename = pJob->soundfonts.at(i);
+		const int iSFID = ::fluid_synth_sfload(
+			pSynth, sFilename.toLocal8Bit().data(), 1);
+		if (iSFID < 0) {
+			pJob->sError = tr("Failed to load the soundfont: \"%1\".")
+				.arg(sFilename);
+			::delete_fluid_synth(pSynth);
+			return Failed;
+		}
+	#ifdef CONFIG_FLUID_BANK_OFFSET
+		if (i < pJob->bankoffsets.count())
+			::fluid_synth_set_bank_offset(
+				pSynth, iSFID, pJob->bankoffsets.at(i).toInt());
+	#endif
+	}
+
+	// Effects and gain, as in setup...
+	::fluid_synth_set_gain(pSynth, pJob->fGain);
+	::fluid_synth_set_reverb_on(pSynth, int(pJob->bReverbActive));
+	::fluid_synth_set_reverb(pSynth,
+		pJob->fReverbRoom,
+		pJob->fReverbDamp,
+		pJob->fReverbWidth,
+		pJob->fReverbLevel);
+	::fluid_synth_set_chorus_on(pSynth, int(pJob->bChorusActive));
+	::fluid_synth_set_chorus(pSynth,
+		pJob->iChorusNr,
+		pJob->fChorusLevel,
+		pJob->fChorusSpeed,
+		pJob->fChorusDepth,
+		pJob->iChorusType);
+
+	State state = Failed;
+
+	fluid_player_t *pPlayer = ::new_fluid_player(pSynth);
+	fluid_file_renderer_t *pRenderer = NULL;
+	if (pPlayer == NULL
+		|| ::fluid_player_add(pPlayer,
+			pJob->sMidiFile.toLocal8Bit().data()) != FLUID_OK
+		|| ::fluid_player_play(pPlayer) != FLUID_OK) {
+		pJob->sError = tr("Failed to play the MIDI file.");
+	} else {
+		pRenderer = ::new_fluid_file_renderer(pSynth);
+		if (pRenderer == NULL)
+			pJob->sError = tr("Failed to open the output file.");
+	}
+
+	if (pRenderer) {
+		// We'll need these to avoid pedandic compiler warnings...
+		char *pszKey = (char *) "audio.period-size";
+		int iPeriodSize = 0;
+		::fluid_settings_getint(pJob->pSettings, pszKey, &iPeriodSize);
+		if (iPeriodSize < 1)
+			iPeriodSize = 64;
+		// Render it all, then some tail...
+		const qint64 iTailFrames
+			= qint64(pJob->fSampleRate) * QSYNTH_RENDER_TAIL_MSECS / 1000;
+		qint64 iTail = 0;
+		state = Done;
+		while (iTail < iTailFrames) {
+			if (isCancelled()) {
+				state = Cancelled;
+				break;
+			}
+			if (::fluid_file_renderer_process_block(pRenderer) != FLUID_OK) {
+				pJob->sError = tr("Failed to write the output file.");
+				state = Failed;
+				break;
+			}
+			pJob->iFrames += iPeriodSize;
+			if (::fluid_player_get_status(pPlayer) != FLUID_PLAYER_PLAYING)
+				iTail += iPeriodSize;
+		}
+		::delete_fluid_file_renderer(pRenderer);
+	}
+
+	if (pPlayer) {
+		::fluid_player_stop(pPlayer);
+		::fluid_player_join(pPlayer);
+		::delete_fluid_player(pPlayer);
+	}
+
+	::delete_fluid_synth(pSynth);
+
+	return state;
+
+#else
+
+	pJob->sError = tr("Offline rendering is not supported"
+		" by this fluidsynth library.");
+
+	return Failed;
+
+#endif
+}
+
+
+// end of qsynthRender.cpp
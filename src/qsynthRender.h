@@ -0,0 +1,141 @@
+// qsynthRender.h
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qsynthRender_h
+#define __qsynthRender_h
+
+#include "qsynthAtomic.h"
+
+#include <fluidsynth.h>
+
+#include <QObject>
+#include <QStringList>
+#include <QList>
+#include <QThreadPool>
+
+// Forward declarations.
+class qsynthSetup;
+class qsynthEngine;
+
+
+// Reverb/chorus tail rendered past the end of each file (msecs).
+#define QSYNTH_RENDER_TAIL_MSECS 2000
+
+
+//-------------------------------------------------------------------------
+// qsynthRender - Offline (faster than realtime) MIDI file renderer.
+//
+// Each job renders one MIDI file through a private synth, set up just
+// like some engine (soundfonts, reverb, chorus and gain), straight into
+// an audio file (WAV or FLAC) with the fluidsynth file renderer, driving
+// the synth as fast as it goes; jobs run in parallel on their own thread
+// pool, their soundfonts being shared through the soundfont cache.
+
+class qsynthRender : public QObject
+{
+	Q_OBJECT
+
+public:
+
+	// Constructor.
+	qsynthRender(int iThreads = 0, QObject *pParent = NULL);
+	// Destructor (cancels and waits for all jobs).
+	~qsynthRender();
+
+	// Whether offline rendering is supported at all.
+	static bool isAvailable();
+
+	// Job states.
+	enum State { Pending = 0, Rendering, Done, Failed, Cancelled };
+
+	// Add a render job, from an engine setup snapshot (GUI thread).
+	int addJob(qsynthSetup *pSetup,
+		const QString& sMidiFile, const QString& sOutputFile);
+
+	// Add all files through all engines; output files are named after
+	// each file (and engine, if more than one) with the format suffix,
+	// in the output directory or else next to each file.
+	void addJobs(const QList<qsynthEngine *>& engines,
+		const QStringList& files, const QString& sOutputDir,
+		const QString& sFormat);
+
+	// Start rendering (GUI thread).
+	void start();
+
+	// Cancel all jobs (the ones rendering stop at the next block).
+	void cancel();
+	bool isCancelled() const;
+
+	// Whether all jobs are done with.
+	bool isFinished() const;
+
+	// Job accessors.
+	int jobCount() const;
+	const QString& name(int iJob) const;
+	const QString& midiFile(int iJob) const;
+	const QString& outputFile(int iJob) const;
+	State state(int iJob) const;
+
+	// Job results (only valid once done with).
+	const QString& error(int iJob) const;
+	float seconds(int iJob) const;
+	float elapsed(int iJob) const;
+
+	// Number of jobs done with (done, failed or cancelled)
+	// and of the ones which have failed.
+	int doneCount() const;
+	int failedCount() const;
+
+signals:
+
+	// Progress signals (emitted from the worker threads).
+	void jobStarted(int iJob);
+	void jobFinished(int iJob);
+	void finished();
+
+protected:
+
+	// Worker thread task.
+	class Task;
+
+	// Render job descriptor.
+	struct Job;
+
+	// Actual rendering (worker thread).
+	void run(int iJob);
+	State render(Job *pJob);
+
+private:
+
+	// Instance variables.
+	QList<Job *> m_jobs;
+
+	QThreadPool m_threadPool;
+
+	qsynthAtomicInt m_iCancel;
+	qsynthAtomicInt m_iRunning;
+};
+
+
+#endif  // __qsynthRender_h
+
+
+// end of qsynthRender.h
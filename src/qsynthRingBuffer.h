@@ -0,0 +1,108 @@
+// qsynthRingBuffer.h
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qsynthRingBuffer_h
+#define __qsynthRingBuffer_h
+
+#include "qsynthAtomic.h"
+
+
+//-------------------------------------------------------------------------
+// qsynthRingBuffer - Lock-free single-producer/single-consumer ring.
+//
+// The producer (eg. audio or MIDI thread) only ever calls write(),
+// the consumer (eg. GUI thread) only ever calls read(); neither side
+// blocks nor allocates. Indexes are free-running and masked on access.
+
+template <typename T>
+class qsynthRingBuffer
+{
+public:
+
+	// Constructor (size gets rounded up to a power of two).
+	qsynthRingBuffer(unsigned int iSize = 64)
+	{
+		m_iSize = 4;
+		while (m_iSize < iSize)
+			m_iSize <<= 1;
+		m_iMask = m_iSize - 1;
+		m_pItems = new T [m_iSize];
+	}
+
+	// Destructor.
+	~qsynthRingBuffer() { delete [] m_pItems; }
+
+	// Ring capacity.
+	unsigned int size() const { return m_iSize; }
+
+	// Producer side: push one item; false when full.
+	bool write ( const T& item )
+	{
+		const unsigned int w = (unsigned int) m_iWrite.load();
+		const unsigned int r = (unsigned int) m_iRead.loadAcquire();
+		if (w - r >= m_iSize)
+			return false;
+		m_pItems[w & m_iMask] = item;
+		m_iWrite.storeRelease(int(w + 1));
+		return true;
+	}
+
+	// Consumer side: pop one item; false when empty.
+	bool read ( T& item )
+	{
+		const unsigned int r = (unsigned int) m_iRead.load();
+		const unsigned int w = (unsigned int) m_iWrite.loadAcquire();
+		if (w == r)
+			return false;
+		item = m_pItems[r & m_iMask];
+		m_iRead.storeRelease(int(r + 1));
+		return true;
+	}
+
+	// Number of items ready to read (consumer side).
+	unsigned int readable() const
+	{
+		return (unsigned int) m_iWrite.loadAcquire()
+			- (unsigned int) m_iRead.load();
+	}
+
+	// Consumer side: discard everything pending.
+	void flush() { m_iRead.storeRelease(m_iWrite.loadAcquire()); }
+
+private:
+
+	// Owns its buffer: no copies.
+	Q_DISABLE_COPY(qsynthRingBuffer)
+
+	// Instance variables.
+	T           *m_pItems;
+	unsigned int m_iSize;
+	unsigned int m_iMask;
+
+	qsynthAtomicInt   m_iWrite;
+	qsynthAtomicInt   m_iRead;
+};
+
+
+#endif  // __qsynthRingBuffer_h
+
+
+// end of qsynthRingBuffer.h
@@ -34,6 +34,10 @@ qsynthSetup::qsynthSetup (void)
 {
 	m_pFluidSettings = NULL;
 
+	iSoundFontLoad = 0;
+
+	bPresetTable = false;
+
 	sDefPresetName = QObject::tr("(default)");
 }
 
@@ -55,6 +59,142 @@ fluid_settings_t *qsynthSetup::fluid_settings (void)
 }
 
 
+// Hand over the current fluidsynth settings (eg. still in use
+// by running drivers); the next realize() won't delete them.
+fluid_settings_t *qsynthSetup::detach_fluid_settings (void)
+{
+	fluid_settings_t *pFluidSettings = m_pFluidSettings;
+	m_pFluidSettings = NULL;
+	return pFluidSettings;
+}
+
+
+//-------------------------------------------------------------------------
+// Setup value changes.
+//
+
+// Setup values, keyed by fluidsynth setting name (or else
+// by a "qsynth." prefixed one), as edited on the setup dialog.
+QMap<QString, QString> qsynthSetup::values (void) const
+{
+	QMap<QString, QString> values;
+
+	values.insert("qsynth.display-name", sDisplayName);
+	values.insert("qsynth.midi-in", QString::number(int(bMidiIn)));
+	values.insert("midi.driver", sMidiDriver);
+	values.insert("midi.device", sMidiDevice);
+	values.insert("midi.id", sMidiName);
+	values.insert("synth.midi-channels", QString::number(iMidiChannels));
+	values.insert("synth.midi-bank-select", sMidiBankSelect);
+	values.insert("synth.dump", QString::number(int(bMidiDump)));
+	values.insert("synth.verbose", QString::number(int(bVerbose)));
+	values.insert("audio.driver", sAudioDriver);
+	values.insert("audio.device", sAudioDevice);
+	values.insert("audio.jack.id", sJackName);
+	values.insert("audio.jack.autoconnect", QString::number(int(bJackAutoConnect)));
+	values.insert("audio.jack.multi", QString::number(int(bJackMulti)));
+	values.insert("audio.sample-format", sSampleFormat);
+	values.insert("audio.period-size", QString::number(iAudioBufSize));
+	values.insert("audio.periods", QString::number(iAudioBufCount));
+	values.insert("synth.audio-channels", QString::number(iAudioChannels));
+	values.insert("synth.audio-groups", QString::number(iAudioGroups));
+	values.insert("synth.sample-rate", QString::number(fSampleRate));
+	values.insert("synth.polyphony", QString::number(iPolyphony));
+	values.insert("qsynth.soundfonts", soundfonts.join("\n"));
+	values.insert("qsynth.bankoffsets", bankoffsets.join("\n"));
+	values.insert("qsynth.soundfont-load", QString::number(iSoundFontLoad));
+
+	// User supplied options (Settings tab) go last, as on realize()...
+	QStringListIterator iter(options);
+	while (iter.hasNext()) {
+		const QString& sOpt = iter.next();
+		values.insert(sOpt.section('=', 0, 0), sOpt.section('=', 1, 1));
+	}
+
+	return values;
+}
+
+
+// Changed setup value keys, against another setup.
+QStringList qsynthSetup::changes ( const qsynthSetup& setup ) const
+{
+	QStringList keys;
+
+	const QMap<QString, QString>& values1 = values();
+	const QMap<QString, QString>& values2 = setup.values();
+	QMapIterator<QString, QString> iter(values1);
+	while (iter.hasNext()) {
+		iter.next();
+		if (values2.value(iter.key()) != iter.value())
+			keys.append(iter.key());
+	}
+
+	// Removed options are changes too...
+	QMapIterator<QString, QString> iter2(values2);
+	while (iter2.hasNext()) {
+		iter2.next();
+		if (!values1.contains(iter2.key()))
+			keys.append(iter2.key());
+	}
+
+	return keys;
+}
+
+
+// Whether a setup value may be changed in place (realtime).
+bool qsynthSetup::isRealtime ( const QString& sKey ) const
+{
+	// Engine name and soundfonts stack are handled in place...
+	if (sKey == "qsynth.display-name" ||
+		sKey == "qsynth.soundfonts"   ||
+		sKey == "qsynth.bankoffsets")
+		return true;
+
+	// Otherwise, as fluidsynth says so...
+	if (m_pFluidSettings == NULL || sKey.startsWith("qsynth."))
+		return false;
+
+	QByteArray tmp = sKey.toLocal8Bit();
+	return (::fluid_settings_is_realtime(m_pFluidSettings, tmp.data()) != 0);
+}
+
+
+// Apply a realtime setup value in place (fluidsynth settings only).
+bool qsynthSetup::update ( const QString& sKey )
+{
+	if (m_pFluidSettings == NULL || sKey.startsWith("qsynth."))
+		return false;
+
+	const QMap<QString, QString>& vals = values();
+	const bool bDefault = !vals.contains(sKey);
+	const QString& sVal = vals.value(sKey);
+
+	// An option removed from the Settings tab reverts to its default.
+	QByteArray tmp = sKey.toLocal8Bit();
+	char *pszKey = tmp.data();
+	int iResult = 0;
+	switch (::fluid_settings_get_type(m_pFluidSettings, pszKey)) {
+	case FLUID_NUM_TYPE:
+		iResult = ::fluid_settings_setnum(m_pFluidSettings, pszKey, bDefault
+			? ::fluid_settings_getnum_default(m_pFluidSettings, pszKey)
+			: sVal.toDouble());
+		break;
+	case FLUID_INT_TYPE:
+		iResult = ::fluid_settings_setint(m_pFluidSettings, pszKey, bDefault
+			? ::fluid_settings_getint_default(m_pFluidSettings, pszKey)
+			: sVal.toInt());
+		break;
+	case FLUID_STR_TYPE:
+		iResult = ::fluid_settings_setstr(m_pFluidSettings, pszKey, bDefault
+			? ::fluid_settings_getstr_default(m_pFluidSettings, pszKey)
+			: sVal.toLocal8Bit().data());
+		break;
+	}
+
+	return (iResult != 0);
+}
+
+
 //-------------------------------------------------------------------------
 // Settings cache realization.
 //
@@ -66,6 +206,14 @@ void qsynthSetup::realize (void)
 
 	m_pFluidSettings = ::new_fluid_settings();
 
+	realize(m_pFluidSettings);
+}
+
+
+// Settings realization onto some other fluidsynth settings
+// (eg. for offline rendering).
+void qsynthSetup::realize ( fluid_settings_t *pFluidSettings )
+{
 	// The 'groups' setting is only relevant for LADSPA operation
 	// If not given, set number groups to number of audio channels, because
 	// they are the same (there is nothing between synth output and 'sound card')
@@ -79,13 +227,13 @@ void qsynthSetup::realize (void)
 	// First we'll force all other conmmand line options...
 	if (!sMidiDriver.isEmpty()) {
 		pszKey = (char *) "midi.driver";
-		::fluid_settings_setstr(m_pFluidSettings, pszKey,
+		::fluid_settings_setstr(pFluidSettings, pszKey,
 			sMidiDriver.toLocal8Bit().data());
 	}
 	if (sMidiDriver == "alsa_seq" || sMidiDriver == "coremidi") {
 		QString sKey = "midi." + sMidiDriver + ".id";
 		if (!sMidiName.isEmpty()) {
-			::fluid_settings_setstr(m_pFluidSettings,
+			::fluid_settings_setstr(pFluidSettings,
 				sKey.toLocal8Bit().data(),
 				sMidiName.toLocal8Bit().data());
 		}
@@ -98,14 +246,14 @@ void qsynthSetup::realize (void)
 		else
 			sMidiKey += sMidiDriver;
 		sMidiKey += ".device";
-		::fluid_settings_setstr(m_pFluidSettings,
+		::fluid_settings_setstr(pFluidSettings,
 			sMidiKey.toLocal8Bit().data(),
 			sMidiDevice.toLocal8Bit().data());
 	}
 
 	if (!sAudioDriver.isEmpty()) {
 		pszKey = (char *) "audio.driver";
-		::fluid_settings_setstr(m_pFluidSettings, pszKey,
+		::fluid_settings_setstr(pFluidSettings, pszKey,
 			sAudioDriver.toLocal8Bit().data());
 	}
 	if (!sAudioDevice.isEmpty()) {
@@ -114,93 +262,93 @@ void qsynthSetup::realize (void)
 			sAudioKey += "name";
 		else
 			sAudioKey += "device";
-		::fluid_settings_setstr(m_pFluidSettings,
+		::fluid_settings_setstr(pFluidSettings,
 			sAudioKey.toLocal8Bit().data(),
 			sAudioDevice.toLocal8Bit().data());
 	}
 	if (!sJackName.isEmpty()) {
 		pszKey = (char *) "audio.jack.id";
-		::fluid_settings_setstr(m_pFluidSettings, pszKey,
+		::fluid_settings_setstr(pFluidSettings, pszKey,
 			sJackName.toLocal8Bit().data());
 	}
 
 	pszKey = (char *) "audio.jack.autoconnect";
-	::fluid_settings_setint(m_pFluidSettings, pszKey,
+	::fluid_settings_setint(pFluidSettings, pszKey,
 		int(bJackAutoConnect));
 
 	pszKey = (char *) "audio.jack.multi";
 	pszVal = (char *) (bJackMulti ? "yes" : "no");
-	::fluid_settings_setstr(m_pFluidSettings, pszKey, pszVal);
+	::fluid_settings_setstr(pFluidSettings, pszKey, pszVal);
 
 	if (!sSampleFormat.isEmpty()) {
 		pszKey = (char *) "audio.sample-format";
-		::fluid_settings_setstr(m_pFluidSettings, pszKey,
+		::fluid_settings_setstr(pFluidSettings, pszKey,
 			sSampleFormat.toLocal8Bit().data());
 	}
 	if (iAudioBufSize > 0) {
 		pszKey = (char *) "audio.period-size";
-		::fluid_settings_setint(m_pFluidSettings, pszKey,
+		::fluid_settings_setint(pFluidSettings, pszKey,
 			iAudioBufSize);
 	}
 	if (iAudioBufCount > 0) {
 		pszKey = (char *) "audio.periods";
-		::fluid_settings_setint(m_pFluidSettings, pszKey,
+		::fluid_settings_setint(pFluidSettings, pszKey,
 			iAudioBufCount);
 	}
 	if (iMidiChannels > 0) {
 		pszKey = (char *) "synth.midi-channels";
-		::fluid_settings_setint(m_pFluidSettings, pszKey,
+		::fluid_settings_setint(pFluidSettings, pszKey,
 			iMidiChannels);
 	}
 
 	pszKey = (char *) "synth.midi-bank-select";
-	::fluid_settings_setstr(m_pFluidSettings, pszKey, sMidiBankSelect.toLocal8Bit().data());
+	::fluid_settings_setstr(pFluidSettings, pszKey, sMidiBankSelect.toLocal8Bit().data());
 
 	if (iAudioChannels > 0) {
 		pszKey = (char *) "synth.audio-channels";
-		::fluid_settings_setint(m_pFluidSettings, pszKey,
+		::fluid_settings_setint(pFluidSettings, pszKey,
 			iAudioChannels);
 	}
 	if (iAudioGroups > 0) {
 		pszKey = (char *) "synth.audio-groups";
-		::fluid_settings_setint(m_pFluidSettings, pszKey,
+		::fluid_settings_setint(pFluidSettings, pszKey,
 			iAudioGroups);
 	}
 	if (fSampleRate > 0.0) {
 		pszKey = (char *) "synth.sample-rate";
-		::fluid_settings_setnum(m_pFluidSettings, pszKey,
+		::fluid_settings_setnum(pFluidSettings, pszKey,
 			fSampleRate);
 	}
 	if (iPolyphony > 0) {
 		pszKey = (char *) "synth.polyphony";
-		::fluid_settings_setint(m_pFluidSettings, pszKey,
+		::fluid_settings_setint(pFluidSettings, pszKey,
 			iPolyphony);
 	}
 //  Gain is set on realtime (don't need to set it here)
 //  if (fGain > 0.0) {
 //		pszKey = (char *) "synth.gain";
-//      ::fluid_settings_setnum(m_pFluidSettings, pszKey, fGain);
+//      ::fluid_settings_setnum(pFluidSettings, pszKey, fGain);
 //	}
 
 	pszKey = (char *) "synth.reverb.active";
 	pszVal = (char *) (bReverbActive ? "yes" : "no");
-	::fluid_settings_setstr(m_pFluidSettings, pszKey, pszVal);
+	::fluid_settings_setstr(pFluidSettings, pszKey, pszVal);
 
 	pszKey = (char *) "synth.chorus.active";
 	pszVal = (char *) (bChorusActive ? "yes" : "no");
-	::fluid_settings_setstr(m_pFluidSettings, pszKey, pszVal);
+	::fluid_settings_setstr(pFluidSettings, pszKey, pszVal);
 
 	pszKey = (char *) "synth.ladspa.active";
 	pszVal = (char *) (bLadspaActive ? "yes" : "no");
-	::fluid_settings_setstr(m_pFluidSettings, pszKey, pszVal);
+	::fluid_settings_setstr(pFluidSettings, pszKey, pszVal);
 
 	pszKey = (char *) "synth.dump";
 	pszVal = (char *) (bMidiDump ? "yes" : "no");
-		::fluid_settings_setstr(m_pFluidSettings, pszKey, pszVal);
+		::fluid_settings_setstr(pFluidSettings, pszKey, pszVal);
 
 	pszKey = (char *) "synth.verbose";
 	pszVal = (char *) (bVerbose ? "yes" : "no");
-	::fluid_settings_setstr(m_pFluidSettings, pszKey, pszVal);
+	::fluid_settings_setstr(pFluidSettings, pszKey, pszVal);
 
 	// Last we set user supplied options...
 	QStringListIterator iter(options);
@@ -210,18 +358,18 @@ void qsynthSetup::realize (void)
 		const QString sVal = sOpt.section('=', 1, 1);
 		QByteArray tmp = sKey.toLocal8Bit();
 		pszKey = tmp.data();
-		switch (::fluid_settings_get_type(m_pFluidSettings, pszKey)) {
+		switch (::fluid_settings_get_type(pFluidSettings, pszKey)) {
 		case FLUID_NUM_TYPE:
-			::fluid_settings_setnum(m_pFluidSettings, pszKey,
+			::fluid_settings_setnum(pFluidSettings, pszKey,
 				sVal.toFloat());
 			break;
 		case FLUID_INT_TYPE:
-			::fluid_settings_setint(m_pFluidSettings, pszKey,
+			::fluid_settings_setint(pFluidSettings, pszKey,
 				sVal.toInt());
 			break;
 		case FLUID_STR_TYPE:
 		default:
-			::fluid_settings_setstr(m_pFluidSettings, pszKey,
+			::fluid_settings_setstr(pFluidSettings, pszKey,
 				sVal.toLocal8Bit().data());
 			break;
 		}
@@ -24,6 +24,9 @@
 
 #include <QStringList>
 #include <QSettings>
+#include <QMap>
+#include <QHash>
+#include <QByteArray>
 
 #include <fluidsynth.h>
 
@@ -43,10 +46,29 @@ public:
 
 	// Settings cache realization.
 	void realize();
+	// Settings realization onto some other fluidsynth settings.
+	void realize(fluid_settings_t *pFluidSettings);
 
 	// Fluidsynth settings accessor.
 	fluid_settings_t *fluid_settings();
 
+	// Hand over the current fluidsynth settings (eg. still in use
+	// by running drivers); the next realize() won't delete them.
+	fluid_settings_t *detach_fluid_settings();
+
+	// Setup values, keyed by fluidsynth setting name (or else
+	// by a "qsynth." prefixed one), as edited on the setup dialog.
+	QMap<QString, QString> values() const;
+
+	// Changed setup value keys, against another setup.
+	QStringList changes(const qsynthSetup& setup) const;
+
+	// Whether a setup value may be changed in place (realtime).
+	bool isRealtime(const QString& sKey) const;
+
+	// Apply a realtime setup value in place (fluidsynth settings only).
+	bool update(const QString& sKey);
+
 	// Setup display name.
 	QString sDisplayName;
 
@@ -94,6 +116,10 @@ public:
 	QStringList bankoffsets;
 	QStringList midifiles;
 
+	// Soundfont sample loading mode
+	// (see qsynthSoundFontCache::LoadMode).
+	int     iSoundFontLoad;
+
 	// Current (translated) preset name.
 	QString sDefPresetName;
 
@@ -102,6 +128,12 @@ public:
 	// Available presets list.
 	QStringList presets;
 
+	// Channel presets table, as compact binary snapshots keyed
+	// by preset name (null for the default one); loaded once per
+	// engine, on first use (see qsynthOptions::loadPreset()).
+	QHash<QString, QByteArray> presetTable;
+	bool bPresetTable;
+
 private:
 
 	// Fluidsynth settings member variable.
@@ -23,6 +23,7 @@
 #include "qsynthSetupForm.h"
 
 #include "qsynthEngine.h"
+#include "qsynthSoundFontMeta.h"
 
 #include <QValidator>
 #include <QHeaderView>
@@ -319,6 +320,9 @@ qsynthSetupForm::qsynthSetupForm (
 	QObject::connect(m_ui.SoundFontListView->itemDelegate(),
 		SIGNAL(commitData(QWidget*)),
 		SLOT(itemRenamed()));
+	QObject::connect(m_ui.SoundFontLoadComboBox,
+		SIGNAL(activated(int)),
+		SLOT(settingsChanged()));
 	QObject::connect(m_ui.DialogButtonBox,
 		SIGNAL(accepted()),
 		SLOT(accept()));
@@ -370,6 +374,7 @@ void qsynthSetupForm::setup ( qsynthOptions *pOptions, qsynthEngine *pEngine, bo
 
 	// Start clean?
 	m_iDirtyCount = 0;
+	m_changes.clear();
 	if (bNew) {
 		m_pSetup->realize();
 		++m_iDirtyCount;
@@ -489,6 +494,7 @@ void qsynthSetupForm::setup ( qsynthOptions *pOptions, qsynthEngine *pEngine, bo
 					pItem->setIcon(0, *m_pXpmSoundFont);
 					pItem->setText(0, QString::number(pSoundFont->id));
 					pItem->setText(1, pSoundFont->get_name(pSoundFont));
+					pItem->setToolTip(1, soundFontToolTip(pItem->text(1)));
 				#ifdef CONFIG_FLUID_BANK_OFFSET
 					pItem->setText(2, QString::number(::fluid_synth_get_bank_offset(pEngine->pSynth, pSoundFont->id)));
 					pItem->setFlags(pItem->flags() | Qt::ItemIsEditable);
@@ -506,6 +512,7 @@ void qsynthSetupForm::setup ( qsynthOptions *pOptions, qsynthEngine *pEngine, bo
 				pItem->setIcon(0, *m_pXpmSoundFont);
 				pItem->setText(0, QString::number(i));
 				pItem->setText(1, iter.next());
+				pItem->setToolTip(1, soundFontToolTip(pItem->text(1)));
 			#ifdef CONFIG_FLUID_BANK_OFFSET
 				pItem->setText(2, m_pSetup->bankoffsets[i]);
 				pItem->setFlags(pItem->flags() | Qt::ItemIsEditable);
@@ -516,6 +523,7 @@ void qsynthSetupForm::setup ( qsynthOptions *pOptions, qsynthEngine *pEngine, bo
 	}
 	m_ui.SoundFontListView->setUpdatesEnabled(true);
 	m_ui.SoundFontListView->update();
+	m_ui.SoundFontLoadComboBox->setCurrentIndex(m_pSetup->iSoundFontLoad);
 
 	// Done.
 	m_iDirtySetup--;
@@ -527,39 +535,11 @@ void qsynthSetupForm::setup ( qsynthOptions *pOptions, qsynthEngine *pEngine, bo
 void qsynthSetupForm::accept (void)
 {
 	if (m_iDirtyCount > 0) {
-		// Save the soundfont view.
-		m_pSetup->soundfonts.clear();
-		m_pSetup->bankoffsets.clear();
-		const int iItemCount = m_ui.SoundFontListView->topLevelItemCount();
-		for (int i = 0; i < iItemCount; ++i) {
-			QTreeWidgetItem *pItem = m_ui.SoundFontListView->topLevelItem(i);
-			m_pSetup->soundfonts.append(pItem->text(1));
-			m_pSetup->bankoffsets.append(pItem->text(2));
-		}
-		// Will we have a setup renaming?
-		m_pSetup->sDisplayName     = m_ui.DisplayNameLineEdit->text();
-		// Midi settings...
-		m_pSetup->bMidiIn          = m_ui.MidiInCheckBox->isChecked();
-		m_pSetup->sMidiDriver      = m_ui.MidiDriverComboBox->currentText();
-		m_pSetup->sMidiDevice      = m_ui.MidiDeviceComboBox->currentText();
-		m_pSetup->iMidiChannels    = m_ui.MidiChannelsSpinBox->value();
-		m_pSetup->sMidiBankSelect  = m_ui.MidiBankSelectComboBox->currentText();
-		m_pSetup->bMidiDump        = m_ui.MidiDumpCheckBox->isChecked();
-		m_pSetup->bVerbose         = m_ui.VerboseCheckBox->isChecked();
-		m_pSetup->sMidiName        = m_ui.MidiNameComboBox->currentText();
-		// Audio settings...
-		m_pSetup->sAudioDriver     = m_ui.AudioDriverComboBox->currentText();
-		m_pSetup->sAudioDevice     = m_ui.AudioDeviceComboBox->currentText();
-		m_pSetup->sSampleFormat    = m_ui.SampleFormatComboBox->currentText();
-		m_pSetup->fSampleRate      = m_ui.SampleRateComboBox->currentText().toDouble();
-		m_pSetup->iAudioBufSize    = m_ui.AudioBufSizeComboBox->currentText().toInt();
-		m_pSetup->iAudioBufCount   = m_ui.AudioBufCountComboBox->currentText().toInt();
-		m_pSetup->iAudioChannels   = m_ui.AudioChannelsSpinBox->value();
-		m_pSetup->iAudioGroups     = m_ui.AudioGroupsSpinBox->value();
-		m_pSetup->iPolyphony       = m_ui.PolyphonySpinBox->value();
-		m_pSetup->bJackMulti       = m_ui.JackMultiCheckBox->isChecked();
-		m_pSetup->bJackAutoConnect = m_ui.JackAutoConnectCheckBox->isChecked();
-		m_pSetup->sJackName        = m_ui.JackNameComboBox->currentText();
+		// Keep track of what's changed...
+		qsynthSetup setup;
+		saveSetup(&setup);
+		m_changes = m_pSetup->changes(setup);
+		saveSetup(m_pSetup);
 		// Reset dirty flag.
 		m_iDirtyCount = 0;
 	}
@@ -569,6 +549,53 @@ void qsynthSetupForm::accept (void)
 }
 
 
+// Save the form settings into a setup.
+void qsynthSetupForm::saveSetup ( qsynthSetup *pSetup ) const
+{
+	// Save the soundfont view.
+	pSetup->soundfonts.clear();
+	pSetup->bankoffsets.clear();
+	const int iItemCount = m_ui.SoundFontListView->topLevelItemCount();
+	for (int i = 0; i < iItemCount; ++i) {
+		QTreeWidgetItem *pItem = m_ui.SoundFontListView->topLevelItem(i);
+		pSetup->soundfonts.append(pItem->text(1));
+		pSetup->bankoffsets.append(pItem->text(2));
+	}
+	pSetup->iSoundFontLoad = m_ui.SoundFontLoadComboBox->currentIndex();
+	// Will we have a setup renaming?
+	pSetup->sDisplayName     = m_ui.DisplayNameLineEdit->text();
+	// Midi settings...
+	pSetup->bMidiIn          = m_ui.MidiInCheckBox->isChecked();
+	pSetup->sMidiDriver      = m_ui.MidiDriverComboBox->currentText();
+	pSetup->sMidiDevice      = m_ui.MidiDeviceComboBox->currentText();
+	pSetup->iMidiChannels    = m_ui.MidiChannelsSpinBox->value();
+	pSetup->sMidiBankSelect  = m_ui.MidiBankSelectComboBox->currentText();
+	pSetup->bMidiDump        = m_ui.MidiDumpCheckBox->isChecked();
+	pSetup->bVerbose         = m_ui.VerboseCheckBox->isChecked();
+	pSetup->sMidiName        = m_ui.MidiNameComboBox->currentText();
+	// Audio settings...
+	pSetup->sAudioDriver     = m_ui.AudioDriverComboBox->currentText();
+	pSetup->sAudioDevice     = m_ui.AudioDeviceComboBox->currentText();
+	pSetup->sSampleFormat    = m_ui.SampleFormatComboBox->currentText();
+	pSetup->fSampleRate      = m_ui.SampleRateComboBox->currentText().toDouble();
+	pSetup->iAudioBufSize    = m_ui.AudioBufSizeComboBox->currentText().toInt();
+	pSetup->iAudioBufCount   = m_ui.AudioBufCountComboBox->currentText().toInt();
+	pSetup->iAudioChannels   = m_ui.AudioChannelsSpinBox->value();
+	pSetup->iAudioGroups     = m_ui.AudioGroupsSpinBox->value();
+	pSetup->iPolyphony       = m_ui.PolyphonySpinBox->value();
+	pSetup->bJackMulti       = m_ui.JackMultiCheckBox->isChecked();
+	pSetup->bJackAutoConnect = m_ui.JackAutoConnectCheckBox->isChecked();
+	pSetup->sJackName        = m_ui.JackNameComboBox->currentText();
+}
+
+
+// Changed setup value keys, as last accepted.
+const QStringList& qsynthSetupForm::changes (void) const
+{
+	return m_changes;
+}
+
+
 // Reject settings (Cancel button slot).
 void qsynthSetupForm::reject (void)
 {
@@ -742,6 +769,27 @@ void qsynthSetupForm::stabilizeForm (void)
 		m_ui.SoundFontMoveDownPushButton->setEnabled(false);
 	}
 
+	// Pending changes that need an engine restart...
+	QStringList restarts;
+	if (m_iDirtyCount > 0 && m_pSetup) {
+		qsynthSetup setup;
+		saveSetup(&setup);
+		QStringListIterator iter(m_pSetup->changes(setup));
+		while (iter.hasNext()) {
+			const QString& sKey = iter.next();
+			if (!m_pSetup->isRealtime(sKey))
+				restarts.append(sKey);
+		}
+	}
+	if (restarts.isEmpty()) {
+		m_ui.RestartTextLabel->clear();
+		m_ui.RestartTextLabel->hide();
+	} else {
+		m_ui.RestartTextLabel->setText(
+			tr("Engine restart needed for: %1").arg(restarts.join(", ")));
+		m_ui.RestartTextLabel->show();
+	}
+
 	bEnabled = (m_iDirtyCount > 0);
 	if (bEnabled && m_pSetup) {
 		const QString& sDisplayName = m_ui.DisplayNameLineEdit->text();
@@ -814,6 +862,29 @@ void qsynthSetupForm::refreshSoundFonts (void)
 }
 
 
+// Soundfont item tooltip (from the metadata cache).
+QString qsynthSetupForm::soundFontToolTip ( const QString& sFilename ) const
+{
+	qsynthSoundFontMeta *pSoundFontMeta = qsynthSoundFontMeta::getInstance();
+	if (pSoundFontMeta == NULL)
+		return QString();
+
+	qsynthSoundFontHeader header;
+	if (!pSoundFontMeta->lookup(sFilename, header))
+		return QString();
+
+	QString sToolTip;
+	if (!header.name().isEmpty())
+		sToolTip += header.name() + '\n';
+	sToolTip += tr("%1 presets, %2 samples (%3 MB)")
+		.arg(header.presetCount())
+		.arg(header.sampleCount())
+		.arg(double(header.sampleSize()) / (1024.0 * 1024.0), 0, 'f', 1);
+
+	return sToolTip;
+}
+
+
 // Browse for a soundfont file on the filesystem.
 void qsynthSetupForm::openSoundFont (void)
 {
@@ -831,7 +902,7 @@ void qsynthSetupForm::openSoundFont (void)
 	while (iter.hasNext()) {
 		const QString& sSoundFont = iter.next();
 		// Is it a soundfont file...
-		if (::fluid_is_soundfont(sSoundFont.toLocal8Bit().data())) {
+		if (qsynthSoundFontMeta::isSoundFont(sSoundFont)) {
 			// Check if not already there...
 			if (!m_ui.SoundFontListView->findItems(
 					sSoundFont, Qt::MatchExactly, 1).isEmpty() &&
@@ -855,6 +926,7 @@ void qsynthSetupForm::openSoundFont (void)
 			if (pItem) {
 				pItem->setIcon(0, *m_pXpmSoundFont);
 				pItem->setText(1, sSoundFont);
+				pItem->setToolTip(1, soundFontToolTip(sSoundFont));
 			#ifdef CONFIG_FLUID_BANK_OFFSET
 				pItem->setText(2, "0");
 				pItem->setFlags(pItem->flags() | Qt::ItemIsEditable);
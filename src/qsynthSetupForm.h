@@ -48,6 +48,9 @@ public:
 
 	void setup(qsynthOptions *pOptions, qsynthEngine *pEngine, bool bNew);
 
+	// Changed setup value keys, as last accepted.
+	const QStringList& changes() const;
+
 public slots:
 
 	void nameChanged(const QString&);
@@ -83,6 +86,11 @@ protected:
 
 	void refreshSoundFonts();
 
+	// Soundfont item tooltip (from the metadata cache).
+	QString soundFontToolTip(const QString& sFilename) const;
+
+	void saveSetup(qsynthSetup *pSetup) const;
+
 private:
 
 	// The Qt-designer UI struct...
@@ -95,6 +103,8 @@ private:
 	int m_iDirtySetup;
 	int m_iDirtyCount;
 
+	QStringList m_changes;
+
 	QString  m_sSoundFontDir;
 	QPixmap *m_pXpmSoundFont;
 };
@@ -0,0 +1,790 @@
+// qsynthSoundFontCache.cpp
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qsynthSoundFontCache.h"
+#include "qsynthSoundFontHeader.h"
+#include "qsynthSoundFontMeta.h"
+
+#include <QFileInfo>
+#include <QDateTime>
+#include <QRunnable>
+
+#include <stdio.h>
+
+#if !defined(_WIN32)
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+
+#ifdef CONFIG_FLUID_SFLOADER
+
+//-------------------------------------------------------------------------
+// Engine loader private data.
+
+struct qsynth_sfloader_data
+{
+	qsynthSoundFontCache          *pCache;
+	qsynthSoundFontCache::LoadMode loadMode;
+};
+
+
+//-------------------------------------------------------------------------
+// Proxy soundfont private data.
+
+struct qsynth_sfont_proxy
+{
+	qsynthSoundFontCache          *pCache;
+	qsynthSoundFontCache::Entry   *pEntry;
+	qsynthSoundFontCache::LoadMode loadMode;
+	bool                           bIterReal;
+	int                            iIterPreset;
+};
+
+
+//-------------------------------------------------------------------------
+// Lazy preset private data (lazy load mode only).
+
+struct qsynth_preset_proxy
+{
+	qsynthSoundFontCache                 *pCache;
+	qsynthSoundFontCache::Entry          *pEntry;
+	const qsynthSoundFontHeader::Preset  *pHeaderPreset;
+	qsynthAtomicPointer<fluid_preset_t>        pRealPreset;
+};
+
+#endif	// CONFIG_FLUID_SFLOADER
+
+
+//-------------------------------------------------------------------------
+// qsynthSoundFontCache::PrefetchTask - Background realization task.
+//
+
+class qsynthSoundFontCache::PrefetchTask : public QRunnable
+{
+public:
+
+	// Constructor.
+	PrefetchTask(qsynthSoundFontCache *pCache, Entry *pEntry)
+		: m_pCache(pCache), m_pEntry(pEntry) {}
+
+	// Task runner; the entry reference was taken on our behalf.
+	// A soundfont that fails to load is never tried again.
+	void run()
+	{
+		const bool bRealized = (m_pCache->realize(m_pEntry) != NULL);
+		m_pEntry->iPrefetch.storeRelease(bRealized ? 0 : 2);
+		m_pCache->release(m_pEntry);
+	}
+
+private:
+
+	// Instance variables.
+	qsynthSoundFontCache *m_pCache;
+	Entry *m_pEntry;
+};
+
+
+//-------------------------------------------------------------------------
+// qsynthSoundFontCache - Process-wide shared soundfont cache.
+//
+
+// Kind of singleton reference.
+qsynthSoundFontCache *qsynthSoundFontCache::g_pSoundFontCache = NULL;
+
+
+// Constructor.
+qsynthSoundFontCache::qsynthSoundFontCache (void)
+{
+	// Our very own settings for the private soundfont synths,
+	// independent of any engine setup lifetime; these just hold
+	// soundfonts, never play a note, so keep them as lean as can be.
+	m_pSettings = ::new_fluid_settings();
+	::fluid_settings_setint(m_pSettings, (char *) "synth.polyphony", 16);
+	::fluid_settings_setstr(m_pSettings, (char *) "synth.reverb.active", (char *) "no");
+	::fluid_settings_setstr(m_pSettings, (char *) "synth.chorus.active", (char *) "no");
+
+	// Pseudo-singleton reference setup.
+	g_pSoundFontCache = this;
+}
+
+
+// Destructor.
+qsynthSoundFontCache::~qsynthSoundFontCache (void)
+{
+	// Pseudo-singleton reference shut-down.
+	g_pSoundFontCache = NULL;
+
+	// Wait for any loading still in progress...
+	m_threadPool.waitForDone();
+
+	// Any soundfont entry still around belongs to some engine
+	// synth still alive; leave it alone, settings included...
+	QMutexLocker locker(&m_mutex);
+
+	if (m_pSettings && m_entries.isEmpty())
+		::delete_fluid_settings(m_pSettings);
+	m_pSettings = NULL;
+}
+
+
+// Kind of singleton reference.
+qsynthSoundFontCache *qsynthSoundFontCache::getInstance (void)
+{
+	return g_pSoundFontCache;
+}
+
+
+// Background loading thread pool.
+QThreadPool *qsynthSoundFontCache::threadPool (void)
+{
+	return &m_threadPool;
+}
+
+
+// Create a new engine loader (none if proxies aren't supported).
+fluid_sfloader_t *qsynthSoundFontCache::createLoader ( LoadMode loadMode )
+{
+#ifdef CONFIG_FLUID_SFLOADER
+
+	if (m_pSettings == NULL)
+		return NULL;
+
+	qsynth_sfloader_data *pData = new qsynth_sfloader_data;
+	pData->pCache   = this;
+	pData->loadMode = loadMode;
+
+	fluid_sfloader_t *pLoader = new fluid_sfloader_t;
+	pLoader->data = (void *) pData;
+	pLoader->free = sfloader_free;
+	pLoader->load = sfloader_load;
+
+	return pLoader;
+
+#else
+
+	Q_UNUSED(loadMode);
+
+	return NULL;
+
+#endif
+}
+
+
+// Cache key helper: canonical path, inode and modification time.
+QString qsynthSoundFontCache::cacheKey ( const QString& sPath )
+{
+	const QFileInfo info(sPath);
+	const QString& sCanonicalPath = info.canonicalFilePath();
+	if (sCanonicalPath.isEmpty())
+		return QString();
+
+	qulonglong iInode = 0;
+#if !defined(_WIN32)
+	struct stat st;
+	if (::stat(sCanonicalPath.toLocal8Bit().data(), &st) == 0)
+		iInode = qulonglong(st.st_ino);
+#endif
+
+	return sCanonicalPath
+		+ ':' + QString::number(iInode)
+		+ ':' + QString::number(info.lastModified().toMSecsSinceEpoch());
+}
+
+
+// Acquire a shared entry reference (any thread); the real soundfont
+// gets loaded on eager mode, otherwise only its headers get parsed.
+qsynthSoundFontCache::Entry *qsynthSoundFontCache::acquire (
+	const QString& sFilename, LoadMode loadMode )
+{
+	const QString& sKey = cacheKey(sFilename);
+	if (sKey.isEmpty())
+		return NULL;
+
+	Entry *pEntry = NULL;
+	{
+		QMutexLocker locker(&m_mutex);
+		pEntry = m_entries.value(sKey, NULL);
+		if (pEntry == NULL) {
+			const QFileInfo info(sFilename);
+			pEntry = new Entry;
+			pEntry->sKey      = sKey;
+			pEntry->sPath     = info.canonicalFilePath();
+			pEntry->name      = sFilename.toLocal8Bit();
+			pEntry->iSize     = info.size();
+			pEntry->iRefCount = 0;
+			pEntry->pSynth    = NULL;
+			pEntry->iSFID     = -1;
+			pEntry->pHeader   = NULL;
+			pEntry->bHeader   = false;
+			pEntry->iPrefetch = 0;
+			m_entries.insert(sKey, pEntry);
+		}
+	#ifdef CONFIG_DEBUG
+		else fprintf(stderr, "qsynthSoundFontCache::acquire(\"%s\"): shared (refcount=%d)\n",
+			pEntry->name.constData(), pEntry->iRefCount + 1);
+	#endif
+		++(pEntry->iRefCount);
+	}
+
+	// Lazy modes: just parse the preset headers for now...
+	if (loadMode != LoadEager && pEntry->pSoundFont.loadAcquire() == NULL) {
+		QMutexLocker locker(&pEntry->mutex);
+		if (!pEntry->bHeader) {
+			pEntry->bHeader = true;
+			// Preset headers from the metadata cache, if fresh...
+			qsynthSoundFontMeta *pSoundFontMeta = qsynthSoundFontMeta::getInstance();
+			qsynthSoundFontHeader *pHeader = new qsynthSoundFontHeader();
+			if (pSoundFontMeta ? pSoundFontMeta->lookup(sFilename, *pHeader)
+				: pHeader->open(sFilename))
+				pEntry->pHeader = pHeader;
+			else
+				delete pHeader;
+		}
+	}
+
+	// Eager mode (or no headers): have it loaded the default way...
+	if (loadMode == LoadEager || pEntry->pHeader == NULL) {
+		if (realize(pEntry) == NULL) {
+			release(pEntry);
+			return NULL;
+		}
+	}
+
+	return pEntry;
+}
+
+
+// Release a shared entry reference (any thread).
+void qsynthSoundFontCache::release ( Entry *pEntry )
+{
+	QMutexLocker locker(&m_mutex);
+
+	--(pEntry->iRefCount);
+
+	cleanup_locked(pEntry);
+}
+
+
+// Realize an entry (any thread); the real soundfont gets loaded once,
+// into its own private synth, though different soundfonts may well get
+// loaded concurrently.
+fluid_sfont_t *qsynthSoundFontCache::realize ( Entry *pEntry )
+{
+	fluid_sfont_t *pRealSoundFont = pEntry->pSoundFont.loadAcquire();
+	if (pRealSoundFont)
+		return pRealSoundFont;
+
+	QMutexLocker locker(&pEntry->mutex);
+
+	pRealSoundFont = pEntry->pSoundFont.load();
+	if (pRealSoundFont == NULL && m_pSettings) {
+	#ifdef CONFIG_DEBUG
+		fprintf(stderr, "qsynthSoundFontCache::realize(\"%s\")\n",
+			pEntry->name.constData());
+	#endif
+		fluid_synth_t *pSynth = ::new_fluid_synth(m_pSettings);
+		if (pSynth == NULL)
+			return NULL;
+		const int iSFID = ::fluid_synth_sfload(
+			pSynth, pEntry->name.constData(), 0);
+		if (iSFID >= 0)
+			pRealSoundFont = ::fluid_synth_get_sfont_by_id(pSynth, iSFID);
+		if (pRealSoundFont) {
+			pEntry->pSynth = pSynth;
+			pEntry->iSFID  = iSFID;
+			pEntry->pSoundFont.storeRelease(pRealSoundFont);
+		} else {
+			::delete_fluid_synth(pSynth);
+		}
+	}
+
+	return pRealSoundFont;
+}
+
+
+// Realize the entry of some engine soundfont proxy in the background
+// (GUI thread), so that neither a preset selection (preload mode) nor
+// its first note-on (lazy mode) will find it still missing; once
+// realized, it stays so for as long as any synth holds it.
+bool qsynthSoundFontCache::prefetch (
+	fluid_sfont_t *pSoundFont, bool *pbFailed )
+{
+#ifdef CONFIG_FLUID_SFLOADER
+
+	if (pSoundFont == NULL || pSoundFont->free != sfont_free)
+		return true;
+
+	qsynth_sfont_proxy *pProxy
+		= static_cast<qsynth_sfont_proxy *> (pSoundFont->data);
+
+	return prefetch(pProxy->pEntry, pbFailed);
+
+#else
+
+	Q_UNUSED(pSoundFont);
+	Q_UNUSED(pbFailed);
+
+	return true;
+
+#endif
+}
+
+
+// Realize an entry in the background (any thread, the MIDI thread
+// included, while the caller holds a reference); only the first call
+// ever takes the cache lock and starts the loading task.
+bool qsynthSoundFontCache::prefetch ( Entry *pEntry, bool *pbFailed )
+{
+	if (pEntry->pSoundFont.loadAcquire())
+		return true;
+
+	// Already on its way (or failed)?
+	if (!pEntry->iPrefetch.testAndSetOrdered(0, 1)) {
+		if (pbFailed && pEntry->iPrefetch.loadAcquire() == 2)
+			*pbFailed = true;
+		return false;
+	}
+
+	// Hold on to it, while loading...
+	{
+		QMutexLocker locker(&m_mutex);
+		++(pEntry->iRefCount);
+	}
+
+	m_threadPool.start(new PrefetchTask(this, pEntry));
+
+	return false;
+}
+
+
+// Free an unreferenced entry, while already locked; the real soundfont
+// gets unloaded from its private synth, which frees it right away or
+// else later on, as soon as none of its samples is playing (on any
+// engine synth) anymore.
+void qsynthSoundFontCache::cleanup_locked ( Entry *pEntry )
+{
+	if (pEntry->iRefCount > 0)
+		return;
+
+	if (pEntry->pSynth) {
+		::fluid_synth_sfunload(pEntry->pSynth, pEntry->iSFID, 0);
+		::delete_fluid_synth(pEntry->pSynth);
+	}
+
+	m_entries.remove(pEntry->sKey);
+	delete pEntry->pHeader;
+	delete pEntry;
+}
+
+
+#ifdef CONFIG_FLUID_SFLOADER
+
+
+// Loader callback: hand out a new proxy over a shared soundfont.
+fluid_sfont_t *qsynthSoundFontCache::load (
+	const char *pszFilename, LoadMode loadMode )
+{
+	Entry *pEntry = acquire(QString::fromLocal8Bit(pszFilename), loadMode);
+	if (pEntry == NULL)
+		return NULL;
+
+	qsynth_sfont_proxy *pProxy = new qsynth_sfont_proxy;
+	pProxy->pCache      = this;
+	pProxy->pEntry      = pEntry;
+	pProxy->loadMode    = loadMode;
+	pProxy->bIterReal   = false;
+	pProxy->iIterPreset = 0;
+
+	fluid_sfont_t *pSoundFont = new fluid_sfont_t;
+	pSoundFont->data            = (void *) pProxy;
+	pSoundFont->id              = 0;
+	pSoundFont->free            = sfont_free;
+	pSoundFont->get_name        = sfont_get_name;
+	pSoundFont->get_preset      = sfont_get_preset;
+	pSoundFont->iteration_start = sfont_iteration_start;
+	pSoundFont->iteration_next  = sfont_iteration_next;
+
+	return pSoundFont;
+}
+
+
+// Proxy callback: release a proxy and its shared soundfont reference.
+int qsynthSoundFontCache::release ( fluid_sfont_t *pSoundFont )
+{
+	qsynth_sfont_proxy *pProxy
+		= static_cast<qsynth_sfont_proxy *> (pSoundFont->data);
+
+	QMutexLocker locker(&m_mutex);
+
+	Entry *pEntry = pProxy->pEntry;
+	--(pEntry->iRefCount);
+
+	cleanup_locked(pEntry);
+
+	delete pProxy;
+	delete pSoundFont;
+
+	return 0;
+}
+
+#endif	// CONFIG_FLUID_SFLOADER
+
+
+// Memory accounting.
+int qsynthSoundFontCache::fileCount (void) const
+{
+	QMutexLocker locker(&m_mutex);
+
+	return m_entries.count();
+}
+
+
+int qsynthSoundFontCache::lazyCount (void) const
+{
+	QMutexLocker locker(&m_mutex);
+
+	int iLazyCount = 0;
+	QHash<QString, Entry *>::ConstIterator iter = m_entries.constBegin();
+	for ( ; iter != m_entries.constEnd(); ++iter) {
+		if (iter.value()->pSoundFont.load() == NULL)
+			++iLazyCount;
+	}
+
+	return iLazyCount;
+}
+
+
+int qsynthSoundFontCache::refCount (void) const
+{
+	QMutexLocker locker(&m_mutex);
+
+	int iRefCount = 0;
+	QHash<QString, Entry *>::ConstIterator iter = m_entries.constBegin();
+	for ( ; iter != m_entries.constEnd(); ++iter)
+		iRefCount += iter.value()->iRefCount;
+
+	return iRefCount;
+}
+
+
+qint64 qsynthSoundFontCache::memoryUsage (void) const
+{
+	QMutexLocker locker(&m_mutex);
+
+	qint64 iMemoryUsage = 0;
+	QHash<QString, Entry *>::ConstIterator iter = m_entries.constBegin();
+	for ( ; iter != m_entries.constEnd(); ++iter) {
+		const Entry *pEntry = iter.value();
+		if (pEntry->pSoundFont.load())
+			iMemoryUsage += pEntry->iSize;
+	}
+
+	return iMemoryUsage;
+}
+
+
+qint64 qsynthSoundFontCache::memorySaved (void) const
+{
+	QMutexLocker locker(&m_mutex);
+
+	qint64 iMemorySaved = 0;
+	QHash<QString, Entry *>::ConstIterator iter = m_entries.constBegin();
+	for ( ; iter != m_entries.constEnd(); ++iter) {
+		const Entry *pEntry = iter.value();
+		if (pEntry->pSoundFont.load() && pEntry->iRefCount > 1)
+			iMemorySaved += pEntry->iSize * (pEntry->iRefCount - 1);
+	}
+
+	return iMemorySaved;
+}
+
+
+#ifdef CONFIG_FLUID_SFLOADER
+
+//-------------------------------------------------------------------------
+// Static loader callback trampolines.
+
+int qsynthSoundFontCache::sfloader_free ( fluid_sfloader_t *pLoader )
+{
+	delete static_cast<qsynth_sfloader_data *> (pLoader->data);
+	delete pLoader;
+	return 0;
+}
+
+
+fluid_sfont_t *qsynthSoundFontCache::sfloader_load (
+	fluid_sfloader_t *pLoader, const char *pszFilename )
+{
+	qsynth_sfloader_data *pData
+		= static_cast<qsynth_sfloader_data *> (pLoader->data);
+	return pData->pCache->load(pszFilename, pData->loadMode);
+}
+
+
+//-------------------------------------------------------------------------
+// Static proxy soundfont callback trampolines.
+
+int qsynthSoundFontCache::sfont_free ( fluid_sfont_t *pSoundFont )
+{
+	qsynth_sfont_proxy *pProxy
+		= static_cast<qsynth_sfont_proxy *> (pSoundFont->data);
+	return pProxy->pCache->release(pSoundFont);
+}
+
+
+char *qsynthSoundFontCache::sfont_get_name ( fluid_sfont_t *pSoundFont )
+{
+	qsynth_sfont_proxy *pProxy
+		= static_cast<qsynth_sfont_proxy *> (pSoundFont->data);
+	return const_cast<char *> (pProxy->pEntry->name.constData());
+}
+
+
+// Presets must refer to the proxy, as synths track soundfonts by pointer.
+fluid_preset_t *qsynthSoundFontCache::sfont_get_preset (
+	fluid_sfont_t *pSoundFont, unsigned int bank, unsigned int prenum )
+{
+	qsynth_sfont_proxy *pProxy
+		= static_cast<qsynth_sfont_proxy *> (pSoundFont->data);
+	Entry *pEntry = pProxy->pEntry;
+
+	// Not realized yet? Never load it here, as this is called on
+	// program changes (MIDI thread, synth locked): hand out a lazy
+	// preset instead, which stays silent until the real one is in...
+	fluid_sfont_t *pRealSoundFont = pEntry->pSoundFont.loadAcquire();
+	if (pRealSoundFont == NULL) {
+		// No headers means it was realized on load (or failed to).
+		const qsynthSoundFontHeader *pHeader = pEntry->pHeader;
+		if (pHeader == NULL)
+			return NULL;
+		const int iPreset = pHeader->findPreset(bank, prenum);
+		if (iPreset < 0)
+			return NULL;
+		// Preload mode: have it loaded in the background, on selection;
+		// lazy mode: only on the first note-on...
+		if (pProxy->loadMode == LoadPreload)
+			pProxy->pCache->prefetch(pEntry);
+		qsynth_preset_proxy *pPresetProxy = new qsynth_preset_proxy;
+		pPresetProxy->pCache        = pProxy->pCache;
+		pPresetProxy->pEntry        = pEntry;
+		pPresetProxy->pHeaderPreset = &pHeader->preset(iPreset);
+		pPresetProxy->pRealPreset   = NULL;
+		fluid_preset_t *pPreset = new fluid_preset_t;
+		pPreset->data        = (void *) pPresetProxy;
+		pPreset->sfont       = pSoundFont;
+		pPreset->free        = preset_free;
+		pPreset->get_name    = preset_get_name;
+		pPreset->get_banknum = preset_get_banknum;
+		pPreset->get_num     = preset_get_num;
+		pPreset->noteon      = preset_noteon;
+		pPreset->notify      = preset_notify;
+		return pPreset;
+	}
+
+	fluid_preset_t *pPreset
+		= (*pRealSoundFont->get_preset)(pRealSoundFont, bank, prenum);
+	if (pPreset)
+		pPreset->sfont = pSoundFont;
+	return pPreset;
+}
+
+
+void qsynthSoundFontCache::sfont_iteration_start ( fluid_sfont_t *pSoundFont )
+{
+	qsynth_sfont_proxy *pProxy
+		= static_cast<qsynth_sfont_proxy *> (pSoundFont->data);
+
+	fluid_sfont_t *pRealSoundFont = pProxy->pEntry->pSoundFont.loadAcquire();
+	pProxy->bIterReal   = (pRealSoundFont != NULL);
+	pProxy->iIterPreset = 0;
+
+	if (pRealSoundFont)
+		(*pRealSoundFont->iteration_start)(pRealSoundFont);
+}
+
+
+int qsynthSoundFontCache::sfont_iteration_next (
+	fluid_sfont_t *pSoundFont, fluid_preset_t *pPreset )
+{
+	qsynth_sfont_proxy *pProxy
+		= static_cast<qsynth_sfont_proxy *> (pSoundFont->data);
+	Entry *pEntry = pProxy->pEntry;
+
+	if (pProxy->bIterReal) {
+		fluid_sfont_t *pRealSoundFont = pEntry->pSoundFont.loadAcquire();
+		const int iResult
+			= (*pRealSoundFont->iteration_next)(pRealSoundFont, pPreset);
+		if (iResult)
+			pPreset->sfont = pSoundFont;
+		return iResult;
+	}
+
+	// Iterate over the preset headers only...
+	const qsynthSoundFontHeader *pHeader = pEntry->pHeader;
+	if (pHeader == NULL || pProxy->iIterPreset >= pHeader->presetCount())
+		return 0;
+
+	const qsynthSoundFontHeader::Preset& preset
+		= pHeader->preset(pProxy->iIterPreset++);
+	pPreset->data        = (void *) &preset;
+	pPreset->sfont       = pSoundFont;
+	pPreset->free        = header_preset_free;
+	pPreset->get_name    = header_preset_get_name;
+	pPreset->get_banknum = header_preset_get_banknum;
+	pPreset->get_num     = header_preset_get_num;
+	pPreset->noteon      = header_preset_noteon;
+	pPreset->notify      = NULL;
+
+	return 1;
+}
+
+
+//-------------------------------------------------------------------------
+// Static lazy preset callback trampolines.
+
+int qsynthSoundFontCache::preset_free ( fluid_preset_t *pPreset )
+{
+	qsynth_preset_proxy *pPresetProxy
+		= static_cast<qsynth_preset_proxy *> (pPreset->data);
+	fluid_preset_t *pRealPreset = pPresetProxy->pRealPreset.load();
+	if (pRealPreset && pRealPreset->free)
+		(*pRealPreset->free)(pRealPreset);
+	delete pPresetProxy;
+	delete pPreset;
+	return 0;
+}
+
+
+char *qsynthSoundFontCache::preset_get_name ( fluid_preset_t *pPreset )
+{
+	qsynth_preset_proxy *pPresetProxy
+		= static_cast<qsynth_preset_proxy *> (pPreset->data);
+	return const_cast<char *> (pPresetProxy->pHeaderPreset->name);
+}
+
+
+int qsynthSoundFontCache::preset_get_banknum ( fluid_preset_t *pPreset )
+{
+	qsynth_preset_proxy *pPresetProxy
+		= static_cast<qsynth_preset_proxy *> (pPreset->data);
+	return pPresetProxy->pHeaderPreset->bank;
+}
+
+
+int qsynthSoundFontCache::preset_get_num ( fluid_preset_t *pPreset )
+{
+	qsynth_preset_proxy *pPresetProxy
+		= static_cast<qsynth_preset_proxy *> (pPreset->data);
+	return pPresetProxy->pHeaderPreset->prog;
+}
+
+
+// Note-on on a lazy preset (MIDI thread, synth locked): never loads
+// anything here; while the real soundfont isn't resident yet, the note
+// is just dropped and the soundfont gets loaded in the background,
+// the real preset being swapped in on the first note-on after that.
+int qsynthSoundFontCache::preset_noteon ( fluid_preset_t *pPreset,
+	fluid_synth_t *pSynth, int chan, int key, int vel )
+{
+	qsynth_preset_proxy *pPresetProxy
+		= static_cast<qsynth_preset_proxy *> (pPreset->data);
+
+	fluid_preset_t *pRealPreset = pPresetProxy->pRealPreset.loadAcquire();
+	if (pRealPreset == NULL) {
+		Entry *pEntry = pPresetProxy->pEntry;
+		fluid_sfont_t *pRealSoundFont = pEntry->pSoundFont.loadAcquire();
+		if (pRealSoundFont == NULL) {
+			pPresetProxy->pCache->prefetch(pEntry);
+			return FLUID_OK;
+		}
+		pRealPreset = (*pRealSoundFont->get_preset)(pRealSoundFont,
+			pPresetProxy->pHeaderPreset->bank,
+			pPresetProxy->pHeaderPreset->prog);
+		if (pRealPreset == NULL)
+			return FLUID_FAILED;
+		pRealPreset->sfont = pPreset->sfont;
+		pPresetProxy->pRealPreset.storeRelease(pRealPreset);
+	}
+
+	return (*pRealPreset->noteon)(pRealPreset, pSynth, chan, key, vel);
+}
+
+
+int qsynthSoundFontCache::preset_notify (
+	fluid_preset_t *pPreset, int reason, int chan )
+{
+	qsynth_preset_proxy *pPresetProxy
+		= static_cast<qsynth_preset_proxy *> (pPreset->data);
+
+	fluid_preset_t *pRealPreset = pPresetProxy->pRealPreset.loadAcquire();
+	if (pRealPreset && pRealPreset->notify)
+		return (*pRealPreset->notify)(pRealPreset, reason, chan);
+
+	return FLUID_OK;
+}
+
+
+//-------------------------------------------------------------------------
+// Static header-only (iteration) preset callback trampolines.
+
+int qsynthSoundFontCache::header_preset_free ( fluid_preset_t * )
+{
+	// Caller owned; nothing to free.
+	return 0;
+}
+
+
+char *qsynthSoundFontCache::header_preset_get_name ( fluid_preset_t *pPreset )
+{
+	const qsynthSoundFontHeader::Preset *pHeaderPreset
+		= static_cast<const qsynthSoundFontHeader::Preset *> (pPreset->data);
+	return const_cast<char *> (pHeaderPreset->name);
+}
+
+
+int qsynthSoundFontCache::header_preset_get_banknum ( fluid_preset_t *pPreset )
+{
+	const qsynthSoundFontHeader::Preset *pHeaderPreset
+		= static_cast<const qsynthSoundFontHeader::Preset *> (pPreset->data);
+	return pHeaderPreset->bank;
+}
+
+
+int qsynthSoundFontCache::header_preset_get_num ( fluid_preset_t *pPreset )
+{
+	const qsynthSoundFontHeader::Preset *pHeaderPreset
+		= static_cast<const qsynthSoundFontHeader::Preset *> (pPreset->data);
+	return pHeaderPreset->prog;
+}
+
+
+int qsynthSoundFontCache::header_preset_noteon ( fluid_preset_t *,
+	fluid_synth_t *, int, int, int )
+{
+	// Not playable; header-only presets are for browsing.
+	return FLUID_FAILED;
+}
+
+#endif	// CONFIG_FLUID_SFLOADER
+
+
+// end of qsynthSoundFontCache.cpp
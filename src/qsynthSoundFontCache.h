@@ -0,0 +1,203 @@
+// qsynthSoundFontCache.h
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qsynthSoundFontCache_h
+#define __qsynthSoundFontCache_h
+
+#include "qsynthAbout.h"
+
+#include "qsynthAtomic.h"
+
+#include <fluidsynth.h>
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+
+// Forward declarations.
+class qsynthSoundFontHeader;
+
+
+//-------------------------------------------------------------------------
+// qsynthSoundFontCache - Process-wide shared soundfont cache.
+//
+// Each engine synth gets its own loader (see createLoader()) which hands
+// out lightweight proxy fluid_sfont_t instances over one single real
+// soundfont per file, keyed by canonical path, inode and modification
+// time. The real soundfont gets loaded into a private synth of its own,
+// through the public API, and is only unloaded when the last proxy goes
+// away; that synth then frees it once none of its samples is playing.
+//
+// Proxies need the public soundfont loader structs (fluidsynth 1.1.x,
+// CONFIG_FLUID_SFLOADER); without them, there's no loader to create and
+// engines just load their soundfonts the default way.
+//
+// On lazy load modes, only the memory-mapped preset headers are parsed
+// at first; the real soundfont (and all its sample data) only gets
+// loaded, in the background, when one of its presets is actually played
+// (LoadLazy) or selected on some channel (LoadPreload). The MIDI thread
+// never waits for it: notes are dropped until it is resident, unless it
+// was prefetched ahead (see prefetch()).
+//
+// Entries may be acquired and realized from any thread, so that engine
+// soundfonts can be loaded ahead on the cache thread pool (see also
+// qsynthSoundFontLoader); the same file is only ever loaded once.
+
+class qsynthSoundFontCache
+{
+public:
+
+	// Constructor.
+	qsynthSoundFontCache();
+	// Destructor.
+	~qsynthSoundFontCache();
+
+	// Kind of singleton reference.
+	static qsynthSoundFontCache *getInstance();
+
+	// Sample data load modes.
+	enum LoadMode { LoadEager = 0, LoadLazy = 1, LoadPreload = 2 };
+
+	// Create a new loader, to be added to an engine synth
+	// (ownership is passed on to fluid_synth_add_sfloader).
+	fluid_sfloader_t *createLoader(LoadMode loadMode = LoadEager);
+
+	// Background loading thread pool.
+	QThreadPool *threadPool();
+
+	// Memory accounting (GUI thread, though thread-safe).
+	int    fileCount() const;
+	int    lazyCount() const;
+	int    refCount() const;
+	qint64 memoryUsage() const;
+	qint64 memorySaved() const;
+
+	// Shared cache entry (one per real soundfont).
+	struct Entry
+	{
+		QString        sKey;
+		QString        sPath;
+		QByteArray     name;
+		qint64         iSize;
+		int            iRefCount;
+
+		// Private synth the real soundfont gets loaded into (owner).
+		fluid_synth_t *pSynth;
+		int            iSFID;
+
+		// Preset headers (lazy load modes only).
+		qsynthSoundFontHeader *pHeader;
+		bool           bHeader;
+
+		// The real soundfont (null until realized).
+		qsynthAtomicPointer<fluid_sfont_t> pSoundFont;
+
+		// Realization (loading) lock.
+		QMutex         mutex;
+
+		// Background realization state (0=idle, 1=loading, 2=failed).
+		qsynthAtomicInt     iPrefetch;
+	};
+
+	// Acquire/release a shared entry reference (any thread).
+	Entry *acquire(const QString& sFilename, LoadMode loadMode);
+	void release(Entry *pEntry);
+
+	// Realize a lazy entry (loads the real soundfont, if not yet).
+	fluid_sfont_t *realize(Entry *pEntry);
+
+	// Realize the entry of some engine soundfont proxy in the
+	// background (GUI thread); returns whether it's ready already
+	// (ie. realized, or else not one of our lazy proxies at all);
+	// if not, pbFailed tells whether it failed to load (for good).
+	bool prefetch(fluid_sfont_t *pSoundFont, bool *pbFailed = NULL);
+
+protected:
+
+	// Background realization task.
+	class PrefetchTask;
+
+	// Realize an entry in the background (any thread).
+	bool prefetch(Entry *pEntry, bool *pbFailed = NULL);
+
+	// Free an unreferenced entry, while already locked.
+	void cleanup_locked(Entry *pEntry);
+
+	// Cache key helper.
+	static QString cacheKey(const QString& sPath);
+
+#ifdef CONFIG_FLUID_SFLOADER
+
+	// Loader and proxy callbacks.
+	fluid_sfont_t *load(const char *pszFilename, LoadMode loadMode);
+	int release(fluid_sfont_t *pSoundFont);
+
+	// Static callback trampolines.
+	static int sfloader_free(fluid_sfloader_t *pLoader);
+	static fluid_sfont_t *sfloader_load(
+		fluid_sfloader_t *pLoader, const char *pszFilename);
+
+	static int sfont_free(fluid_sfont_t *pSoundFont);
+	static char *sfont_get_name(fluid_sfont_t *pSoundFont);
+	static fluid_preset_t *sfont_get_preset(
+		fluid_sfont_t *pSoundFont, unsigned int bank, unsigned int prenum);
+	static void sfont_iteration_start(fluid_sfont_t *pSoundFont);
+	static int sfont_iteration_next(
+		fluid_sfont_t *pSoundFont, fluid_preset_t *pPreset);
+
+	static int preset_free(fluid_preset_t *pPreset);
+	static char *preset_get_name(fluid_preset_t *pPreset);
+	static int preset_get_banknum(fluid_preset_t *pPreset);
+	static int preset_get_num(fluid_preset_t *pPreset);
+	static int preset_noteon(fluid_preset_t *pPreset,
+		fluid_synth_t *pSynth, int chan, int key, int vel);
+	static int preset_notify(fluid_preset_t *pPreset, int reason, int chan);
+
+	static int header_preset_free(fluid_preset_t *pPreset);
+	static char *header_preset_get_name(fluid_preset_t *pPreset);
+	static int header_preset_get_banknum(fluid_preset_t *pPreset);
+	static int header_preset_get_num(fluid_preset_t *pPreset);
+	static int header_preset_noteon(fluid_preset_t *pPreset,
+		fluid_synth_t *pSynth, int chan, int key, int vel);
+
+#endif	// CONFIG_FLUID_SFLOADER
+
+private:
+
+	// Instance variables.
+	mutable QMutex         m_mutex;
+
+	fluid_settings_t      *m_pSettings;
+
+	QHash<QString, Entry *> m_entries;
+
+	QThreadPool            m_threadPool;
+
+	static qsynthSoundFontCache *g_pSoundFontCache;
+};
+
+
+#endif  // __qsynthSoundFontCache_h
+
+
+// end of qsynthSoundFontCache.h
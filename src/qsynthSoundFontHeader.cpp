@@ -0,0 +1,303 @@
+// qsynthSoundFontHeader.cpp
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qsynthSoundFontHeader.h"
+
+#include <QFile>
+#include <QDataStream>
+#include <QCryptographicHash>
+
+#include <string.h>
+
+
+// SoundFont 2 preset header record size (phdr).
+#define QSYNTH_SF2_PHDR_SIZE  38
+
+// SoundFont 2 sample header record size (shdr).
+#define QSYNTH_SF2_SHDR_SIZE  46
+
+// Preset lookup key.
+#define QSYNTH_SF2_PRESET_KEY(bank, prog)  (((bank) << 8) | ((prog) & 0xff))
+
+
+//-------------------------------------------------------------------------
+// qsynthSoundFontHeader - SoundFont (SF2/SF3) header/preset table parser.
+//
+
+// Constructor.
+qsynthSoundFontHeader::qsynthSoundFontHeader (void)
+{
+	m_iSampleOffset = 0;
+	m_iSampleSize   = 0;
+	m_iSampleCount  = 0;
+}
+
+
+// Little-endian readers.
+unsigned int qsynthSoundFontHeader::read_u16 ( const uchar *p )
+{
+	return (unsigned int) p[0] | ((unsigned int) p[1] << 8);
+}
+
+unsigned int qsynthSoundFontHeader::read_u32 ( const uchar *p )
+{
+	return (unsigned int) p[0]
+		| ((unsigned int) p[1] << 8)
+		| ((unsigned int) p[2] << 16)
+		| ((unsigned int) p[3] << 24);
+}
+
+
+// Parse a soundfont file.
+bool qsynthSoundFontHeader::open ( const QString& sFilename )
+{
+	m_sFilename = sFilename;
+	m_sName.clear();
+	m_iSampleOffset = 0;
+	m_iSampleSize   = 0;
+	m_iSampleCount  = 0;
+	m_hash.clear();
+	m_presets.clear();
+	m_index.clear();
+
+	QFile file(sFilename);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	const qint64 iSize = file.size();
+	if (iSize < 12)
+		return false;
+
+	// Map it all, but only header pages will get touched...
+	const uchar *pData = file.map(0, iSize);
+	if (pData == NULL)
+		return false;
+
+	const bool bResult = parse(pData, iSize);
+
+	file.unmap(const_cast<uchar *> (pData));
+	file.close();
+
+	return bResult;
+}
+
+
+// Actual parser, over the mapped file contents.
+bool qsynthSoundFontHeader::parse ( const uchar *pData, qint64 iSize )
+{
+	if (::memcmp(pData, "RIFF", 4) || ::memcmp(pData + 8, "sfbk", 4))
+		return false;
+
+	qint64 iEnd = 8 + qint64(read_u32(pData + 4));
+	if (iEnd > iSize)
+		iEnd = iSize;
+
+	bool bPresets = false;
+
+	// All but the sample data chunk contents make for the hash.
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+
+	qint64 iOffset = 12;
+	while (iOffset + 12 <= iEnd) {
+		const uchar *pChunk = pData + iOffset;
+		const qint64 iChunkSize = qint64(read_u32(pChunk + 4));
+		const qint64 iChunkEnd  = iOffset + 8 + iChunkSize;
+		if (iChunkEnd > iEnd)
+			break;
+		if (::memcmp(pChunk, "LIST", 4) == 0) {
+			const uchar *pListType = pChunk + 8;
+			if (::memcmp(pListType, "sdta", 4) == 0)
+				hash.addData((const char *) pChunk, 12);
+			else
+				hash.addData((const char *) pChunk, int(8 + iChunkSize));
+			qint64 iSubOffset = iOffset + 12;
+			while (iSubOffset + 8 <= iChunkEnd) {
+				const uchar *pSub = pData + iSubOffset;
+				const qint64 iSubSize = qint64(read_u32(pSub + 4));
+				if (iSubOffset + 8 + iSubSize > iChunkEnd)
+					break;
+				const uchar *pSubData = pSub + 8;
+				if (::memcmp(pListType, "INFO", 4) == 0
+					&& ::memcmp(pSub, "INAM", 4) == 0) {
+					m_sName = QString::fromLatin1(
+						(const char *) pSubData,
+						int(::strnlen((const char *) pSubData, size_t(iSubSize))));
+				}
+				else
+				if (::memcmp(pListType, "sdta", 4) == 0
+					&& ::memcmp(pSub, "smpl", 4) == 0) {
+					m_iSampleOffset = iSubOffset + 8;
+					m_iSampleSize   = iSubSize;
+				}
+				else
+				if (::memcmp(pListType, "pdta", 4) == 0
+					&& ::memcmp(pSub, "phdr", 4) == 0) {
+					// Last record is the terminal one (EOP).
+					const int iCount = int(iSubSize / QSYNTH_SF2_PHDR_SIZE) - 1;
+					m_presets.reserve(iCount > 0 ? iCount : 0);
+					for (int i = 0; i < iCount; ++i) {
+						const uchar *pRec = pSubData + i * QSYNTH_SF2_PHDR_SIZE;
+						Preset preset;
+						::memcpy(preset.name, pRec, 20);
+						preset.name[20] = '\0';
+						preset.prog = int(read_u16(pRec + 20));
+						preset.bank = int(read_u16(pRec + 22));
+						const int iKey = QSYNTH_SF2_PRESET_KEY(preset.bank, preset.prog);
+						// First one wins, as with the default loader...
+						if (!m_index.contains(iKey))
+							m_index.insert(iKey, m_presets.count());
+						m_presets.append(preset);
+					}
+					bPresets = true;
+				}
+				else
+				if (::memcmp(pListType, "pdta", 4) == 0
+					&& ::memcmp(pSub, "shdr", 4) == 0) {
+					// Last record is the terminal one (EOS).
+					const int iCount = int(iSubSize / QSYNTH_SF2_SHDR_SIZE) - 1;
+					m_iSampleCount = (iCount > 0 ? iCount : 0);
+				}
+				iSubOffset += 8 + iSubSize + (iSubSize & 1);
+			}
+		}
+		iOffset = iChunkEnd + (iChunkSize & 1);
+	}
+
+	if (bPresets)
+		m_hash = hash.result();
+
+	return bPresets;
+}
+
+
+// Header accessors.
+const QString& qsynthSoundFontHeader::filename (void) const
+{
+	return m_sFilename;
+}
+
+const QString& qsynthSoundFontHeader::name (void) const
+{
+	return m_sName;
+}
+
+
+qint64 qsynthSoundFontHeader::sampleOffset (void) const
+{
+	return m_iSampleOffset;
+}
+
+qint64 qsynthSoundFontHeader::sampleSize (void) const
+{
+	return m_iSampleSize;
+}
+
+int qsynthSoundFontHeader::sampleCount (void) const
+{
+	return m_iSampleCount;
+}
+
+
+// Content hash (SHA-1 of all but sample data).
+const QByteArray& qsynthSoundFontHeader::hash (void) const
+{
+	return m_hash;
+}
+
+
+// Preset table accessors.
+int qsynthSoundFontHeader::presetCount (void) const
+{
+	return m_presets.count();
+}
+
+const qsynthSoundFontHeader::Preset& qsynthSoundFontHeader::preset ( int iPreset ) const
+{
+	return m_presets.at(iPreset);
+}
+
+
+// Preset lookup.
+int qsynthSoundFontHeader::findPreset ( int iBank, int iProg ) const
+{
+	return m_index.value(QSYNTH_SF2_PRESET_KEY(iBank, iProg), -1);
+}
+
+
+// Compact serialization.
+void qsynthSoundFontHeader::write ( QDataStream& ds ) const
+{
+	ds << m_sFilename << m_sName
+		<< m_iSampleOffset << m_iSampleSize
+		<< qint32(m_iSampleCount) << m_hash;
+
+	ds << qint32(m_presets.count());
+	QVectorIterator<Preset> iter(m_presets);
+	while (iter.hasNext()) {
+		const Preset& preset = iter.next();
+		ds.writeRawData(preset.name, 20);
+		ds << qint16(preset.bank) << qint16(preset.prog);
+	}
+}
+
+
+// Compact deserialization (rebuilds the lookup index).
+bool qsynthSoundFontHeader::read ( QDataStream& ds )
+{
+	qint32 iSampleCount = 0;
+	qint32 iPresets = 0;
+
+	m_presets.clear();
+	m_index.clear();
+
+	ds >> m_sFilename >> m_sName
+		>> m_iSampleOffset >> m_iSampleSize
+		>> iSampleCount >> m_hash;
+	ds >> iPresets;
+
+	if (ds.status() != QDataStream::Ok || iPresets < 0)
+		return false;
+
+	m_iSampleCount = iSampleCount;
+
+	m_presets.reserve(iPresets);
+	for (int i = 0; i < iPresets; ++i) {
+		Preset preset;
+		qint16 iBank = 0;
+		qint16 iProg = 0;
+		if (ds.readRawData(preset.name, 20) != 20)
+			return false;
+		preset.name[20] = '\0';
+		ds >> iBank >> iProg;
+		preset.bank = quint16(iBank);
+		preset.prog = quint16(iProg);
+		const int iKey = QSYNTH_SF2_PRESET_KEY(preset.bank, preset.prog);
+		// First one wins, as with the default loader...
+		if (!m_index.contains(iKey))
+			m_index.insert(iKey, m_presets.count());
+		m_presets.append(preset);
+	}
+
+	return (ds.status() == QDataStream::Ok);
+}
+
+
+// end of qsynthSoundFontHeader.cpp
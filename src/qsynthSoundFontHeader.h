@@ -0,0 +1,112 @@
+// qsynthSoundFontHeader.h
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qsynthSoundFontHeader_h
+#define __qsynthSoundFontHeader_h
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+
+
+// Forward declarations.
+class QDataStream;
+
+
+//-------------------------------------------------------------------------
+// qsynthSoundFontHeader - SoundFont (SF2/SF3) header/preset table parser.
+//
+// The file is memory-mapped and only the RIFF chunk headers, the INFO
+// list and the preset headers (pdta/phdr) get ever touched; the sample
+// data chunk (sdta/smpl) is located but never read. All but the sample
+// data chunk make for the content hash (see qsynthSoundFontMeta).
+
+class qsynthSoundFontHeader
+{
+public:
+
+	// Constructor.
+	qsynthSoundFontHeader();
+
+	// Parse a soundfont file (false if not a valid soundfont).
+	bool open(const QString& sFilename);
+
+	// Preset header record.
+	struct Preset
+	{
+		char name[21];
+		int  bank;
+		int  prog;
+	};
+
+	// Header accessors.
+	const QString& filename() const;
+	const QString& name() const;
+
+	qint64 sampleOffset() const;
+	qint64 sampleSize() const;
+	int sampleCount() const;
+
+	// Content hash (SHA-1 of all but sample data).
+	const QByteArray& hash() const;
+
+	// Preset table accessors.
+	int presetCount() const;
+	const Preset& preset(int iPreset) const;
+
+	// Preset lookup (index or -1 if not found).
+	int findPreset(int iBank, int iProg) const;
+
+	// Compact (de)serialization (see qsynthSoundFontMeta).
+	void write(QDataStream& ds) const;
+	bool read(QDataStream& ds);
+
+protected:
+
+	// Actual parser, over the mapped file contents.
+	bool parse(const uchar *pData, qint64 iSize);
+
+	// Little-endian readers.
+	static unsigned int read_u16(const uchar *p);
+	static unsigned int read_u32(const uchar *p);
+
+private:
+
+	// Instance variables.
+	QString m_sFilename;
+	QString m_sName;
+
+	qint64  m_iSampleOffset;
+	qint64  m_iSampleSize;
+	int     m_iSampleCount;
+
+	QByteArray m_hash;
+
+	QVector<Preset>  m_presets;
+	QHash<int, int>  m_index;
+};
+
+
+#endif  // __qsynthSoundFontHeader_h
+
+
+// end of qsynthSoundFontHeader.h
@@ -0,0 +1,211 @@
+// qsynthSoundFontLoader.cpp
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qsynthSoundFontLoader.h"
+#include "qsynthSoundFontMeta.h"
+
+#include <QRunnable>
+
+#include <fluidsynth.h>
+
+
+//-------------------------------------------------------------------------
+// qsynthSoundFontLoader::Task - Worker thread task.
+//
+
+class qsynthSoundFontLoader::Task : public QRunnable
+{
+public:
+
+	// Constructor.
+	Task(qsynthSoundFontLoader *pLoader, int iFile)
+		: m_pLoader(pLoader), m_iFile(iFile) {}
+
+	// Task runner.
+	void run() { m_pLoader->run(m_iFile); }
+
+private:
+
+	// Instance variables.
+	qsynthSoundFontLoader *m_pLoader;
+	int m_iFile;
+};
+
+
+//-------------------------------------------------------------------------
+// qsynthSoundFontLoader - Engine soundfont background loader.
+//
+
+// Constructor.
+qsynthSoundFontLoader::qsynthSoundFontLoader ( qsynthEngine *pEngine,
+	const QStringList& files, qsynthSoundFontCache::LoadMode loadMode )
+	: QObject(NULL), m_pEngine(pEngine), m_loadMode(loadMode)
+{
+	QStringListIterator iter(files);
+	while (iter.hasNext()) {
+		File *pFile = new File;
+		pFile->sFilename = iter.next();
+		pFile->iState    = Pending;
+		pFile->pEntry    = NULL;
+		m_files.append(pFile);
+	}
+}
+
+
+// Destructor.
+qsynthSoundFontLoader::~qsynthSoundFontLoader (void)
+{
+	release();
+
+	qDeleteAll(m_files);
+	m_files.clear();
+}
+
+
+// Engine accessors (null when detached).
+qsynthEngine *qsynthSoundFontLoader::engine (void) const
+{
+	return m_pEngine;
+}
+
+void qsynthSoundFontLoader::setEngine ( qsynthEngine *pEngine )
+{
+	m_pEngine = pEngine;
+}
+
+
+// Start loading (GUI thread).
+void qsynthSoundFontLoader::start (void)
+{
+	qsynthSoundFontCache *pCache = qsynthSoundFontCache::getInstance();
+
+	const int iFileCount = m_files.count();
+	m_iRunning = iFileCount;
+
+	if (pCache == NULL || iFileCount < 1) {
+		for (int iFile = 0; iFile < iFileCount; ++iFile)
+			m_files.at(iFile)->iState = Cancelled;
+		m_iRunning = 0;
+		emit finished();
+		return;
+	}
+
+	for (int iFile = 0; iFile < iFileCount; ++iFile)
+		pCache->threadPool()->start(new Task(this, iFile));
+}
+
+
+// Cancel pending files (files already loading will finish anyway).
+void qsynthSoundFontLoader::cancel (void)
+{
+	m_iCancel = 1;
+}
+
+bool qsynthSoundFontLoader::isCancelled (void) const
+{
+	return (m_iCancel.load() > 0);
+}
+
+
+// Whether all files are done with.
+bool qsynthSoundFontLoader::isFinished (void) const
+{
+	return (m_iRunning.loadAcquire() < 1);
+}
+
+
+// File list accessors.
+int qsynthSoundFontLoader::fileCount (void) const
+{
+	return m_files.count();
+}
+
+const QString& qsynthSoundFontLoader::filename ( int iFile ) const
+{
+	return m_files.at(iFile)->sFilename;
+}
+
+qsynthSoundFontLoader::State qsynthSoundFontLoader::state ( int iFile ) const
+{
+	return State(m_files.at(iFile)->iState.loadAcquire());
+}
+
+
+// Number of files done with (loaded, failed or cancelled).
+int qsynthSoundFontLoader::doneCount (void) const
+{
+	int iDoneCount = 0;
+
+	QListIterator<File *> iter(m_files);
+	while (iter.hasNext()) {
+		if (iter.next()->iState.loadAcquire() > Loading)
+			++iDoneCount;
+	}
+
+	return iDoneCount;
+}
+
+
+// Release all acquired cache references (GUI thread).
+void qsynthSoundFontLoader::release (void)
+{
+	if (!isFinished())
+		return;
+
+	qsynthSoundFontCache *pCache = qsynthSoundFontCache::getInstance();
+	if (pCache == NULL)
+		return;
+
+	QListIterator<File *> iter(m_files);
+	while (iter.hasNext()) {
+		File *pFile = iter.next();
+		if (pFile->pEntry) {
+			pCache->release(pFile->pEntry);
+			pFile->pEntry = NULL;
+		}
+	}
+}
+
+
+// Actual file loading (worker thread).
+void qsynthSoundFontLoader::run ( int iFile )
+{
+	File *pFile = m_files.at(iFile);
+
+	qsynthSoundFontCache *pCache = qsynthSoundFontCache::getInstance();
+	if (pCache == NULL || isCancelled()) {
+		pFile->iState.storeRelease(Cancelled);
+	} else {
+		pFile->iState.storeRelease(Loading);
+		emit fileStarted(iFile);
+		if (qsynthSoundFontMeta::isSoundFont(pFile->sFilename))
+			pFile->pEntry = pCache->acquire(pFile->sFilename, m_loadMode);
+		pFile->iState.storeRelease(pFile->pEntry ? Loaded : Failed);
+	}
+
+	emit fileFinished(iFile);
+
+	if (!m_iRunning.deref())
+		emit finished();
+}
+
+
+// end of qsynthSoundFontLoader.cpp
@@ -0,0 +1,122 @@
+// qsynthSoundFontLoader.h
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qsynthSoundFontLoader_h
+#define __qsynthSoundFontLoader_h
+
+#include "qsynthSoundFontCache.h"
+#include "qsynthAtomic.h"
+
+#include <QObject>
+#include <QStringList>
+#include <QList>
+
+// Forward declarations.
+class qsynthEngine;
+
+
+//-------------------------------------------------------------------------
+// qsynthSoundFontLoader - Engine soundfont background loader.
+//
+// Gets all engine soundfont files acquired into the shared cache, in
+// parallel, on the cache thread pool; the engine synth may then have
+// them all loaded right away, as they're already there to be shared.
+
+class qsynthSoundFontLoader : public QObject
+{
+	Q_OBJECT
+
+public:
+
+	// Constructor.
+	qsynthSoundFontLoader(qsynthEngine *pEngine,
+		const QStringList& files, qsynthSoundFontCache::LoadMode loadMode);
+	// Destructor.
+	~qsynthSoundFontLoader();
+
+	// File loading states.
+	enum State { Pending = 0, Loading, Loaded, Failed, Cancelled };
+
+	// Engine accessors (null when detached).
+	qsynthEngine *engine() const;
+	void setEngine(qsynthEngine *pEngine);
+
+	// Start loading (GUI thread).
+	void start();
+
+	// Cancel pending files (files already loading will finish anyway).
+	void cancel();
+	bool isCancelled() const;
+
+	// Whether all files are done with.
+	bool isFinished() const;
+
+	// File list accessors.
+	int fileCount() const;
+	const QString& filename(int iFile) const;
+	State state(int iFile) const;
+
+	// Number of files done with (loaded, failed or cancelled).
+	int doneCount() const;
+
+	// Release all acquired cache references (GUI thread).
+	void release();
+
+signals:
+
+	// Progress signals (emitted from the worker threads).
+	void fileStarted(int iFile);
+	void fileFinished(int iFile);
+	void finished();
+
+protected:
+
+	// Worker thread task.
+	class Task;
+
+	// Actual file loading (worker thread).
+	void run(int iFile);
+
+private:
+
+	// Instance variables.
+	qsynthEngine *m_pEngine;
+
+	qsynthSoundFontCache::LoadMode m_loadMode;
+
+	struct File
+	{
+		QString     sFilename;
+		qsynthAtomicInt  iState;
+		qsynthSoundFontCache::Entry *pEntry;
+	};
+
+	QList<File *> m_files;
+
+	qsynthAtomicInt m_iCancel;
+	qsynthAtomicInt m_iRunning;
+};
+
+
+#endif  // __qsynthSoundFontLoader_h
+
+
+// end of qsynthSoundFontLoader.h
@@ -0,0 +1,272 @@
+// qsynthSoundFontMeta.cpp
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qsynthAbout.h"
+#include "qsynthSoundFontMeta.h"
+
+#include <fluidsynth.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QDir>
+
+#if QT_VERSION >= 0x050000
+#include <QStandardPaths>
+#endif
+
+#ifdef CONFIG_DEBUG
+#include <stdio.h>
+#endif
+
+
+// Cache file magic and format version.
+#define QSYNTH_SFMETA_MAGIC    0x5153464d   // "QSFM"
+#define QSYNTH_SFMETA_VERSION  1
+
+
+//-------------------------------------------------------------------------
+// qsynthSoundFontMeta - Persistent soundfont metadata cache.
+//
+
+// Kind of singleton reference.
+qsynthSoundFontMeta *qsynthSoundFontMeta::g_pSoundFontMeta = NULL;
+
+
+// Constructor (loads the cache file).
+qsynthSoundFontMeta::qsynthSoundFontMeta (void)
+{
+	m_bDirty = false;
+
+#if QT_VERSION >= 0x050000
+	const QString& sCacheDir = QStandardPaths::writableLocation(
+		QStandardPaths::GenericCacheLocation);
+#else
+	const QString& sCacheDir = QDir::homePath() + "/.cache";
+#endif
+	if (!sCacheDir.isEmpty()) {
+		m_sFilename = sCacheDir + '/' + QSYNTH_DOMAIN
+			+ '/' + QSYNTH_TITLE ".sfmeta";
+	}
+
+	load();
+
+	// Pseudo-singleton reference setup.
+	g_pSoundFontMeta = this;
+}
+
+
+// Destructor (saves the cache file, if changed).
+qsynthSoundFontMeta::~qsynthSoundFontMeta (void)
+{
+	// Pseudo-singleton reference shut-down.
+	g_pSoundFontMeta = NULL;
+
+	if (m_bDirty)
+		save();
+}
+
+
+// Kind of singleton reference.
+qsynthSoundFontMeta *qsynthSoundFontMeta::getInstance (void)
+{
+	return g_pSoundFontMeta;
+}
+
+
+// Header lookup, parsing the file only if new or stale.
+bool qsynthSoundFontMeta::lookup (
+	const QString& sFilename, qsynthSoundFontHeader& header )
+{
+	const QFileInfo info(sFilename);
+	if (!info.isFile())
+		return false;
+
+	const QString& sKey = info.canonicalFilePath();
+	const qint64 iSize = info.size();
+#if QT_VERSION >= 0x040700
+	const qint64 iModified = info.lastModified().toMSecsSinceEpoch();
+#else
+	const qint64 iModified = qint64(info.lastModified().toTime_t()) * 1000;
+#endif
+
+	QByteArray hash;
+	{
+		QMutexLocker locker(&m_mutex);
+		QHash<QString, Entry>::ConstIterator iter = m_entries.constFind(sKey);
+		if (iter != m_entries.constEnd()) {
+			const Entry& entry = iter.value();
+			if (entry.iSize == iSize && entry.iModified == iModified) {
+				header = entry.header;
+				return true;
+			}
+			// Stale entry, to be revalidated...
+			hash = entry.header.hash();
+		}
+	}
+
+	// New or stale entry: parse it all over again (unlocked)...
+	if (!header.open(sFilename)) {
+		QMutexLocker locker(&m_mutex);
+		if (m_entries.remove(sKey) > 0)
+			m_bDirty = true;
+		return false;
+	}
+
+#ifdef CONFIG_DEBUG
+	fprintf(stderr, "qsynthSoundFontMeta::lookup(\"%s\"): %s\n",
+		sFilename.toLocal8Bit().constData(), hash.isEmpty() ? "new"
+			: (hash == header.hash() ? "revalidated" : "changed"));
+#endif
+
+	QMutexLocker locker(&m_mutex);
+	Entry& entry = m_entries[sKey];
+	// Same content hash? keep the cached entry, just re-stamped...
+	if (!hash.isEmpty() && hash == header.hash()
+		&& entry.header.hash() == hash)
+		header = entry.header;
+	else
+		entry.header = header;
+	entry.iSize     = iSize;
+	entry.iModified = iModified;
+	m_bDirty = true;
+
+	return true;
+}
+
+
+// Soundfont file validation, as fluid_is_soundfont() but
+// from the cache whenever possible.
+bool qsynthSoundFontMeta::isSoundFont ( const QString& sFilename )
+{
+	qsynthSoundFontMeta *pSoundFontMeta = getInstance();
+	if (pSoundFontMeta) {
+		qsynthSoundFontHeader header;
+		if (pSoundFontMeta->lookup(sFilename, header))
+			return true;
+	}
+
+	// Not parsed our way, leave it to fluidsynth...
+	return ::fluid_is_soundfont(sFilename.toLocal8Bit().data());
+}
+
+
+// Cache file persistence.
+bool qsynthSoundFontMeta::load (void)
+{
+	if (m_sFilename.isEmpty())
+		return false;
+
+	QFile file(m_sFilename);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream ds(&file);
+	ds.setVersion(QDataStream::Qt_4_6);
+
+	quint32 iMagic = 0;
+	quint32 iVersion = 0;
+	qint32  iEntries = 0;
+	ds >> iMagic >> iVersion >> iEntries;
+	if (iMagic != QSYNTH_SFMETA_MAGIC
+		|| iVersion != QSYNTH_SFMETA_VERSION
+		|| iEntries < 0)
+		return false;
+
+	QMutexLocker locker(&m_mutex);
+
+	m_entries.clear();
+
+	for (int i = 0; i < iEntries; ++i) {
+		QString sKey;
+		Entry entry;
+		ds >> sKey >> entry.iSize >> entry.iModified;
+		if (ds.status() != QDataStream::Ok || !entry.header.read(ds))
+			break;
+		m_entries.insert(sKey, entry);
+	}
+
+	m_bDirty = false;
+
+#ifdef CONFIG_DEBUG
+	fprintf(stderr, "qsynthSoundFontMeta::load(\"%s\"): %d entries.\n",
+		m_sFilename.toLocal8Bit().constData(), m_entries.count());
+#endif
+
+	return true;
+}
+
+
+bool qsynthSoundFontMeta::save (void)
+{
+	if (m_sFilename.isEmpty())
+		return false;
+
+	QDir().mkpath(QFileInfo(m_sFilename).absolutePath());
+
+	// Write it aside, then replace the old one...
+	const QString sTempname = m_sFilename + ".tmp";
+	QFile file(sTempname);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	QDataStream ds(&file);
+	ds.setVersion(QDataStream::Qt_4_6);
+
+	QMutexLocker locker(&m_mutex);
+
+	ds << quint32(QSYNTH_SFMETA_MAGIC)
+		<< quint32(QSYNTH_SFMETA_VERSION)
+		<< qint32(m_entries.count());
+
+	QHash<QString, Entry>::ConstIterator iter = m_entries.constBegin();
+	for ( ; iter != m_entries.constEnd(); ++iter) {
+		const Entry& entry = iter.value();
+		ds << iter.key() << entry.iSize << entry.iModified;
+		entry.header.write(ds);
+	}
+
+	file.close();
+
+	if (ds.status() != QDataStream::Ok) {
+		QFile::remove(sTempname);
+		return false;
+	}
+
+	QFile::remove(m_sFilename);
+	if (!QFile::rename(sTempname, m_sFilename))
+		return false;
+
+	m_bDirty = false;
+
+	return true;
+}
+
+
+// Cache file path.
+const QString& qsynthSoundFontMeta::filename (void) const
+{
+	return m_sFilename;
+}
+
+
+// end of qsynthSoundFontMeta.cpp
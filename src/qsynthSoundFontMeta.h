@@ -0,0 +1,98 @@
+// qsynthSoundFontMeta.h
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qsynthSoundFontMeta_h
+#define __qsynthSoundFontMeta_h
+
+#include "qsynthSoundFontHeader.h"
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+
+
+//-------------------------------------------------------------------------
+// qsynthSoundFontMeta - Persistent soundfont metadata cache.
+//
+// Soundfont headers (name, preset table, sample count and size) are
+// kept on disk across sessions, keyed by canonical path; an entry is
+// taken as is while the file size and modification time still match,
+// otherwise the file is parsed again (lazily, on next lookup) and the
+// entry is kept whenever the content hash turns out the same.
+//
+// Lookups may happen from any thread (eg. soundfont background loading).
+
+class qsynthSoundFontMeta
+{
+public:
+
+	// Constructor (loads the cache file).
+	qsynthSoundFontMeta();
+	// Destructor (saves the cache file, if changed).
+	~qsynthSoundFontMeta();
+
+	// Kind of singleton reference.
+	static qsynthSoundFontMeta *getInstance();
+
+	// Header lookup, parsing the file only if new or stale
+	// (false if not a valid soundfont).
+	bool lookup(const QString& sFilename, qsynthSoundFontHeader& header);
+
+	// Soundfont file validation, as fluid_is_soundfont() but
+	// from the cache whenever possible.
+	static bool isSoundFont(const QString& sFilename);
+
+	// Cache file persistence.
+	bool load();
+	bool save();
+
+	// Cache file path.
+	const QString& filename() const;
+
+protected:
+
+	// Cache entry.
+	struct Entry
+	{
+		qint64 iSize;
+		qint64 iModified;
+		qsynthSoundFontHeader header;
+	};
+
+private:
+
+	// Instance variables.
+	QString m_sFilename;
+
+	QHash<QString, Entry> m_entries;
+	bool m_bDirty;
+
+	QMutex m_mutex;
+
+	// Kind of singleton reference.
+	static qsynthSoundFontMeta *g_pSoundFontMeta;
+};
+
+
+#endif  // __qsynthSoundFontMeta_h
+
+
+// end of qsynthSoundFontMeta.h
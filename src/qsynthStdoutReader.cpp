@@ -0,0 +1,248 @@
+// qsynthStdoutReader.cpp
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qsynthAbout.h"
+#include "qsynthStdoutReader.h"
+
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(WIN32)
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#endif
+
+
+// Reader buffer size (bytes per pipe read).
+#define QSYNTH_STDOUT_BUFSIZE  65536
+
+// Maximum pending lines, not yet taken by the GUI thread.
+#define QSYNTH_STDOUT_MAXLINES 4096
+
+// Maximum unfinished line length (bytes), before being broken.
+#define QSYNTH_STDOUT_MAXLINE  4096
+
+// Wake up commands.
+#define QSYNTH_STDOUT_FLUSH    'f'
+#define QSYNTH_STDOUT_QUIT     'q'
+
+
+//-------------------------------------------------------------------------
+// qsynthStdoutReader - Captured stdout/stderr pipe reader thread.
+//
+
+// Constructor.
+qsynthStdoutReader::qsynthStdoutReader ( int fd, QObject *pParent )
+	: QThread(pParent), m_fd(fd)
+{
+	m_fdWake[0] = m_fdWake[1] = -1;
+
+	m_iDropped = 0;
+	m_bBackpressure = false;
+	m_bPosted = false;
+
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(WIN32)
+	if (::pipe(m_fdWake) != 0)
+		m_fdWake[0] = m_fdWake[1] = -1;
+#endif
+}
+
+
+// Destructor.
+qsynthStdoutReader::~qsynthStdoutReader (void)
+{
+	stop();
+
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(WIN32)
+	if (m_fdWake[0] >= 0)
+		::close(m_fdWake[0]);
+	if (m_fdWake[1] >= 0)
+		::close(m_fdWake[1]);
+#endif
+}
+
+
+// Wake up the reader thread with some command.
+void qsynthStdoutReader::wake ( char ch )
+{
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(WIN32)
+	if (m_fdWake[1] >= 0 && ::write(m_fdWake[1], &ch, 1) < 0)
+		return;
+#endif
+}
+
+
+// Stop and wait for the reader thread.
+void qsynthStdoutReader::stop (void)
+{
+	if (isRunning()) {
+		wake(QSYNTH_STDOUT_QUIT);
+		wait();
+	}
+}
+
+
+// Have any unfinished line out, asynchronously.
+void qsynthStdoutReader::flush (void)
+{
+	if (isRunning())
+		wake(QSYNTH_STDOUT_FLUSH);
+}
+
+
+// Take out the pending lines (GUI thread).
+QStringList qsynthStdoutReader::takeLines (
+	int *piDropped, bool *pbBackpressure )
+{
+	QMutexLocker locker(&m_mutex);
+
+	QStringList lines;
+	lines.swap(m_lines);
+
+	if (piDropped)
+		*piDropped = m_iDropped;
+	if (pbBackpressure)
+		*pbBackpressure = m_bBackpressure;
+
+	m_iDropped = 0;
+	m_bBackpressure = false;
+	m_bPosted = false;
+
+	return lines;
+}
+
+
+// Hand over a batch of lines (reader thread).
+void qsynthStdoutReader::post ( const QStringList& lines, bool bBackpressure )
+{
+	QMutexLocker locker(&m_mutex);
+
+	// Keep up to the limit, drop and count the excess...
+	int iFree = QSYNTH_STDOUT_MAXLINES - m_lines.count();
+	QStringListIterator iter(lines);
+	while (iter.hasNext()) {
+		const QString& sLine = iter.next();
+		if (iFree > 0) {
+			m_lines.append(sLine);
+			--iFree;
+		}
+		else ++m_iDropped;
+	}
+
+	if (bBackpressure)
+		m_bBackpressure = true;
+
+	// Only one notification in flight, till taken...
+	if (!m_bPosted
+		&& (!m_lines.isEmpty() || m_iDropped > 0 || m_bBackpressure)) {
+		m_bPosted = true;
+		emit linesReady();
+	}
+}
+
+
+// Reader thread loop.
+void qsynthStdoutReader::run (void)
+{
+#if !defined(__WIN32__) && !defined(_WIN32) && !defined(WIN32)
+	if (m_fdWake[0] < 0)
+		return;
+
+	QByteArray buffer(QSYNTH_STDOUT_BUFSIZE, '\0');
+	char *pchBuffer = buffer.data();
+
+	struct pollfd pfds[2];
+	pfds[0].fd = m_fd;
+	pfds[0].events = POLLIN;
+	pfds[1].fd = m_fdWake[0];
+	pfds[1].events = POLLIN;
+
+	bool bRunning = true;
+	while (bRunning) {
+		pfds[0].revents = pfds[1].revents = 0;
+		if (::poll(pfds, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		QStringList lines;
+		bool bBackpressure = false;
+		// Any commands?
+		if (pfds[1].revents & POLLIN) {
+			char ch = 0;
+			if (::read(m_fdWake[0], &ch, 1) == 1) {
+				if (ch == QSYNTH_STDOUT_QUIT)
+					bRunning = false;
+				else
+				if (ch == QSYNTH_STDOUT_FLUSH && !m_line.isEmpty()) {
+					lines.append(QString::fromUtf8(m_line));
+					m_line.clear();
+				}
+			}
+		}
+		// Any output?
+		if (pfds[0].revents & (POLLIN | POLLHUP)) {
+			const int cchRead
+				= ::read(m_fd, pchBuffer, QSYNTH_STDOUT_BUFSIZE);
+			if (cchRead > 0) {
+				// Split complete lines, decoded one by one...
+				int iStart = 0;
+				for (int i = 0; i < cchRead; ++i) {
+					if (pchBuffer[i] == '\n') {
+						m_line.append(pchBuffer + iStart, i - iStart);
+						lines.append(QString::fromUtf8(m_line));
+						m_line.clear();
+						iStart = i + 1;
+					}
+				}
+				if (iStart < cchRead)
+					m_line.append(pchBuffer + iStart, cchRead - iStart);
+				// Break any overlong unfinished line (on a UTF-8
+				// character boundary)...
+				while (m_line.size() > QSYNTH_STDOUT_MAXLINE) {
+					int iBreak = QSYNTH_STDOUT_MAXLINE;
+					while (iBreak > 0 && (m_line.at(iBreak) & 0xc0) == 0x80)
+						--iBreak;
+					if (iBreak < 1)
+						iBreak = QSYNTH_STDOUT_MAXLINE;
+					lines.append(QString::fromUtf8(m_line.constData(), iBreak));
+					m_line.remove(0, iBreak);
+				}
+				// Were we falling behind?
+				if (cchRead >= QSYNTH_STDOUT_BUFSIZE)
+					bBackpressure = true;
+			}
+			else
+			if (cchRead == 0 || (errno != EINTR && errno != EAGAIN))
+				bRunning = false;
+		}
+		if (!lines.isEmpty() || bBackpressure)
+			post(lines, bBackpressure);
+	}
+
+	// Unfinished line left?
+	if (!m_line.isEmpty()) {
+		post(QStringList() << QString::fromUtf8(m_line), false);
+		m_line.clear();
+	}
+#endif
+}
+
+
+// end of qsynthStdoutReader.cpp
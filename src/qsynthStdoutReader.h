@@ -0,0 +1,99 @@
+// qsynthStdoutReader.h
+//
+/****************************************************************************
+   Copyright (C) 2003-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qsynthStdoutReader_h
+#define __qsynthStdoutReader_h
+
+#include <QThread>
+#include <QStringList>
+#include <QByteArray>
+#include <QMutex>
+
+
+//-------------------------------------------------------------------------
+// qsynthStdoutReader - Captured stdout/stderr pipe reader thread.
+//
+// Drains the pipe as soon as anything gets written, so that it never
+// fills up and blocks any writer (eg. fluidsynth MIDI thread on dump);
+// lines are split and decoded (UTF-8) here, and handed over to the GUI
+// thread through a bounded pending list, with at most one queued signal
+// in flight; any excess lines are dropped and counted.
+
+class qsynthStdoutReader : public QThread
+{
+	Q_OBJECT
+
+public:
+
+	// Constructor.
+	qsynthStdoutReader(int fd, QObject *pParent = NULL);
+	// Destructor.
+	~qsynthStdoutReader();
+
+	// Stop and wait for the reader thread.
+	void stop();
+
+	// Have any unfinished line out, asynchronously.
+	void flush();
+
+	// Take out the pending lines (GUI thread), also telling how many
+	// were dropped and whether any pipe read has filled the whole
+	// buffer (ie. falling behind) since last time.
+	QStringList takeLines(int *piDropped, bool *pbBackpressure);
+
+signals:
+
+	// Pending lines are ready to take (reader thread, coalesced).
+	void linesReady();
+
+protected:
+
+	// Reader thread loop.
+	void run();
+
+	// Wake up the reader thread with some command.
+	void wake(char ch);
+
+	// Hand over a batch of lines (reader thread).
+	void post(const QStringList& lines, bool bBackpressure);
+
+private:
+
+	// Instance variables.
+	int m_fd;
+	int m_fdWake[2];
+
+	// Unfinished line, if any (reader thread only).
+	QByteArray m_line;
+
+	// Pending lines, bounded (shared).
+	QMutex      m_mutex;
+	QStringList m_lines;
+	int         m_iDropped;
+	bool        m_bBackpressure;
+	bool        m_bPosted;
+};
+
+
+#endif  // __qsynthStdoutReader_h
+
+
+// end of qsynthStdoutReader.h
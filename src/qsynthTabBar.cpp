@@ -24,8 +24,17 @@
 #include "qsynthEngine.h"
 
 #include <QIcon>
+#include <QPainter>
 
 #include <QContextMenuEvent>
+#include <QPaintEvent>
+
+#include <math.h>
+
+
+// Level indicator range (in dB) and fall-off rate (per update).
+#define QSYNTH_TABBAR_MINDB   (-60.0f)
+#define QSYNTH_TABBAR_DECAY   (0.8f)
 
 
 // Common icon set.
@@ -83,6 +92,7 @@ int qsynthTabBar::addEngine ( qsynthEngine *pEngine )
 	if (iTab >= 0) {
 		QTabBar::setTabData(iTab,
 			qVariantFromValue(static_cast<void *> (pEngine)));
+		m_levels.insert(iTab, 0.0f);
 	}
 	return iTab;
 }
@@ -95,6 +105,9 @@ void qsynthTabBar::removeEngine ( int iTab )
 	if (pEngine)
 		delete pEngine;
 
+	if (iTab >= 0 && iTab < m_levels.count())
+		m_levels.removeAt(iTab);
+
 	QTabBar::removeTab(iTab);
 }
 
@@ -106,6 +119,81 @@ void qsynthTabBar::setOn ( int iTab, bool bOn )
 }
 
 
+// Engine tab level indicator accessor (peak, linear).
+void qsynthTabBar::setLevel ( int iTab, float fLevel )
+{
+	if (iTab < 0 || iTab >= m_levels.count())
+		return;
+
+	// Slow fall-off...
+	const float fOldLevel = m_levels.at(iTab);
+	if (fLevel < fOldLevel * QSYNTH_TABBAR_DECAY)
+		fLevel = fOldLevel * QSYNTH_TABBAR_DECAY;
+	if (fLevel < 0.001f)
+		fLevel = 0.0f;
+
+	m_levels[iTab] = fLevel;
+
+	// Only repaint when the bar has actually changed...
+	const QRect& rectOld = levelRect(iTab, fOldLevel);
+	const QRect& rectNew = levelRect(iTab, fLevel);
+	if (rectOld != rectNew)
+		QWidget::update(rectOld.united(rectNew));
+}
+
+
+// Whether any level indicator is still showing.
+bool qsynthTabBar::isLevelActive (void) const
+{
+	QListIterator<float> iter(m_levels);
+	while (iter.hasNext()) {
+		if (iter.next() > 0.0f)
+			return true;
+	}
+
+	return false;
+}
+
+
+// Level indicator geometry helper.
+QRect qsynthTabBar::levelRect ( int iTab, float fLevel ) const
+{
+	if (fLevel < 0.001f)
+		return QRect();
+
+	float dB = 20.0f * ::log10f(fLevel);
+	if (dB < QSYNTH_TABBAR_MINDB)
+		dB = QSYNTH_TABBAR_MINDB;
+	else if (dB > 0.0f)
+		dB = 0.0f;
+
+	const QRect& rect = QTabBar::tabRect(iTab);
+	const int w = int(float(rect.width() - 8)
+		* (dB - QSYNTH_TABBAR_MINDB) / -QSYNTH_TABBAR_MINDB);
+
+	return QRect(rect.left() + 4, rect.bottom() - 4, w, 2);
+}
+
+
+// Paint event (level indicators overlay).
+void qsynthTabBar::paintEvent ( QPaintEvent *pPaintEvent )
+{
+	QTabBar::paintEvent(pPaintEvent);
+
+	QPainter painter(this);
+
+	const int iTabCount = m_levels.count();
+	for (int iTab = 0; iTab < iTabCount; ++iTab) {
+		const float fLevel = m_levels.at(iTab);
+		const QRect& rect = levelRect(iTab, fLevel);
+		if (rect.isEmpty() || !rect.intersects(pPaintEvent->rect()))
+			continue;
+		painter.fillRect(rect, fLevel < 1.0f
+			? QColor(40, 160, 40) : QColor(240, 0, 20));
+	}
+}
+
+
 // Context menu event.
 void qsynthTabBar::contextMenuEvent ( QContextMenuEvent *pContextMenuEvent )
 {
@@ -23,6 +23,7 @@
 #define __qsynthTabBar_h
 
 #include <QTabBar>
+#include <QList>
 
 // Forward declarations.
 class qsynthEngine;
@@ -57,6 +58,12 @@ public:
 	// Engine tab icon accessor.
 	void setOn(int iTab, bool bOn);
 
+	// Engine tab level indicator accessor.
+	void setLevel(int iTab, float fLevel);
+
+	// Whether any level indicator is still showing.
+	bool isLevelActive() const;
+
 signals:
 
 	// Context menu signal.
@@ -66,6 +73,17 @@ protected:
 
 	// Context menu event.
 	void contextMenuEvent(QContextMenuEvent *pContextMenuEvent);
+
+	// Paint event (level indicators overlay).
+	void paintEvent(QPaintEvent *pPaintEvent);
+
+	// Level indicator geometry helper.
+	QRect levelRect(int iTab, float fLevel) const;
+
+private:
+
+	// Current level indicators (one per tab).
+	QList<float> m_levels;
 };
 
 
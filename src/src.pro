@@ -12,20 +12,34 @@ include(src.pri)
 HEADERS += config.h \
 	qsynthAbout.h \
 	qsynthEngine.h \
+	qsynthEngineManager.h \
+	qsynthAtomic.h \
+	qsynthRingBuffer.h \
 	qsynthChannels.h \
 	qsynthKnob.h \
+	qsynthLevels.h \
 	qsynthMeter.h \
+	qsynthMessagesModel.h \
 	qsynthSetup.h \
+	qsynthSoundFontCache.h \
+	qsynthSoundFontHeader.h \
+	qsynthSoundFontMeta.h \
+	qsynthPresetIndex.h \
+	qsynthSoundFontLoader.h \
+	qsynthRender.h \
+	qsynthStdoutReader.h \
 	qsynthOptions.h \
 	qsynthSystemTray.h \
 	qsynthTabBar.h \
 	qsynthAboutForm.h \
 	qsynthChannelsForm.h \
 	qsynthMainForm.h \
+	qsynthMidiMonitorForm.h \
 	qsynthMessagesForm.h \
 	qsynthOptionsForm.h \
 	qsynthPresetForm.h \
 	qsynthSetupForm.h \
+	qsynthDialStyle.h \
 	qsynthDialClassicStyle.h \
 	qsynthDialPeppinoStyle.h \
 	qsynthDialVokiStyle.h \
@@ -34,20 +48,32 @@ HEADERS += config.h \
 SOURCES += \
 	qsynth.cpp \
 	qsynthEngine.cpp \
+	qsynthEngineManager.cpp \
 	qsynthChannels.cpp \
 	qsynthKnob.cpp \
+	qsynthLevels.cpp \
 	qsynthMeter.cpp \
+	qsynthMessagesModel.cpp \
 	qsynthSetup.cpp \
+	qsynthSoundFontCache.cpp \
+	qsynthSoundFontHeader.cpp \
+	qsynthSoundFontMeta.cpp \
+	qsynthPresetIndex.cpp \
+	qsynthSoundFontLoader.cpp \
+	qsynthRender.cpp \
+	qsynthStdoutReader.cpp \
 	qsynthOptions.cpp \
 	qsynthSystemTray.cpp \
 	qsynthTabBar.cpp \
 	qsynthAboutForm.cpp \
 	qsynthChannelsForm.cpp \
 	qsynthMainForm.cpp \
+	qsynthMidiMonitorForm.cpp \
 	qsynthMessagesForm.cpp \
 	qsynthOptionsForm.cpp \
 	qsynthPresetForm.cpp \
 	qsynthSetupForm.cpp \
+	qsynthDialStyle.cpp \
 	qsynthDialClassicStyle.cpp \
 	qsynthDialPeppinoStyle.cpp \
 	qsynthDialVokiStyle.cpp \
@@ -57,6 +83,7 @@ FORMS += \
 	qsynthAboutForm.ui \
 	qsynthChannelsForm.ui \
 	qsynthMainForm.ui \
+	qsynthMidiMonitorForm.ui \
 	qsynthMessagesForm.ui \
 	qsynthOptionsForm.ui \
 	qsynthPresetForm.ui \